@@ -0,0 +1,250 @@
+/**
+ * Bump allocator for short-lived vectors and lists.
+ * Blocks are chained newest first; only the head block is bumped.
+ * @author Alejandro Ciuba
+ */
+
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct arena_block {
+
+    // Older block, NULL for the first one
+    arena_block* next;
+    size_t capacity;
+    size_t used;
+};
+
+// Block headers are padded so the data right after them is aligned too
+#define ARENA_HEADER ((sizeof(arena_block) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+// ===================== HELPERS =====================
+
+// Rounds bytes up to a whole number of ARENA_ALIGNMENT blocks, 0 on overflow
+static size_t align_up(size_t bytes) {
+
+    if (bytes > SIZE_MAX - (ARENA_ALIGNMENT - 1)) return 0;
+    return (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+static char* block_data(arena_block* b) {
+    return (char*)b + ARENA_HEADER;
+}
+
+// Pushes a new head block with room for at least bytes
+static arena_block* open_block(arena* a, size_t bytes) {
+
+    size_t capacity = bytes > a->block_size ? bytes : a->block_size;
+    if (capacity > SIZE_MAX - ARENA_HEADER) return NULL;
+
+    arena_block* b = (arena_block*)aligned_alloc(ARENA_ALIGNMENT, ARENA_HEADER + capacity);
+    if (b == NULL) return NULL;
+
+    b->next = a->head;
+    b->capacity = capacity;
+    b->used = 0;
+    a->head = b;
+
+    return b;
+}
+
+// Frees head blocks until last is the head (NULL frees all of them)
+static void free_blocks_until(arena* a, arena_block* last) {
+
+    while (a->head != NULL && a->head != last) {
+
+        arena_block* next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd arena. No block is allocated until the
+ * first allocation.
+ *
+ * @param block_size Usable bytes per block, 0 for ARENA_DEFAULT_BLOCK.
+ * @return arena* | NULL
+ */
+arena* init_arena(size_t block_size) {
+
+    if (block_size == 0) block_size = ARENA_DEFAULT_BLOCK;
+
+    block_size = align_up(block_size);
+    if (block_size == 0) return NULL;
+
+    arena* a = (arena*)malloc(sizeof(arena));
+    if (a == NULL) return NULL;
+
+    a->head = NULL;
+    a->block_size = block_size;
+
+    return a;
+}
+
+/**
+ * @brief Allocates bytes from the arena, ARENA_ALIGNMENT-aligned.
+ * The memory is NOT zeroed.
+ *
+ * @param a Arena.
+ * @param bytes Number of bytes (> 0).
+ * @return void* | NULL if a == NULL, bytes == 0 or out of memory.
+ */
+void* arena_alloc(arena* a, size_t bytes) {
+
+    if (a == NULL || bytes == 0) return NULL;
+
+    bytes = align_up(bytes);
+    if (bytes == 0) return NULL;
+
+    arena_block* b = a->head;
+    if (b == NULL || b->capacity - b->used < bytes) b = open_block(a, bytes);
+    if (b == NULL) return NULL;
+
+    void* ptr = block_data(b) + b->used;
+    b->used += bytes;
+
+    return ptr;
+}
+
+/**
+ * @brief arena_alloc for count * size zeroed bytes, overflow-checked.
+ *
+ * @return void* | NULL
+ */
+void* arena_calloc(arena* a, size_t count, size_t size) {
+
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+
+    void* ptr = arena_alloc(a, count * size);
+    if (ptr == NULL) return NULL;
+
+    return memset(ptr, 0, count * size);
+}
+
+/**
+ * @brief Resizes an arena allocation. The most recent allocation grows
+ * or shrinks in place when its block has room; anything else is copied
+ * to a fresh allocation (the old bytes stay in the arena until rewound).
+ *
+ * @param a Arena ptr came from.
+ * @param ptr Allocation to resize, NULL behaves like arena_alloc.
+ * @param old_bytes Size ptr was allocated (or last resized) with.
+ * @param new_bytes New size (> 0).
+ * @return void* | NULL, in which case ptr is left untouched.
+ */
+void* arena_realloc(arena* a, void* ptr, size_t old_bytes, size_t new_bytes) {
+
+    if (ptr == NULL) return arena_alloc(a, new_bytes);
+    if (a == NULL || new_bytes == 0) return NULL;
+
+    size_t old_aligned = align_up(old_bytes);
+    size_t new_aligned = align_up(new_bytes);
+    if (new_aligned == 0) return NULL;
+
+    // Last allocation of the head block: just move the bump pointer
+    arena_block* b = a->head;
+    if (b != NULL && (char*)ptr + old_aligned == block_data(b) + b->used
+        && (char*)ptr - block_data(b) + new_aligned <= b->capacity) {
+
+        b->used = (size_t)((char*)ptr - block_data(b)) + new_aligned;
+        return ptr;
+    }
+
+    void* moved = arena_alloc(a, new_bytes);
+    if (moved == NULL) return NULL;
+
+    return memcpy(moved, ptr, old_bytes < new_bytes ? old_bytes : new_bytes);
+}
+
+/**
+ * @brief Current position of the arena, to be passed to arena_rewind.
+ *
+ * @param a Arena.
+ * @return arena_mark
+ */
+arena_mark arena_get_mark(const arena* a) {
+
+    arena_mark mark = { NULL, 0 };
+    if (a == NULL || a->head == NULL) return mark;
+
+    mark.block = a->head;
+    mark.used = a->head->used;
+
+    return mark;
+}
+
+/**
+ * @brief Releases everything allocated after mark was taken. Blocks
+ * opened since are freed. Marks taken after mark become invalid.
+ *
+ * @param a Arena.
+ * @param mark Earlier mark of a.
+ */
+void arena_rewind(arena* a, arena_mark mark) {
+
+    if (a == NULL) return;
+
+    free_blocks_until(a, mark.block);
+    if (a->head != NULL) a->head->used = mark.used;
+}
+
+/**
+ * @brief Releases every allocation. If the arena had spilled into several
+ * blocks they are merged into one big enough for all of them, so a
+ * reset-per-frame pattern settles on a single block.
+ *
+ * @param a Arena.
+ */
+void arena_reset(arena* a) {
+
+    if (a == NULL || a->head == NULL) return;
+
+    if (a->head->next == NULL) {
+
+        a->head->used = 0;
+        return;
+    }
+
+    size_t total = 0;
+    for (arena_block* b = a->head; b != NULL; b = b->next)
+        total = total > SIZE_MAX - b->capacity ? SIZE_MAX : total + b->capacity;
+
+    free_blocks_until(a, NULL);
+
+    // Best effort, the next allocation opens a regular block if this fails
+    open_block(a, total);
+}
+
+/**
+ * @brief Bytes handed out since the last reset (including alignment padding).
+ *
+ * @param a Arena.
+ * @return size_t
+ */
+size_t arena_used(const arena* a) {
+
+    if (a == NULL) return 0;
+
+    size_t used = 0;
+    for (arena_block* b = a->head; b != NULL; b = b->next) used += b->used;
+
+    return used;
+}
+
+/**
+ * @brief Frees the arena and every block, invalidating all its allocations.
+ *
+ * @param a Arena to be freed.
+ */
+void free_arena(arena* a) {
+
+    if (a == NULL) return;
+
+    free_blocks_until(a, NULL);
+    free(a);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file arena.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Bump allocator for short-lived vectors and lists. Allocations are
+ * carved out of large blocks, ARENA_ALIGNMENT-aligned, and never freed one
+ * by one: rewind to a mark or reset the whole arena to release everything
+ * allocated since, in O(blocks). Not thread-safe, give each thread its own.
+ * @version 0.1
+ * @date 2022-07-23
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Every allocation starts on a cache line, wide enough for AVX-512 loads
+#define ARENA_ALIGNMENT 64
+// Block size used when init_arena is given 0
+#define ARENA_DEFAULT_BLOCK ((size_t)1 << 16)
+
+typedef struct arena_block arena_block;
+
+/**
+ * @brief The arena containing the following:
+ * - arena_block* head: Block currently being bumped, older blocks chain behind it.
+ * - size_t block_size: Usable bytes of a new block (bigger requests get their own).
+ */
+typedef struct arena {
+
+    arena_block* head;
+    size_t block_size;
+} arena;
+
+/**
+ * @brief Position in an arena, from arena_get_mark. Rewinding to it releases
+ * everything allocated after it was taken.
+ */
+typedef struct arena_mark {
+
+    arena_block* block;
+    size_t used;
+} arena_mark;
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd arena. No block is allocated until the
+ * first allocation.
+ *
+ * @param block_size Usable bytes per block, 0 for ARENA_DEFAULT_BLOCK.
+ * @return arena* | NULL
+ */
+arena* init_arena(size_t block_size);
+
+/**
+ * @brief Allocates bytes from the arena, ARENA_ALIGNMENT-aligned.
+ * The memory is NOT zeroed.
+ *
+ * @param a Arena.
+ * @param bytes Number of bytes (> 0).
+ * @return void* | NULL if a == NULL, bytes == 0 or out of memory.
+ */
+void* arena_alloc(arena* a, size_t bytes);
+
+/**
+ * @brief arena_alloc for count * size zeroed bytes, overflow-checked.
+ *
+ * @return void* | NULL
+ */
+void* arena_calloc(arena* a, size_t count, size_t size);
+
+/**
+ * @brief Resizes an arena allocation. The most recent allocation grows
+ * or shrinks in place when its block has room; anything else is copied
+ * to a fresh allocation (the old bytes stay in the arena until rewound).
+ *
+ * @param a Arena ptr came from.
+ * @param ptr Allocation to resize, NULL behaves like arena_alloc.
+ * @param old_bytes Size ptr was allocated (or last resized) with.
+ * @param new_bytes New size (> 0).
+ * @return void* | NULL, in which case ptr is left untouched.
+ */
+void* arena_realloc(arena* a, void* ptr, size_t old_bytes, size_t new_bytes);
+
+/**
+ * @brief Current position of the arena, to be passed to arena_rewind.
+ *
+ * @param a Arena.
+ * @return arena_mark
+ */
+arena_mark arena_get_mark(const arena* a);
+
+/**
+ * @brief Releases everything allocated after mark was taken. Blocks
+ * opened since are freed. Marks taken after mark become invalid.
+ *
+ * @param a Arena.
+ * @param mark Earlier mark of a.
+ */
+void arena_rewind(arena* a, arena_mark mark);
+
+/**
+ * @brief Releases every allocation. If the arena had spilled into several
+ * blocks they are merged into one big enough for all of them, so a
+ * reset-per-frame pattern settles on a single block.
+ *
+ * @param a Arena.
+ */
+void arena_reset(arena* a);
+
+/**
+ * @brief Bytes handed out since the last reset (including alignment padding).
+ *
+ * @param a Arena.
+ * @return size_t
+ */
+size_t arena_used(const arena* a);
+
+/**
+ * @brief Frees the arena and every block, invalidating all its allocations.
+ *
+ * @param a Arena to be freed.
+ */
+void free_arena(arena* a);
+
+#endif
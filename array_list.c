@@ -6,160 +6,539 @@
  */
 
 #include "array_list.h"
+#include "vector_search.h"
+#include "vector_io.h"
+#include "telemetry.h"
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
+// ===================== HELPERS =====================
+
+// Address of the element at index, in either storage mode
+static void* slot(int index, arl* ar) {
+
+    if(ar->packed) return (char*) ar->data + (size_t) index * ar->data_size;
+    else return ar->array[index];
+}
+
+// Moves the list to new_capacity elements in place, in either storage mode
+// Elements past new_capacity are dropped; boxed ones are freed even if the realloc fails
+// Returns char -> 0 FAILED (capacity unchanged), 1 OK
+static char resize_arl(int new_capacity, arl* ar) {
+
+    if(new_capacity <= 0) return 0;
+    if(new_capacity == ar->capacity) return 1;
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_RESIZE);
+    int keep = ar->size < new_capacity ? ar->size : new_capacity;
+
+    // Elements past new_capacity are about to go, take them out of the index
+    for(int i = new_capacity; ar->index != NULL && i < ar->size; i++)
+        hash_index_remove(ar->index, slot(i, ar));
+
+    if(ar->packed) {
+        void* data = ar->arena != NULL
+            ? arena_realloc(ar->arena, ar->data, ar->data_size * ar->capacity, ar->data_size * new_capacity)
+            : realloc(ar->data, ar->data_size * new_capacity);
+        if(data == NULL) {
+            // Still there, put them back
+            for(int i = new_capacity; ar->index != NULL && i < ar->size; i++)
+                hash_index_insert(ar->index, slot(i, ar));
+            return 0;
+        }
+        if(ar->arena == NULL) TELEMETRY_ALLOC(ar->data_size * new_capacity);
+        if(data != ar->data) TELEMETRY_COPY((size_t) keep * ar->data_size);
+        ar->data = data;
+    } else {
+        // Boxed: only the pointer array moves, the elements stay where they are
+        for(int i = new_capacity; i < ar->size; i++) {free(ar->array[i]); ar->array[i] = NULL;}
+        if(ar->size > new_capacity) ar->size = new_capacity;
+
+        void** array = (void**) realloc(ar->array, sizeof(void*) * new_capacity);
+        if(array == NULL) return 0;
+        TELEMETRY_ALLOC(sizeof(void*) * new_capacity);
+        if(array != ar->array) TELEMETRY_COPY(sizeof(void*) * keep);
+        for(int i = ar->capacity; i < new_capacity; i++) array[i] = NULL;
+        ar->array = array;
+    }
+
+    TELEMETRY_RESIZE(new_capacity > ar->capacity);
+    if(new_capacity > ar->capacity) ar->stats.grows++;
+    else ar->stats.shrinks++;
+
+    ar->capacity = new_capacity;
+    if(ar->size > new_capacity) ar->size = new_capacity;
+    return 1;
+}
+
+// Makes room for extra more elements with at most one resize, in place for both modes
+// Returns char -> 0 FAILED (ar unchanged), 1 OK
+static char make_room(int extra, arl* ar) {
+
+    if(extra > INT_MAX - ar->size) return 0;
+
+    int need = ar->size + extra;
+    if(need <= ar->capacity) return 1;
+
+    // One growth step, or the whole batch if that is more
+    size_t new_capacity = policy_grow(ar->policy, (size_t) ar->capacity, (size_t) need);
+    return resize_arl(new_capacity > INT_MAX ? INT_MAX : (int) new_capacity, ar);
+}
+
+// Shrinks ar in place if its policy says it has too much room, with a single resize
+static arl* shrink(arl* ar) {
+
+    size_t new_capacity = policy_shrink(ar->policy, (size_t) ar->size, (size_t) ar->capacity);
+    if(new_capacity < (size_t) ar->capacity) resize_arl((int) new_capacity, ar);
+    return ar;
+}
+
+// Adds count elements to the list's index, taking them back out if one fails
+// Returns char -> 0 FAILED, 1 OK
+static char index_range(const void* data, int count, arl* ar) {
+
+    if(ar->index == NULL) return 1;
+
+    const char* bytes = (const char*) data;
+    for(int i = 0; i < count; i++) {
+        if(hash_index_insert(ar->index, bytes + (size_t) i * ar->data_size)) continue;
+        while(i-- > 0) hash_index_remove(ar->index, bytes + (size_t) i * ar->data_size);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Boxed mode: one malloc'd copy of each of the count elements at data, NULL if any failed
+static void** box_range(const void* data, int count, arl* ar) {
+
+    void** boxes = (void**) malloc(sizeof(void*) * count);
+    if(boxes == NULL) return NULL;
+    TELEMETRY_ALLOC(sizeof(void*) * count);
+
+    for(int i = 0; i < count; i++) {
+        boxes[i] = malloc(ar->data_size);
+        if(boxes[i] == NULL) {
+            while(i-- > 0) free(boxes[i]);
+            free(boxes);
+            return NULL;
+        }
+        memcpy(boxes[i], (const char*) data + (size_t) i * ar->data_size, ar->data_size);
+        TELEMETRY_ALLOC(ar->data_size);
+        TELEMETRY_COPY(ar->data_size);
+    }
+
+    return boxes;
+}
+
 // ===================== FUNCTIONS =====================
 
 // Initializes the array list
 arl* init_arl(int init_capacity, size_t data_size) {
 
+    TELEMETRY_SCOPE(TELEMETRY_ARL_INIT);
     if(init_capacity == 0) return NULL;
     if(data_size == 0) return NULL;
 
     arl* ar = (arl*) malloc(sizeof(arl));
     if(ar == NULL) return NULL;
     ar->array = (void**) malloc(sizeof(void*) * init_capacity);
-    if(ar->array == NULL) return NULL;
+    if(ar->array == NULL) {free(ar); return NULL;}
+    TELEMETRY_ALLOC(sizeof(arl));
+    TELEMETRY_ALLOC(sizeof(void*) * init_capacity);
     for(int i = 0; i < init_capacity; i++) ar->array[i] = NULL;
+    ar->data = NULL;
+    ar->size = 0;
+    ar->capacity = init_capacity;
+    ar->data_size = data_size;
+    ar->packed = 0;
+    ar->arena = NULL;
+    ar->index = NULL;
+    ar->policy = ARL_DEFAULT_POLICY;
+    ar->stats = (resize_stats) {0, 0};
+    return ar;
+}
+
+// Initializes a packed array list, every element lives inline in one buffer
+arl* init_arl_packed(int init_capacity, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_INIT);
+    if(init_capacity <= 0) return NULL;
+    if(data_size == 0) return NULL;
+
+    arl* ar = (arl*) malloc(sizeof(arl));
+    if(ar == NULL) return NULL;
+    ar->data = malloc(data_size * init_capacity);
+    if(ar->data == NULL) {free(ar); return NULL;}
+    TELEMETRY_ALLOC(sizeof(arl));
+    TELEMETRY_ALLOC(data_size * init_capacity);
+    ar->array = NULL;
+    ar->size = 0;
+    ar->capacity = init_capacity;
+    ar->data_size = data_size;
+    ar->packed = 1;
+    ar->arena = NULL;
+    ar->index = NULL;
+    ar->policy = ARL_DEFAULT_POLICY;
+    ar->stats = (resize_stats) {0, 0};
+    return ar;
+}
+
+// Initializes a packed array list inside an arena
+arl* init_arl_arena(arena* a, int init_capacity, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_INIT);
+    if(a == NULL || init_capacity <= 0) return NULL;
+    if(data_size == 0) return NULL;
+
+    // Roll back the struct too if the elements do not fit
+    arena_mark mark = arena_get_mark(a);
+
+    arl* ar = (arl*) arena_alloc(a, sizeof(arl));
+    if(ar == NULL) return NULL;
+    ar->data = arena_alloc(a, data_size * init_capacity);
+    if(ar->data == NULL) {arena_rewind(a, mark); return NULL;}
+    ar->array = NULL;
     ar->size = 0;
     ar->capacity = init_capacity;
     ar->data_size = data_size;
+    ar->packed = 1;
+    ar->arena = a;
+    ar->index = NULL;
+    ar->policy = ARL_DEFAULT_POLICY;
+    ar->stats = (resize_stats) {0, 0};
     return ar;
 }
 
 // Append to end, copies data into array
-arl* append(const void* data, arl* ar) {
+arl* append_arl(const void* data, arl* ar) {
 
+    TELEMETRY_SCOPE(TELEMETRY_ARL_APPEND);
     if(data == NULL || ar == NULL) return ar;
-    
+
+    // Packed: grow the buffer if needed and copy inline, no per-element malloc
+    if(ar->packed) {
+        if(!make_room(1, ar)) return ar;
+        if(ar->index != NULL && !hash_index_insert(ar->index, data)) return ar;
+        memcpy(slot(ar->size++, ar), data, ar->data_size);
+        TELEMETRY_COPY(ar->data_size);
+        return ar;
+    }
+
     // Make a deep copy of the object
     void* data_cpy = malloc(ar->data_size);
     if(data_cpy == NULL) return ar;
     memcpy(data_cpy, data, ar->data_size);
-    
-    // If index out of bounds, upsize
-    // Else insert
-    if(ar->size == ar->capacity) {
-        ar = upsize(ar);
-        // Check if upsize failed
-        if(ar->size == ar->capacity) return ar;
-        ar->array[ar->size++] = data_cpy;
-        return ar;
-    }
+    TELEMETRY_ALLOC(ar->data_size);
+    TELEMETRY_COPY(ar->data_size);
 
-    // Else insert
+    // Boxed lists grow the pointer array in place too
+    if(!make_room(1, ar)) {free(data_cpy); return ar;}
+    if(ar->index != NULL && !hash_index_insert(ar->index, data)) {free(data_cpy); return ar;}
+
+    // Insert
     ar->array[ar->size++] = data_cpy;
     return ar;
 }
 
 // Replaces value
-arl* replace(const void* data, int index, arl* ar) {
+arl* replace_arl(const void* data, int index, arl* ar) {
 
+    TELEMETRY_SCOPE(TELEMETRY_ARL_REPLACE);
     if(data == NULL || ar == NULL) return ar;
-    if(index > ar->capacity) return ar;
-    if(index > ar->size + 1) return ar;
+    if(index < 0 || index > ar->size) return ar;
+
+    // Special Case: index is one past the last element, simple append
+    if(index == ar->size) return append_arl(data, ar);
 
-    // Special Case: index is one greater than the size, simple append
-    if(index == ar->size + 1) return append(data, ar);
+    // index now holds an element, swap the old value for the new one in the index
+    if(ar->index != NULL) {
+        if(!hash_index_insert(ar->index, data)) return ar;
+        hash_index_remove(ar->index, slot(index, ar));
+    }
+
+    if(ar->packed) memcpy(slot(index, ar), data, ar->data_size);
     else ar->array[index] = memcpy(ar->array[index], data, ar->data_size);
+    TELEMETRY_COPY(ar->data_size);
     return ar;
 }
 
 // Removes at index, shifts array down
-arl* delete(int index, arl* ar) {
+arl* delete_arl(int index, arl* ar) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_ERASE);
+    if(ar == NULL || index < 0 || index >= ar->size) return ar;
+
+    if(ar->packed) {
+        if(ar->index != NULL) hash_index_remove(ar->index, slot(index, ar));
+
+        // Slide the tail down over the removed element in one move
+        memmove(slot(index, ar), slot(index + 1, ar), (size_t) (ar->size - index - 1) * ar->data_size);
+        TELEMETRY_COPY((size_t) (ar->size - index - 1) * ar->data_size);
+        ar->size--;
+
+        // Special Case: We can shrink
+        return shrink(ar);
+    }
 
-    if(index < 0 || ar == NULL) return ar;
-    if(index > ar->capacity) return ar;
     if(ar->array[index] == NULL) return ar;
+    if(ar->index != NULL) hash_index_remove(ar->index, ar->array[index]);
 
     // Free stuff at that memory location
     free(ar->array[index]);
 
-    // Shift
-    for(int i = index; i < ar->size - 1; i++)
-        ar->array[i] = ar->array[i + 1];
+    // Shift the tail down in one move
+    memmove(&ar->array[index], &ar->array[index + 1], sizeof(void*) * (ar->size - index - 1));
+    TELEMETRY_COPY(sizeof(void*) * (ar->size - index - 1));
 
     // Decrement size and make last spot NULL
     ar->array[--(ar->size)] = NULL;
-    
-    // Special Case: We can downsize
-    if(ar->size <= ar->capacity / 2) return downsize(ar);
-    else return ar;
+
+    // Special Case: We can shrink
+    return shrink(ar);
+}
+
+// Appends count elements stored back to back at data, growing at most once
+// All or nothing: if anything fails ar is left as it was
+arl* append_n_arl(const void* data, int count, arl* ar) {
+    return insert_range_arl(data, count, ar == NULL ? 0 : ar->size, ar);
+}
+
+// Inserts count elements stored back to back at data before index (0..size),
+// shifting the tail up in one move. All or nothing, like append_n_arl
+arl* insert_range_arl(const void* data, int count, int index, arl* ar) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_INSERT);
+    if(data == NULL || ar == NULL || count <= 0) return ar;
+    if(index < 0 || index > ar->size) return ar;
+
+    // Boxed: every copy is made up front so nothing has to be undone later
+    void** boxes = NULL;
+    if(!ar->packed && (boxes = box_range(data, count, ar)) == NULL) return ar;
+
+    if(!make_room(count, ar) || !index_range(data, count, ar)) {
+        for(int i = 0; boxes != NULL && i < count; i++) free(boxes[i]);
+        free(boxes);
+        return ar;
+    }
+
+    if(ar->packed) {
+        memmove(slot(index + count, ar), slot(index, ar), (size_t) (ar->size - index) * ar->data_size);
+        memcpy(slot(index, ar), data, (size_t) count * ar->data_size);
+        TELEMETRY_COPY((size_t) (ar->size - index + count) * ar->data_size);
+    } else {
+        memmove(&ar->array[index + count], &ar->array[index], sizeof(void*) * (ar->size - index));
+        memcpy(&ar->array[index], boxes, sizeof(void*) * count);
+        TELEMETRY_COPY(sizeof(void*) * (ar->size - index + count));
+        free(boxes);
+    }
+
+    ar->size += count;
+    return ar;
+}
+
+// Removes count elements starting at index, shifting the tail down in one move
+// Shrinks at most once afterwards, like delete_arl
+arl* erase_range_arl(int index, int count, arl* ar) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_ERASE);
+    if(ar == NULL || count <= 0) return ar;
+    if(index < 0 || index > ar->size || count > ar->size - index) return ar;
+
+    for(int i = index; i < index + count; i++) {
+        if(ar->index != NULL) hash_index_remove(ar->index, slot(i, ar));
+        if(!ar->packed) free(ar->array[i]);
+    }
+
+    TELEMETRY_COPY((size_t) (ar->size - index - count) * (ar->packed ? ar->data_size : sizeof(void*)));
+    if(ar->packed) memmove(slot(index, ar), slot(index + count, ar), (size_t) (ar->size - index - count) * ar->data_size);
+    else {
+        memmove(&ar->array[index], &ar->array[index + count], sizeof(void*) * (ar->size - index - count));
+        for(int i = ar->size - count; i < ar->size; i++) ar->array[i] = NULL;
+    }
+
+    ar->size -= count;
+    return shrink(ar);
+}
+
+// Removes every element predicate returns 1 for, keeping the order of the rest
+// One pass, runs of kept elements are moved together. Shrinks like erase_range_arl
+arl* erase_if_arl(char (*predicate)(const void* data, void* context), void* context, arl* ar) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_ERASE_IF);
+    if(predicate == NULL || ar == NULL) return ar;
+
+    // Packed lists move elements, boxed lists move pointers
+    char* base = ar->packed ? (char*) ar->data : (char*) ar->array;
+    size_t width = ar->packed ? ar->data_size : sizeof(void*);
+    int kept = 0, run = 0;
+
+    for(int i = 0; i < ar->size; i++) {
+
+        if(!predicate(slot(i, ar), context)) continue;
+
+        // Close the run of kept elements before i
+        if(i > run) memmove(base + (size_t) kept * width, base + (size_t) run * width, (size_t) (i - run) * width);
+        if(i > run) TELEMETRY_COPY((size_t) (i - run) * width);
+        kept += i - run;
+        run = i + 1;
+
+        if(ar->index != NULL) hash_index_remove(ar->index, slot(i, ar));
+        if(!ar->packed) free(ar->array[i]);
+    }
+
+    if(ar->size > run) memmove(base + (size_t) kept * width, base + (size_t) run * width, (size_t) (ar->size - run) * width);
+    if(ar->size > run) TELEMETRY_COPY((size_t) (ar->size - run) * width);
+    kept += ar->size - run;
+
+    if(kept == ar->size) return ar;
+    for(int i = kept; !ar->packed && i < ar->size; i++) ar->array[i] = NULL;
+    ar->size = kept;
+    return shrink(ar);
 }
 
 // Check if arl contains data, uses user-supplied function
 // Such that: 0: the same, 1: arg1 > arg2, -1: arg1 < arg2
 // Returns char -> 0 FALSE, 1 TRUE
-char contains(const void* data, arl* ar, char (*comparator)(const void* arg1, const void* arg2)) {
+char contains_arl(const void* data, arl* ar, char (*comparator)(const void* arg1, const void* arg2)) {
+
+    TELEMETRY_SCOPE(TELEMETRY_ARL_CONTAINS);
+    if(data == NULL || ar == NULL) return 0;
 
-    if(comparator == NULL) return 0;
-    if(data == NULL) return 0;
+    // Byte-wise lookup through the index, or a scan without one
+    if(comparator == NULL) {
+
+        if(ar->index != NULL) return hash_index_count(ar->index, data) != 0;
+        if(ar->packed) return find_bytes(ar->data, (size_t) ar->size, data, ar->data_size) != (size_t) ar->size;
+
+        for(int i = 0; i < ar->size; i++)
+            if(memcmp(slot(i, ar), data, ar->data_size) == 0) return 1;
+
+        return 0;
+    }
 
     for(int i = 0; i < ar->size; i++)
-        if(comparator(data, ar->array + i) == 0) return 1;
+        if(comparator(data, slot(i, ar)) == 0) return 1;
 
     return 0;
 }
 
 // Gets data at index, returning a deep copy, REMEMBER TO FREE!!!
-void* get_deep(int index, arl* ar) {
+void* get_deep_arl(int index, arl* ar) {
+    TELEMETRY_SCOPE(TELEMETRY_ARL_GET_DEEP);
     if(ar == NULL) return NULL;
-    if(index > ar->size) return NULL;
+    if(index < 0 || index >= ar->size) return NULL;
     void* data_cpy = malloc(ar->data_size);
     if(data_cpy == NULL) return NULL;
-    return (void*) memcpy(data_cpy, ar->array[index], ar->data_size);
+    TELEMETRY_ALLOC(ar->data_size);
+    TELEMETRY_COPY(ar->data_size);
+    return (void*) memcpy(data_cpy, slot(index, ar), ar->data_size);
 }
 
 // Gets data at index, returning a shallow copy,
 // REMEMBER: CHANGES MADE TO IT WILL BE REFLECTED IN THE ARRAY LIST
-void* get_shallow(int index, arl* ar) {
+void* get_shallow_arl(int index, arl* ar) {
     if(ar == NULL) return NULL;
-    if(index > ar->size) return NULL;
-    return ar->array[index];
+    if(index < 0 || index >= ar->size) return NULL;
+    return slot(index, ar);
+}
+
+// Doubles the capacity in place and returns ar
+arl* upsize_arl(arl* ar) {
+
+    if(ar == NULL) return NULL;
+    resize_arl(ar->capacity > INT_MAX / 2 ? INT_MAX : ar->capacity * 2, ar);
+    return ar;
 }
 
-// Frees old ar and returns new ar twice the size
-arl* upsize(arl* ar) {
+// Halves the capacity in place, dropping the elements that no longer fit, and returns ar
+arl* downsize_arl(arl* ar) {
 
     if(ar == NULL) return NULL;
+    resize_arl(ar->capacity / 2, ar);
+    return ar;
+}
+
+// Replaces the list's growth policy, ARL_DEFAULT_POLICY to begin with
+// Returns char -> 0 FAILED (invalid policy), 1 OK
+char set_policy_arl(growth_policy policy, arl* ar) {
+
+    if(ar == NULL || !growth_policy_valid(policy)) return 0;
+    if(policy.min_capacity == 0 || policy.min_capacity > INT_MAX) return 0;
+
+    ar->policy = policy;
+    return 1;
+}
+
+// Builds (or rebuilds) a hash index of the elements so byte-wise contains_arl is O(1)
+char index_arl(arl* ar) {
+
+    if(ar == NULL) return 0;
+    drop_index_arl(ar);
 
-    // Initialize new array list
-    arl* new_ar = init_arl(ar->capacity * 2, ar->data_size);
-    if(new_ar == NULL) return ar;
+    hash_index* h = init_hash_index(ar->data_size, (size_t) ar->size);
+    if(h == NULL) return 0;
 
-    // Copy all the data
     for(int i = 0; i < ar->size; i++)
-        if((new_ar = append(ar->array[i], new_ar)) == NULL) return ar;
-    
-    // Free old array and return new_ar
-    free_arl(ar);
+        if(!hash_index_insert(h, slot(i, ar))) {free_hash_index(h); return 0;}
 
-    return new_ar;
+    ar->index = h;
+    return 1;
 }
 
-// Frees old ar and returns new ar twice as small
-arl* downsize(arl* ar) {
+// Frees the list's index, if any
+void drop_index_arl(arl* ar) {
 
-    if(ar == NULL) return NULL;
+    if(ar == NULL) return;
+    free_hash_index(ar->index);
+    ar->index = NULL;
+}
+
+// Writes the elements to path as a checksummed stream (see vector_io.h)
+// Returns char -> 0 FAILED, 1 OK
+char save_arl(const char* path, char append, arl* ar) {
+
+    if(ar == NULL) return 0;
+
+    vec_writer* w = open_vec_writer(path, ar->data_size, append);
+    char ok = w != NULL && (ar->packed
+        ? write_vec_stream(w, ar->data, (size_t) ar->size)
+        : write_vec_stream_boxed(w, ar->array, (size_t) ar->size));
+
+    return close_vec_writer(w, 0) && ok;
+}
 
-    // Initialize new array list
-    arl* new_ar = init_arl(ar->capacity / 2, ar->data_size);
-    if(new_ar == NULL) return ar;
+// Reads the stream at path into a new list, packed or boxed, one chunk at a time
+arl* load_arl(const char* path, size_t data_size, char packed) {
 
-    //Copy all the data
-    for(int i = 0; i < new_ar->capacity; i++)
-        if((new_ar = append(ar->array[i], new_ar)) == NULL) return ar;
-    
-    // Free old array and return new_ar
-    free_arl(ar);
-    return new_ar;
+    vec_reader* r = open_vec_reader(path);
+    if(r == NULL) return NULL;
+
+    arl* ar = r->data_size != data_size ? NULL : packed ? init_arl_packed(1, data_size) : init_arl(1, data_size);
+
+    size_t count;
+    const void* chunk;
+    while(ar != NULL && (chunk = read_vec_stream(r, &count)) != NULL) {
+        int before = ar->size;
+        if(count > (size_t) (INT_MAX - before) || append_n_arl(chunk, (int) count, ar)->size != before + (int) count) break;
+    }
+
+    // Stopped early: corrupt stream, or the list could not take the chunk
+    if(ar != NULL && (r->error || r->read != (size_t) ar->size)) {free_arl(ar); ar = NULL;}
+
+    close_vec_reader(r);
+    return ar;
 }
 
 // Frees array list
 void free_arl(arl* ar) {
 
-    if(ar == NULL) return;
+    TELEMETRY_SCOPE(TELEMETRY_ARL_FREE);
+    // The index is on the heap even for arena-backed lists
+    drop_index_arl(ar);
+    if(ar == NULL || ar->arena != NULL) return;
+    else if(ar->packed) {free(ar->data); free(ar); return;}
     else if(ar->array == NULL) {free(ar); return;}
 
     // Free everything in ar
@@ -172,4 +551,4 @@ void free_arl(arl* ar) {
 
     // Finally, free the arl pointer
     free(ar);
-}
\ No newline at end of file
+}
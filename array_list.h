@@ -7,15 +7,35 @@
 #define ARRAY_LIST_H
 
 #include <stddef.h>
+#include <stdbool.h>
+#include "arena.h"
+#include "hash_index.h"
+#include "growth_policy.h"
+
+// Default growth policy: double when full, shrink back to half once a
+// quarter is in use, never below ARL_MIN_CAPACITY elements
+#define ARL_MIN_CAPACITY 8
+#define ARL_DEFAULT_POLICY ((growth_policy){ 200, 4, ARL_MIN_CAPACITY })
 
 // The array list
 typedef struct array_list {
 
     // An array of pointers to any data type
     void** array;
+    // Packed mode: elements stored back to back, data_size bytes apart
+    void* data;
     int size;
     int capacity;
     size_t data_size;
+    bool packed;
+    // Arena the list lives in, NULL if it is on the heap
+    arena* arena;
+    // Optional lookup index for contains_arl, see index_arl
+    hash_index* index;
+    // When the list grows and shrinks on its own, see set_policy_arl
+    growth_policy policy;
+    // How many times its capacity changed so far
+    resize_stats stats;
 } arl;
 
 // ===================== FUNCTIONS =====================
@@ -23,32 +43,83 @@ typedef struct array_list {
 // Initializes the array list
 arl* init_arl(int init_capacity, size_t data_size);
 
+// Initializes a packed array list, every element lives inline in one buffer
+// Same API as init_arl, but the whole list costs a single allocation
+// and get_shallow_arl pointers are invalidated by upsize_arl/downsize_arl/delete_arl
+arl* init_arl_packed(int init_capacity, size_t data_size);
+
+// Initializes a packed array list inside an arena, elements are ARENA_ALIGNMENT-aligned
+// free_arl leaves it alone, the memory goes back when the arena is rewound, reset or freed
+arl* init_arl_arena(arena* a, int init_capacity, size_t data_size);
+
 // Add to an index, copies data into array
-arl* append(const void* data, arl* ar);
+arl* append_arl(const void* data, arl* ar);
+
+// Replaces the value at index (0..size-1), index == size appends instead
+arl* replace_arl(const void* data, int index, arl* ar);
+
+// Removes at index (0..size-1), shifts array down
+// Shrinks in place once the list is down to 1/shrink_divisor of its capacity (see set_policy_arl)
+arl* delete_arl(int index, arl* ar);
+
+// Appends count elements stored back to back at data, growing at most once
+// All or nothing: if anything fails ar is left as it was
+arl* append_n_arl(const void* data, int count, arl* ar);
 
-// Replaces value
-arl* replace(const void* data, int index, arl* ar);
+// Inserts count elements stored back to back at data before index (0..size),
+// shifting the tail up in one move. All or nothing, like append_n_arl
+arl* insert_range_arl(const void* data, int count, int index, arl* ar);
 
-// Removes at index, shifts array down
-arl* delete(int index, arl* ar);
+// Removes count elements starting at index, shifting the tail down in one move
+// Shrinks at most once afterwards, like delete_arl
+arl* erase_range_arl(int index, int count, arl* ar);
+
+// Removes every element predicate returns 1 for, keeping the order of the rest
+// One pass, runs of kept elements are moved together. Shrinks like erase_range_arl
+arl* erase_if_arl(char (*predicate)(const void* data, void* context), void* context, arl* ar);
 
 // Check if arl contains data, uses user-supplied function
 // Such that: 0: the same, 1: arg1 > arg2, -1: arg1 < arg2
+// A NULL comparator compares bytes, through the list's index if it has one
 // Returns char -> 0 FALSE, 1 TRUE
-char contains(const void* data, arl* ar, char (*comparator)(const void* arg1, const void* arg2));
+char contains_arl(const void* data, arl* ar, char (*comparator)(const void* arg1, const void* arg2));
 
 // Gets data at index, returning a deep copy, REMEMBER TO FREE!!!
-void* get_deep(int index, arl* ar);
+// NULL if index is not in 0..size-1, for get_shallow_arl too
+void* get_deep_arl(int index, arl* ar);
 
 // Gets data at index, returning a shallow copy,
 // REMEMBER: CHANGES MADE TO IT WILL BE REFLECTED IN THE ARRAY LIST
-void* get_shallow(int index, arl* ar);
+void* get_shallow_arl(int index, arl* ar);
+
+// Doubles the capacity in place and returns ar
+arl* upsize_arl(arl* ar);
+
+// Halves the capacity in place, dropping the elements that no longer fit, and returns ar
+arl* downsize_arl(arl* ar);
+
+// Replaces the list's growth policy, ARL_DEFAULT_POLICY to begin with
+// The new policy takes effect on the next grow or delete_arl, ar->stats keeps counting
+// Returns char -> 0 FAILED (invalid policy, see growth_policy.h), 1 OK
+char set_policy_arl(growth_policy policy, arl* ar);
+
+// Builds (or rebuilds) a hash index of the elements so byte-wise contains_arl is O(1)
+// append_arl, replace_arl, delete_arl and downsize_arl keep it up to date,
+// writes through get_shallow_arl pointers do not, rebuild it after those
+// Returns char -> 0 FAILED (no index kept), 1 OK
+char index_arl(arl* ar);
+
+// Frees the list's index, if any
+void drop_index_arl(arl* ar);
 
-// Frees old ar and returns new ar twice the size
-arl* upsize(arl* ar);
+// Writes the elements to path as a checksummed stream (see vector_io.h)
+// append adds them to the stream already there instead of replacing it
+// Returns char -> 0 FAILED, 1 OK
+char save_arl(const char* path, char append, arl* ar);
 
-// Frees old ar and returns new ar twice as small
-arl* downsize(arl* ar);
+// Reads the stream at path into a new list, packed or boxed, one chunk at a time
+// NULL if the stream is missing, corrupt or holds elements of another size
+arl* load_arl(const char* path, size_t data_size, char packed);
 
 // Frees array list
 void free_arl(arl* ar);
@@ -0,0 +1,275 @@
+/**
+ * @file bench.c
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Benchmark driver for the vector and array list operations. Every
+ * (container, operation, component type, size) case is warmed up, timed
+ * over several repetitions and summarized as ns/op and GB/s. A table goes
+ * to stdout; -o also writes every row as CSV or JSON so runs on different
+ * commits can be diffed.
+ *
+ * ./bench opt. -n [MAX_SIZE|10-10^8] -r [REPS] -w [WARMUPS] -o [FILE] -f [csv|json] -c [CONTAINER]
+ * @version 0.1
+ * @date 2022-08-06
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MIN_SIZE 10
+#define MAX_SIZE 100000000
+
+volatile size_t bench_sink = 0;
+
+// Component types, by name and size
+typedef struct elem_type {
+
+    const char* name;
+    size_t size;
+} elem_type;
+
+static const elem_type types[] = {
+    { "char", sizeof(char) },
+    { "int_32", 4 },
+    { "int_64", 8 },
+    { "float", sizeof(float) },
+    { "double", sizeof(double) },
+};
+
+// Summary of one case over every repetition
+typedef struct result {
+
+    const bench_op* op;
+    const elem_type* type;
+    size_t n;
+    size_t ops;
+    size_t bytes;
+    // Per operation
+    double ns_median;
+    double ns_min;
+    double ns_mean;
+    double ns_stddev;
+    double gb_per_s;
+} result;
+
+typedef enum { OUT_CSV, OUT_JSON } out_format;
+
+// Command line settings
+static size_t max_size = 1000000;
+static int reps = 5;
+static int warmups = 1;
+static const char* out_path = NULL;
+static out_format format = OUT_CSV;
+static const char* only_container = NULL;
+
+// ===================== HELPERS =====================
+
+static int compare_doubles(const void* arg1, const void* arg2) {
+
+    double a = *(const double*)arg1, b = *(const double*)arg2;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Warms up and times one case, reps times.
+ *
+ * @return false if the case could not allocate its container.
+ */
+static bool measure(const bench_op* op, const elem_type* type, size_t n, result* r) {
+
+    bench_sample sample;
+    for (int i = 0; i < warmups; i++)
+        if (!op->run(n, type->size, &sample)) return false;
+
+    double* ns = malloc(sizeof(double) * reps);
+    if (ns == NULL) return false;
+
+    for (int i = 0; i < reps; i++) {
+
+        if (!op->run(n, type->size, &sample)) {
+
+            free(ns);
+            return false;
+        }
+
+        ns[i] = sample.ns / (double)sample.ops;
+    }
+
+    qsort(ns, reps, sizeof(double), compare_doubles);
+
+    double sum = 0.0, sq = 0.0;
+    for (int i = 0; i < reps; i++) sum += ns[i];
+    double mean = sum / reps;
+    for (int i = 0; i < reps; i++) sq += (ns[i] - mean) * (ns[i] - mean);
+
+    r->op = op;
+    r->type = type;
+    r->n = n;
+    r->ops = sample.ops;
+    r->bytes = sample.bytes;
+    r->ns_median = reps % 2 ? ns[reps / 2] : (ns[reps / 2 - 1] + ns[reps / 2]) / 2.0;
+    r->ns_min = ns[0];
+    r->ns_mean = mean;
+    r->ns_stddev = reps > 1 ? sqrt(sq / (reps - 1)) : 0.0;
+    // Bytes per ns is GB/s
+    r->gb_per_s = (double)sample.bytes / sample.ops / r->ns_median;
+
+    free(ns);
+    return true;
+}
+
+static void print_row(const result* r) {
+
+    printf("%-11s %-16s %-7s %10zu %12.2f ns/op %9.3f GB/s (min %.2f, +/- %.1f%%)\n",
+           r->op->container, r->op->name, r->type->name, r->n, r->ns_median, r->gb_per_s,
+           r->ns_min, r->ns_mean > 0.0 ? 100.0 * r->ns_stddev / r->ns_mean : 0.0);
+}
+
+static void write_csv(FILE* f, const result* results, size_t count) {
+
+    fprintf(f, "container,op,type,elem_size,n,reps,ops,bytes,ns_op_median,ns_op_min,ns_op_mean,ns_op_stddev,gb_s\n");
+
+    for (size_t i = 0; i < count; i++) {
+
+        const result* r = &results[i];
+        fprintf(f, "%s,%s,%s,%zu,%zu,%d,%zu,%zu,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                r->op->container, r->op->name, r->type->name, r->type->size, r->n, reps,
+                r->ops, r->bytes, r->ns_median, r->ns_min, r->ns_mean, r->ns_stddev, r->gb_per_s);
+    }
+}
+
+static void write_json(FILE* f, const result* results, size_t count) {
+
+    fprintf(f, "{\n  \"compiler\": \"%s\",\n  \"reps\": %d,\n  \"warmups\": %d,\n  \"results\": [\n",
+            __VERSION__, reps, warmups);
+
+    for (size_t i = 0; i < count; i++) {
+
+        const result* r = &results[i];
+        fprintf(f, "    {\"container\": \"%s\", \"op\": \"%s\", \"type\": \"%s\", \"elem_size\": %zu, "
+                   "\"n\": %zu, \"ops\": %zu, \"bytes\": %zu, \"ns_op_median\": %.4f, \"ns_op_min\": %.4f, "
+                   "\"ns_op_mean\": %.4f, \"ns_op_stddev\": %.4f, \"gb_s\": %.4f}%s\n",
+                r->op->container, r->op->name, r->type->name, r->type->size, r->n, r->ops, r->bytes,
+                r->ns_median, r->ns_min, r->ns_mean, r->ns_stddev, r->gb_per_s, i + 1 < count ? "," : "");
+    }
+
+    fprintf(f, "  ]\n}\n");
+}
+
+static bool parse_args(int argc, char* argv[]) {
+
+    int opt = -1;
+    while ((opt = getopt(argc, argv, "n:r:w:o:f:c:")) != -1) {
+
+        switch (opt) {
+
+            case 'n':
+
+                max_size = strtoull(optarg, NULL, 10);
+                if (max_size < MIN_SIZE || max_size > MAX_SIZE) return false;
+                break;
+
+            case 'r':
+
+                reps = atoi(optarg);
+                if (reps < 1) return false;
+                break;
+
+            case 'w':
+
+                warmups = atoi(optarg);
+                if (warmups < 0) return false;
+                break;
+
+            case 'o':
+
+                out_path = optarg;
+                break;
+
+            case 'f':
+
+                if (strcmp(optarg, "csv") == 0) format = OUT_CSV;
+                else if (strcmp(optarg, "json") == 0) format = OUT_JSON;
+                else return false;
+                break;
+
+            case 'c':
+
+                only_container = optarg;
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return optind == argc;
+}
+
+// ===================== MAIN =====================
+
+int main(int argc, char* argv[]) {
+
+    if (!parse_args(argc, argv)) {
+
+        printf("\nINVALID FORMAT:\n\t./bench opt. -n [MAX_SIZE|10-10^8] -r [REPS] -w [WARMUPS] "
+               "-o [FILE] -f [csv|json] -c [vec|arl|arl_packed]\n");
+        exit(-1);
+    }
+
+    const bench_op* tables[] = { vector_ops, array_list_ops };
+    const size_t counts[] = { vector_ops_count, array_list_ops_count };
+
+    // Decades from MIN_SIZE up to max_size
+    size_t sizes = 0;
+    for (size_t n = MIN_SIZE; n <= max_size; n *= 10) sizes++;
+
+    size_t capacity = (vector_ops_count + array_list_ops_count) * (sizeof(types) / sizeof(types[0])) * sizes;
+    result* results = malloc(sizeof(result) * capacity);
+    if (results == NULL) return -1;
+
+    size_t count = 0;
+    for (size_t t = 0; t < sizeof(tables) / sizeof(tables[0]); t++)
+        for (size_t o = 0; o < counts[t]; o++) {
+
+            const bench_op* op = &tables[t][o];
+            if (only_container != NULL && strcmp(only_container, op->container) != 0) continue;
+
+            for (size_t e = 0; e < sizeof(types) / sizeof(types[0]); e++)
+                for (size_t n = MIN_SIZE; n <= max_size; n *= 10) {
+
+                    if (!measure(op, &types[e], n, &results[count])) {
+
+                        fprintf(stderr, "SKIPPED %s %s %s %zu: out of memory\n", op->container, op->name, types[e].name, n);
+                        continue;
+                    }
+
+                    print_row(&results[count++]);
+                    fflush(stdout);
+                }
+        }
+
+    if (out_path != NULL) {
+
+        FILE* f = fopen(out_path, "w");
+        if (f == NULL) {
+
+            fprintf(stderr, "COULD NOT OPEN %s\n", out_path);
+            free(results);
+            return -1;
+        }
+
+        if (format == OUT_JSON) write_json(f, results, count);
+        else write_csv(f, results, count);
+        fclose(f);
+    }
+
+    free(results);
+    return 0;
+}
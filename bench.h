@@ -0,0 +1,73 @@
+/**
+ * @file bench.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Shared pieces of the benchmark driver. Each container's operations
+ * live in their own file (bench_vector.c, bench_array_list.c) and are
+ * handed to bench.c as tables of bench_op.
+ * @version 0.1
+ * @date 2022-08-06
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+
+// Lookups timed per contains repetition, each one a full scan (the needle is never there)
+#define BENCH_LOOKUPS 8
+// upsize + downsize pairs timed per repetition
+#define BENCH_RESIZE_CYCLES 8
+
+/**
+ * @brief One timed repetition:
+ * - double ns: Nanoseconds spent in the timed section.
+ * - size_t ops: Operations performed in it.
+ * - size_t bytes: Component bytes those operations read or wrote.
+ */
+typedef struct bench_sample {
+
+    double ns;
+    size_t ops;
+    size_t bytes;
+} bench_sample;
+
+/**
+ * @brief A benchmarked operation. run builds its container untimed, times
+ * the operation on n components of elem_size bytes, frees everything and
+ * fills out. Returns false if an allocation failed.
+ */
+typedef struct bench_op {
+
+    const char* container;
+    const char* name;
+    bool (*run)(size_t n, size_t elem_size, bench_sample* out);
+} bench_op;
+
+extern const bench_op vector_ops[];
+extern const size_t vector_ops_count;
+extern const bench_op array_list_ops[];
+extern const size_t array_list_ops_count;
+
+// Results are folded into this so the compiler cannot drop the timed work
+extern volatile size_t bench_sink;
+
+// ===================== HELPERS =====================
+
+static inline double bench_now_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Component i of a run: bytes cycle through 0..250, so an all-0xFF needle never matches
+static inline void bench_element(unsigned char* elem, size_t elem_size, size_t i) {
+    for (size_t b = 0; b < elem_size; b++) elem[b] = (unsigned char)((i + b) % 251);
+}
+
+#endif
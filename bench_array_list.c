@@ -0,0 +1,296 @@
+/**
+ * Benchmarks for the array list operations, in both storage modes.
+ * See bench.h.
+ * @author Alejandro Ciuba
+ */
+
+#include "bench.h"
+#include "array_list.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest component the driver asks for
+#define MAX_ELEM 8
+
+// contains_arl() only hands the comparator two pointers
+static size_t compared_size = 0;
+
+// ===================== HELPERS =====================
+
+static char compare_bytes(const void* arg1, const void* arg2) {
+    return (char)(memcmp(arg1, arg2, compared_size) != 0);
+}
+
+static arl* make(bool packed, size_t elem_size) {
+    return packed ? init_arl_packed(1, elem_size) : init_arl(1, elem_size);
+}
+
+// List of n components built with append_arl, NULL if it could not be
+static arl* filled(bool packed, size_t n, size_t elem_size) {
+
+    if (n > INT_MAX / 2) return NULL;
+
+    arl* ar = make(packed, elem_size);
+    unsigned char elem[MAX_ELEM];
+
+    for (size_t i = 0; ar != NULL && i < n; i++) {
+
+        bench_element(elem, elem_size, i);
+        ar = append_arl(elem, ar);
+    }
+
+    if (ar != NULL && (size_t)ar->size != n) {
+
+        free_arl(ar);
+        return NULL;
+    }
+
+    return ar;
+}
+
+// ===================== OPERATIONS =====================
+
+static bool run_append(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    if (n > INT_MAX / 2) return false;
+
+    arl* ar = make(packed, elem_size);
+    if (ar == NULL) return false;
+
+    unsigned char elem[MAX_ELEM];
+    bench_element(elem, elem_size, 0);
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) ar = append_arl(elem, ar);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bool ok = (size_t)ar->size == n;
+    bench_sink += (size_t)ar->size;
+    free_arl(ar);
+
+    return ok;
+}
+
+static bool run_append_n(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    if (n > INT_MAX / 2) return false;
+
+    arl* ar = make(packed, elem_size);
+    unsigned char* src = malloc(n * elem_size);
+    if (ar == NULL || src == NULL) {
+
+        free_arl(ar);
+        free(src);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) bench_element(src + i * elem_size, elem_size, i);
+
+    double start = bench_now_ns();
+    ar = append_n_arl(src, (int)n, ar);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bool ok = (size_t)ar->size == n;
+    bench_sink += (size_t)ar->size;
+    free_arl(ar);
+    free(src);
+
+    return ok;
+}
+
+static bool run_replace(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL) return false;
+
+    unsigned char elem[MAX_ELEM];
+    bench_element(elem, elem_size, 7);
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) ar = replace_arl(elem, (int)i, ar);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += *(unsigned char*)get_shallow_arl((int)n - 1, ar);
+    free_arl(ar);
+
+    return true;
+}
+
+static bool run_contains(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL) return false;
+
+    unsigned char needle[MAX_ELEM];
+    memset(needle, 0xFF, sizeof(needle));
+    compared_size = elem_size;
+
+    size_t found = 0;
+    double start = bench_now_ns();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) found += (size_t)contains_arl(needle, ar, compare_bytes);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = BENCH_LOOKUPS;
+    out->bytes = BENCH_LOOKUPS * n * elem_size;
+    bench_sink += found;
+    free_arl(ar);
+
+    return true;
+}
+
+static bool run_contains_indexed(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL || !index_arl(ar)) {
+
+        free_arl(ar);
+        return false;
+    }
+
+    unsigned char needle[MAX_ELEM];
+    memset(needle, 0xFF, sizeof(needle));
+
+    size_t found = 0;
+    double start = bench_now_ns();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) found += (size_t)contains_arl(needle, ar, NULL);
+    out->ns = bench_now_ns() - start;
+
+    // A probe only touches the needle's bytes
+    out->ops = BENCH_LOOKUPS;
+    out->bytes = BENCH_LOOKUPS * elem_size;
+    bench_sink += found;
+    free_arl(ar);
+
+    return true;
+}
+
+static bool run_get_deep(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL) return false;
+
+    size_t sum = 0;
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+
+        unsigned char* copy = get_deep_arl((int)i, ar);
+        sum += copy[0];
+        free(copy);
+    }
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += sum;
+    free_arl(ar);
+
+    return true;
+}
+
+static bool run_resize(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL) return false;
+
+    double start = bench_now_ns();
+    for (int i = 0; i < BENCH_RESIZE_CYCLES; i++) ar = downsize_arl(upsize_arl(ar));
+    out->ns = bench_now_ns() - start;
+
+    out->ops = 2 * BENCH_RESIZE_CYCLES;
+    out->bytes = 2 * BENCH_RESIZE_CYCLES * n * elem_size;
+    bool ok = (size_t)ar->size == n;
+    bench_sink += (size_t)ar->capacity;
+    free_arl(ar);
+
+    return ok;
+}
+
+// Pops from the back, so every delete_arl is O(1) plus the occasional downsize_arl
+static bool run_delete(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL) return false;
+
+    double start = bench_now_ns();
+    for (size_t i = n; i > 0; i--) ar = delete_arl((int)i - 1, ar);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += (size_t)ar->size;
+    free_arl(ar);
+
+    return true;
+}
+
+// Appends and deletes at the back of a full list, right where it has to grow
+// Measures how often the growth policy reallocates on a queue-like workload
+static bool run_churn(bool packed, size_t n, size_t elem_size, bench_sample* out) {
+
+    arl* ar = filled(packed, n, elem_size);
+    if (ar == NULL) return false;
+
+    unsigned char elem[MAX_ELEM];
+    bench_element(elem, elem_size, 0);
+    while (ar->size < ar->capacity) ar = append_arl(elem, ar);
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+
+        ar = append_arl(elem, ar);
+        ar = delete_arl(ar->size - 1, ar);
+    }
+    out->ns = bench_now_ns() - start;
+
+    out->ops = 2 * n;
+    out->bytes = 2 * n * elem_size;
+    bench_sink += ar->stats.grows + ar->stats.shrinks;
+    free_arl(ar);
+
+    return true;
+}
+
+// One wrapper per (operation, storage mode) pair
+#define BENCH_MODES(op) \
+static bool op##_boxed(size_t n, size_t elem_size, bench_sample* out) { return run_##op(false, n, elem_size, out); } \
+static bool op##_packed(size_t n, size_t elem_size, bench_sample* out) { return run_##op(true, n, elem_size, out); }
+
+BENCH_MODES(append)
+BENCH_MODES(append_n)
+BENCH_MODES(replace)
+BENCH_MODES(contains)
+BENCH_MODES(contains_indexed)
+BENCH_MODES(get_deep)
+BENCH_MODES(resize)
+BENCH_MODES(delete)
+BENCH_MODES(churn)
+
+const bench_op array_list_ops[] = {
+    { "arl", "append", append_boxed },
+    { "arl", "append_n", append_n_boxed },
+    { "arl", "replace", replace_boxed },
+    { "arl", "contains", contains_boxed },
+    { "arl", "contains_indexed", contains_indexed_boxed },
+    { "arl", "get_deep", get_deep_boxed },
+    { "arl", "upsize_downsize", resize_boxed },
+    { "arl", "delete", delete_boxed },
+    { "arl", "churn", churn_boxed },
+    { "arl_packed", "append", append_packed },
+    { "arl_packed", "append_n", append_n_packed },
+    { "arl_packed", "replace", replace_packed },
+    { "arl_packed", "contains", contains_packed },
+    { "arl_packed", "contains_indexed", contains_indexed_packed },
+    { "arl_packed", "get_deep", get_deep_packed },
+    { "arl_packed", "upsize_downsize", resize_packed },
+    { "arl_packed", "delete", delete_packed },
+    { "arl_packed", "churn", churn_packed },
+};
+
+const size_t array_list_ops_count = sizeof(array_list_ops) / sizeof(array_list_ops[0]);
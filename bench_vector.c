@@ -0,0 +1,203 @@
+/**
+ * Benchmarks for the vector operations, see bench.h.
+ * @author Alejandro Ciuba
+ */
+
+#include "bench.h"
+#include "vector.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Largest component the driver asks for
+#define MAX_ELEM 8
+
+// ===================== HELPERS =====================
+
+// Vector of n components built with append, NULL if it could not be
+static vec_void* filled(size_t n, size_t elem_size) {
+
+    vec_void* v = init_vec(0, elem_size, false);
+    if (v == NULL || !reserve_vec(v, n, elem_size)) {
+
+        free_vec(v);
+        return NULL;
+    }
+
+    unsigned char elem[MAX_ELEM];
+    for (size_t i = 0; i < n; i++) {
+
+        bench_element(elem, elem_size, i);
+        append_vec(v, elem, elem_size);
+    }
+
+    return v;
+}
+
+// ===================== OPERATIONS =====================
+
+static bool bench_append(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = init_vec(0, elem_size, false);
+    if (v == NULL) return false;
+
+    unsigned char elem[MAX_ELEM];
+    bench_element(elem, elem_size, 0);
+
+    bool ok = true;
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) ok &= append_vec(v, elem, elem_size);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += v->size;
+    free_vec(v);
+
+    return ok;
+}
+
+static bool bench_append_n(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = init_vec(0, elem_size, false);
+    unsigned char* src = malloc(n * elem_size);
+    if (v == NULL || src == NULL) {
+
+        free_vec(v);
+        free(src);
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) bench_element(src + i * elem_size, elem_size, i);
+
+    double start = bench_now_ns();
+    bool ok = append_n_vec(v, src, n, elem_size);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += v->size;
+    free_vec(v);
+    free(src);
+
+    return ok;
+}
+
+static bool bench_replace(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = filled(n, elem_size);
+    if (v == NULL) return false;
+
+    unsigned char elem[MAX_ELEM];
+    bench_element(elem, elem_size, 7);
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) replace_vec(v, i, elem, elem_size);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += ((unsigned char*)v->array)[n - 1];
+    free_vec(v);
+
+    return true;
+}
+
+static bool bench_contains(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = filled(n, elem_size);
+    if (v == NULL) return false;
+
+    unsigned char needle[MAX_ELEM];
+    memset(needle, 0xFF, sizeof(needle));
+
+    size_t found = 0;
+    double start = bench_now_ns();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) found += contains_vec(v, needle, elem_size, NULL);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = BENCH_LOOKUPS;
+    out->bytes = BENCH_LOOKUPS * n * elem_size;
+    bench_sink += found;
+    free_vec(v);
+
+    return true;
+}
+
+static bool bench_contains_indexed(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = filled(n, elem_size);
+    if (v == NULL || !build_index_vec(v, elem_size)) {
+
+        free_vec(v);
+        return false;
+    }
+
+    unsigned char needle[MAX_ELEM];
+    memset(needle, 0xFF, sizeof(needle));
+
+    size_t found = 0;
+    double start = bench_now_ns();
+    for (int i = 0; i < BENCH_LOOKUPS; i++) found += contains_vec(v, needle, elem_size, NULL);
+    out->ns = bench_now_ns() - start;
+
+    // A probe only touches the needle's bytes
+    out->ops = BENCH_LOOKUPS;
+    out->bytes = BENCH_LOOKUPS * elem_size;
+    bench_sink += found;
+    free_vec(v);
+
+    return true;
+}
+
+static bool bench_get_deep(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = filled(n, elem_size);
+    if (v == NULL) return false;
+
+    size_t sum = 0;
+    double start = bench_now_ns();
+    for (size_t i = 0; i < n; i++) {
+
+        unsigned char* copy = get_deep_vec(v, i, elem_size);
+        sum += copy[0];
+        free(copy);
+    }
+    out->ns = bench_now_ns() - start;
+
+    out->ops = n;
+    out->bytes = n * elem_size;
+    bench_sink += sum;
+    free_vec(v);
+
+    return true;
+}
+
+static bool bench_resize(size_t n, size_t elem_size, bench_sample* out) {
+
+    vec_void* v = filled(n, elem_size);
+    if (v == NULL) return false;
+
+    bool ok = true;
+    double start = bench_now_ns();
+    for (int i = 0; i < BENCH_RESIZE_CYCLES; i++) ok &= upsize_vec(v, elem_size) && downsize_vec(v, elem_size);
+    out->ns = bench_now_ns() - start;
+
+    out->ops = 2 * BENCH_RESIZE_CYCLES;
+    out->bytes = 2 * BENCH_RESIZE_CYCLES * n * elem_size;
+    bench_sink += v->capacity;
+    free_vec(v);
+
+    return ok;
+}
+
+const bench_op vector_ops[] = {
+    { "vec", "append", bench_append },
+    { "vec", "append_n", bench_append_n },
+    { "vec", "replace", bench_replace },
+    { "vec", "contains", bench_contains },
+    { "vec", "contains_indexed", bench_contains_indexed },
+    { "vec", "get_deep", bench_get_deep },
+    { "vec", "upsize_downsize", bench_resize },
+};
+
+const size_t vector_ops_count = sizeof(vector_ops) / sizeof(vector_ops[0]);
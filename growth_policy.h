@@ -0,0 +1,109 @@
+/**
+ * @file growth_policy.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief When vectors and array lists grow and shrink on their own, and
+ * how many times they did. Growing multiplies the capacity by a factor;
+ * shrinking only kicks in once the container is down to 1/shrink_divisor
+ * of its capacity and undoes one growth step at a time. With a divisor
+ * larger than the factor a container that just shrank is still far from
+ * full (and one that just grew far from empty), so add/remove oscillation
+ * around a boundary does not reallocate on every operation.
+ * @version 0.1
+ * @date 2022-08-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef GROWTH_POLICY_H
+#define GROWTH_POLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief A container's growth policy:
+ * - unsigned growth_percent: New capacity in percent of the old one when
+ *   full, > 100 (200 doubles).
+ * - unsigned shrink_divisor: Shrink once size <= capacity / shrink_divisor.
+ *   0 never shrinks; otherwise it must be larger than the growth factor
+ *   (shrink_divisor * 100 > growth_percent), or the container would thrash.
+ * - size_t min_capacity: Growing goes straight to at least this many
+ *   components, shrinking never goes below it.
+ */
+typedef struct growth_policy {
+
+    unsigned growth_percent;
+    unsigned shrink_divisor;
+    size_t min_capacity;
+} growth_policy;
+
+/**
+ * @brief How many times a container changed its capacity. Every resize is
+ * one realloc (or arena_realloc), whether it was asked for or automatic.
+ * Reset it by zeroing it.
+ */
+typedef struct resize_stats {
+
+    size_t grows;
+    size_t shrinks;
+} resize_stats;
+
+/**
+ * @brief Whether p is a usable policy (see growth_policy above).
+ *
+ * @param p Policy to check.
+ * @return bool
+ */
+static inline bool growth_policy_valid(growth_policy p) {
+    return p.growth_percent > 100 && (p.shrink_divisor == 0 || (size_t)p.shrink_divisor * 100 > p.growth_percent);
+}
+
+/**
+ * @brief Capacity to grow to from capacity so that need components fit:
+ * one growth step, min_capacity or need, whichever is largest.
+ *
+ * @param p A valid policy.
+ * @param capacity Current capacity.
+ * @param need Components that have to fit.
+ * @return size_t SIZE_MAX if the step overflows.
+ */
+static inline size_t policy_grow(growth_policy p, size_t capacity, size_t need) {
+
+    size_t grown = capacity > SIZE_MAX / p.growth_percent ? SIZE_MAX : capacity * p.growth_percent / 100;
+
+    // Small capacities and factors can round down to no growth at all
+    if (grown <= capacity && capacity < SIZE_MAX) grown = capacity + 1;
+    if (grown < p.min_capacity) grown = p.min_capacity;
+
+    return grown < need ? need : grown;
+}
+
+/**
+ * @brief Capacity to shrink to with size components in use: as many growth
+ * steps undone as it takes for size to be above capacity / shrink_divisor
+ * again, so a large erase still costs a single resize.
+ *
+ * @param p A valid policy.
+ * @param size Components in use.
+ * @param capacity Current capacity.
+ * @return size_t capacity itself if no shrinking is due.
+ */
+static inline size_t policy_shrink(growth_policy p, size_t size, size_t capacity) {
+
+    if (p.shrink_divisor == 0) return capacity;
+
+    while (capacity > p.min_capacity && size <= capacity / p.shrink_divisor) {
+
+        size_t next = capacity > SIZE_MAX / 100 ? capacity / p.growth_percent * 100 : capacity * 100 / p.growth_percent;
+        if (next < p.min_capacity) next = p.min_capacity;
+        if (next >= capacity || next < size) break;
+
+        capacity = next;
+    }
+
+    return capacity;
+}
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ * Hash multiset of fixed-size keys for contains() lookups.
+ * Linear probing with backward-shift deletion.
+ * @author Alejandro Ciuba
+ */
+
+#include "hash_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest table allocated, in slots
+#define MIN_SLOTS 16
+// Grow once the table is 70% full
+#define MAX_LOAD_NUM 7
+#define MAX_LOAD_DEN 10
+
+// ===================== HELPERS =====================
+
+// Murmur3 finalizer
+static uint64_t mix(uint64_t h) {
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+// Hash of key_size bytes, taken 8 at a time; never 0, which marks empty slots
+static uint64_t hash_key(const void* key, size_t key_size) {
+
+    const unsigned char* bytes = (const unsigned char*)key;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ key_size;
+    size_t i = 0;
+
+    for (; i + 8 <= key_size; i += 8) {
+
+        uint64_t chunk;
+        memcpy(&chunk, bytes + i, 8);
+        h = mix(h ^ chunk) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    if (i < key_size) {
+
+        uint64_t chunk = 0;
+        memcpy(&chunk, bytes + i, key_size - i);
+        h = mix(h ^ chunk) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    h = mix(h);
+    return h == 0 ? 1 : h;
+}
+
+static unsigned char* key_at(const hash_index* h, size_t slot) {
+    return h->keys + slot * h->key_size;
+}
+
+// Slot holding key, or the empty slot where it would go
+static size_t find_slot(const hash_index* h, const void* key, uint64_t hash) {
+
+    size_t mask = h->capacity - 1;
+    size_t slot = (size_t)hash & mask;
+
+    while (h->hashes[slot] != 0) {
+
+        if (h->hashes[slot] == hash && memcmp(key_at(h, slot), key, h->key_size) == 0) return slot;
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+// Rehashes every key into a table of capacity slots
+static bool rehash(hash_index* h, size_t capacity) {
+
+    if (capacity > SIZE_MAX / h->key_size || capacity > SIZE_MAX / sizeof(uint64_t)) return false;
+
+    uint64_t* hashes = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+    size_t* counts = (size_t*)malloc(capacity * sizeof(size_t));
+    unsigned char* keys = (unsigned char*)malloc(capacity * h->key_size);
+    if (hashes == NULL || counts == NULL || keys == NULL) {
+
+        free(hashes);
+        free(counts);
+        free(keys);
+        return false;
+    }
+
+    hash_index grown = { h->key_size, capacity, h->used, hashes, counts, keys };
+
+    for (size_t i = 0; i < h->capacity; i++) {
+
+        if (h->hashes[i] == 0) continue;
+
+        size_t slot = find_slot(&grown, key_at(h, i), h->hashes[i]);
+        hashes[slot] = h->hashes[i];
+        counts[slot] = h->counts[i];
+        memcpy(key_at(&grown, slot), key_at(h, i), h->key_size);
+    }
+
+    free(h->hashes);
+    free(h->counts);
+    free(h->keys);
+    *h = grown;
+
+    return true;
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd, empty index.
+ *
+ * @param key_size Bytes per key (> 0).
+ * @param expected Number of keys to make room for up front (may be 0).
+ * @return hash_index* | NULL
+ */
+hash_index* init_hash_index(size_t key_size, size_t expected) {
+
+    if (key_size == 0) return NULL;
+
+    hash_index* h = (hash_index*)calloc(1, sizeof(hash_index));
+    if (h == NULL) return NULL;
+
+    h->key_size = key_size;
+    if (expected == 0) return h;
+
+    // Enough slots to stay under the load factor with expected keys
+    size_t capacity = MIN_SLOTS;
+    while (capacity / MAX_LOAD_DEN * MAX_LOAD_NUM < expected && capacity <= SIZE_MAX / 2) capacity *= 2;
+
+    if (!rehash(h, capacity)) {
+
+        free(h);
+        return NULL;
+    }
+
+    return h;
+}
+
+/**
+ * @brief Adds one copy of key.
+ *
+ * @param h Index.
+ * @param key key_size bytes.
+ * @return false if h or key is NULL, or the table could not grow.
+ */
+bool hash_index_insert(hash_index* h, const void* key) {
+
+    if (h == NULL || key == NULL) return false;
+
+    // Keep room for one more distinct key under the load factor
+    if ((h->used + 1) * MAX_LOAD_DEN > h->capacity * MAX_LOAD_NUM)
+        if (!rehash(h, h->capacity == 0 ? MIN_SLOTS : h->capacity * 2)) return false;
+
+    uint64_t hash = hash_key(key, h->key_size);
+    size_t slot = find_slot(h, key, hash);
+
+    if (h->hashes[slot] != 0) {
+
+        h->counts[slot]++;
+        return true;
+    }
+
+    h->hashes[slot] = hash;
+    h->counts[slot] = 1;
+    memcpy(key_at(h, slot), key, h->key_size);
+    h->used++;
+
+    return true;
+}
+
+/**
+ * @brief Removes one copy of key.
+ *
+ * @param h Index.
+ * @param key key_size bytes.
+ * @return false if key was not in h.
+ */
+bool hash_index_remove(hash_index* h, const void* key) {
+
+    if (h == NULL || key == NULL || h->used == 0) return false;
+
+    size_t slot = find_slot(h, key, hash_key(key, h->key_size));
+    if (h->hashes[slot] == 0) return false;
+    if (--h->counts[slot] > 0) return true;
+
+    // Last copy: pull later keys of the probe run back over the hole
+    size_t mask = h->capacity - 1;
+    size_t hole = slot;
+
+    for (size_t next = (hole + 1) & mask; h->hashes[next] != 0; next = (next + 1) & mask) {
+
+        size_t home = (size_t)h->hashes[next] & mask;
+
+        // Movable unless its home lies cyclically in (hole, next]
+        bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (stays) continue;
+
+        h->hashes[hole] = h->hashes[next];
+        h->counts[hole] = h->counts[next];
+        memcpy(key_at(h, hole), key_at(h, next), h->key_size);
+        hole = next;
+    }
+
+    h->hashes[hole] = 0;
+    h->used--;
+
+    return true;
+}
+
+/**
+ * @brief Number of copies of key in h.
+ *
+ * @param h Index. Returns 0 if NULL.
+ * @param key key_size bytes. Returns 0 if NULL.
+ * @return size_t
+ */
+size_t hash_index_count(const hash_index* h, const void* key) {
+
+    if (h == NULL || key == NULL || h->used == 0) return 0;
+
+    size_t slot = find_slot(h, key, hash_key(key, h->key_size));
+    return h->hashes[slot] == 0 ? 0 : h->counts[slot];
+}
+
+/**
+ * @brief Removes every key, keeping the table allocated.
+ *
+ * @param h Index.
+ */
+void clear_hash_index(hash_index* h) {
+
+    if (h == NULL || h->capacity == 0) return;
+
+    memset(h->hashes, 0, h->capacity * sizeof(uint64_t));
+    h->used = 0;
+}
+
+/**
+ * @brief Frees the index and its table.
+ *
+ * @param h Index to be freed.
+ */
+void free_hash_index(hash_index* h) {
+
+    if (h == NULL) return;
+
+    free(h->hashes);
+    free(h->counts);
+    free(h->keys);
+    free(h);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file hash_index.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Open-addressing hash multiset of fixed-size keys, compared byte
+ * by byte. Vectors and array lists can keep one next to their components
+ * (see build_index_vec and index_arl) so contains() becomes an O(1) probe
+ * instead of a linear scan.
+ * @version 0.1
+ * @date 2022-08-13
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief The index containing the following:
+ * - size_t key_size: Bytes per key.
+ * - size_t capacity: Number of slots, a power of 2 (0 until the first insert).
+ * - size_t used: Distinct keys stored.
+ * - uint64_t* hashes: Hash of every slot's key, 0 marks an empty slot.
+ * - size_t* counts: Copies of every slot's key in the container.
+ * - unsigned char* keys: The keys themselves, key_size bytes apart.
+ *
+ * Collisions are resolved by linear probing and removals shift the probe
+ * run back, so there are no tombstones to clean up.
+ */
+typedef struct hash_index {
+
+    size_t key_size;
+    size_t capacity;
+    size_t used;
+    uint64_t* hashes;
+    size_t* counts;
+    unsigned char* keys;
+} hash_index;
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd, empty index.
+ *
+ * @param key_size Bytes per key (> 0).
+ * @param expected Number of keys to make room for up front (may be 0).
+ * @return hash_index* | NULL
+ */
+hash_index* init_hash_index(size_t key_size, size_t expected);
+
+/**
+ * @brief Adds one copy of key.
+ *
+ * @param h Index.
+ * @param key key_size bytes.
+ * @return false if h or key is NULL, or the table could not grow.
+ */
+bool hash_index_insert(hash_index* h, const void* key);
+
+/**
+ * @brief Removes one copy of key.
+ *
+ * @param h Index.
+ * @param key key_size bytes.
+ * @return false if key was not in h.
+ */
+bool hash_index_remove(hash_index* h, const void* key);
+
+/**
+ * @brief Number of copies of key in h.
+ *
+ * @param h Index. Returns 0 if NULL.
+ * @param key key_size bytes. Returns 0 if NULL.
+ * @return size_t
+ */
+size_t hash_index_count(const hash_index* h, const void* key);
+
+/**
+ * @brief Removes every key, keeping the table allocated.
+ *
+ * @param h Index.
+ */
+void clear_hash_index(hash_index* h);
+
+/**
+ * @brief Frees the index and its table.
+ *
+ * @param h Index to be freed.
+ */
+void free_hash_index(hash_index* h);
+
+#endif
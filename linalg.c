@@ -0,0 +1,320 @@
+/**
+ * Blocked LU, Cholesky and triangular solves.
+ * Diagonal blocks are handled with row-wise level-2 loops (every inner
+ * loop runs along a row), off-diagonal blocks with gemm_f64.
+ * @author Alejandro Ciuba
+ */
+
+#include "linalg.h"
+#include "vector_math.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Component (i, j) of op(A)
+#define OP_AT(a, lda, t, i, j) ((t) ? (a)[(j) * (lda) + (i)] : (a)[(i) * (lda) + (j)])
+
+static size_t min_size(size_t a, size_t b) { return a < b ? a : b; }
+
+static void swap_rows(double* x, double* y, size_t n) {
+
+    for (size_t j = 0; j < n; j++) {
+
+        double tmp = x[j];
+        x[j] = y[j];
+        y[j] = tmp;
+    }
+}
+
+// ===================== TRIANGULAR SOLVES =====================
+
+/**
+ * @brief Unblocked solve of the w x w diagonal block of op(A) at (k, k)
+ * against rows [k, k + w) of B. Rows are indexed from the start of both
+ * a and b.
+ *
+ * @param forward op(A) is lower triangular.
+ */
+static void trsm_block(bool forward, bool transpose, bool unit, size_t k, size_t w, size_t nrhs,
+                       const double* a, size_t lda, double* b, size_t ldb) {
+
+    for (size_t s = 0; s < w; s++) {
+
+        size_t i = forward ? k + s : k + w - 1 - s;
+        double* bi = b + i * ldb;
+
+        if (forward)
+            for (size_t p = k; p < i; p++) axpy_f64(nrhs, -OP_AT(a, lda, transpose, i, p), b + p * ldb, bi);
+        else
+            for (size_t p = i + 1; p < k + w; p++) axpy_f64(nrhs, -OP_AT(a, lda, transpose, i, p), b + p * ldb, bi);
+
+        if (!unit) scale_f64(nrhs, 1.0 / a[i * lda + i], bi);
+    }
+}
+
+bool trsm_f64(tri_part part, bool transpose, bool unit, size_t n, size_t nrhs,
+              const double* a, size_t lda, double* b, size_t ldb) {
+
+    if (n == 0 || nrhs == 0) return true;
+
+    bool forward = (part == TRI_LOWER) != transpose;
+
+    // Off-diagonal blocks of a transposed op(A) are gathered here for GEMM
+    double* t = NULL;
+    if (transpose && n > LINALG_BLOCK) {
+
+        t = (double*)malloc(n * LINALG_BLOCK * sizeof(double));
+        if (t == NULL) return false;
+    }
+
+    bool ok = true;
+    for (size_t s = 0; ok && s < n; s += LINALG_BLOCK) {
+
+        size_t w = min_size(LINALG_BLOCK, n - s);
+        size_t k = forward ? s : n - s - w;
+        trsm_block(forward, transpose, unit, k, w, nrhs, a, lda, b, ldb);
+
+        // Rows still unsolved: below the block going forward, above it going back
+        size_t r0 = forward ? k + w : 0;
+        size_t rows = forward ? n - k - w : k;
+        if (rows == 0) continue;
+
+        // Their part of op(A) in columns [k, k + w)
+        const double* m = a + r0 * lda + k;
+        size_t ldm = lda;
+        if (transpose) {
+
+            for (size_t j = 0; j < w; j++)
+                for (size_t i = 0; i < rows; i++) t[i * w + j] = a[(k + j) * lda + r0 + i];
+
+            m = t;
+            ldm = w;
+        }
+
+        ok = gemm_f64(rows, nrhs, w, -1.0, m, ldm, b + k * ldb, ldb, 1.0, b + r0 * ldb, ldb);
+    }
+
+    free(t);
+    return ok;
+}
+
+// ===================== LU =====================
+
+bool lu_f64(size_t n, double* a, size_t lda, size_t* piv) {
+
+    for (size_t k = 0; k < n; k += LINALG_BLOCK) {
+
+        size_t w = min_size(LINALG_BLOCK, n - k);
+
+        // Panel: columns [k, k + w) of rows [k, n). Whole rows are swapped,
+        // which also applies the pivots to the left and right of the panel
+        for (size_t j = k; j < k + w; j++) {
+
+            size_t p = j;
+            double best = fabs(a[j * lda + j]);
+            for (size_t i = j + 1; i < n; i++) {
+
+                if (fabs(a[i * lda + j]) > best) {
+
+                    best = fabs(a[i * lda + j]);
+                    p = i;
+                }
+            }
+
+            piv[j] = p;
+            if (best == 0.0) return false;
+            if (p != j) swap_rows(a + j * lda, a + p * lda, n);
+
+            double inv = 1.0 / a[j * lda + j];
+            for (size_t i = j + 1; i < n; i++) {
+
+                double* ri = a + i * lda;
+                ri[j] *= inv;
+                axpy_f64(k + w - j - 1, -ri[j], a + j * lda + j + 1, ri + j + 1);
+            }
+        }
+
+        size_t rest = n - k - w;
+        if (rest == 0) break;
+
+        // U12 = L11^-1 A12, then A22 -= L21 U12
+        trsm_block(true, false, true, k, w, rest, a, lda, a + k + w, lda);
+        if (!gemm_f64(rest, rest, w, -1.0, a + (k + w) * lda + k, lda, a + k * lda + k + w, lda,
+                      1.0, a + (k + w) * lda + k + w, lda)) return false;
+    }
+
+    return true;
+}
+
+bool lu_solve_f64(size_t n, size_t nrhs, const double* lu, size_t ld, const size_t* piv, double* b, size_t ldb) {
+
+    for (size_t i = 0; i < n; i++)
+        if (piv[i] != i) swap_rows(b + i * ldb, b + piv[i] * ldb, nrhs);
+
+    return trsm_f64(TRI_LOWER, false, true, n, nrhs, lu, ld, b, ldb)
+        && trsm_f64(TRI_UPPER, false, false, n, nrhs, lu, ld, b, ldb);
+}
+
+// ===================== CHOLESKY =====================
+
+/**
+ * @brief Lower triangle of the w x w block at (r, c): a[i][j] -=
+ * dot(row i, row j) over the w2 columns starting at column k, finished
+ * as Cholesky columns when diag is set.
+ *
+ * @return false if diag is set and a pivot is not positive.
+ */
+static bool syrk_block(double* a, size_t lda, size_t r, size_t w, size_t k, size_t w2, bool diag) {
+
+    for (size_t i = r; i < r + w; i++) {
+
+        for (size_t j = r; j <= i; j++) {
+
+            // The diagonal block factors itself left-looking, dot over its own finished columns
+            size_t len = diag ? j - k : w2;
+            double s = a[i * lda + j] - dot_f64(a + i * lda + k, a + j * lda + k, len);
+
+            if (!diag) a[i * lda + j] = s;
+            else if (i != j) a[i * lda + j] = s / a[j * lda + j];
+            else if (s > 0.0) a[i * lda + i] = sqrt(s);
+            else return false;
+        }
+    }
+
+    return true;
+}
+
+bool cholesky_f64(size_t n, double* a, size_t lda) {
+
+    // L21^T of the current panel, the B operand of the trailing update
+    double* t = NULL;
+    if (n > LINALG_BLOCK) {
+
+        t = (double*)malloc(n * LINALG_BLOCK * sizeof(double));
+        if (t == NULL) return false;
+    }
+
+    bool ok = true;
+    for (size_t k = 0; ok && k < n; k += LINALG_BLOCK) {
+
+        size_t w = min_size(LINALG_BLOCK, n - k);
+        if (!(ok = syrk_block(a, lda, k, w, k, 0, true))) break;
+
+        size_t m = n - k - w;
+        if (m == 0) break;
+
+        // L21 = A21 L11^-T, one row at a time
+        for (size_t r = k + w; r < n; r++) {
+
+            double* ar = a + r * lda;
+            for (size_t j = k; j < k + w; j++)
+                ar[j] = (ar[j] - dot_f64(ar + k, a + j * lda + k, j - k)) / a[j * lda + j];
+        }
+
+        for (size_t r = 0; r < m; r++)
+            for (size_t j = 0; j < w; j++) t[j * m + r] = a[(k + w + r) * lda + k + j];
+
+        // A22 -= L21 L21^T on the lower triangle only: diagonal blocks with
+        // dots (so the upper triangle is never written), the rest with GEMM
+        for (size_t c = 0; ok && c < m; c += LINALG_BLOCK) {
+
+            size_t cw = min_size(LINALG_BLOCK, m - c);
+            size_t c0 = k + w + c;
+            syrk_block(a, lda, c0, cw, k, w, false);
+
+            if (c + cw < m)
+                ok = gemm_f64(m - c - cw, cw, w, -1.0, a + (c0 + cw) * lda + k, lda, t + c, m,
+                              1.0, a + (c0 + cw) * lda + c0, lda);
+        }
+    }
+
+    free(t);
+    return ok;
+}
+
+bool cholesky_solve_f64(size_t n, size_t nrhs, const double* l, size_t ld, double* b, size_t ldb) {
+
+    return trsm_f64(TRI_LOWER, false, false, n, nrhs, l, ld, b, ldb)
+        && trsm_f64(TRI_LOWER, true, false, n, nrhs, l, ld, b, ldb);
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Solves op(A) X = B in place (B becomes X), where A is triangular
+ * and op(A) is A or its transpose. Only the part triangle of A is read.
+ *
+ * @param part Triangle of A holding the matrix.
+ * @param transpose Solve with the transpose of A.
+ * @param unit The diagonal of A is taken as all ones (and not read).
+ * @param a Square triangular matrix.
+ * @param b Right-hand sides, one per column, b->rows == a->rows.
+ * @return false if a or b is NULL, the shapes do not match, or the
+ * scratch space could not be allocated (b is then partially solved).
+ */
+bool trsm_mat_double(tri_part part, bool transpose, bool unit, const mat_double* a, mat_double* b) {
+
+    if (a == NULL || b == NULL || a->rows != a->cols || b->rows != a->rows) return false;
+    return trsm_f64(part, transpose, unit, a->rows, b->cols, a->array, a->ld, b->array, b->ld);
+}
+
+/**
+ * @brief Factors P A = L U in place: L (unit diagonal, not stored) ends
+ * up below the diagonal of a and U on and above it. Row i was swapped
+ * with row piv[i] >= i at step i, in that order.
+ *
+ * @param a Square matrix, overwritten with L and U.
+ * @param piv Room for a->rows pivots.
+ * @return false if either is NULL, a is not square, a is singular (an
+ * exactly zero pivot column) or the GEMM buffers could not be allocated.
+ * a then holds a partial factorization.
+ */
+bool lu_mat_double(mat_double* a, size_t* piv) {
+
+    if (a == NULL || piv == NULL || a->rows != a->cols) return false;
+    return lu_f64(a->rows, a->array, a->ld, piv);
+}
+
+/**
+ * @brief Solves A X = B in place, given lu and piv from lu_mat_double.
+ *
+ * @param lu Factored matrix.
+ * @param piv Its pivots.
+ * @param b Right-hand sides, one per column, b->rows == lu->rows.
+ * @return false if any is NULL, the shapes do not match, or the scratch
+ * space could not be allocated.
+ */
+bool lu_solve_mat_double(const mat_double* lu, const size_t* piv, mat_double* b) {
+
+    if (lu == NULL || piv == NULL || b == NULL || lu->rows != lu->cols || b->rows != lu->rows) return false;
+    return lu_solve_f64(lu->rows, b->cols, lu->array, lu->ld, piv, b->array, b->ld);
+}
+
+/**
+ * @brief Factors A = L L^T in place for a symmetric positive definite A.
+ * Only the lower triangle is read and overwritten with L, the strict
+ * upper triangle is left as it was.
+ *
+ * @param a Square matrix.
+ * @return false if a is NULL, not square, not positive definite (a then
+ * holds a partial factorization), or the scratch space could not be
+ * allocated.
+ */
+bool cholesky_mat_double(mat_double* a) {
+
+    if (a == NULL || a->rows != a->cols) return false;
+    return cholesky_f64(a->rows, a->array, a->ld);
+}
+
+/**
+ * @brief Solves A X = B in place, given l from cholesky_mat_double.
+ *
+ * @param l Factored matrix.
+ * @param b Right-hand sides, one per column, b->rows == l->rows.
+ * @return false if either is NULL, the shapes do not match, or the
+ * scratch space could not be allocated.
+ */
+bool cholesky_solve_mat_double(const mat_double* l, mat_double* b) {
+
+    if (l == NULL || b == NULL || l->rows != l->cols || b->rows != l->rows) return false;
+    return cholesky_solve_f64(l->rows, b->cols, l->array, l->ld, b->array, b->ld);
+}
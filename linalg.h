@@ -0,0 +1,110 @@
+/**
+ * @file linalg.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Dense solvers for mat_double: LU with partial pivoting, Cholesky
+ * and triangular solves with many right-hand sides. The factorizations
+ * are blocked and right-looking: each LINALG_BLOCK-wide panel is factored
+ * with level-2 loops, then the whole trailing matrix is updated with one
+ * gemm_f64 call, so nearly all of the flops run at matmul speed (and on
+ * the thread pool) instead of streaming the matrix once per column.
+ * @version 0.1
+ * @date 2022-09-14
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef LINALG_H
+#define LINALG_H
+
+#include "matrix.h"
+
+// Panel width of the blocked factorizations and solves
+#define LINALG_BLOCK 64
+
+/**
+ * @brief Which triangle of a matrix a triangular solve reads.
+ */
+typedef enum {
+
+    TRI_LOWER,
+    TRI_UPPER
+} tri_part;
+
+// ===================== RAW =====================
+
+/**
+ * @brief Solvers over raw row-major arrays, for code that manages its
+ * own storage. Same semantics as the mat_double versions below, with
+ * n the order of A, nrhs the columns of B and lda/ldb leading dimensions.
+ */
+bool trsm_f64(tri_part part, bool transpose, bool unit, size_t n, size_t nrhs,
+              const double* a, size_t lda, double* b, size_t ldb);
+bool lu_f64(size_t n, double* a, size_t lda, size_t* piv);
+bool lu_solve_f64(size_t n, size_t nrhs, const double* lu, size_t ld, const size_t* piv, double* b, size_t ldb);
+bool cholesky_f64(size_t n, double* a, size_t lda);
+bool cholesky_solve_f64(size_t n, size_t nrhs, const double* l, size_t ld, double* b, size_t ldb);
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Solves op(A) X = B in place (B becomes X), where A is triangular
+ * and op(A) is A or its transpose. Only the part triangle of A is read.
+ *
+ * @param part Triangle of A holding the matrix.
+ * @param transpose Solve with the transpose of A.
+ * @param unit The diagonal of A is taken as all ones (and not read).
+ * @param a Square triangular matrix.
+ * @param b Right-hand sides, one per column, b->rows == a->rows.
+ * @return false if a or b is NULL, the shapes do not match, or the
+ * scratch space could not be allocated (b is then partially solved).
+ */
+bool trsm_mat_double(tri_part part, bool transpose, bool unit, const mat_double* a, mat_double* b);
+
+/**
+ * @brief Factors P A = L U in place: L (unit diagonal, not stored) ends
+ * up below the diagonal of a and U on and above it. Row i was swapped
+ * with row piv[i] >= i at step i, in that order.
+ *
+ * @param a Square matrix, overwritten with L and U.
+ * @param piv Room for a->rows pivots.
+ * @return false if either is NULL, a is not square, a is singular (an
+ * exactly zero pivot column) or the GEMM buffers could not be allocated.
+ * a then holds a partial factorization.
+ */
+bool lu_mat_double(mat_double* a, size_t* piv);
+
+/**
+ * @brief Solves A X = B in place, given lu and piv from lu_mat_double.
+ *
+ * @param lu Factored matrix.
+ * @param piv Its pivots.
+ * @param b Right-hand sides, one per column, b->rows == lu->rows.
+ * @return false if any is NULL, the shapes do not match, or the scratch
+ * space could not be allocated.
+ */
+bool lu_solve_mat_double(const mat_double* lu, const size_t* piv, mat_double* b);
+
+/**
+ * @brief Factors A = L L^T in place for a symmetric positive definite A.
+ * Only the lower triangle is read and overwritten with L, the strict
+ * upper triangle is left as it was.
+ *
+ * @param a Square matrix.
+ * @return false if a is NULL, not square, not positive definite (a then
+ * holds a partial factorization), or the scratch space could not be
+ * allocated.
+ */
+bool cholesky_mat_double(mat_double* a);
+
+/**
+ * @brief Solves A X = B in place, given l from cholesky_mat_double.
+ *
+ * @param l Factored matrix.
+ * @param b Right-hand sides, one per column, b->rows == l->rows.
+ * @return false if either is NULL, the shapes do not match, or the
+ * scratch space could not be allocated.
+ */
+bool cholesky_solve_mat_double(const mat_double* l, mat_double* b);
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * Dense matrices and blocked GEMM.
+ * The loop nest lives in matrix_gemm.h; this file supplies the
+ * register-tiled micro-kernels for each instruction set.
+ * @author Alejandro Ciuba
+ */
+
+#include "matrix.h"
+#include "vector_math.h"
+#include "thread_pool.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// ===================== GEMM TEMPLATES =====================
+
+// 6 x 16 floats: 12 ymm or 6 zmm accumulators
+#define T float
+#define SUFFIX f32
+#define MR 6
+#define NR 16
+#define MC 120
+#define KC 256
+#define NC 4096
+#include "matrix_gemm.h"
+
+// 6 x 8 doubles: 12 ymm or 6 zmm accumulators
+#define T double
+#define SUFFIX f64
+#define MR 6
+#define NR 8
+#define MC 120
+#define KC 256
+#define NC 4096
+#include "matrix_gemm.h"
+
+#ifdef SIMD_X86
+
+// ===================== AVX2 MICRO-KERNELS =====================
+
+// One k step of row i: broadcast a[i] against both halves of the B sliver
+#define F32_AVX2_STEP(i) \
+    ai = _mm256_broadcast_ss(a + i); \
+    c##i##0 = _mm256_fmadd_ps(ai, b0, c##i##0); \
+    c##i##1 = _mm256_fmadd_ps(ai, b1, c##i##1)
+
+#define F32_AVX2_STORE(i) \
+    _mm256_storeu_ps(c + i * ldc, _mm256_add_ps(_mm256_loadu_ps(c + i * ldc), c##i##0)); \
+    _mm256_storeu_ps(c + i * ldc + 8, _mm256_add_ps(_mm256_loadu_ps(c + i * ldc + 8), c##i##1))
+
+__attribute__((target("avx2,fma")))
+static void kernel_f32_avx2(size_t kc, const float* a, const float* b, float* c, size_t ldc) {
+
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    __m256 ai;
+
+    for (size_t p = 0; p < kc; p++, a += 6, b += 16) {
+
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+
+        F32_AVX2_STEP(0); F32_AVX2_STEP(1); F32_AVX2_STEP(2);
+        F32_AVX2_STEP(3); F32_AVX2_STEP(4); F32_AVX2_STEP(5);
+    }
+
+    F32_AVX2_STORE(0); F32_AVX2_STORE(1); F32_AVX2_STORE(2);
+    F32_AVX2_STORE(3); F32_AVX2_STORE(4); F32_AVX2_STORE(5);
+}
+
+#define F64_AVX2_STEP(i) \
+    ai = _mm256_broadcast_sd(a + i); \
+    c##i##0 = _mm256_fmadd_pd(ai, b0, c##i##0); \
+    c##i##1 = _mm256_fmadd_pd(ai, b1, c##i##1)
+
+#define F64_AVX2_STORE(i) \
+    _mm256_storeu_pd(c + i * ldc, _mm256_add_pd(_mm256_loadu_pd(c + i * ldc), c##i##0)); \
+    _mm256_storeu_pd(c + i * ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + i * ldc + 4), c##i##1))
+
+__attribute__((target("avx2,fma")))
+static void kernel_f64_avx2(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    __m256d ai;
+
+    for (size_t p = 0; p < kc; p++, a += 6, b += 8) {
+
+        __m256d b0 = _mm256_load_pd(b);
+        __m256d b1 = _mm256_load_pd(b + 4);
+
+        F64_AVX2_STEP(0); F64_AVX2_STEP(1); F64_AVX2_STEP(2);
+        F64_AVX2_STEP(3); F64_AVX2_STEP(4); F64_AVX2_STEP(5);
+    }
+
+    F64_AVX2_STORE(0); F64_AVX2_STORE(1); F64_AVX2_STORE(2);
+    F64_AVX2_STORE(3); F64_AVX2_STORE(4); F64_AVX2_STORE(5);
+}
+
+// ===================== AVX-512 MICRO-KERNELS =====================
+
+#define F32_AVX512_STEP(i) c##i = _mm512_fmadd_ps(_mm512_set1_ps(a[i]), b0, c##i)
+#define F32_AVX512_STORE(i) _mm512_storeu_ps(c + i * ldc, _mm512_add_ps(_mm512_loadu_ps(c + i * ldc), c##i))
+
+__attribute__((target("avx512f")))
+static void kernel_f32_avx512(size_t kc, const float* a, const float* b, float* c, size_t ldc) {
+
+    __m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps(), c2 = _mm512_setzero_ps();
+    __m512 c3 = _mm512_setzero_ps(), c4 = _mm512_setzero_ps(), c5 = _mm512_setzero_ps();
+
+    for (size_t p = 0; p < kc; p++, a += 6, b += 16) {
+
+        __m512 b0 = _mm512_load_ps(b);
+
+        F32_AVX512_STEP(0); F32_AVX512_STEP(1); F32_AVX512_STEP(2);
+        F32_AVX512_STEP(3); F32_AVX512_STEP(4); F32_AVX512_STEP(5);
+    }
+
+    F32_AVX512_STORE(0); F32_AVX512_STORE(1); F32_AVX512_STORE(2);
+    F32_AVX512_STORE(3); F32_AVX512_STORE(4); F32_AVX512_STORE(5);
+}
+
+#define F64_AVX512_STEP(i) c##i = _mm512_fmadd_pd(_mm512_set1_pd(a[i]), b0, c##i)
+#define F64_AVX512_STORE(i) _mm512_storeu_pd(c + i * ldc, _mm512_add_pd(_mm512_loadu_pd(c + i * ldc), c##i))
+
+__attribute__((target("avx512f")))
+static void kernel_f64_avx512(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd();
+    __m512d c3 = _mm512_setzero_pd(), c4 = _mm512_setzero_pd(), c5 = _mm512_setzero_pd();
+
+    for (size_t p = 0; p < kc; p++, a += 6, b += 8) {
+
+        __m512d b0 = _mm512_load_pd(b);
+
+        F64_AVX512_STEP(0); F64_AVX512_STEP(1); F64_AVX512_STEP(2);
+        F64_AVX512_STEP(3); F64_AVX512_STEP(4); F64_AVX512_STEP(5);
+    }
+
+    F64_AVX512_STORE(0); F64_AVX512_STORE(1); F64_AVX512_STORE(2);
+    F64_AVX512_STORE(3); F64_AVX512_STORE(4); F64_AVX512_STORE(5);
+}
+
+#endif
+
+// ===================== DISPATCH =====================
+
+// Micro-kernels follow the instruction set chosen in vector_math
+static micro_kernel_f32 pick_kernel_f32(void) {
+
+    switch (get_simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: return kernel_f32_avx512;
+        case SIMD_AVX2: return kernel_f32_avx2;
+#endif
+        default: return kernel_generic_f32;
+    }
+}
+
+static micro_kernel_f64 pick_kernel_f64(void) {
+
+    switch (get_simd_level()) {
+#ifdef SIMD_X86
+        case SIMD_AVX512: return kernel_f64_avx512;
+        case SIMD_AVX2: return kernel_f64_avx2;
+#endif
+        default: return kernel_generic_f64;
+    }
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd instance of a matrix with all components
+ * set to 0. The storage is MAT_ALIGNMENT-aligned and ld is rounded up
+ * so every row is aligned too. Cast to your desired matrix.
+ *
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param data_size Size of one component, sizeof(type).
+ * @return mat* | NULL
+ */
+void* init_mat(size_t rows, size_t cols, size_t data_size) {
+
+    if (rows == 0 || cols == 0 || data_size == 0) return NULL;
+    if (MAT_ALIGNMENT % data_size != 0) return NULL;
+
+    // Pad rows to a whole number of alignment blocks
+    size_t per_block = MAT_ALIGNMENT / data_size;
+    size_t ld = (cols + per_block - 1) / per_block * per_block;
+    if (rows > SIZE_MAX / ld / data_size) return NULL;
+
+    // Init mat struct, every mat struct shares mat_double's layout
+    mat_double* m = (mat_double*)malloc(sizeof(mat_double));
+    if (m == NULL) return NULL;
+
+    m->rows = rows;
+    m->cols = cols;
+    m->ld = ld;
+
+    size_t bytes = rows * ld * data_size;
+    m->array = aligned_alloc(MAT_ALIGNMENT, bytes);
+    if (m->array == NULL) {
+
+        free(m);
+        return NULL;
+    }
+
+    memset(m->array, 0, bytes);
+    return m;
+}
+
+/**
+ * @brief Frees the given matrix and all its components.
+ *
+ * @param m Matrix to be freed.
+ */
+void free_mat(void* m) {
+
+    if (m == NULL) return;
+
+    free(((mat_double*)m)->array);
+    free(m);
+}
+
+bool gemm_f32(size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda,
+              const float* b, size_t ldb, float beta, float* c, size_t ldc) {
+    return gemm_blocked_f32(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, pick_kernel_f32());
+}
+
+bool gemm_f64(size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda,
+              const double* b, size_t ldb, double beta, double* c, size_t ldc) {
+    return gemm_blocked_f64(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, pick_kernel_f64());
+}
+
+/**
+ * @brief C = alpha * A * B + beta * C.
+ *
+ * @param c Result, c->rows == a->rows and c->cols == b->cols.
+ * @param alpha Scalar for A * B.
+ * @param a Matrix, a->cols == b->rows.
+ * @param b Matrix.
+ * @param beta Scalar for the old C.
+ * @return false if any is NULL, the shapes do not match, or c is a or b.
+ */
+bool gemm_mat_float(mat_float* c, float alpha, const mat_float* a, const mat_float* b, float beta) {
+
+    if (c == NULL || a == NULL || b == NULL) return false;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols) return false;
+    if (c->array == a->array || c->array == b->array) return false;
+
+    return gemm_f32(c->rows, c->cols, a->cols, alpha, a->array, a->ld, b->array, b->ld, beta, c->array, c->ld);
+}
+
+bool gemm_mat_double(mat_double* c, double alpha, const mat_double* a, const mat_double* b, double beta) {
+
+    if (c == NULL || a == NULL || b == NULL) return false;
+    if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols) return false;
+    if (c->array == a->array || c->array == b->array) return false;
+
+    return gemm_f64(c->rows, c->cols, a->cols, alpha, a->array, a->ld, b->array, b->ld, beta, c->array, c->ld);
+}
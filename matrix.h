@@ -0,0 +1,104 @@
+/**
+ * @file matrix.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Dense row-major matrix structs built the same way as the vec
+ * structs, and a cache-blocked general matrix multiply (GEMM) for them.
+ * @version 0.1
+ * @date 2022-07-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Every row of a matrix starts on a MAT_ALIGNMENT-byte boundary
+#define MAT_ALIGNMENT 64
+
+/**
+ * @brief Shared bookkeeping for every matrix struct:
+ * - size_t rows, cols: Dimensions of the matrix.
+ * - size_t ld: Leading dimension, components between the starts of two
+ *   consecutive rows (ld >= cols, padded so rows stay aligned).
+ */
+#define mat_metadata size_t rows; size_t cols; size_t ld
+
+/**
+ * @brief The matrix structs containing the following:
+ * - type* array: row-major components, access with mat_at(m, i, j).
+ * - mat_metadata: rows, cols and ld (see above).
+ *
+ * types: mat_float and mat_double
+ */
+typedef struct matrix_float {
+
+    float* array;
+    mat_metadata;
+} mat_float;
+
+typedef struct matrix_double {
+
+    double* array;
+    mat_metadata;
+} mat_double;
+
+// ===================== MACROS =====================
+
+/**
+ * @brief Component at row i, column j (an lvalue).
+ */
+#define mat_at(m, i, j) ((m)->array[(i) * (m)->ld + (j)])
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd instance of a matrix with all components
+ * set to 0. The storage is MAT_ALIGNMENT-aligned and ld is rounded up
+ * so every row is aligned too. Cast to your desired matrix.
+ *
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param data_size Size of one component, sizeof(type).
+ * @return mat* | NULL
+ */
+void* init_mat(size_t rows, size_t cols, size_t data_size);
+
+/**
+ * @brief Frees the given matrix and all its components.
+ *
+ * @param m Matrix to be freed.
+ */
+void free_mat(void* m);
+
+/**
+ * @brief General matrix multiply over raw row-major arrays:
+ * C = alpha * A * B + beta * C, with A m x k, B k x n and C m x n.
+ * C must not overlap A or B. When beta == 0, C is not read.
+ *
+ * @param lda, ldb, ldc Leading dimensions of A, B and C.
+ * @return false if the packing buffers could not be allocated (C is
+ * then only scaled by beta).
+ */
+bool gemm_f32(size_t m, size_t n, size_t k, float alpha, const float* a, size_t lda,
+              const float* b, size_t ldb, float beta, float* c, size_t ldc);
+bool gemm_f64(size_t m, size_t n, size_t k, double alpha, const double* a, size_t lda,
+              const double* b, size_t ldb, double beta, double* c, size_t ldc);
+
+/**
+ * @brief C = alpha * A * B + beta * C.
+ *
+ * @param c Result, c->rows == a->rows and c->cols == b->cols.
+ * @param alpha Scalar for A * B.
+ * @param a Matrix, a->cols == b->rows.
+ * @param b Matrix.
+ * @param beta Scalar for the old C.
+ * @return false if any is NULL, the shapes do not match, or c is a or b.
+ */
+bool gemm_mat_float(mat_float* c, float alpha, const mat_float* a, const mat_float* b, float beta);
+bool gemm_mat_double(mat_double* c, double alpha, const mat_double* a, const mat_double* b, double beta);
+
+#endif
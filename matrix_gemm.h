@@ -0,0 +1,282 @@
+/**
+ * @file matrix_gemm.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Blocked GEMM template, NOT a regular header. matrix.c includes it
+ * once per component type after defining:
+ *
+ * - T, SUFFIX: component type and the suffix of every generated name.
+ * - MR, NR: register tile computed by one micro-kernel call.
+ * - MC, KC, NC: cache blocks. A KC x NR sliver of B stays in L1, an
+ *   MC x KC block of A stays in L2 and a KC x NC panel of B in L3.
+ *
+ * The layout follows the usual Goto/BLIS loop nest: B panels are packed
+ * into NR-wide column slivers and A blocks into MR-tall row slivers, so
+ * the micro-kernel streams both operands with unit stride. alpha is
+ * folded into the packed A and partial edge tiles are zero-padded.
+ *
+ * Large products are split across the thread pool: every packed B panel
+ * is shared and the C panel under it is cut into (MC rows x PC columns)
+ * tiles, each of which packs its own A block into a per-thread buffer.
+ * Tiles never overlap in C, so no locking is needed.
+ * @version 0.1
+ * @date 2022-07-09
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#define GCAT_(a, b) a##_##b
+#define GCAT(a, b) GCAT_(a, b)
+#define GFN(name) GCAT(name, SUFFIX)
+#define GMIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Columns of C per parallel tile, a multiple of NR
+#define PC (256 / NR * NR)
+
+/**
+ * @brief Micro-kernel: c[i * ldc + j] += sum_p a[p * MR + i] * b[p * NR + j]
+ * for the full MR x NR tile. a and b are packed slivers.
+ */
+typedef void (*GFN(micro_kernel))(size_t kc, const T* a, const T* b, T* c, size_t ldc);
+
+// Portable micro-kernel, used when no SIMD one is available
+static void GFN(kernel_generic)(size_t kc, const T* a, const T* b, T* c, size_t ldc) {
+
+    T acc[MR][NR] = { { 0 } };
+
+    for (size_t p = 0; p < kc; p++, a += MR, b += NR)
+        for (size_t i = 0; i < MR; i++)
+            for (size_t j = 0; j < NR; j++)
+                acc[i][j] += a[i] * b[j];
+
+    for (size_t i = 0; i < MR; i++)
+        for (size_t j = 0; j < NR; j++)
+            c[i * ldc + j] += acc[i][j];
+}
+
+// Packs alpha * A[0:mc, 0:kc] into MR-tall slivers, zero-padding the last one
+static void GFN(pack_a)(size_t mc, size_t kc, T alpha, const T* a, size_t lda, T* ap) {
+
+    for (size_t ir = 0; ir < mc; ir += MR) {
+
+        size_t mr = GMIN(MR, mc - ir);
+
+        for (size_t p = 0; p < kc; p++, ap += MR) {
+
+            for (size_t i = 0; i < mr; i++) ap[i] = alpha * a[(ir + i) * lda + p];
+            for (size_t i = mr; i < MR; i++) ap[i] = 0;
+        }
+    }
+}
+
+// Packs B[0:kc, 0:nc] into NR-wide slivers, zero-padding the last one
+static void GFN(pack_b)(size_t kc, size_t nc, const T* b, size_t ldb, T* bp) {
+
+    for (size_t jr = 0; jr < nc; jr += NR) {
+
+        size_t nr = GMIN(NR, nc - jr);
+
+        for (size_t p = 0; p < kc; p++, bp += NR) {
+
+            const T* row = b + p * ldb + jr;
+            for (size_t j = 0; j < nr; j++) bp[j] = row[j];
+            for (size_t j = nr; j < NR; j++) bp[j] = 0;
+        }
+    }
+}
+
+// C[0:mc, 0:nc] += packed A block * packed B panel
+static void GFN(macro_kernel)(size_t mc, size_t nc, size_t kc, const T* ap, const T* bp,
+                              T* c, size_t ldc, GFN(micro_kernel) kernel) {
+
+    T tile[MR * NR] __attribute__((aligned(MAT_ALIGNMENT)));
+
+    for (size_t jr = 0; jr < nc; jr += NR) {
+
+        size_t nr = GMIN(NR, nc - jr);
+
+        for (size_t ir = 0; ir < mc; ir += MR) {
+
+            size_t mr = GMIN(MR, mc - ir);
+            const T* a_sliver = ap + ir * kc;
+            const T* b_sliver = bp + jr * kc;
+            T* c_tile = c + ir * ldc + jr;
+
+            if (mr == MR && nr == NR) {
+
+                kernel(kc, a_sliver, b_sliver, c_tile, ldc);
+                continue;
+            }
+
+            // Edge tile: compute the full tile aside and keep the valid part
+            memset(tile, 0, sizeof(tile));
+            kernel(kc, a_sliver, b_sliver, tile, NR);
+
+            for (size_t i = 0; i < mr; i++)
+                for (size_t j = 0; j < nr; j++)
+                    c_tile[i * ldc + j] += tile[i * NR + j];
+        }
+    }
+}
+
+// C = beta * C, without reading C when beta == 0
+static void GFN(scale_c)(size_t m, size_t n, T beta, T* c, size_t ldc) {
+
+    if (beta == 1) return;
+
+    for (size_t i = 0; i < m; i++) {
+
+        T* row = c + i * ldc;
+        if (beta == 0) memset(row, 0, n * sizeof(T));
+        else for (size_t j = 0; j < n; j++) row[j] *= beta;
+    }
+}
+
+// Rounds a buffer of count components up to a whole number of MAT_ALIGNMENT blocks
+static T* GFN(alloc_packed)(size_t count) {
+
+    size_t bytes = count * sizeof(T);
+    bytes = (bytes + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT;
+    return (T*)aligned_alloc(MAT_ALIGNMENT, bytes);
+}
+
+// Shared state of one parallel B panel
+typedef struct GFN(gemm_tiles) {
+
+    size_t m, nc, kc;
+    T alpha;
+    const T* a;
+    size_t lda;
+    const T* bp;
+    T* c;
+    size_t ldc;
+    GFN(micro_kernel) kernel;
+    // One MC x KC A buffer per thread, indexed by get_worker_index()
+    T** aps;
+    size_t col_tiles;
+} GFN(gemm_tiles);
+
+static void GFN(gemm_tile_task)(void* arg, size_t begin, size_t end) {
+
+    GFN(gemm_tiles)* g = (GFN(gemm_tiles)*)arg;
+    T* ap = g->aps[get_worker_index()];
+    size_t packed = SIZE_MAX;
+
+    // Tiles run row block by row block, so A is repacked only when the block changes
+    for (size_t t = begin; t < end; t++) {
+
+        size_t ic = t / g->col_tiles * MC;
+        size_t jr = t % g->col_tiles * PC;
+        size_t mc = GMIN(MC, g->m - ic);
+
+        if (packed != ic) {
+
+            GFN(pack_a)(mc, g->kc, g->alpha, g->a + ic * g->lda, g->lda, ap);
+            packed = ic;
+        }
+
+        GFN(macro_kernel)(mc, GMIN(PC, g->nc - jr), g->kc, ap, g->bp + jr * g->kc,
+                          g->c + ic * g->ldc + jr, g->ldc, g->kernel);
+    }
+}
+
+static bool GFN(gemm_parallel)(size_t m, size_t n, size_t k, T alpha, const T* a, size_t lda,
+                               const T* b, size_t ldb, T* c, size_t ldc,
+                               GFN(micro_kernel) kernel, size_t threads) {
+
+    size_t kc_max = GMIN(KC, k);
+    size_t nc_max = GMIN(NC, (n + NR - 1) / NR * NR);
+
+    T* bp = GFN(alloc_packed)(kc_max * nc_max);
+    T** aps = (T**)calloc(threads, sizeof(T*));
+    bool ok = bp != NULL && aps != NULL;
+
+    for (size_t t = 0; ok && t < threads; t++)
+        ok = (aps[t] = GFN(alloc_packed)(MC * kc_max)) != NULL;
+
+    for (size_t jc = 0; ok && jc < n; jc += NC) {
+
+        size_t nc = GMIN(NC, n - jc);
+
+        for (size_t pc = 0; pc < k; pc += KC) {
+
+            size_t kc = GMIN(KC, k - pc);
+            GFN(pack_b)(kc, nc, b + pc * ldb + jc, ldb, bp);
+
+            GFN(gemm_tiles) g = { m, nc, kc, alpha, a + pc, lda, bp, c + jc, ldc, kernel, aps,
+                                  (nc + PC - 1) / PC };
+            size_t row_tiles = (m + MC - 1) / MC;
+            parallel_for(0, row_tiles * g.col_tiles, 1, GFN(gemm_tile_task), &g);
+        }
+    }
+
+    for (size_t t = 0; aps != NULL && t < threads; t++) free(aps[t]);
+    free(aps);
+    free(bp);
+    return ok;
+}
+
+static bool GFN(gemm_blocked)(size_t m, size_t n, size_t k, T alpha, const T* a, size_t lda,
+                              const T* b, size_t ldb, T beta, T* c, size_t ldc,
+                              GFN(micro_kernel) kernel) {
+
+    GFN(scale_c)(m, n, beta, c, ldc);
+    if (m == 0 || n == 0 || k == 0 || alpha == 0) return true;
+
+    // Only worth waking the pool when there is enough arithmetic to share
+    if (m * n * k >= get_parallel_threshold() && (m > MC || n > PC)) {
+
+        size_t threads = get_thread_count();
+        if (threads > 1) return GFN(gemm_parallel)(m, n, k, alpha, a, lda, b, ldb, c, ldc, kernel, threads);
+    }
+
+    // Small problems only need buffers as big as the problem itself
+    size_t kc_max = GMIN(KC, k);
+    size_t mc_max = GMIN(MC, (m + MR - 1) / MR * MR);
+    size_t nc_max = GMIN(NC, (n + NR - 1) / NR * NR);
+
+    T* ap = GFN(alloc_packed)(mc_max * kc_max);
+    T* bp = GFN(alloc_packed)(kc_max * nc_max);
+    if (ap == NULL || bp == NULL) {
+
+        free(ap);
+        free(bp);
+        return false;
+    }
+
+    for (size_t jc = 0; jc < n; jc += NC) {
+
+        size_t nc = GMIN(NC, n - jc);
+
+        for (size_t pc = 0; pc < k; pc += KC) {
+
+            size_t kc = GMIN(KC, k - pc);
+            GFN(pack_b)(kc, nc, b + pc * ldb + jc, ldb, bp);
+
+            for (size_t ic = 0; ic < m; ic += MC) {
+
+                size_t mc = GMIN(MC, m - ic);
+                GFN(pack_a)(mc, kc, alpha, a + ic * lda + pc, lda, ap);
+                GFN(macro_kernel)(mc, nc, kc, ap, bp, c + ic * ldc + jc, ldc, kernel);
+            }
+        }
+    }
+
+    free(ap);
+    free(bp);
+    return true;
+}
+
+#undef PC
+#undef GMIN
+#undef GFN
+#undef GCAT
+#undef GCAT_
+
+#undef T
+#undef SUFFIX
+#undef MR
+#undef NR
+#undef MC
+#undef KC
+#undef NC
@@ -0,0 +1,21 @@
+/**
+ * @file simd.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Instruction set levels shared by the runtime-dispatched kernels
+ * (vector_math.c and vector_search.c).
+ * @version 0.1
+ * @date 2022-08-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+/**
+ * @brief Instruction sets the kernels can run on, from slowest to fastest.
+ */
+typedef enum { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 } simd_level;
+
+#endif
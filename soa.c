@@ -0,0 +1,875 @@
+/**
+ * Struct-of-arrays vec3/vec4 container.
+ * The kernels themselves live in soa_kernels.h and are stamped out once
+ * per instruction set; the level follows vector_math's set_simd_level.
+ * @author Alejandro Ciuba
+ */
+
+#include "soa.h"
+#include "vector_math.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Vectors per pool task, a whole number of SOA_LANES
+#define SOA_BLOCK ((size_t)1 << 12)
+
+// ===================== SCALAR KERNELS =====================
+
+static inline float inv_len_scalar(float l2) { return l2 > 0.0f ? 1.0f / sqrtf(l2) : 1.0f; }
+static inline float inv_w_scalar(float w) { return w != 0.0f && w != 1.0f ? 1.0f / w : 1.0f; }
+static inline float rcp0_scalar(float d) { return d != 0.0f ? 1.0f / d : 0.0f; }
+
+#define VT float
+#define W 1
+#define SUFFIX scalar
+#define ATTR
+#define VLOAD(p) (*(p))
+#define VSTORE(p, v) (*(p) = (v))
+#define VSET1(a) (a)
+#define VADD(a, b) ((a) + (b))
+#define VSUB(a, b) ((a) - (b))
+#define VMUL(a, b) ((a) * (b))
+#define VFMA(a, b, c) ((a) * (b) + (c))
+#define VINVLEN(l2) inv_len_scalar(l2)
+#define VINVW(w) inv_w_scalar(w)
+#define VRCP0(d) rcp0_scalar(d)
+#include "soa_kernels.h"
+
+#ifdef SIMD_X86
+
+// ===================== SSE2 KERNELS =====================
+
+// Lanes of a where mask is set, of b elsewhere
+static inline __m128 select_sse2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 inv_len_sse2(__m128 l2) {
+
+    __m128 one = _mm_set1_ps(1.0f);
+    return select_sse2(_mm_cmpgt_ps(l2, _mm_setzero_ps()), _mm_div_ps(one, _mm_sqrt_ps(l2)), one);
+}
+
+static inline __m128 inv_w_sse2(__m128 w) {
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 mask = _mm_and_ps(_mm_cmpneq_ps(w, _mm_setzero_ps()), _mm_cmpneq_ps(w, one));
+    return select_sse2(mask, _mm_div_ps(one, w), one);
+}
+
+static inline __m128 rcp0_sse2(__m128 d) {
+    return _mm_and_ps(_mm_cmpneq_ps(d, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.0f), d));
+}
+
+#define VT __m128
+#define W 4
+#define SUFFIX sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSTORE(p, v) _mm_storeu_ps((p), (v))
+#define VSET1(a) _mm_set1_ps(a)
+#define VADD(a, b) _mm_add_ps((a), (b))
+#define VSUB(a, b) _mm_sub_ps((a), (b))
+#define VMUL(a, b) _mm_mul_ps((a), (b))
+#define VFMA(a, b, c) _mm_add_ps(_mm_mul_ps((a), (b)), (c))
+#define VINVLEN(l2) inv_len_sse2(l2)
+#define VINVW(w) inv_w_sse2(w)
+#define VRCP0(d) rcp0_sse2(d)
+#include "soa_kernels.h"
+
+// ===================== AVX2 KERNELS =====================
+
+__attribute__((target("avx2,fma")))
+static inline __m256 inv_len_avx2(__m256 l2) {
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 mask = _mm256_cmp_ps(l2, _mm256_setzero_ps(), _CMP_GT_OQ);
+    return _mm256_blendv_ps(one, _mm256_div_ps(one, _mm256_sqrt_ps(l2)), mask);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 inv_w_avx2(__m256 w) {
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 mask = _mm256_and_ps(_mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_NEQ_UQ), _mm256_cmp_ps(w, one, _CMP_NEQ_UQ));
+    return _mm256_blendv_ps(one, _mm256_div_ps(one, w), mask);
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256 rcp0_avx2(__m256 d) {
+    return _mm256_and_ps(_mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_NEQ_UQ), _mm256_div_ps(_mm256_set1_ps(1.0f), d));
+}
+
+#define VT __m256
+#define W 8
+#define SUFFIX avx2
+#define ATTR __attribute__((target("avx2,fma")))
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSTORE(p, v) _mm256_storeu_ps((p), (v))
+#define VSET1(a) _mm256_set1_ps(a)
+#define VADD(a, b) _mm256_add_ps((a), (b))
+#define VSUB(a, b) _mm256_sub_ps((a), (b))
+#define VMUL(a, b) _mm256_mul_ps((a), (b))
+#define VFMA(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#define VINVLEN(l2) inv_len_avx2(l2)
+#define VINVW(w) inv_w_avx2(w)
+#define VRCP0(d) rcp0_avx2(d)
+#include "soa_kernels.h"
+
+// ===================== AVX-512 KERNELS =====================
+
+__attribute__((target("avx512f")))
+static inline __m512 inv_len_avx512(__m512 l2) {
+
+    __m512 one = _mm512_set1_ps(1.0f);
+    __mmask16 mask = _mm512_cmp_ps_mask(l2, _mm512_setzero_ps(), _CMP_GT_OQ);
+    return _mm512_mask_blend_ps(mask, one, _mm512_div_ps(one, _mm512_sqrt_ps(l2)));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 inv_w_avx512(__m512 w) {
+
+    __m512 one = _mm512_set1_ps(1.0f);
+    __mmask16 mask = _mm512_cmp_ps_mask(w, _mm512_setzero_ps(), _CMP_NEQ_UQ) & _mm512_cmp_ps_mask(w, one, _CMP_NEQ_UQ);
+    return _mm512_mask_blend_ps(mask, one, _mm512_div_ps(one, w));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 rcp0_avx512(__m512 d) {
+    return _mm512_maskz_div_ps(_mm512_cmp_ps_mask(d, _mm512_setzero_ps(), _CMP_NEQ_UQ), _mm512_set1_ps(1.0f), d);
+}
+
+#define VT __m512
+#define W 16
+#define SUFFIX avx512
+#define ATTR __attribute__((target("avx512f")))
+#define VLOAD(p) _mm512_loadu_ps(p)
+#define VSTORE(p, v) _mm512_storeu_ps((p), (v))
+#define VSET1(a) _mm512_set1_ps(a)
+#define VADD(a, b) _mm512_add_ps((a), (b))
+#define VSUB(a, b) _mm512_sub_ps((a), (b))
+#define VMUL(a, b) _mm512_mul_ps((a), (b))
+#define VFMA(a, b, c) _mm512_fmadd_ps((a), (b), (c))
+#define VINVLEN(l2) inv_len_avx512(l2)
+#define VINVW(w) inv_w_avx512(w)
+#define VRCP0(d) rcp0_avx512(d)
+#include "soa_kernels.h"
+
+#endif
+
+// ===================== DISPATCH =====================
+
+typedef struct soa_kernels {
+
+    void (*transform)(const mat4*, float* const*, size_t, bool, size_t);
+    void (*normalize)(float* const*, size_t, size_t);
+    void (*cross)(float* const*, const float* const*, const float* const*, size_t);
+    void (*dot)(float*, const float* const*, const float* const*, size_t, size_t);
+    void (*mat_mul3)(float* const*, const float* const*, const float* const*, size_t);
+    void (*mat_mul4)(float* const*, const float* const*, const float* const*, size_t);
+    void (*mat_inverse3)(float* const*, const float* const*, float*, size_t);
+    void (*mat_inverse4)(float* const*, const float* const*, float*, size_t);
+    void (*mat_transform3)(const float* const*, float* const*, size_t);
+    void (*mat_transform4)(const float* const*, float* const*, size_t, bool, size_t);
+} soa_kernels;
+
+#define KERNEL_TABLE(suffix) { transform_##suffix, normalize_##suffix, cross_##suffix, dot_##suffix, \
+                               mat_mul3_##suffix, mat_mul4_##suffix, mat_inverse3_##suffix, mat_inverse4_##suffix, \
+                               mat_transform3_##suffix, mat_transform4_##suffix }
+
+static const soa_kernels table[] = {
+    [SIMD_SCALAR] = KERNEL_TABLE(scalar),
+#ifdef SIMD_X86
+    [SIMD_SSE2] = KERNEL_TABLE(sse2),
+    [SIMD_AVX2] = KERNEL_TABLE(avx2),
+    [SIMD_AVX512] = KERNEL_TABLE(avx512),
+#endif
+};
+
+// ===================== PARALLEL =====================
+
+typedef enum { SOA_TRANSFORM, SOA_NORMALIZE, SOA_CROSS, SOA_DOT, SOA_MAT_MUL, SOA_MAT_INVERSE, SOA_MAT_TRANSFORM } soa_op;
+
+typedef struct soa_ctx {
+
+    soa_op op;
+    const soa_kernels* k;
+    const mat4* m;
+    bool directions;
+    size_t components;
+    size_t dim;
+    size_t n;
+    float* out[SOA_MAT_STREAMS];
+    const float* a[SOA_MAT_STREAMS];
+    const float* b[SOA_MAT_STREAMS];
+    float* dots;
+} soa_ctx;
+
+/**
+ * @brief Runs the op over vectors (or matrices) [begin, end), end rounded
+ * up to whole SOA_LANES (the padding) except for dot, which writes
+ * exactly n floats. Matrix transforms take the matrices in b, inverses
+ * their determinants in dots (sized to the padding).
+ */
+static void soa_range(const soa_ctx* ctx, size_t begin, size_t end) {
+
+    size_t padded = (end + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+    float* out[SOA_MAT_STREAMS];
+    const float* a[SOA_MAT_STREAMS];
+    const float* b[SOA_MAT_STREAMS];
+
+    for (size_t c = 0; c < SOA_MAT_STREAMS; c++) {
+
+        out[c] = ctx->out[c] == NULL ? NULL : ctx->out[c] + begin;
+        a[c] = ctx->a[c] == NULL ? NULL : ctx->a[c] + begin;
+        b[c] = ctx->b[c] == NULL ? NULL : ctx->b[c] + begin;
+    }
+
+    switch (ctx->op) {
+        case SOA_TRANSFORM: ctx->k->transform(ctx->m, out, ctx->components, ctx->directions, padded - begin); break;
+        case SOA_NORMALIZE: ctx->k->normalize(out, ctx->components, padded - begin); break;
+        case SOA_CROSS: ctx->k->cross(out, a, b, padded - begin); break;
+        case SOA_DOT: ctx->k->dot(ctx->dots + begin, a, b, ctx->components, end - begin); break;
+        case SOA_MAT_MUL: (ctx->dim == 3 ? ctx->k->mat_mul3 : ctx->k->mat_mul4)(out, a, b, padded - begin); break;
+        case SOA_MAT_INVERSE:
+            (ctx->dim == 3 ? ctx->k->mat_inverse3 : ctx->k->mat_inverse4)(out, a, ctx->dots == NULL ? NULL : ctx->dots + begin, padded - begin);
+            break;
+        case SOA_MAT_TRANSFORM:
+            if (ctx->dim == 3) ctx->k->mat_transform3(b, out, padded - begin);
+            else ctx->k->mat_transform4(b, out, ctx->components, ctx->directions, padded - begin);
+            break;
+    }
+}
+
+static void soa_task(void* arg, size_t begin, size_t end) {
+
+    const soa_ctx* ctx = (const soa_ctx*)arg;
+    size_t last = end * SOA_BLOCK < ctx->n ? end * SOA_BLOCK : ctx->n;
+    soa_range(ctx, begin * SOA_BLOCK, last);
+}
+
+/**
+ * @brief Runs ctx over its n vectors, in SOA_BLOCK blocks across the pool
+ * when there are enough components. Blocks never split a padded register.
+ */
+static void soa_run(soa_ctx* ctx) {
+
+    ctx->k = &table[get_simd_level()];
+    if (ctx->n == 0) return;
+
+    size_t work = ctx->n * ctx->components;
+    if (work < get_parallel_threshold() || ctx->n <= SOA_BLOCK || get_thread_count() == 1) {
+
+        soa_range(ctx, 0, ctx->n);
+        return;
+    }
+
+    parallel_for(0, (ctx->n + SOA_BLOCK - 1) / SOA_BLOCK, 1, soa_task, ctx);
+}
+
+// ===================== HELPERS =====================
+
+// Floats per stream for capacity vectors, 0 on overflow
+static size_t stream_length(size_t capacity, size_t components) {
+
+    if (capacity > SIZE_MAX / sizeof(float) / components - SOA_LANES) return 0;
+    return (capacity + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+}
+
+/**
+ * @brief One zeroed block for count streams of length floats each, every
+ * one a whole number of aligned lines (the kernels only ever read
+ * initialized floats), with the first size floats of each old stream
+ * copied over.
+ *
+ * @return float* | NULL
+ */
+static float* alloc_streams(float* const* old, size_t count, size_t size, size_t length) {
+
+    size_t bytes = length * count * sizeof(float);
+    float* block = aligned_alloc(SOA_ALIGNMENT, bytes);
+    if (block == NULL) return NULL;
+    memset(block, 0, bytes);
+
+    for (size_t c = 0; c < count && size > 0; c++)
+        memcpy(block + c * length, old[c], size * sizeof(float));
+
+    return block;
+}
+
+static void streams_of(const soa_vec* v, float** s) {
+
+    s[0] = v->x;
+    s[1] = v->y;
+    s[2] = v->z;
+    s[3] = v->w;
+}
+
+static void const_streams_of(const soa_vec* v, const float** s) {
+
+    s[0] = v->x;
+    s[1] = v->y;
+    s[2] = v->z;
+    s[3] = v->w;
+}
+
+// ===================== CONTAINER =====================
+
+/**
+ * @brief Initialize a malloc'd, empty SoA container.
+ *
+ * @param components 3 for vec3, 4 for vec4.
+ * @param capacity Vectors to make room for (may be 0).
+ * @return soa_vec* | NULL
+ */
+soa_vec* init_soa(size_t components, size_t capacity) {
+
+    if (components != 3 && components != 4) return NULL;
+
+    soa_vec* v = calloc(1, sizeof(soa_vec));
+    if (v == NULL) return NULL;
+
+    v->components = components;
+    if (!reserve_soa(v, capacity)) {
+
+        free(v);
+        return NULL;
+    }
+
+    // Setting the capacity up front is not a resize
+    v->stats = (resize_stats){ 0, 0 };
+    return v;
+}
+
+/**
+ * @brief Makes sure v has room for at least capacity vectors. Never
+ * shrinks. The streams may move.
+ *
+ * @return false if v is NULL or the streams could not grow (v is left
+ * unchanged).
+ */
+bool reserve_soa(soa_vec* v, size_t capacity) {
+
+    if (v == NULL) return false;
+    if (capacity <= v->capacity) return true;
+
+    size_t length = stream_length(capacity, v->components);
+    if (length == 0) return false;
+
+    // All streams in one block
+    float* old[4];
+    streams_of(v, old);
+    float* block = alloc_streams(old, v->components, v->size, length);
+    if (block == NULL) return false;
+
+    free(v->x);
+    v->x = block;
+    v->y = block + length;
+    v->z = block + 2 * length;
+    v->w = v->components == 4 ? block + 3 * length : NULL;
+    v->capacity = length;
+    v->stats.grows++;
+
+    return true;
+}
+
+// Room for one more vector, by the default vector policy
+static bool make_room(soa_vec* v) {
+
+    if (v->size < v->capacity) return true;
+
+    size_t capacity = policy_grow(VEC_DEFAULT_POLICY, v->capacity, v->size + 1);
+    return capacity != SIZE_MAX && reserve_soa(v, capacity);
+}
+
+/**
+ * @brief Appends one vector, growing by the default vector policy.
+ * append_vec3_soa only works on vec3 containers, append_vec4_soa on vec4.
+ *
+ * @return false if v is NULL, has the other component count or could
+ * not grow.
+ */
+bool append_vec3_soa(soa_vec* v, vec3 a) {
+
+    if (v == NULL || v->components != 3 || !make_room(v)) return false;
+
+    v->x[v->size] = a.x;
+    v->y[v->size] = a.y;
+    v->z[v->size] = a.z;
+    v->size++;
+
+    return true;
+}
+
+bool append_vec4_soa(soa_vec* v, vec4 a) {
+
+    if (v == NULL || v->components != 4 || !make_room(v)) return false;
+
+    v->x[v->size] = a.x;
+    v->y[v->size] = a.y;
+    v->z[v->size] = a.z;
+    v->w[v->size] = a.w;
+    v->size++;
+
+    return true;
+}
+
+/**
+ * @brief Vector i gathered out of the streams. Out of range (or the wrong
+ * component count) gives all zeros.
+ */
+vec3 get_vec3_soa(const soa_vec* v, size_t i) {
+
+    if (v == NULL || v->components != 3 || i >= v->size) return (vec3){ 0, 0, 0 };
+    return (vec3){ v->x[i], v->y[i], v->z[i] };
+}
+
+vec4 get_vec4_soa(const soa_vec* v, size_t i) {
+
+    if (v == NULL || v->components != 4 || i >= v->size) return (vec4){ 0, 0, 0, 0 };
+    return (vec4){ v->x[i], v->y[i], v->z[i], v->w[i] };
+}
+
+/**
+ * @brief Frees the given container and its streams.
+ *
+ * @param v Container, may be NULL.
+ */
+void free_soa(soa_vec* v) {
+
+    if (v == NULL) return;
+
+    // x is the start of the one block holding every stream
+    free(v->x);
+    free(v);
+}
+
+// ===================== KERNELS =====================
+
+/**
+ * @brief Every vector v' = m * v, in place. vec4 containers are
+ * transformed as is. vec3 containers are points (w = 1, divided by the
+ * resulting w when it is neither 0 nor 1, like transform_point_mat4) or,
+ * with directions, directions (w = 0: no translation, no divide).
+ *
+ * @param v Container.
+ * @param m Transform, row-major like mat4.
+ * @param directions Treat vec3s as directions instead of points.
+ * @return false if v is NULL.
+ */
+bool transform_soa(soa_vec* v, mat4 m, bool directions) {
+
+    if (v == NULL) return false;
+
+    soa_ctx ctx = { .op = SOA_TRANSFORM, .m = &m, .directions = directions, .components = v->components, .n = v->size };
+    streams_of(v, ctx.out);
+    soa_run(&ctx);
+
+    return true;
+}
+
+/**
+ * @brief Every vector scaled to unit length in place, those of length 0
+ * are left alone (like normalize_vec3/normalize_vec4).
+ *
+ * @return false if v is NULL.
+ */
+bool normalize_soa(soa_vec* v) {
+
+    if (v == NULL) return false;
+
+    soa_ctx ctx = { .op = SOA_NORMALIZE, .components = v->components, .n = v->size };
+    streams_of(v, ctx.out);
+    soa_run(&ctx);
+
+    return true;
+}
+
+/**
+ * @brief out[i] = cross(a[i], b[i]) for vec3 containers. out may be a or
+ * b and is resized to match.
+ *
+ * @return false if any is NULL, one is not a vec3 container, or a and b
+ * differ in size.
+ */
+bool cross_soa(soa_vec* out, const soa_vec* a, const soa_vec* b) {
+
+    if (out == NULL || a == NULL || b == NULL || a->size != b->size) return false;
+    if (out->components != 3 || a->components != 3 || b->components != 3) return false;
+    if (!reserve_soa(out, a->size)) return false;
+    out->size = a->size;
+
+    soa_ctx ctx = { .op = SOA_CROSS, .components = 3, .n = a->size };
+    streams_of(out, ctx.out);
+    const_streams_of(a, ctx.a);
+    const_streams_of(b, ctx.b);
+    soa_run(&ctx);
+
+    return true;
+}
+
+/**
+ * @brief out[i] = dot(a[i], b[i]). out is resized to a->size.
+ *
+ * @return false if any is NULL, or a and b differ in size or component
+ * count.
+ */
+bool dot_soa(vec_float* out, const soa_vec* a, const soa_vec* b) {
+
+    if (out == NULL || a == NULL || b == NULL) return false;
+    if (a->size != b->size || a->components != b->components) return false;
+    if (!reserve_vec(out, a->size, sizeof(float))) return false;
+    out->size = a->size;
+
+    // Written in place behind the index's back
+    drop_index_vec(out);
+
+    soa_ctx ctx = { .op = SOA_DOT, .components = a->components, .n = a->size, .dots = out->array };
+    const_streams_of(a, ctx.a);
+    const_streams_of(b, ctx.b);
+    soa_run(&ctx);
+
+    return true;
+}
+
+// ===================== INTERLEAVED =====================
+
+/**
+ * @brief Writes vectors [first, first + count) as interleaved vertices:
+ * vector i's components, back to back as floats, go stride bytes apart
+ * starting at dst. Point dst at the attribute inside the first vertex
+ * (buffer + offset) to fill one attribute of a wider vertex. dst needs no
+ * particular alignment.
+ *
+ * @param v Container.
+ * @param dst Vertex buffer, count * stride bytes.
+ * @param stride Bytes from one vertex to the next, at least
+ * v->components * sizeof(float).
+ * @param first First vector.
+ * @param count Number of vectors.
+ * @return false if any is NULL, the range is out of bounds or stride is
+ * too small.
+ */
+bool export_interleaved_soa(const soa_vec* v, void* dst, size_t stride, size_t first, size_t count) {
+
+    if (v == NULL || dst == NULL || first > v->size || count > v->size - first) return false;
+
+    size_t bytes = v->components * sizeof(float);
+    if (stride < bytes) return false;
+
+    // Vertices are written front to back in one pass, which is what
+    // write-combined (mapped GPU) memory wants
+    char* out = (char*)dst;
+    float* w = v->w == NULL ? NULL : v->w + first;
+    const float* x = v->x + first;
+    const float* y = v->y + first;
+    const float* z = v->z + first;
+
+    for (size_t i = 0; i < count; i++, out += stride) {
+
+        float vertex[4] = { x[i], y[i], z[i], w == NULL ? 0.0f : w[i] };
+        memcpy(out, vertex, bytes);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends count vectors read from interleaved vertices (the
+ * reverse of export_interleaved_soa).
+ *
+ * @param v Container.
+ * @param src Vertex buffer, at the attribute inside the first vertex.
+ * @param stride Bytes from one vertex to the next.
+ * @param count Number of vectors.
+ * @return false if any is NULL, stride is too small or v could not grow.
+ */
+bool import_interleaved_soa(soa_vec* v, const void* src, size_t stride, size_t count) {
+
+    if (v == NULL || src == NULL || count > SIZE_MAX - v->size) return false;
+
+    size_t bytes = v->components * sizeof(float);
+    if (stride < bytes) return false;
+
+    size_t need = v->size + count;
+    if (need > v->capacity && !reserve_soa(v, policy_grow(VEC_DEFAULT_POLICY, v->capacity, need))) return false;
+
+    const char* in = (const char*)src;
+    for (size_t i = v->size; i < need; i++, in += stride) {
+
+        float vertex[4];
+        memcpy(vertex, in, bytes);
+        v->x[i] = vertex[0];
+        v->y[i] = vertex[1];
+        v->z[i] = vertex[2];
+        if (v->w != NULL) v->w[i] = vertex[3];
+    }
+
+    v->size = need;
+    return true;
+}
+
+// ===================== MATRICES =====================
+
+/**
+ * @brief Initialize a malloc'd, empty SoA matrix container.
+ *
+ * @param dim 3 for mat3, 4 for mat4.
+ * @param capacity Matrices to make room for (may be 0).
+ * @return soa_mat* | NULL
+ */
+soa_mat* init_soa_mat(size_t dim, size_t capacity) {
+
+    if (dim != 3 && dim != 4) return NULL;
+
+    soa_mat* m = calloc(1, sizeof(soa_mat));
+    if (m == NULL) return NULL;
+
+    m->dim = dim;
+    if (!reserve_soa_mat(m, capacity)) {
+
+        free(m);
+        return NULL;
+    }
+
+    // Setting the capacity up front is not a resize
+    m->stats = (resize_stats){ 0, 0 };
+    return m;
+}
+
+/**
+ * @brief Makes sure m has room for at least capacity matrices. Never
+ * shrinks. The streams may move.
+ *
+ * @return false if m is NULL or the streams could not grow (m is left
+ * unchanged).
+ */
+bool reserve_soa_mat(soa_mat* m, size_t capacity) {
+
+    if (m == NULL) return false;
+    if (capacity <= m->capacity) return true;
+
+    size_t count = m->dim * m->dim;
+    size_t length = stream_length(capacity, count);
+    if (length == 0) return false;
+
+    float* block = alloc_streams(m->m, count, m->size, length);
+    if (block == NULL) return false;
+
+    free(m->m[0]);
+    for (size_t c = 0; c < count; c++) m->m[c] = block + c * length;
+    m->capacity = length;
+    m->stats.grows++;
+
+    return true;
+}
+
+// Room for count more matrices, by the default vector policy
+static bool make_room_mat(soa_mat* m, size_t count) {
+
+    if (count > SIZE_MAX - m->size) return false;
+
+    size_t need = m->size + count;
+    if (need <= m->capacity) return true;
+
+    size_t capacity = policy_grow(VEC_DEFAULT_POLICY, m->capacity, need);
+    return capacity != SIZE_MAX && reserve_soa_mat(m, capacity);
+}
+
+/**
+ * @brief Appends one matrix, growing by the default vector policy.
+ * append_mat3_soa only works on mat3 containers, append_mat4_soa on mat4.
+ *
+ * @return false if m is NULL, has the other dimension or could not grow.
+ */
+bool append_mat3_soa(soa_mat* m, mat3 a) {
+
+    if (m == NULL || m->dim != 3 || !make_room_mat(m, 1)) return false;
+
+    for (size_t e = 0; e < 9; e++) m->m[e][m->size] = a.m[e / 3][e % 3];
+    m->size++;
+
+    return true;
+}
+
+bool append_mat4_soa(soa_mat* m, mat4 a) {
+
+    if (m == NULL || m->dim != 4 || !make_room_mat(m, 1)) return false;
+
+    for (size_t e = 0; e < 16; e++) m->m[e][m->size] = a.m[e / 4][e % 4];
+    m->size++;
+
+    return true;
+}
+
+/**
+ * @brief Matrix i gathered out of the streams. Out of range (or the wrong
+ * dimension) gives all zeros.
+ */
+mat3 get_mat3_soa(const soa_mat* m, size_t i) {
+
+    mat3 a = { { { 0 } } };
+    if (m == NULL || m->dim != 3 || i >= m->size) return a;
+
+    for (size_t e = 0; e < 9; e++) a.m[e / 3][e % 3] = m->m[e][i];
+    return a;
+}
+
+mat4 get_mat4_soa(const soa_mat* m, size_t i) {
+
+    mat4 a = { { { 0 } } };
+    if (m == NULL || m->dim != 4 || i >= m->size) return a;
+
+    for (size_t e = 0; e < 16; e++) a.m[e / 4][e % 4] = m->m[e][i];
+    return a;
+}
+
+/**
+ * @brief Appends count matrices from a contiguous array of mat3 or mat4
+ * (dim * dim floats each, row-major), e.g. a mat4[].
+ *
+ * @return false if any is NULL or m could not grow.
+ */
+bool import_mats_soa(soa_mat* m, const void* src, size_t count) {
+
+    if (m == NULL || src == NULL || !make_room_mat(m, count)) return false;
+
+    size_t floats = m->dim * m->dim;
+    const float* in = (const float*)src;
+
+    // One stream at a time, so every store goes to the same few lines
+    for (size_t e = 0; e < floats; e++)
+        for (size_t i = 0; i < count; i++) m->m[e][m->size + i] = in[i * floats + e];
+
+    m->size += count;
+    return true;
+}
+
+/**
+ * @brief Writes matrices [first, first + count) to a contiguous array of
+ * mat3 or mat4 (the reverse of import_mats_soa), e.g. a mapped uniform
+ * or storage buffer.
+ *
+ * @return false if any is NULL or the range is out of bounds.
+ */
+bool export_mats_soa(const soa_mat* m, void* dst, size_t first, size_t count) {
+
+    if (m == NULL || dst == NULL || first > m->size || count > m->size - first) return false;
+
+    size_t floats = m->dim * m->dim;
+    float* out = (float*)dst;
+
+    // Matrices are written front to back, which is what write-combined
+    // (mapped GPU) memory wants
+    for (size_t i = 0; i < count; i++)
+        for (size_t e = 0; e < floats; e++) out[i * floats + e] = m->m[e][first + i];
+
+    return true;
+}
+
+/**
+ * @brief Frees the given container and its streams.
+ *
+ * @param m Container, may be NULL.
+ */
+void free_soa_mat(soa_mat* m) {
+
+    if (m == NULL) return;
+
+    // m[0] is the start of the one block holding every stream
+    free(m->m[0]);
+    free(m);
+}
+
+/**
+ * @brief out[i] = a[i] * b[i]. out may be a or b and is resized to match.
+ *
+ * @return false if any is NULL, the dimensions differ, or a and b differ
+ * in size.
+ */
+bool mul_soa_mat(soa_mat* out, const soa_mat* a, const soa_mat* b) {
+
+    if (out == NULL || a == NULL || b == NULL || a->size != b->size) return false;
+    if (out->dim != a->dim || b->dim != a->dim) return false;
+    if (!reserve_soa_mat(out, a->size)) return false;
+    out->size = a->size;
+
+    soa_ctx ctx = { .op = SOA_MAT_MUL, .components = a->dim * a->dim, .dim = a->dim, .n = a->size };
+    for (size_t c = 0; c < a->dim * a->dim; c++) {
+
+        ctx.out[c] = out->m[c];
+        ctx.a[c] = a->m[c];
+        ctx.b[c] = b->m[c];
+    }
+    soa_run(&ctx);
+
+    return true;
+}
+
+/**
+ * @brief out[i] = inverse(a[i]), singular matrices (determinant exactly 0)
+ * give all zeros. out may be a and is resized to match.
+ *
+ * @param dets If not NULL, resized to a->size and given every determinant,
+ * to tell singular (or badly conditioned) matrices apart.
+ * @return false if out or a is NULL, or the dimensions differ.
+ */
+bool inverse_soa_mat(soa_mat* out, const soa_mat* a, vec_float* dets) {
+
+    if (out == NULL || a == NULL || out->dim != a->dim) return false;
+    if (!reserve_soa_mat(out, a->size)) return false;
+
+    // The kernels store whole registers, so dets gets room for the padding
+    if (dets != NULL) {
+
+        if (!reserve_vec(dets, stream_length(a->size, 1), sizeof(float))) return false;
+        dets->size = a->size;
+
+        // Written in place behind the index's back
+        drop_index_vec(dets);
+    }
+
+    out->size = a->size;
+
+    soa_ctx ctx = { .op = SOA_MAT_INVERSE, .components = a->dim * a->dim, .dim = a->dim, .n = a->size,
+                    .dots = dets == NULL ? NULL : dets->array };
+    for (size_t c = 0; c < a->dim * a->dim; c++) {
+
+        ctx.out[c] = out->m[c];
+        ctx.a[c] = a->m[c];
+    }
+    soa_run(&ctx);
+
+    return true;
+}
+
+/**
+ * @brief Every vector v[i] = m[i] * v[i], in place. mat4 containers follow
+ * transform_soa (vec4 as is, vec3 as points or directions), mat3 ones
+ * only take vec3 containers.
+ *
+ * @param v Vectors, v->size == m->size.
+ * @param m One matrix per vector.
+ * @param directions Treat vec3s as directions instead of points (mat4).
+ * @return false if either is NULL, the sizes differ or m is mat3 and v is
+ * not vec3.
+ */
+bool transform_soa_mat(soa_vec* v, const soa_mat* m, bool directions) {
+
+    if (v == NULL || m == NULL || v->size != m->size) return false;
+    if (m->dim == 3 && v->components != 3) return false;
+
+    soa_ctx ctx = { .op = SOA_MAT_TRANSFORM, .directions = directions, .components = v->components, .dim = m->dim, .n = v->size };
+    streams_of(v, ctx.out);
+    for (size_t c = 0; c < m->dim * m->dim; c++) ctx.b[c] = m->m[c];
+    soa_run(&ctx);
+
+    return true;
+}
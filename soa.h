@@ -0,0 +1,286 @@
+/**
+ * @file soa.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Struct-of-arrays container for large batches of vec3 or vec4
+ * (positions, normals, colors). Every component lives in its own
+ * SOA_ALIGNMENT-aligned float stream, so the bulk kernels below load 4, 8
+ * or 16 vectors per instruction (SSE2, AVX2, AVX-512, picked like
+ * vector_math) instead of shuffling x/y/z/w out of each one. Batches of at
+ * least get_parallel_threshold() components are split across the pool.
+ *
+ * export_interleaved_soa writes the streams straight into a vertex buffer
+ * (e.g. one mapped with glMapBufferRange or vkMapMemory) in the usual
+ * interleaved layout, without a staging copy in between.
+ *
+ * soa_mat does the same for batches of mat3 or mat4 (one stream per
+ * component), so thousands of independent products, inverses and
+ * per-object transforms run as a handful of fully unrolled loops with
+ * W matrices per instruction instead of one call per matrix.
+ * @version 0.1
+ * @date 2022-09-08
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SOA_H
+#define SOA_H
+
+#include "vector.h"
+#include "value_types.h"
+
+// Every stream starts on a SOA_ALIGNMENT-byte boundary
+#define SOA_ALIGNMENT 64
+// Streams are padded to a multiple of SOA_LANES floats (one aligned line),
+// so the kernels never need a scalar tail
+#define SOA_LANES (SOA_ALIGNMENT / sizeof(float))
+// Streams of a mat4 container
+#define SOA_MAT_STREAMS 16
+
+/**
+ * @brief The SoA container containing the following:
+ * - float* x, y, z, w: The component streams, w is NULL for vec3
+ *   containers. Component i of vector j is stream[j].
+ * - size_t size: Number of vectors.
+ * - size_t capacity: Vectors the streams have room for.
+ * - size_t components: 3 (vec3) or 4 (vec4).
+ * - resize_stats stats: How often the streams were reallocated.
+ */
+typedef struct soa_vec {
+
+    float* x;
+    float* y;
+    float* z;
+    float* w;
+    size_t size;
+    size_t capacity;
+    size_t components;
+    resize_stats stats;
+} soa_vec;
+
+/**
+ * @brief The SoA matrix container containing the following:
+ * - float* m[SOA_MAT_STREAMS]: The component streams, entry (r, c) of
+ *   matrix j is m[r * dim + c][j]. Only the first dim * dim are used.
+ * - size_t size: Number of matrices.
+ * - size_t capacity: Matrices the streams have room for.
+ * - size_t dim: 3 (mat3) or 4 (mat4).
+ * - resize_stats stats: How often the streams were reallocated.
+ */
+typedef struct soa_mat {
+
+    float* m[SOA_MAT_STREAMS];
+    size_t size;
+    size_t capacity;
+    size_t dim;
+    resize_stats stats;
+} soa_mat;
+
+// ===================== CONTAINER =====================
+
+/**
+ * @brief Initialize a malloc'd, empty SoA container.
+ *
+ * @param components 3 for vec3, 4 for vec4.
+ * @param capacity Vectors to make room for (may be 0).
+ * @return soa_vec* | NULL
+ */
+soa_vec* init_soa(size_t components, size_t capacity);
+
+/**
+ * @brief Makes sure v has room for at least capacity vectors. Never
+ * shrinks. The streams may move.
+ *
+ * @return false if v is NULL or the streams could not grow (v is left
+ * unchanged).
+ */
+bool reserve_soa(soa_vec* v, size_t capacity);
+
+/**
+ * @brief Appends one vector, growing by the default vector policy.
+ * append_vec3_soa only works on vec3 containers, append_vec4_soa on vec4.
+ *
+ * @return false if v is NULL, has the other component count or could
+ * not grow.
+ */
+bool append_vec3_soa(soa_vec* v, vec3 a);
+bool append_vec4_soa(soa_vec* v, vec4 a);
+
+/**
+ * @brief Vector i gathered out of the streams. Out of range (or the wrong
+ * component count) gives all zeros.
+ */
+vec3 get_vec3_soa(const soa_vec* v, size_t i);
+vec4 get_vec4_soa(const soa_vec* v, size_t i);
+
+/**
+ * @brief Frees the given container and its streams.
+ *
+ * @param v Container, may be NULL.
+ */
+void free_soa(soa_vec* v);
+
+// ===================== KERNELS =====================
+
+/**
+ * @brief Every vector v' = m * v, in place. vec4 containers are
+ * transformed as is. vec3 containers are points (w = 1, divided by the
+ * resulting w when it is neither 0 nor 1, like transform_point_mat4) or,
+ * with directions, directions (w = 0: no translation, no divide).
+ *
+ * @param v Container.
+ * @param m Transform, row-major like mat4.
+ * @param directions Treat vec3s as directions instead of points.
+ * @return false if v is NULL.
+ */
+bool transform_soa(soa_vec* v, mat4 m, bool directions);
+
+/**
+ * @brief Every vector scaled to unit length in place, those of length 0
+ * are left alone (like normalize_vec3/normalize_vec4).
+ *
+ * @return false if v is NULL.
+ */
+bool normalize_soa(soa_vec* v);
+
+/**
+ * @brief out[i] = cross(a[i], b[i]) for vec3 containers. out may be a or
+ * b and is resized to match.
+ *
+ * @return false if any is NULL, one is not a vec3 container, or a and b
+ * differ in size.
+ */
+bool cross_soa(soa_vec* out, const soa_vec* a, const soa_vec* b);
+
+/**
+ * @brief out[i] = dot(a[i], b[i]). out is resized to a->size.
+ *
+ * @return false if any is NULL, or a and b differ in size or component
+ * count.
+ */
+bool dot_soa(vec_float* out, const soa_vec* a, const soa_vec* b);
+
+// ===================== INTERLEAVED =====================
+
+/**
+ * @brief Writes vectors [first, first + count) as interleaved vertices:
+ * vector i's components, back to back as floats, go stride bytes apart
+ * starting at dst. Point dst at the attribute inside the first vertex
+ * (buffer + offset) to fill one attribute of a wider vertex. dst needs no
+ * particular alignment.
+ *
+ * @param v Container.
+ * @param dst Vertex buffer, count * stride bytes.
+ * @param stride Bytes from one vertex to the next, at least
+ * v->components * sizeof(float).
+ * @param first First vector.
+ * @param count Number of vectors.
+ * @return false if any is NULL, the range is out of bounds or stride is
+ * too small.
+ */
+bool export_interleaved_soa(const soa_vec* v, void* dst, size_t stride, size_t first, size_t count);
+
+/**
+ * @brief Appends count vectors read from interleaved vertices (the
+ * reverse of export_interleaved_soa).
+ *
+ * @param v Container.
+ * @param src Vertex buffer, at the attribute inside the first vertex.
+ * @param stride Bytes from one vertex to the next.
+ * @param count Number of vectors.
+ * @return false if any is NULL, stride is too small or v could not grow.
+ */
+bool import_interleaved_soa(soa_vec* v, const void* src, size_t stride, size_t count);
+
+// ===================== MATRICES =====================
+
+/**
+ * @brief Initialize a malloc'd, empty SoA matrix container.
+ *
+ * @param dim 3 for mat3, 4 for mat4.
+ * @param capacity Matrices to make room for (may be 0).
+ * @return soa_mat* | NULL
+ */
+soa_mat* init_soa_mat(size_t dim, size_t capacity);
+
+/**
+ * @brief Makes sure m has room for at least capacity matrices. Never
+ * shrinks. The streams may move.
+ *
+ * @return false if m is NULL or the streams could not grow (m is left
+ * unchanged).
+ */
+bool reserve_soa_mat(soa_mat* m, size_t capacity);
+
+/**
+ * @brief Appends one matrix, growing by the default vector policy.
+ * append_mat3_soa only works on mat3 containers, append_mat4_soa on mat4.
+ *
+ * @return false if m is NULL, has the other dimension or could not grow.
+ */
+bool append_mat3_soa(soa_mat* m, mat3 a);
+bool append_mat4_soa(soa_mat* m, mat4 a);
+
+/**
+ * @brief Matrix i gathered out of the streams. Out of range (or the wrong
+ * dimension) gives all zeros.
+ */
+mat3 get_mat3_soa(const soa_mat* m, size_t i);
+mat4 get_mat4_soa(const soa_mat* m, size_t i);
+
+/**
+ * @brief Appends count matrices from a contiguous array of mat3 or mat4
+ * (dim * dim floats each, row-major), e.g. a mat4[].
+ *
+ * @return false if any is NULL or m could not grow.
+ */
+bool import_mats_soa(soa_mat* m, const void* src, size_t count);
+
+/**
+ * @brief Writes matrices [first, first + count) to a contiguous array of
+ * mat3 or mat4 (the reverse of import_mats_soa), e.g. a mapped uniform
+ * or storage buffer.
+ *
+ * @return false if any is NULL or the range is out of bounds.
+ */
+bool export_mats_soa(const soa_mat* m, void* dst, size_t first, size_t count);
+
+/**
+ * @brief Frees the given container and its streams.
+ *
+ * @param m Container, may be NULL.
+ */
+void free_soa_mat(soa_mat* m);
+
+/**
+ * @brief out[i] = a[i] * b[i]. out may be a or b and is resized to match.
+ *
+ * @return false if any is NULL, the dimensions differ, or a and b differ
+ * in size.
+ */
+bool mul_soa_mat(soa_mat* out, const soa_mat* a, const soa_mat* b);
+
+/**
+ * @brief out[i] = inverse(a[i]), singular matrices (determinant exactly 0)
+ * give all zeros. out may be a and is resized to match.
+ *
+ * @param dets If not NULL, resized to a->size and given every determinant,
+ * to tell singular (or badly conditioned) matrices apart.
+ * @return false if out or a is NULL, or the dimensions differ.
+ */
+bool inverse_soa_mat(soa_mat* out, const soa_mat* a, vec_float* dets);
+
+/**
+ * @brief Every vector v[i] = m[i] * v[i], in place. mat4 containers follow
+ * transform_soa (vec4 as is, vec3 as points or directions), mat3 ones
+ * only take vec3 containers.
+ *
+ * @param v Vectors, v->size == m->size.
+ * @param m One matrix per vector.
+ * @param directions Treat vec3s as directions instead of points (mat4).
+ * @return false if either is NULL, the sizes differ or m is mat3 and v is
+ * not vec3.
+ */
+bool transform_soa_mat(soa_vec* v, const soa_mat* m, bool directions);
+
+#endif
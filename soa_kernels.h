@@ -0,0 +1,288 @@
+/**
+ * @file soa_kernels.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief SoA kernel template, NOT a regular header. soa.c includes it
+ * once per instruction set after defining the macros below, so every ISA
+ * shares the same loop structure:
+ *
+ * - VT, W: SIMD register type and floats per register.
+ * - SUFFIX: appended to every generated function name.
+ * - ATTR: function attributes (e.g. the target ISA).
+ * - VLOAD, VSTORE, VSET1: unaligned load/store and broadcast.
+ * - VADD, VSUB, VMUL, VFMA(a, b, c) = a * b + c.
+ * - VINVLEN(l2): 1 / sqrt(l2) where l2 > 0, else 1.
+ * - VINVW(w): 1 / w where w is neither 0 nor 1, else 1.
+ * - VRCP0(d): 1 / d where d is not 0, else 0.
+ *
+ * Counts are whole registers: the streams are padded to SOA_LANES, so
+ * the kernels run past the last vector instead of handling a tail.
+ * Matrix kernels take one stream per component, m[r][c] in stream
+ * r * D + c, and are fully unrolled for D = 3 and D = 4.
+ * The macros are #undef'd at the end so the next instantiation starts clean.
+ * @version 0.1
+ * @date 2022-09-08
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#define SCAT_(a, b) a##_##b
+#define SCAT(a, b) SCAT_(a, b)
+#define SFN(name) SCAT(name, SUFFIX)
+
+// Row r of the broadcast matrix mm applied to (x, y, z, w)
+#define ROW(r, x, y, z, w) VFMA(mm[r][0], x, VFMA(mm[r][1], y, VFMA(mm[r][2], z, VMUL(mm[r][3], w))))
+
+static ATTR void SFN(transform)(const mat4* m, float* const* s, size_t components, bool directions, size_t n) {
+
+    VT mm[4][4];
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++) mm[r][c] = VSET1(m->m[r][c]);
+
+    bool points = components == 3 && !directions;
+    VT w3 = VSET1(directions ? 0.0f : 1.0f);
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT x = VLOAD(s[0] + i), y = VLOAD(s[1] + i), z = VLOAD(s[2] + i);
+        VT w = components == 4 ? VLOAD(s[3] + i) : w3;
+
+        VT rx = ROW(0, x, y, z, w), ry = ROW(1, x, y, z, w), rz = ROW(2, x, y, z, w);
+
+        if (points) {
+
+            VT inv = VINVW(ROW(3, x, y, z, w));
+            rx = VMUL(rx, inv);
+            ry = VMUL(ry, inv);
+            rz = VMUL(rz, inv);
+        }
+
+        if (components == 4) VSTORE(s[3] + i, ROW(3, x, y, z, w));
+        VSTORE(s[0] + i, rx);
+        VSTORE(s[1] + i, ry);
+        VSTORE(s[2] + i, rz);
+    }
+}
+
+static ATTR void SFN(normalize)(float* const* s, size_t components, size_t n) {
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT x = VLOAD(s[0] + i), y = VLOAD(s[1] + i), z = VLOAD(s[2] + i);
+        VT l2 = VADD(VADD(VMUL(x, x), VMUL(y, y)), VMUL(z, z));
+        VT w = x;
+
+        if (components == 4) {
+
+            w = VLOAD(s[3] + i);
+            l2 = VADD(l2, VMUL(w, w));
+        }
+
+        VT inv = VINVLEN(l2);
+        if (components == 4) VSTORE(s[3] + i, VMUL(w, inv));
+        VSTORE(s[0] + i, VMUL(x, inv));
+        VSTORE(s[1] + i, VMUL(y, inv));
+        VSTORE(s[2] + i, VMUL(z, inv));
+    }
+}
+
+static ATTR void SFN(cross)(float* const* out, const float* const* a, const float* const* b, size_t n) {
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT ax = VLOAD(a[0] + i), ay = VLOAD(a[1] + i), az = VLOAD(a[2] + i);
+        VT bx = VLOAD(b[0] + i), by = VLOAD(b[1] + i), bz = VLOAD(b[2] + i);
+
+        // Everything is loaded before out (possibly a or b) is written
+        VSTORE(out[0] + i, VSUB(VMUL(ay, bz), VMUL(az, by)));
+        VSTORE(out[1] + i, VSUB(VMUL(az, bx), VMUL(ax, bz)));
+        VSTORE(out[2] + i, VSUB(VMUL(ax, by), VMUL(ay, bx)));
+    }
+}
+
+// out is a plain array of exactly n floats, the last register goes through tmp
+static ATTR void SFN(dot)(float* out, const float* const* a, const float* const* b, size_t components, size_t n) {
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT d = VMUL(VLOAD(a[0] + i), VLOAD(b[0] + i));
+        d = VADD(d, VMUL(VLOAD(a[1] + i), VLOAD(b[1] + i)));
+        d = VADD(d, VMUL(VLOAD(a[2] + i), VLOAD(b[2] + i)));
+        if (components == 4) d = VADD(d, VMUL(VLOAD(a[3] + i), VLOAD(b[3] + i)));
+
+        if (i + W <= n) {
+
+            VSTORE(out + i, d);
+            continue;
+        }
+
+        float tmp[W];
+        VSTORE(tmp, d);
+        for (size_t k = 0; i + k < n; k++) out[i + k] = tmp[k];
+    }
+}
+
+// ===================== MATRICES =====================
+
+#define UNROLL_ALL _Pragma("GCC unroll 16")
+
+// a * b - c * d, and x * p - y * q + z * r
+#define DIFF(a, b, c, d) VSUB(VMUL(a, b), VMUL(c, d))
+#define TRI(x, p, y, q, z, r) VFMA(z, r, DIFF(x, p, y, q))
+
+// out[i] = a[i] * b[i]. Everything is loaded before out (possibly a or b) is written
+#define KERNEL_MAT_MUL(D) \
+static ATTR void SFN(mat_mul##D)(float* const* out, const float* const* a, const float* const* b, size_t n) { \
+    for (size_t i = 0; i < n; i += W) { \
+        VT ra[D * D], rb[D * D], rc[D * D]; \
+        UNROLL_ALL for (int e = 0; e < D * D; e++) { \
+            ra[e] = VLOAD(a[e] + i); \
+            rb[e] = VLOAD(b[e] + i); \
+        } \
+        UNROLL_ALL for (int e = 0; e < D * D; e++) { \
+            VT acc = VMUL(ra[e / D * D], rb[e % D]); \
+            UNROLL_ALL for (int k = 1; k < D; k++) acc = VFMA(ra[e / D * D + k], rb[k * D + e % D], acc); \
+            rc[e] = acc; \
+        } \
+        UNROLL_ALL for (int e = 0; e < D * D; e++) VSTORE(out[e] + i, rc[e]); \
+    } \
+}
+
+KERNEL_MAT_MUL(3)
+KERNEL_MAT_MUL(4)
+
+// Adjugate over determinant, zeros for singular matrices. dets, if not
+// NULL, gets every determinant
+static ATTR void SFN(mat_inverse3)(float* const* out, const float* const* a, float* dets, size_t n) {
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT m[9];
+        UNROLL_ALL for (int e = 0; e < 9; e++) m[e] = VLOAD(a[e] + i);
+
+        VT b00 = DIFF(m[4], m[8], m[5], m[7]), b01 = DIFF(m[2], m[7], m[1], m[8]), b02 = DIFF(m[1], m[5], m[2], m[4]);
+        VT b10 = DIFF(m[5], m[6], m[3], m[8]), b11 = DIFF(m[0], m[8], m[2], m[6]), b12 = DIFF(m[2], m[3], m[0], m[5]);
+        VT b20 = DIFF(m[3], m[7], m[4], m[6]), b21 = DIFF(m[1], m[6], m[0], m[7]), b22 = DIFF(m[0], m[4], m[1], m[3]);
+
+        VT det = VFMA(m[2], b20, VFMA(m[1], b10, VMUL(m[0], b00)));
+        VT inv = VRCP0(det);
+
+        VSTORE(out[0] + i, VMUL(b00, inv));
+        VSTORE(out[1] + i, VMUL(b01, inv));
+        VSTORE(out[2] + i, VMUL(b02, inv));
+        VSTORE(out[3] + i, VMUL(b10, inv));
+        VSTORE(out[4] + i, VMUL(b11, inv));
+        VSTORE(out[5] + i, VMUL(b12, inv));
+        VSTORE(out[6] + i, VMUL(b20, inv));
+        VSTORE(out[7] + i, VMUL(b21, inv));
+        VSTORE(out[8] + i, VMUL(b22, inv));
+        if (dets != NULL) VSTORE(dets + i, det);
+    }
+}
+
+// Laplace expansion along the 2x2 minors of the top (s) and bottom (c) row pairs
+static ATTR void SFN(mat_inverse4)(float* const* out, const float* const* a, float* dets, size_t n) {
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT m[16];
+        UNROLL_ALL for (int e = 0; e < 16; e++) m[e] = VLOAD(a[e] + i);
+
+        VT s0 = DIFF(m[0], m[5], m[4], m[1]), s1 = DIFF(m[0], m[6], m[4], m[2]), s2 = DIFF(m[0], m[7], m[4], m[3]);
+        VT s3 = DIFF(m[1], m[6], m[5], m[2]), s4 = DIFF(m[1], m[7], m[5], m[3]), s5 = DIFF(m[2], m[7], m[6], m[3]);
+        VT c5 = DIFF(m[10], m[15], m[14], m[11]), c4 = DIFF(m[9], m[15], m[13], m[11]), c3 = DIFF(m[9], m[14], m[13], m[10]);
+        VT c2 = DIFF(m[8], m[15], m[12], m[11]), c1 = DIFF(m[8], m[14], m[12], m[10]), c0 = DIFF(m[8], m[13], m[12], m[9]);
+
+        VT det = VADD(VADD(DIFF(s0, c5, s1, c4), DIFF(s2, c3, s4, c1)), VFMA(s3, c2, VMUL(s5, c0)));
+        VT inv = VRCP0(det);
+        VT ninv = VSUB(VSET1(0.0f), inv);
+
+        VSTORE(out[0] + i, VMUL(TRI(m[5], c5, m[6], c4, m[7], c3), inv));
+        VSTORE(out[1] + i, VMUL(TRI(m[1], c5, m[2], c4, m[3], c3), ninv));
+        VSTORE(out[2] + i, VMUL(TRI(m[13], s5, m[14], s4, m[15], s3), inv));
+        VSTORE(out[3] + i, VMUL(TRI(m[9], s5, m[10], s4, m[11], s3), ninv));
+        VSTORE(out[4] + i, VMUL(TRI(m[4], c5, m[6], c2, m[7], c1), ninv));
+        VSTORE(out[5] + i, VMUL(TRI(m[0], c5, m[2], c2, m[3], c1), inv));
+        VSTORE(out[6] + i, VMUL(TRI(m[12], s5, m[14], s2, m[15], s1), ninv));
+        VSTORE(out[7] + i, VMUL(TRI(m[8], s5, m[10], s2, m[11], s1), inv));
+        VSTORE(out[8] + i, VMUL(TRI(m[4], c4, m[5], c2, m[7], c0), inv));
+        VSTORE(out[9] + i, VMUL(TRI(m[0], c4, m[1], c2, m[3], c0), ninv));
+        VSTORE(out[10] + i, VMUL(TRI(m[12], s4, m[13], s2, m[15], s0), inv));
+        VSTORE(out[11] + i, VMUL(TRI(m[8], s4, m[9], s2, m[11], s0), ninv));
+        VSTORE(out[12] + i, VMUL(TRI(m[4], c3, m[5], c1, m[6], c0), ninv));
+        VSTORE(out[13] + i, VMUL(TRI(m[0], c3, m[1], c1, m[2], c0), inv));
+        VSTORE(out[14] + i, VMUL(TRI(m[12], s3, m[13], s1, m[14], s0), ninv));
+        VSTORE(out[15] + i, VMUL(TRI(m[8], s3, m[9], s1, m[10], s0), inv));
+        if (dets != NULL) VSTORE(dets + i, det);
+    }
+}
+
+// Vector i of s transformed by matrix i of m, in place
+static ATTR void SFN(mat_transform3)(const float* const* m, float* const* s, size_t n) {
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT mm[9];
+        UNROLL_ALL for (int e = 0; e < 9; e++) mm[e] = VLOAD(m[e] + i);
+
+        VT x = VLOAD(s[0] + i), y = VLOAD(s[1] + i), z = VLOAD(s[2] + i);
+        VSTORE(s[0] + i, VFMA(mm[0], x, VFMA(mm[1], y, VMUL(mm[2], z))));
+        VSTORE(s[1] + i, VFMA(mm[3], x, VFMA(mm[4], y, VMUL(mm[5], z))));
+        VSTORE(s[2] + i, VFMA(mm[6], x, VFMA(mm[7], y, VMUL(mm[8], z))));
+    }
+}
+
+// Same vec3 point/direction rules as transform
+static ATTR void SFN(mat_transform4)(const float* const* m, float* const* s, size_t components, bool directions, size_t n) {
+
+    bool points = components == 3 && !directions;
+    VT w3 = VSET1(directions ? 0.0f : 1.0f);
+
+    for (size_t i = 0; i < n; i += W) {
+
+        VT mm[4][4];
+        UNROLL_ALL for (int e = 0; e < 16; e++) mm[e / 4][e % 4] = VLOAD(m[e] + i);
+
+        VT x = VLOAD(s[0] + i), y = VLOAD(s[1] + i), z = VLOAD(s[2] + i);
+        VT w = components == 4 ? VLOAD(s[3] + i) : w3;
+
+        VT rx = ROW(0, x, y, z, w), ry = ROW(1, x, y, z, w), rz = ROW(2, x, y, z, w);
+
+        if (points) {
+
+            VT inv = VINVW(ROW(3, x, y, z, w));
+            rx = VMUL(rx, inv);
+            ry = VMUL(ry, inv);
+            rz = VMUL(rz, inv);
+        }
+
+        if (components == 4) VSTORE(s[3] + i, ROW(3, x, y, z, w));
+        VSTORE(s[0] + i, rx);
+        VSTORE(s[1] + i, ry);
+        VSTORE(s[2] + i, rz);
+    }
+}
+
+#undef KERNEL_MAT_MUL
+#undef TRI
+#undef DIFF
+#undef UNROLL_ALL
+#undef ROW
+#undef SFN
+#undef SCAT
+#undef SCAT_
+
+#undef VT
+#undef W
+#undef SUFFIX
+#undef ATTR
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VFMA
+#undef VINVLEN
+#undef VINVW
+#undef VRCP0
@@ -0,0 +1,394 @@
+/**
+ * Sparse vectors and CSR matrices.
+ * The typed operations are stamped out once per component type by
+ * DEFINE_SPARSE_OPS, the allocation helpers work on any of them.
+ * @author Alejandro Ciuba
+ */
+
+#include "sparse.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Rows plus nonzeros one SpMV block covers
+#define SPMV_BLOCK ((size_t)1 << 14)
+
+// ===================== HELPERS =====================
+
+/**
+ * @brief malloc that never hands back NULL for 0 bytes, so empty sparse
+ * structs still look allocated.
+ */
+static void* alloc_bytes(size_t count, size_t data_size) {
+
+    if (data_size != 0 && count > SIZE_MAX / data_size) return NULL;
+    return malloc(count == 0 ? 1 : count * data_size);
+}
+
+/**
+ * @brief Resizes the index and value arrays of s to capacity components.
+ *
+ * @return false if either realloc failed (s is left unchanged).
+ */
+static bool resize_spvec(spvec_double* s, size_t capacity, size_t data_size) {
+
+    if (capacity > SIZE_MAX / sizeof(size_t) || capacity > SIZE_MAX / data_size) return false;
+
+    size_t* index = realloc(s->index, capacity * sizeof(size_t));
+    if (index == NULL) return false;
+    s->index = index;
+
+    void* value = realloc(s->value, capacity * data_size);
+    if (value == NULL) return false;
+    s->value = value;
+
+    s->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief First row i whose row_ptr[i] + i reaches work. Rows plus
+ * nonzeros grow strictly with i, so cutting at multiples of SPMV_BLOCK
+ * gives blocks of about equal work however the nonzeros are spread.
+ *
+ * @return size_t
+ */
+static size_t block_start(const size_t* row_ptr, size_t rows, size_t work) {
+
+    size_t lo = 0, hi = rows;
+    while (lo < hi) {
+
+        size_t mid = lo + (hi - lo) / 2;
+        if (row_ptr[mid] + mid < work) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+// ===================== SPARSE VECTORS =====================
+
+/**
+ * @brief Initialize a malloc'd, empty (all zero) sparse vector. Cast to
+ * your desired sparse vector.
+ *
+ * @param dim Length of the dense vector it stands for.
+ * @param capacity Stored components to make room for (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @return spvec* | NULL
+ */
+void* init_spvec(size_t dim, size_t capacity, size_t data_size) {
+
+    if (data_size == 0) return NULL;
+
+    // Every spvec struct shares spvec_double's layout
+    spvec_double* s = (spvec_double*)malloc(sizeof(spvec_double));
+    if (s == NULL) return NULL;
+
+    s->index = alloc_bytes(capacity, sizeof(size_t));
+    s->value = alloc_bytes(capacity, data_size);
+    s->nnz = 0;
+    s->capacity = capacity;
+    s->dim = dim;
+
+    if (s->index == NULL || s->value == NULL) {
+
+        free_spvec(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+/**
+ * @brief Stores data at position index, which must come after every
+ * position already stored, growing by the default vector policy.
+ *
+ * @param s Sparse vector.
+ * @param index Position, index < s->dim.
+ * @param data The component.
+ * @param data_size Size of one component.
+ * @return false if index is out of range or not past the last one stored,
+ * or s could not grow (s is left unchanged).
+ */
+bool append_spvec(void* s, size_t index, const void* data, size_t data_size) {
+
+    if (s == NULL || data == NULL) return false;
+
+    spvec_double* sp = (spvec_double*)s;
+    if (index >= sp->dim || (sp->nnz > 0 && index <= sp->index[sp->nnz - 1])) return false;
+
+    if (sp->nnz == sp->capacity) {
+
+        size_t capacity = policy_grow(VEC_DEFAULT_POLICY, sp->capacity, sp->nnz + 1);
+        if (capacity == SIZE_MAX || !resize_spvec(sp, capacity, data_size)) return false;
+    }
+
+    sp->index[sp->nnz] = index;
+    memcpy((char*)sp->value + sp->nnz * data_size, data, data_size);
+    sp->nnz++;
+
+    return true;
+}
+
+/**
+ * @brief Frees the given sparse vector and all its components.
+ *
+ * @param s Sparse vector, may be NULL.
+ */
+void free_spvec(void* s) {
+
+    if (s == NULL) return;
+
+    free(((spvec_double*)s)->index);
+    free(((spvec_double*)s)->value);
+    free(s);
+}
+
+// ===================== CSR MATRICES =====================
+
+/**
+ * @brief Initialize a malloc'd, empty (all zero) CSR matrix with room for
+ * nnz components. Fill col and value, then row_ptr and nnz, to build one
+ * by hand. Cast to your desired CSR matrix.
+ *
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param nnz Stored components to make room for (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @return csr* | NULL
+ */
+void* init_csr(size_t rows, size_t cols, size_t nnz, size_t data_size) {
+
+    if (rows == 0 || cols == 0 || data_size == 0 || rows == SIZE_MAX) return NULL;
+
+    // Every csr struct shares csr_double's layout
+    csr_double* a = (csr_double*)malloc(sizeof(csr_double));
+    if (a == NULL) return NULL;
+
+    a->rows = rows;
+    a->cols = cols;
+    a->nnz = 0;
+    a->row_ptr = calloc(rows + 1, sizeof(size_t));
+    a->col = alloc_bytes(nnz, sizeof(size_t));
+    a->value = alloc_bytes(nnz, data_size);
+
+    if (a->row_ptr == NULL || a->col == NULL || a->value == NULL) {
+
+        free_csr(a);
+        return NULL;
+    }
+
+    return a;
+}
+
+/**
+ * @brief Frees the given CSR matrix and all its components.
+ *
+ * @param a CSR matrix, may be NULL.
+ */
+void free_csr(void* a) {
+
+    if (a == NULL) return;
+
+    free(((csr_double*)a)->row_ptr);
+    free(((csr_double*)a)->col);
+    free(((csr_double*)a)->value);
+    free(a);
+}
+
+/**
+ * @brief Orders n triplets by row, then column, into a's arrays with two
+ * stable counting sorts (by column, then by row). Duplicates end up next
+ * to each other. Row and column indices must already be in range.
+ *
+ * @return false if the scratch arrays could not be allocated.
+ */
+static bool fill_csr(csr_double* a, size_t n, const size_t* row, const size_t* col,
+                     const void* value, size_t data_size) {
+
+    size_t* by_col = calloc(a->cols + 1, sizeof(size_t));
+    size_t* order = alloc_bytes(n, sizeof(size_t));
+    size_t* next = alloc_bytes(a->rows, sizeof(size_t));
+    bool ok = by_col != NULL && order != NULL && next != NULL;
+
+    if (ok) {
+
+        // Triplet numbers in column order
+        for (size_t k = 0; k < n; k++) by_col[col[k] + 1]++;
+        for (size_t j = 0; j < a->cols; j++) by_col[j + 1] += by_col[j];
+        for (size_t k = 0; k < n; k++) order[by_col[col[k]]++] = k;
+
+        // Scattered into their rows in that order, so each row comes out sorted
+        for (size_t k = 0; k < n; k++) a->row_ptr[row[k] + 1]++;
+        for (size_t i = 0; i < a->rows; i++) a->row_ptr[i + 1] += a->row_ptr[i];
+        memcpy(next, a->row_ptr, a->rows * sizeof(size_t));
+
+        for (size_t p = 0; p < n; p++) {
+
+            size_t k = order[p];
+            size_t dst = next[row[k]]++;
+            a->col[dst] = col[k];
+            memcpy((char*)a->value + dst * data_size, (const char*)value + k * data_size, data_size);
+        }
+    }
+
+    free(by_col);
+    free(order);
+    free(next);
+
+    return ok;
+}
+
+// ===================== TYPED OPERATIONS =====================
+
+/**
+ * @brief Stamps out the typed sparse operations for one component type.
+ * T is both the component type and the suffix of every name.
+ */
+#define DEFINE_SPARSE_OPS(T) \
+T get_spvec_##T(const spvec_##T* s, size_t index) { \
+    if (s == NULL) return (T)NAN; \
+    size_t lo = 0, hi = s->nnz; \
+    while (lo < hi) { \
+        size_t mid = lo + (hi - lo) / 2; \
+        if (s->index[mid] < index) lo = mid + 1; \
+        else hi = mid; \
+    } \
+    return lo < s->nnz && s->index[lo] == index ? s->value[lo] : (T)0; \
+} \
+\
+spvec_##T* dense_to_spvec_##T(const vec_##T* x) { \
+    if (x == NULL) return NULL; \
+    size_t nnz = 0; \
+    for (size_t i = 0; i < x->size; i++) nnz += x->array[i] != (T)0; \
+    spvec_##T* s = init_spvec(x->size, nnz, sizeof(T)); \
+    if (s == NULL) return NULL; \
+    for (size_t i = 0; i < x->size; i++) { \
+        if (x->array[i] == (T)0) continue; \
+        s->index[s->nnz] = i; \
+        s->value[s->nnz++] = x->array[i]; \
+    } \
+    return s; \
+} \
+\
+vec_##T* spvec_to_dense_##T(const spvec_##T* x) { \
+    if (x == NULL) return NULL; \
+    vec_##T* v = init_vec(x->dim, sizeof(T), false); \
+    if (v == NULL) return NULL; \
+    for (size_t k = 0; k < x->nnz; k++) v->array[x->index[k]] = x->value[k]; \
+    return v; \
+} \
+\
+T dot_spvec_##T(const spvec_##T* x, const vec_##T* y) { \
+    if (x == NULL || y == NULL || x->dim != y->size) return (T)NAN; \
+    T sum = 0; \
+    for (size_t k = 0; k < x->nnz; k++) sum += x->value[k] * y->array[x->index[k]]; \
+    return sum; \
+} \
+\
+bool axpy_spvec_##T(vec_##T* y, T a, const spvec_##T* x) { \
+    if (x == NULL || y == NULL || x->dim != y->size) return false; \
+    /* Written in place behind the index's back */ \
+    drop_index_vec(y); \
+    for (size_t k = 0; k < x->nnz; k++) y->array[x->index[k]] += a * x->value[k]; \
+    return true; \
+} \
+\
+csr_##T* triplets_to_csr_##T(size_t rows, size_t cols, size_t n, \
+                             const size_t* row, const size_t* col, const T* value) { \
+    if (n > 0 && (row == NULL || col == NULL || value == NULL)) return NULL; \
+    for (size_t k = 0; k < n; k++) \
+        if (row[k] >= rows || col[k] >= cols) return NULL; \
+    csr_##T* a = init_csr(rows, cols, n, sizeof(T)); \
+    if (a == NULL) return NULL; \
+    if (!fill_csr((csr_double*)a, n, row, col, value, sizeof(T))) { \
+        free_csr(a); \
+        return NULL; \
+    } \
+    /* Duplicates sit next to each other now: fold them and close the gaps */ \
+    size_t w = 0, lo = 0; \
+    for (size_t i = 0; i < rows; i++) { \
+        size_t hi = a->row_ptr[i + 1]; \
+        a->row_ptr[i] = w; \
+        for (size_t p = lo; p < hi; p++) { \
+            if (w > a->row_ptr[i] && a->col[w - 1] == a->col[p]) { \
+                a->value[w - 1] += a->value[p]; \
+                continue; \
+            } \
+            a->col[w] = a->col[p]; \
+            a->value[w++] = a->value[p]; \
+        } \
+        lo = hi; \
+    } \
+    a->row_ptr[rows] = w; \
+    a->nnz = w; \
+    return a; \
+} \
+\
+csr_##T* dense_to_csr_##T(const mat_##T* m) { \
+    if (m == NULL) return NULL; \
+    size_t nnz = 0; \
+    for (size_t i = 0; i < m->rows; i++) \
+        for (size_t j = 0; j < m->cols; j++) nnz += mat_at(m, i, j) != (T)0; \
+    csr_##T* a = init_csr(m->rows, m->cols, nnz, sizeof(T)); \
+    if (a == NULL) return NULL; \
+    for (size_t i = 0; i < m->rows; i++) { \
+        for (size_t j = 0; j < m->cols; j++) { \
+            if (mat_at(m, i, j) == (T)0) continue; \
+            a->col[a->nnz] = j; \
+            a->value[a->nnz++] = mat_at(m, i, j); \
+        } \
+        a->row_ptr[i + 1] = a->nnz; \
+    } \
+    return a; \
+} \
+\
+mat_##T* csr_to_dense_##T(const csr_##T* a) { \
+    if (a == NULL) return NULL; \
+    mat_##T* m = init_mat(a->rows, a->cols, sizeof(T)); \
+    if (m == NULL) return NULL; \
+    for (size_t i = 0; i < a->rows; i++) \
+        for (size_t k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++) mat_at(m, i, a->col[k]) = a->value[k]; \
+    return m; \
+} \
+\
+typedef struct spmv_ctx_##T { T alpha; T beta; const csr_##T* a; const T* x; T* y; } spmv_ctx_##T; \
+\
+static void spmv_rows_##T(const spmv_ctx_##T* ctx, size_t begin, size_t end) { \
+    const csr_##T* a = ctx->a; \
+    for (size_t i = begin; i < end; i++) { \
+        T sum = 0; \
+        for (size_t k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++) sum += a->value[k] * ctx->x[a->col[k]]; \
+        ctx->y[i] = ctx->beta == (T)0 ? ctx->alpha * sum : ctx->alpha * sum + ctx->beta * ctx->y[i]; \
+    } \
+} \
+\
+static void spmv_task_##T(void* arg, size_t begin, size_t end) { \
+    const spmv_ctx_##T* ctx = (const spmv_ctx_##T*)arg; \
+    const csr_##T* a = ctx->a; \
+    for (size_t b = begin; b < end; b++) { \
+        size_t first = block_start(a->row_ptr, a->rows, b * SPMV_BLOCK); \
+        size_t last = block_start(a->row_ptr, a->rows, (b + 1) * SPMV_BLOCK); \
+        spmv_rows_##T(ctx, first, last); \
+    } \
+} \
+\
+bool spmv_csr_##T(vec_##T* y, T alpha, const csr_##T* a, const vec_##T* x, T beta) { \
+    if (y == NULL || a == NULL || x == NULL) return false; \
+    if (y->size != a->rows || x->size != a->cols || y->array == x->array) return false; \
+    /* Written in place behind the index's back */ \
+    drop_index_vec(y); \
+    spmv_ctx_##T ctx = { alpha, beta, a, x->array, y->array }; \
+    size_t work = a->nnz + a->rows; \
+    if (work < get_parallel_threshold() || work <= SPMV_BLOCK || get_thread_count() == 1) { \
+        spmv_rows_##T(&ctx, 0, a->rows); \
+        return true; \
+    } \
+    parallel_for(0, (work + SPMV_BLOCK - 1) / SPMV_BLOCK, 1, spmv_task_##T, &ctx); \
+    return true; \
+}
+
+DEFINE_SPARSE_OPS(float)
+DEFINE_SPARSE_OPS(double)
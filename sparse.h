@@ -0,0 +1,223 @@
+/**
+ * @file sparse.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Sparse vectors (sorted index/value arrays) and compressed sparse
+ * row (CSR) matrices of floats and doubles, next to the dense vec_float,
+ * vec_double, mat_float and mat_double. Memory and time scale with the
+ * number of stored components, not the dimensions: dot products and AXPY
+ * against dense vectors touch only the stored positions, and SpMV splits
+ * the rows across the thread pool.
+ * @version 0.1
+ * @date 2022-09-05
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "vector.h"
+#include "matrix.h"
+
+/**
+ * @brief Shared bookkeeping for every sparse vector struct:
+ * - size_t* index: Positions of the stored components, strictly increasing.
+ * - size_t nnz: Number of stored components.
+ * - size_t capacity: Room in index and value.
+ * - size_t dim: Length of the dense vector it stands for.
+ */
+#define spvec_metadata size_t* index; size_t nnz; size_t capacity; size_t dim
+
+/**
+ * @brief The sparse vector structs containing the following:
+ * - type* value: value[k] is the component at position index[k], every
+ *   other component is 0.
+ * - spvec_metadata: index, nnz, capacity and dim (see above).
+ *
+ * types: spvec_float and spvec_double
+ */
+typedef struct sparse_vector_float {
+
+    float* value;
+    spvec_metadata;
+} spvec_float;
+
+typedef struct sparse_vector_double {
+
+    double* value;
+    spvec_metadata;
+} spvec_double;
+
+/**
+ * @brief Shared bookkeeping for every CSR matrix struct:
+ * - size_t rows, cols: Dimensions of the matrix.
+ * - size_t nnz: Number of stored components (row_ptr[rows]).
+ * - size_t* row_ptr: rows + 1 offsets, row i is stored in
+ *   [row_ptr[i], row_ptr[i + 1]).
+ * - size_t* col: Column of every stored component, strictly increasing
+ *   within a row.
+ */
+#define csr_metadata size_t rows; size_t cols; size_t nnz; size_t* row_ptr; size_t* col
+
+/**
+ * @brief The CSR matrix structs containing the following:
+ * - type* value: value[k] is the component at row i, column col[k], for
+ *   row_ptr[i] <= k < row_ptr[i + 1].
+ * - csr_metadata: rows, cols, nnz, row_ptr and col (see above).
+ *
+ * types: csr_float and csr_double
+ */
+typedef struct csr_matrix_float {
+
+    float* value;
+    csr_metadata;
+} csr_float;
+
+typedef struct csr_matrix_double {
+
+    double* value;
+    csr_metadata;
+} csr_double;
+
+// ===================== SPARSE VECTORS =====================
+
+/**
+ * @brief Initialize a malloc'd, empty (all zero) sparse vector. Cast to
+ * your desired sparse vector.
+ *
+ * @param dim Length of the dense vector it stands for.
+ * @param capacity Stored components to make room for (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @return spvec* | NULL
+ */
+void* init_spvec(size_t dim, size_t capacity, size_t data_size);
+
+/**
+ * @brief Stores data at position index, which must come after every
+ * position already stored, growing by the default vector policy.
+ *
+ * @param s Sparse vector.
+ * @param index Position, index < s->dim.
+ * @param data The component.
+ * @param data_size Size of one component.
+ * @return false if index is out of range or not past the last one stored,
+ * or s could not grow (s is left unchanged).
+ */
+bool append_spvec(void* s, size_t index, const void* data, size_t data_size);
+
+/**
+ * @brief Frees the given sparse vector and all its components.
+ *
+ * @param s Sparse vector, may be NULL.
+ */
+void free_spvec(void* s);
+
+/**
+ * @brief Component at position index, found by binary search.
+ *
+ * @return type 0 if it is not stored or index >= s->dim, NAN if s is NULL.
+ */
+float get_spvec_float(const spvec_float* s, size_t index);
+double get_spvec_double(const spvec_double* s, size_t index);
+
+/**
+ * @brief Sparse copy of a dense vector, keeping its nonzero components.
+ *
+ * @return spvec* | NULL
+ */
+spvec_float* dense_to_spvec_float(const vec_float* x);
+spvec_double* dense_to_spvec_double(const vec_double* x);
+
+/**
+ * @brief Dense copy of a sparse vector, x->dim components long.
+ *
+ * @return vec* | NULL
+ */
+vec_float* spvec_to_dense_float(const spvec_float* x);
+vec_double* spvec_to_dense_double(const spvec_double* x);
+
+/**
+ * @brief Sparse-dense dot product, touching only the stored components.
+ *
+ * @return type NAN if either is NULL or x->dim != y->size.
+ */
+float dot_spvec_float(const spvec_float* x, const vec_float* y);
+double dot_spvec_double(const spvec_double* x, const vec_double* y);
+
+/**
+ * @brief y = a * x + y for sparse x and dense y, in place.
+ *
+ * @return false if either is NULL or x->dim != y->size.
+ */
+bool axpy_spvec_float(vec_float* y, float a, const spvec_float* x);
+bool axpy_spvec_double(vec_double* y, double a, const spvec_double* x);
+
+// ===================== CSR MATRICES =====================
+
+/**
+ * @brief Initialize a malloc'd, empty (all zero) CSR matrix with room for
+ * nnz components. Fill col and value, then row_ptr and nnz, to build one
+ * by hand. Cast to your desired CSR matrix.
+ *
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param nnz Stored components to make room for (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @return csr* | NULL
+ */
+void* init_csr(size_t rows, size_t cols, size_t nnz, size_t data_size);
+
+/**
+ * @brief Frees the given CSR matrix and all its components.
+ *
+ * @param a CSR matrix, may be NULL.
+ */
+void free_csr(void* a);
+
+/**
+ * @brief Builds a rows x cols CSR matrix from n (row, col, value)
+ * triplets in any order, without a dense intermediate. Duplicate
+ * positions are summed in the order given. Runs in O(n + rows + cols).
+ *
+ * @return csr* | NULL if a position is out of range or allocation failed.
+ */
+csr_float* triplets_to_csr_float(size_t rows, size_t cols, size_t n,
+                                 const size_t* row, const size_t* col, const float* value);
+csr_double* triplets_to_csr_double(size_t rows, size_t cols, size_t n,
+                                   const size_t* row, const size_t* col, const double* value);
+
+/**
+ * @brief CSR copy of a dense matrix, keeping its nonzero components.
+ *
+ * @return csr* | NULL
+ */
+csr_float* dense_to_csr_float(const mat_float* a);
+csr_double* dense_to_csr_double(const mat_double* a);
+
+/**
+ * @brief Dense copy of a CSR matrix.
+ *
+ * @return mat* | NULL
+ */
+mat_float* csr_to_dense_float(const csr_float* a);
+mat_double* csr_to_dense_double(const csr_double* a);
+
+/**
+ * @brief Sparse matrix-vector product y = alpha * A * x + beta * y. Rows
+ * are split into blocks of about equal nonzeros across the thread pool
+ * once nnz reaches get_parallel_threshold(). Every row is summed by one
+ * thread in column order, so the result does not depend on the thread
+ * count. When beta == 0, y is not read.
+ *
+ * @param y Result, y->size == a->rows.
+ * @param alpha Scalar for A * x.
+ * @param a CSR matrix.
+ * @param x Vector, x->size == a->cols.
+ * @param beta Scalar for the old y.
+ * @return false if any is NULL, the shapes do not match, or y is x.
+ */
+bool spmv_csr_float(vec_float* y, float alpha, const csr_float* a, const vec_float* x, float beta);
+bool spmv_csr_double(vec_double* y, double alpha, const csr_double* a, const vec_double* x, double beta);
+
+#endif
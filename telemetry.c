@@ -0,0 +1,230 @@
+/**
+ * Per-thread operation counters.
+ * Each thread counts into its own block, linked into a global list the
+ * first time it counts anything so snapshots can reach it. A thread
+ * folds its block into the retired totals when it exits.
+ * @author Alejandro Ciuba
+ */
+
+#include "telemetry.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+static const char* const op_names[TELEMETRY_OP_COUNT] = {
+
+    "vec_init", "vec_append", "vec_insert", "vec_replace", "vec_erase",
+    "vec_erase_if", "vec_contains", "vec_get_deep", "vec_resize", "vec_free",
+    "arl_init", "arl_append", "arl_insert", "arl_replace", "arl_erase",
+    "arl_erase_if", "arl_contains", "arl_get_deep", "arl_resize", "arl_free"
+};
+
+#ifdef CATORCE_TELEMETRY
+
+// Flat view of telemetry_stats: per-op calls and cycles, then the totals
+#define COUNTERS (sizeof(telemetry_stats) / sizeof(uint64_t))
+#define CALLS(op) (op)
+#define CYCLES(op) (TELEMETRY_OP_COUNT + (op))
+#define TOTAL(field) (offsetof(telemetry_stats, field) / sizeof(uint64_t))
+
+/**
+ * @brief A thread's counters. Only the owner writes them, with plain
+ * relaxed load/store pairs (no locked instructions); the atomics are
+ * there so snapshots from other threads read whole values.
+ */
+typedef struct thread_counters {
+
+    _Atomic uint64_t c[COUNTERS];
+    struct thread_counters* next;
+    struct thread_counters* prev;
+} thread_counters;
+
+static _Thread_local thread_counters local;
+static _Thread_local bool registered = false;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static thread_counters* registry = NULL;
+static uint64_t retired[COUNTERS];
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t exit_key;
+
+// ===================== REGISTRY =====================
+
+static void thread_exit(void* arg) {
+
+    thread_counters* t = (thread_counters*)arg;
+
+    pthread_mutex_lock(&registry_lock);
+
+    for (size_t i = 0; i < COUNTERS; i++) retired[i] += atomic_load_explicit(&t->c[i], memory_order_relaxed);
+
+    if (t->prev != NULL) t->prev->next = t->next;
+    else registry = t->next;
+    if (t->next != NULL) t->next->prev = t->prev;
+
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static void make_key(void) {
+    pthread_key_create(&exit_key, thread_exit);
+}
+
+// The calling thread's block, linked in on first use
+static thread_counters* counters(void) {
+
+    if (registered) return &local;
+
+    pthread_once(&key_once, make_key);
+    pthread_setspecific(exit_key, &local);
+
+    pthread_mutex_lock(&registry_lock);
+    local.prev = NULL;
+    local.next = registry;
+    if (registry != NULL) registry->prev = &local;
+    registry = &local;
+    pthread_mutex_unlock(&registry_lock);
+
+    registered = true;
+    return &local;
+}
+
+static void bump(size_t counter, uint64_t by) {
+
+    _Atomic uint64_t* c = &counters()->c[counter];
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+static void copy_out(const thread_counters* t, uint64_t* out) {
+
+    for (size_t i = 0; i < COUNTERS; i++) out[i] += atomic_load_explicit(&t->c[i], memory_order_relaxed);
+}
+
+// ===================== HOOKS =====================
+
+void telemetry_record(telemetry_op op, uint64_t cycles) {
+
+    bump(CALLS(op), 1);
+    bump(CYCLES(op), cycles);
+}
+
+void telemetry_alloc(size_t bytes) {
+
+    bump(TOTAL(allocations), 1);
+    bump(TOTAL(bytes_allocated), bytes);
+}
+
+void telemetry_copy(size_t bytes) { bump(TOTAL(bytes_copied), bytes); }
+
+void telemetry_resize(bool grew) { bump(grew ? TOTAL(grows) : TOTAL(shrinks), 1); }
+
+#else
+
+void telemetry_record(telemetry_op op, uint64_t cycles) { (void)op; (void)cycles; }
+void telemetry_alloc(size_t bytes) { (void)bytes; }
+void telemetry_copy(size_t bytes) { (void)bytes; }
+void telemetry_resize(bool grew) { (void)grew; }
+
+#endif
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Whether the library was built with CATORCE_TELEMETRY.
+ *
+ * @return bool
+ */
+bool telemetry_enabled(void) {
+
+#ifdef CATORCE_TELEMETRY
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Copies the calling thread's counters.
+ *
+ * @param out Filled in, all zeros without telemetry.
+ */
+void telemetry_snapshot(telemetry_stats* out) {
+
+    if (out == NULL) return;
+    memset(out, 0, sizeof(*out));
+
+#ifdef CATORCE_TELEMETRY
+    copy_out(counters(), (uint64_t*)out);
+#endif
+}
+
+/**
+ * @brief Adds up the counters of every thread that has counted anything,
+ * including threads that already exited. Other threads keep counting
+ * meanwhile, so their part may be a few operations behind.
+ *
+ * @param out Filled in, all zeros without telemetry.
+ */
+void telemetry_snapshot_all(telemetry_stats* out) {
+
+    if (out == NULL) return;
+    memset(out, 0, sizeof(*out));
+
+#ifdef CATORCE_TELEMETRY
+    uint64_t* flat = (uint64_t*)out;
+
+    pthread_mutex_lock(&registry_lock);
+    for (size_t i = 0; i < COUNTERS; i++) flat[i] = retired[i];
+    for (const thread_counters* t = registry; t != NULL; t = t->next) copy_out(t, flat);
+    pthread_mutex_unlock(&registry_lock);
+#endif
+}
+
+/**
+ * @brief Zeroes the calling thread's counters.
+ */
+void telemetry_reset(void) {
+
+#ifdef CATORCE_TELEMETRY
+    thread_counters* t = counters();
+    for (size_t i = 0; i < COUNTERS; i++) atomic_store_explicit(&t->c[i], 0, memory_order_relaxed);
+#endif
+}
+
+/**
+ * @brief Name of op, e.g. "vec_append".
+ *
+ * @return "unknown" for anything out of range.
+ */
+const char* telemetry_op_name(telemetry_op op) {
+    return (unsigned)op < TELEMETRY_OP_COUNT ? op_names[op] : "unknown";
+}
+
+/**
+ * @brief Prints s as a table: calls, total and per-call cycles for every
+ * operation that ran, then the allocation, copy and resize totals.
+ *
+ * @param out Stream to print to.
+ * @param s Counters, e.g. from telemetry_snapshot_all.
+ * @return false if either is NULL or writing failed.
+ */
+bool telemetry_dump(FILE* out, const telemetry_stats* s) {
+
+    if (out == NULL || s == NULL) return false;
+
+    bool ok = fprintf(out, "%-14s %14s %18s %12s\n", "operation", "calls", "cycles", "cycles/call") >= 0;
+
+    for (int op = 0; ok && op < TELEMETRY_OP_COUNT; op++) {
+
+        if (s->calls[op] == 0) continue;
+        ok = fprintf(out, "%-14s %14llu %18llu %12.1f\n", op_names[op], (unsigned long long)s->calls[op],
+                     (unsigned long long)s->cycles[op], (double)s->cycles[op] / (double)s->calls[op]) >= 0;
+    }
+
+    ok = ok && fprintf(out, "allocations %llu (%llu bytes), copied %llu bytes, grows %llu, shrinks %llu\n",
+                       (unsigned long long)s->allocations, (unsigned long long)s->bytes_allocated,
+                       (unsigned long long)s->bytes_copied, (unsigned long long)s->grows,
+                       (unsigned long long)s->shrinks) >= 0;
+
+    return ok;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file telemetry.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Optional operation counters for vectors and array lists, for
+ * finding out whether latency goes into resizes, per-element mallocs or
+ * copies. Build with -DCATORCE_TELEMETRY (make TELEMETRY=1) and every
+ * vector and list operation counts its calls and the cycles it took
+ * (rdtsc on x86, nanoseconds elsewhere), along with heap allocations,
+ * bytes copied and resizes. Counters are per thread, so counting never
+ * contends; telemetry_snapshot_all adds up every thread.
+ *
+ * Without CATORCE_TELEMETRY the TELEMETRY_* hooks expand to nothing, so
+ * the library compiles to exactly what it was without them. The API below
+ * still links, and every snapshot is all zeros.
+ * @version 0.1
+ * @date 2022-09-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#if defined(CATORCE_TELEMETRY) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#elif defined(CATORCE_TELEMETRY)
+#include <time.h>
+#endif
+
+/**
+ * @brief Operations counted. Element reads that neither allocate nor
+ * copy (get, get_shallow, direct array access) are left out.
+ * - *_INIT: init_vec / init_arl and their variants.
+ * - *_APPEND: One component (typed fast path included).
+ * - *_INSERT: append_n and insert_range.
+ * - *_REPLACE, *_ERASE (erase_range, delete), *_ERASE_IF, *_CONTAINS,
+ *   *_GET_DEEP, *_FREE: Their functions.
+ * - *_RESIZE: Every capacity change, automatic or asked for (reserve,
+ *   shrink_to_fit, upsize, downsize).
+ */
+typedef enum {
+
+    TELEMETRY_VEC_INIT,
+    TELEMETRY_VEC_APPEND,
+    TELEMETRY_VEC_INSERT,
+    TELEMETRY_VEC_REPLACE,
+    TELEMETRY_VEC_ERASE,
+    TELEMETRY_VEC_ERASE_IF,
+    TELEMETRY_VEC_CONTAINS,
+    TELEMETRY_VEC_GET_DEEP,
+    TELEMETRY_VEC_RESIZE,
+    TELEMETRY_VEC_FREE,
+    TELEMETRY_ARL_INIT,
+    TELEMETRY_ARL_APPEND,
+    TELEMETRY_ARL_INSERT,
+    TELEMETRY_ARL_REPLACE,
+    TELEMETRY_ARL_ERASE,
+    TELEMETRY_ARL_ERASE_IF,
+    TELEMETRY_ARL_CONTAINS,
+    TELEMETRY_ARL_GET_DEEP,
+    TELEMETRY_ARL_RESIZE,
+    TELEMETRY_ARL_FREE,
+    TELEMETRY_OP_COUNT
+} telemetry_op;
+
+/**
+ * @brief A copy of the counters containing the following:
+ * - uint64_t calls[op], cycles[op]: Times each operation ran and the
+ *   cycles spent inside it, nested operations included (an append that
+ *   resizes also counts toward TELEMETRY_VEC_RESIZE).
+ * - uint64_t allocations, bytes_allocated: Blocks taken from malloc,
+ *   calloc, realloc or aligned_alloc, and their size. Blocks recycled by
+ *   the vector pool are not allocations.
+ * - uint64_t bytes_copied: Component bytes moved by memcpy/memmove, and by
+ *   realloc when it had to move the block.
+ * - uint64_t grows, shrinks: Capacity changes, as in resize_stats.
+ */
+typedef struct telemetry_stats {
+
+    uint64_t calls[TELEMETRY_OP_COUNT];
+    uint64_t cycles[TELEMETRY_OP_COUNT];
+    uint64_t allocations;
+    uint64_t bytes_allocated;
+    uint64_t bytes_copied;
+    uint64_t grows;
+    uint64_t shrinks;
+} telemetry_stats;
+
+// ===================== HOOKS =====================
+
+/**
+ * @brief Counting entry points behind the hooks, not meant to be called
+ * directly.
+ */
+void telemetry_record(telemetry_op op, uint64_t cycles);
+void telemetry_alloc(size_t bytes);
+void telemetry_copy(size_t bytes);
+void telemetry_resize(bool grew);
+
+#ifdef CATORCE_TELEMETRY
+
+static inline uint64_t telemetry_clock(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+#endif
+}
+
+typedef struct telemetry_scope {
+
+    telemetry_op op;
+    uint64_t start;
+} telemetry_scope;
+
+static inline void telemetry_scope_end(telemetry_scope* s) { telemetry_record(s->op, telemetry_clock() - s->start); }
+
+/**
+ * @brief TELEMETRY_SCOPE(op) counts one call of op and times it until the
+ * enclosing block is left, whichever return it leaves by. The others
+ * count what their name says.
+ */
+#define TELEMETRY_SCOPE(op) \
+    telemetry_scope telemetry_scope_ __attribute__((cleanup(telemetry_scope_end))) = { (op), telemetry_clock() }
+#define TELEMETRY_ALLOC(bytes) telemetry_alloc(bytes)
+#define TELEMETRY_COPY(bytes) telemetry_copy(bytes)
+#define TELEMETRY_RESIZE(grew) telemetry_resize(grew)
+
+#else
+
+// sizeof keeps the arguments "used" without evaluating them
+#define TELEMETRY_SCOPE(op) ((void)0)
+#define TELEMETRY_ALLOC(bytes) ((void)sizeof(bytes))
+#define TELEMETRY_COPY(bytes) ((void)sizeof(bytes))
+#define TELEMETRY_RESIZE(grew) ((void)sizeof(grew))
+
+#endif
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Whether the library was built with CATORCE_TELEMETRY.
+ *
+ * @return bool
+ */
+bool telemetry_enabled(void);
+
+/**
+ * @brief Copies the calling thread's counters.
+ *
+ * @param out Filled in, all zeros without telemetry.
+ */
+void telemetry_snapshot(telemetry_stats* out);
+
+/**
+ * @brief Adds up the counters of every thread that has counted anything,
+ * including threads that already exited. Other threads keep counting
+ * meanwhile, so their part may be a few operations behind.
+ *
+ * @param out Filled in, all zeros without telemetry.
+ */
+void telemetry_snapshot_all(telemetry_stats* out);
+
+/**
+ * @brief Zeroes the calling thread's counters.
+ */
+void telemetry_reset(void);
+
+/**
+ * @brief Name of op, e.g. "vec_append".
+ *
+ * @return "unknown" for anything out of range.
+ */
+const char* telemetry_op_name(telemetry_op op);
+
+/**
+ * @brief Prints s as a table: calls, total and per-call cycles for every
+ * operation that ran, then the allocation, copy and resize totals.
+ *
+ * @param out Stream to print to.
+ * @param s Counters, e.g. from telemetry_snapshot_all.
+ * @return false if either is NULL or writing failed.
+ */
+bool telemetry_dump(FILE* out, const telemetry_stats* s);
+
+#endif
@@ -11,17 +11,42 @@
 
  // TO TEST
 #include "vector.h"
+#include "vector_math.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include "arena.h"
+#include "value_types.h"
+#include "hash_index.h"
+#include "vector_search.h"
+#include "vector_view.h"
+#include "vector_mmap.h"
+#include "vector_io.h"
+#include "sparse.h"
+#include "soa.h"
+#include "vector_expr.h"
+#include "linalg.h"
+#include "vector_shared.h"
+#include "vector_ring.h"
+#include "telemetry.h"
+#include "array_list.h"
 
 // REQUIRED STANDARDS
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h> 
+#include <unistd.h>
+#include <fcntl.h>
 #include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
 
 // Error-check
 typedef enum { FAILED, PASSED } test;
 
+// Data types selectable with -d
+typedef enum { NO_TYPE, CHAR, INT32, INT64, FLOAT32, DOUBLE } type;
+
 // HELPER FUNCTIONS & GLOBAL
 size_t data_size = 0x00;
 type data_type = NO_TYPE;
@@ -30,73 +55,332 @@ time_t seed = 0x00;
 
 bool comp_data(const void* arg1, const void* arg2, type data_type);
 bool parse_args(int argc, char* argv[]);
+size_t get_data_size(type data_type);
+void fill_random(vec_void* v);
+bool close_enough(double got, double want, double tol);
 
 // PREFIXTURES
-vec* prefixtures(type data_type, int init_size, bool fixed_length);
-void run_test_case(test(*test_case[])(vec*), int size);
+vec_void* prefixtures(type data_type, int init_size, bool fixed_length);
+void run_test_case(test(*test_case[])(vec_void*), int size);
 
 // TEAR DOWN
-void teardown(vec* v);
+void teardown(vec_void* v);
 
 // TESTS FOR VECTOR_H
-test test_init_vec(vec* v);
-test test_append(vec* v);
-test test_replace(vec* v);
-test test_contains(vec* v);
-test test_get_deep(vec* v);
-test test_get_shallow(vec* v);
-test test_get_data_size(vec* v);
-test test_byte_size(vec* v);
-test test_upsize(vec* v);
-test test_downsize(vec* v);
-test test_free_vec(vec* v);
+test test_init_vec(vec_void* v);
+test test_append(vec_void* v);
+test test_replace(vec_void* v);
+test test_contains(vec_void* v);
+test test_get_deep(vec_void* v);
+test test_byte_size(vec_void* v);
+test test_reserve(vec_void* v);
+test test_shrink_to_fit(vec_void* v);
+test test_upsize(vec_void* v);
+test test_downsize(vec_void* v);
+test test_typed_macros(vec_void* v);
+test test_typed_api(vec_void* v);
+test test_batch_edits(vec_void* v);
+test test_growth_policy(vec_void* v);
+test test_free_vec(vec_void* v);
+
+// TESTS FOR VECTOR_MATH_H
+test test_math_float(vec_void* v);
+test test_math_double(vec_void* v);
+test test_math_errors(vec_void* v);
+
+// TESTS FOR MATRIX_H
+test test_init_mat(vec_void* v);
+test test_gemm_float(vec_void* v);
+test test_gemm_double(vec_void* v);
+
+// TESTS FOR THREAD_POOL_H
+test test_parallel_for(vec_void* v);
+test test_parallel_math(vec_void* v);
+test test_parallel_gemm(vec_void* v);
+test test_parallel_nested(vec_void* v);
+test test_parallel_reduce(vec_void* v);
+
+// TESTS FOR ARENA_H
+test test_arena_alloc(vec_void* v);
+test test_arena_vec(vec_void* v);
+
+// TESTS FOR VALUE_TYPES_H
+test test_value_types(vec_void* v);
+test test_vec_pool(vec_void* v);
+
+// TESTS FOR HASH_INDEX_H
+test test_hash_index(vec_void* v);
+test test_indexed_contains(vec_void* v);
+
+// TESTS FOR VECTOR_SEARCH_H
+test test_search_kernels(vec_void* v);
+test test_scan_contains(vec_void* v);
+
+// TESTS FOR VECTOR_VIEW_H
+test test_view_slices(vec_void* v);
+test test_view_math(vec_void* v);
+
+// TESTS FOR VECTOR_MMAP_H
+test test_vec_file(vec_void* v);
+test test_vec_file_errors(vec_void* v);
+
+// TESTS FOR VECTOR_IO_H
+test test_stream_roundtrip(vec_void* v);
+test test_stream_corruption(vec_void* v);
+
+// TESTS FOR SPARSE_H
+test test_spvec(vec_void* v);
+test test_spmv(vec_void* v);
+
+// TESTS FOR SOA_H
+test test_soa_container(vec_void* v);
+test test_soa_kernels(vec_void* v);
+test test_soa_mat(vec_void* v);
+test test_soa_mat_kernels(vec_void* v);
+
+// TESTS FOR VECTOR_EXPR_H
+test test_expr_fused(vec_void* v);
+test test_expr_errors(vec_void* v);
+
+// TESTS FOR VECTOR_MATH_H STATISTICS
+test test_stats_reproducible(vec_void* v);
+test test_stats_edges(vec_void* v);
+
+// TESTS FOR LINALG_H
+test test_lu_solve(vec_void* v);
+test test_cholesky_solve(vec_void* v);
+
+// TESTS FOR VECTOR_SHARED_H
+test test_vec_shared(vec_void* v);
+test test_vec_shared_threads(vec_void* v);
+
+// TESTS FOR VECTOR_RING_H
+test test_vec_ring(vec_void* v);
+test test_vec_ring_threads(vec_void* v);
+
+// TESTS FOR TELEMETRY_H
+test test_telemetry(vec_void* v);
+
+// TESTS FOR ARRAY_LIST_H
+test test_arl_modes(vec_void* v);
+test test_arl_batch(vec_void* v);
+test test_arl_policy(vec_void* v);
+test test_arl_index(vec_void* v);
+test test_arl_io(vec_void* v);
 
 int main(int argc, char* argv[]) {
 
     // GET TESTING ARGUMENTS
     if ((argc != 5 && argc != 7) || !parse_args(argc, argv)) {
 
-        printf("\nINVALID FORMAT:\n\t./test -d [DATA_TYPE|0-6] -n [INIT_CAPACITY|0-MAX_INT] opt. -s [SEED]\n");
+        printf("\nINVALID FORMAT:\n\t./test -d [DATA_TYPE|0-5] -n [INIT_CAPACITY|0-MAX_INT] opt. -s [SEED]\n");
         exit(-1);
     }
 
+    data_size = get_data_size(data_type);
+    srand(seed);
+
     // TEST CASE I: VECTOR_H
     printf("TEST CASE I: VECTOR_H\n");
 
-    int tc1_size = 11;
-    test(*test_case_1[])(vec*) = { test_init_vec, test_append, test_replace,
-                                    test_contains, test_get_deep, test_get_shallow,
-                                    test_get_data_size, test_byte_size, test_upsize,
-                                    test_downsize, test_free_vec };
+    int tc1_size = 15;
+    test(*test_case_1[])(vec_void*) = { test_init_vec, test_append, test_replace,
+                                        test_contains, test_get_deep, test_byte_size,
+                                        test_reserve, test_shrink_to_fit, test_upsize,
+                                        test_downsize, test_typed_macros, test_typed_api,
+                                        test_batch_edits, test_growth_policy, test_free_vec };
 
     run_test_case(test_case_1, tc1_size);
 
+    // TEST CASE II: VECTOR_MATH_H
+    printf("TEST CASE II: VECTOR_MATH_H\n");
+
+    int tc2_size = 3;
+    test(*test_case_2[])(vec_void*) = { test_math_float, test_math_double, test_math_errors };
+
+    run_test_case(test_case_2, tc2_size);
+
+    // TEST CASE III: MATRIX_H
+    printf("TEST CASE III: MATRIX_H\n");
+
+    int tc3_size = 3;
+    test(*test_case_3[])(vec_void*) = { test_init_mat, test_gemm_float, test_gemm_double };
+
+    run_test_case(test_case_3, tc3_size);
+
+    // TEST CASE IV: THREAD_POOL_H
+    printf("TEST CASE IV: THREAD_POOL_H\n");
+
+    int tc4_size = 5;
+    test(*test_case_4[])(vec_void*) = { test_parallel_for, test_parallel_math, test_parallel_gemm, test_parallel_nested,
+                                        test_parallel_reduce };
+
+    run_test_case(test_case_4, tc4_size);
+    free_thread_pool();
+
+    // TEST CASE V: ARENA_H
+    printf("TEST CASE V: ARENA_H\n");
+
+    int tc5_size = 2;
+    test(*test_case_5[])(vec_void*) = { test_arena_alloc, test_arena_vec };
+
+    run_test_case(test_case_5, tc5_size);
+
+    // TEST CASE VI: VALUE_TYPES_H
+    printf("TEST CASE VI: VALUE_TYPES_H\n");
+
+    int tc6_size = 2;
+    test(*test_case_6[])(vec_void*) = { test_value_types, test_vec_pool };
+
+    run_test_case(test_case_6, tc6_size);
+
+    // TEST CASE VII: HASH_INDEX_H
+    printf("TEST CASE VII: HASH_INDEX_H\n");
+
+    int tc7_size = 2;
+    test(*test_case_7[])(vec_void*) = { test_hash_index, test_indexed_contains };
+
+    run_test_case(test_case_7, tc7_size);
+    trim_vec_pool();
+
+    // TEST CASE VIII: VECTOR_SEARCH_H
+    printf("TEST CASE VIII: VECTOR_SEARCH_H\n");
+
+    int tc8_size = 2;
+    test(*test_case_8[])(vec_void*) = { test_search_kernels, test_scan_contains };
+
+    run_test_case(test_case_8, tc8_size);
+    trim_vec_pool();
+
+    // TEST CASE IX: VECTOR_VIEW_H
+    printf("TEST CASE IX: VECTOR_VIEW_H\n");
+
+    int tc9_size = 2;
+    test(*test_case_9[])(vec_void*) = { test_view_slices, test_view_math };
+
+    run_test_case(test_case_9, tc9_size);
+    trim_vec_pool();
+
+    // TEST CASE X: VECTOR_MMAP_H
+    printf("TEST CASE X: VECTOR_MMAP_H\n");
+
+    int tc10_size = 2;
+    test(*test_case_10[])(vec_void*) = { test_vec_file, test_vec_file_errors };
+
+    run_test_case(test_case_10, tc10_size);
+    trim_vec_pool();
+
+    // TEST CASE XI: VECTOR_IO_H
+    printf("TEST CASE XI: VECTOR_IO_H\n");
+
+    int tc11_size = 2;
+    test(*test_case_11[])(vec_void*) = { test_stream_roundtrip, test_stream_corruption };
+
+    run_test_case(test_case_11, tc11_size);
+    trim_vec_pool();
+
+    // TEST CASE XII: SPARSE_H
+    printf("TEST CASE XII: SPARSE_H\n");
+
+    int tc12_size = 2;
+    test(*test_case_12[])(vec_void*) = { test_spvec, test_spmv };
+
+    run_test_case(test_case_12, tc12_size);
+    trim_vec_pool();
+
+    // TEST CASE XIII: SOA_H
+    printf("TEST CASE XIII: SOA_H\n");
+
+    int tc13_size = 4;
+    test(*test_case_13[])(vec_void*) = { test_soa_container, test_soa_kernels, test_soa_mat, test_soa_mat_kernels };
+
+    run_test_case(test_case_13, tc13_size);
+    trim_vec_pool();
+
+    // TEST CASE XIV: VECTOR_EXPR_H
+    printf("TEST CASE XIV: VECTOR_EXPR_H\n");
+
+    int tc14_size = 2;
+    test(*test_case_14[])(vec_void*) = { test_expr_fused, test_expr_errors };
+
+    run_test_case(test_case_14, tc14_size);
+    trim_vec_pool();
+
+    // TEST CASE XV: VECTOR_MATH_H STATISTICS
+    printf("TEST CASE XV: VECTOR_MATH_H STATISTICS\n");
+
+    int tc15_size = 2;
+    test(*test_case_15[])(vec_void*) = { test_stats_reproducible, test_stats_edges };
+
+    run_test_case(test_case_15, tc15_size);
+    trim_vec_pool();
+
+    // TEST CASE XVI: LINALG_H
+    printf("TEST CASE XVI: LINALG_H\n");
+
+    int tc16_size = 2;
+    test(*test_case_16[])(vec_void*) = { test_lu_solve, test_cholesky_solve };
+
+    run_test_case(test_case_16, tc16_size);
+    trim_vec_pool();
+
+    // TEST CASE XVII: VECTOR_SHARED_H
+    printf("TEST CASE XVII: VECTOR_SHARED_H\n");
+
+    int tc17_size = 2;
+    test(*test_case_17[])(vec_void*) = { test_vec_shared, test_vec_shared_threads };
+
+    run_test_case(test_case_17, tc17_size);
+    trim_vec_pool();
+
+    // TEST CASE XVIII: VECTOR_RING_H
+    printf("TEST CASE XVIII: VECTOR_RING_H\n");
+
+    int tc18_size = 2;
+    test(*test_case_18[])(vec_void*) = { test_vec_ring, test_vec_ring_threads };
+
+    run_test_case(test_case_18, tc18_size);
+    trim_vec_pool();
+
+    // TEST CASE XIX: TELEMETRY_H
+    printf("TEST CASE XIX: TELEMETRY_H\n");
+
+    int tc19_size = 1;
+    test(*test_case_19[])(vec_void*) = { test_telemetry };
+
+    run_test_case(test_case_19, tc19_size);
+    trim_vec_pool();
+
+    // TEST CASE XX: ARRAY_LIST_H
+    printf("TEST CASE XX: ARRAY_LIST_H\n");
+
+    int tc20_size = 5;
+    test(*test_case_20[])(vec_void*) = { test_arl_modes, test_arl_batch, test_arl_policy, test_arl_index, test_arl_io };
+
+    run_test_case(test_case_20, tc20_size);
+    trim_vec_pool();
+
     printf("ALL TEST CASES PASSED, EXIT 0!\n");
     return 0;
 }
 
 // TEST CASE I: VECTOR_H
-test test_init_vec(vec* v) {
+test test_init_vec(vec_void* v) {
 
+    // NO_TYPE has no component size, init_vec refuses it
+    if (data_type == NO_TYPE) return init_vec(init_size, data_size, false) == NULL ? PASSED : FAILED;
     if (v == NULL) return FAILED;
 
-    vec* test_v = init_vec(v->size, v->data_type, v->fixed_length);
-    if (test_v == NULL) goto FAILED_TEST_INIT_VEC;
+    vec_void* test_v = init_vec(v->size, data_size, v->fixed_length);
+    if (test_v == NULL) return FAILED;
 
     if (test_v->size != v->size) goto FAILED_TEST_INIT_VEC;
-    if (test_v->array == v->array) goto FAILED_TEST_INIT_VEC;
-    if (test_v->data_type != v->data_type) goto FAILED_TEST_INIT_VEC;
+    if (test_v->capacity != v->size) goto FAILED_TEST_INIT_VEC;
+    if (test_v->size != 0 && test_v->array == v->array) goto FAILED_TEST_INIT_VEC;
     if (test_v->fixed_length != v->fixed_length) goto FAILED_TEST_INIT_VEC;
 
-    // NO_TYPE passes
-    if (data_type == NO_TYPE) {
-
-        teardown(test_v);
-        return PASSED;
-    }
-
-    for (int i = 0; i < v->size; i++)
-        if (!comp_data(test_v->array + i * data_size, v->array + i * data_size, data_type)) goto FAILED_TEST_INIT_VEC;
+    for (size_t i = 0; i < v->size; i++)
+        if (!comp_data((char*)test_v->array + i * data_size, (char*)v->array + i * data_size, data_type)) goto FAILED_TEST_INIT_VEC;
 
     teardown(test_v);
     return PASSED;
@@ -106,36 +390,50 @@ FAILED_TEST_INIT_VEC:
     return FAILED;
 }
 
-test test_append(vec* v) {
-
-    if (v == NULL) return FAILED;
+test test_append(vec_void* v) {
 
     // NO_TYPE passes
     if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
 
-    vec* test_v = init_vec(v->size, data_type, v->fixed_length);
+    vec_void* test_v = init_vec(v->size, data_size, v->fixed_length);
     if (test_v == NULL) return FAILED;
 
-    // Init random seed
-    srand(time(NULL));
+    fill_random(v);
 
-    // Fill v with random values
-    for (int i = 0; i < v->size; i++) {
+    // Appended components go after the zeroed ones
+    size_t reallocs = 0;
+    for (size_t i = 0; i < v->size; i++) {
+
+        void* before = test_v->array;
+        size_t capacity = test_v->capacity;
+        if (!append_vec(test_v, (char*)v->array + i * data_size, data_size)) goto FAILED_TEST_APPEND;
 
-        int64_t val64 = (int64_t)(rand() % init_size);
-        memcpy(v->array + i * data_size, &val64, data_size);
+        // Capacity only changes when full, and then grows geometrically
+        if (test_v->capacity != capacity) {
+
+            if (capacity >= VEC_MIN_CAPACITY && test_v->capacity != capacity * VEC_GROWTH_FACTOR) goto FAILED_TEST_APPEND;
+            reallocs++;
+        } else if (test_v->array != before) goto FAILED_TEST_APPEND;
     }
 
-    // Test without upsize
-    for (int i = 0; i < v->size; i++)
-        if ((test_v = append(v->array + i * data_size, test_v, false)) == NULL) goto FAILED_TEST_APPEND;
+    if (test_v->size != 2 * v->size) goto FAILED_TEST_APPEND;
+    // At most one step up to VEC_MIN_CAPACITY plus one doubling
+    if (reallocs > 2) goto FAILED_TEST_APPEND;
 
-    for (int i = 0; i < init_size; i++) {
-        if (!comp_data(test_v->array + (i + init_size) * data_size, v->array + i * data_size, data_type)) goto FAILED_TEST_APPEND;
-        char zero_test = 0x00 >> data_size;
-        if (strncmp(test_v->array + i * data_size, &zero_test, data_size)) goto FAILED_TEST_APPEND;
+    char zero[sizeof(int64_t)] = { 0 };
+    for (size_t i = 0; i < v->size; i++) {
+        if (!comp_data((char*)test_v->array + (i + v->size) * data_size, (char*)v->array + i * data_size, data_type)) goto FAILED_TEST_APPEND;
+        if (memcmp((char*)test_v->array + i * data_size, zero, data_size)) goto FAILED_TEST_APPEND;
     }
 
+    // Fixed length vectors cannot grow
+    vec_void* fixed_v = init_vec(1, data_size, true);
+    if (fixed_v == NULL) goto FAILED_TEST_APPEND;
+    bool grew = append_vec(fixed_v, zero, data_size);
+    teardown(fixed_v);
+    if (grew) goto FAILED_TEST_APPEND;
+
     teardown(test_v);
     return PASSED;
 
@@ -144,35 +442,36 @@ FAILED_TEST_APPEND:
     return FAILED;
 }
 
-test test_replace(vec* v) {
-
-    if (v == NULL) return FAILED;
+test test_replace(vec_void* v) {
 
     // NO_TYPE passes
     if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
 
-    vec* test_v = init_vec(v->size, data_type, v->fixed_length);
+    vec_void* test_v = init_vec(v->size, data_size, v->fixed_length);
     if (test_v == NULL) return FAILED;
 
-    // Init random seed
-    srand(time(NULL));
-    int64_t comp_arr[v->size];
+    int64_t comp_arr[v->size + 1];
 
     // Fill test_v with random values
-    for (int i = 0; i < v->size; i++) {
+    for (size_t i = 0; i < v->size; i++) {
 
-        int64_t val64 = (int64_t)(rand() % init_size);
-        if (!replace(&val64, i, test_v)) goto FAILED_TEST_REPLACE;
+        int64_t val64 = (int64_t)(rand() % (init_size + 1));
+        if (!replace_vec(test_v, i, &val64, data_size)) goto FAILED_TEST_REPLACE;
 
         // Add to comp_arr
         comp_arr[i] = val64;
     }
 
+    // Out of bounds
+    if (replace_vec(test_v, v->size, comp_arr, data_size)) goto FAILED_TEST_REPLACE;
+
     // Now check
-    for (int i = 0; i < v->size; i++) {
-        if (strncmp(test_v->array + i * data_size, (char*)&comp_arr[i], data_size)) goto FAILED_TEST_REPLACE;
+    for (size_t i = 0; i < v->size; i++) {
+        if (memcmp((char*)test_v->array + i * data_size, &comp_arr[i], data_size)) goto FAILED_TEST_REPLACE;
     }
 
+    teardown(test_v);
     return PASSED;
 
 FAILED_TEST_REPLACE:
@@ -180,248 +479,3152 @@ FAILED_TEST_REPLACE:
     return FAILED;
 }
 
-test test_contains(vec* v) {
-
-    if (v == NULL) return FAILED;
+test test_contains(vec_void* v) {
 
     // NO_TYPE passes
     if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
 
-    vec* test_v = init_vec(v->size, data_type, v->fixed_length);
+    vec_void* test_v = init_vec(0, data_size, false);
     if (test_v == NULL) return FAILED;
 
-    // Init random seed
-    srand(time(NULL));
-    int64_t comp_arr[v->size];
+    int64_t comp_arr[v->size + 1];
 
-    // Fill test_v with random values
-    for (int i = 0; i < v->size; i++) {
+    // Fill test_v with random non-zero values
+    for (size_t i = 0; i < v->size; i++) {
 
-        int64_t val64 = (int64_t)(rand() % init_size);
-        if (!replace(&val64, i, test_v)) goto FAILED_TEST_CONTAINS;
+        int64_t val64 = (int64_t)(rand() % 100 + 1);
+        if (!append_vec(test_v, &val64, data_size)) goto FAILED_TEST_CONTAINS;
 
         // Add to comp_arr
         comp_arr[i] = val64;
     }
 
     // Now check
-    for (int i = 0; i < v->size; i++) {
-        if (!contains((void*)(comp_arr + i), test_v, NULL)) goto FAILED_TEST_CONTAINS;
+    for (size_t i = 0; i < v->size; i++) {
+        if (!contains_vec(test_v, comp_arr + i, data_size, NULL)) goto FAILED_TEST_CONTAINS;
     }
 
-    return PASSED;
+    int64_t zero = 0;
+    if (contains_vec(test_v, &zero, data_size, NULL)) goto FAILED_TEST_CONTAINS;
 
+    teardown(test_v);
+    return PASSED;
 
 FAILED_TEST_CONTAINS:
     teardown(test_v);
     return FAILED;
 }
 
-test test_get_deep(vec* v) {
+test test_get_deep(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    fill_random(v);
+
+    for (size_t i = 0; i < v->size; i++) {
+
+        void* data = get_deep_vec(v, i, data_size);
+        if (data == NULL) return FAILED;
+
+        bool same = comp_data(data, (char*)v->array + i * data_size, data_type);
+        bool aliased = data == (char*)v->array + i * data_size;
+        free(data);
+
+        if (!same || aliased) return FAILED;
+    }
+
+    if (get_deep_vec(v, v->size, data_size) != NULL) return FAILED;
     return PASSED;
 }
 
-test test_get_shallow(vec* v) {
-    return PASSED;
+test test_byte_size(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    vec_double* test_v = init_vec(v->size, sizeof(double), false);
+    if (test_v == NULL) return FAILED;
+
+    bool ok = byte_size(test_v) == v->size * sizeof(double);
+    teardown((vec_void*)test_v);
+
+    return ok ? PASSED : FAILED;
 }
 
-test test_get_data_size(vec* v) {
+test test_reserve(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    vec_void* test_v = init_vec(0, data_size, false);
+    if (test_v == NULL) return FAILED;
+
+    size_t n = v->size + 100;
+    if (!reserve_vec(test_v, n, data_size)) goto FAILED_TEST_RESERVE;
+    if (test_v->capacity != n || test_v->size != 0) goto FAILED_TEST_RESERVE;
+
+    // No reallocation while appending within the reserved capacity
+    void* array = test_v->array;
+    int64_t val64 = 1;
+    for (size_t i = 0; i < n; i++)
+        if (!append_vec(test_v, &val64, data_size)) goto FAILED_TEST_RESERVE;
+
+    if (test_v->array != array || test_v->capacity != n) goto FAILED_TEST_RESERVE;
+
+    // Reserve never shrinks
+    if (!reserve_vec(test_v, 1, data_size) || test_v->capacity != n) goto FAILED_TEST_RESERVE;
+
+    // Fixed length vectors cannot reserve past their capacity
+    test_v->fixed_length = true;
+    if (reserve_vec(test_v, n + 1, data_size)) goto FAILED_TEST_RESERVE;
+
+    teardown(test_v);
     return PASSED;
+
+FAILED_TEST_RESERVE:
+    teardown(test_v);
+    return FAILED;
 }
 
-test test_byte_size(vec* v) {
+test test_shrink_to_fit(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    vec_void* test_v = init_vec(0, data_size, false);
+    if (test_v == NULL) return FAILED;
+
+    fill_random(v);
+    for (size_t i = 0; i < v->size; i++)
+        if (!append_vec(test_v, (char*)v->array + i * data_size, data_size)) goto FAILED_TEST_SHRINK;
+
+    if (!shrink_to_fit_vec(test_v, data_size)) goto FAILED_TEST_SHRINK;
+    if (test_v->capacity != v->size || test_v->size != v->size) goto FAILED_TEST_SHRINK;
+    if (v->size != 0 && memcmp(test_v->array, v->array, v->size * data_size)) goto FAILED_TEST_SHRINK;
+
+    teardown(test_v);
     return PASSED;
+
+FAILED_TEST_SHRINK:
+    teardown(test_v);
+    return FAILED;
 }
 
-test test_upsize(vec* v) {
+test test_upsize(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    fill_random(v);
+
+    vec_void* test_v = init_vec(v->size, data_size, false);
+    if (test_v == NULL) return FAILED;
+    if (v->size != 0) memcpy(test_v->array, v->array, v->size * data_size);
+
+    size_t capacity = test_v->capacity;
+    if (!upsize_vec(test_v, data_size)) goto FAILED_TEST_UPSIZE;
+    if (test_v->capacity <= capacity || test_v->size != v->size) goto FAILED_TEST_UPSIZE;
+    if (v->size != 0 && memcmp(test_v->array, v->array, v->size * data_size)) goto FAILED_TEST_UPSIZE;
+
+    teardown(test_v);
     return PASSED;
+
+FAILED_TEST_UPSIZE:
+    teardown(test_v);
+    return FAILED;
 }
 
-test test_downsize(vec* v) {
+test test_downsize(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    fill_random(v);
+
+    vec_void* test_v = init_vec(v->size, data_size, false);
+    if (test_v == NULL) return FAILED;
+    if (v->size != 0) memcpy(test_v->array, v->array, v->size * data_size);
+
+    if (!downsize_vec(test_v, data_size)) goto FAILED_TEST_DOWNSIZE;
+    if (test_v->capacity != v->size / 2 || test_v->size != v->size / 2) goto FAILED_TEST_DOWNSIZE;
+    if (test_v->size != 0 && memcmp(test_v->array, v->array, test_v->size * data_size)) goto FAILED_TEST_DOWNSIZE;
+
+    teardown(test_v);
     return PASSED;
+
+FAILED_TEST_DOWNSIZE:
+    teardown(test_v);
+    return FAILED;
 }
 
-test test_free_vec(vec* v) {
+test test_typed_macros(vec_void* v) {
+
+    (void)v;
+
+    vec_int_32* vi = init_vec(0, sizeof(int32_t), false);
+    vec_double* vd = init_vec(0, sizeof(double), false);
+    if (vi == NULL || vd == NULL) goto FAILED_TEST_TYPED_MACROS;
+
+    for (int i = 0; i < 1000; i++) {
+        if (!append(vi, i)) goto FAILED_TEST_TYPED_MACROS;
+        if (!append(vd, i * 0.5)) goto FAILED_TEST_TYPED_MACROS;
+    }
+
+    if (vi->size != 1000 || vd->size != 1000) goto FAILED_TEST_TYPED_MACROS;
+    if (vi->array[999] != 999 || vd->array[999] != 499.5) goto FAILED_TEST_TYPED_MACROS;
+
+    if (!replace(vd, 10, -1.0) || vd->array[10] != -1.0) goto FAILED_TEST_TYPED_MACROS;
+    if (!contains(vi, 500) || contains(vi, 1000)) goto FAILED_TEST_TYPED_MACROS;
+
+    double* deep = get_deep(vd, 3);
+    if (deep == NULL || *deep != 1.5) {
+        free(deep);
+        goto FAILED_TEST_TYPED_MACROS;
+    }
+    free(deep);
+
+    if (!reserve(vi, 5000) || vi->capacity != 5000) goto FAILED_TEST_TYPED_MACROS;
+    if (!shrink_to_fit(vi) || vi->capacity != 1000) goto FAILED_TEST_TYPED_MACROS;
+
+    free_vec(vi);
+    free_vec(vd);
     return PASSED;
+
+FAILED_TEST_TYPED_MACROS:
+    free_vec(vi);
+    free_vec(vd);
+    return FAILED;
 }
 
-// PREFIXTURES
-vec* prefixtures(type data_type, int init_size, bool fixed_length) {
+test test_typed_api(vec_void* v) {
 
-    // Manually create a vector
-    if (init_size == 0) return NULL;
+    (void)v;
 
-    // Init vec struct
-    vec* v = (vec*)malloc(sizeof(vec));
-    if (v == NULL) return NULL;
+    vec_char* vc = init_vec_char(0);
+    vec_int_64* vl = init_vec_int_64(3);
+    vec_float* vf = init_vec_float(0);
+    bool ok = vc != NULL && vl != NULL && vf != NULL;
 
-    // Init the size, data_type, and fixed_length metadata
-    v->size = init_size;
-    v->data_type = data_type;
-    v->fixed_length = fixed_length;
+    ok = ok && vec_type_of(vc) == VEC_CHAR && vec_type_of(vl) == VEC_INT_64 && vec_type_of(vf) == VEC_FLOAT;
+    ok = ok && vl->size == 3 && get(vl, 2) == 0;
 
-    // Init the vector array and GLOBAL data_size
-    switch (data_type) {
+    size_t n = (size_t)init_size + 100;
+    for (size_t i = 0; ok && i < n; i++)
+        ok = append(vc, (char)('a' + i % 26)) && append(vl, (int64_t)i << 33) && append(vf, (float)i * 0.25f);
 
-        case NO_TYPE:;
+    ok = ok && vc->size == n && vl->size == n + 3 && vf->size == n;
+    for (size_t i = 0; ok && i < n; i++)
+        ok = get(vc, i) == (char)('a' + i % 26) && get(vl, i + 3) == (int64_t)i << 33 && get(vf, i) == (float)i * 0.25f;
 
-            void* arrv = malloc(sizeof(void) * init_size);
-            if (arrv == NULL) {
+    // Reads take const vectors too
+    const vec_float* cf = vf;
+    ok = ok && contains(cf, 0.25f) && !contains(cf, -1.0f) && get(cf, 4) == 1.0f && vec_type_of(cf) == VEC_FLOAT;
 
-                free(v);
-                return NULL;
-            }
+    // Out of range is refused, like replace_vec
+    ok = ok && !replace(vl, n + 3, 1) && replace(vl, 0, -7) && get(vl, 0) == -7;
 
-            v->array = arrv;
-            return v;
+    // Indexed vectors leave the inline paths so the index stays current
+    ok = ok && build_index(vl) && append(vl, 5) && contains(vl, 5) && replace(vl, vl->size - 1, 6);
+    ok = ok && !contains(vl, 5) && contains(vl, 6) && contains(vl, -7);
 
-        case CHAR:;
+    int64_t* deep = ok ? get_deep(vl, 0) : NULL;
+    ok = ok && deep != NULL && *deep == -7;
+    free(deep);
 
-            char* arrc = (char*)malloc(sizeof(char) * init_size);
-            if (arrc == NULL) {
+    free_vec(vc);
+    free_vec(vl);
+    free_vec(vf);
+    return ok ? PASSED : FAILED;
+}
 
-                free(v);
-                return NULL;
-            }
+static bool is_odd(const void* component, void* context) {
 
-            v->array = arrc;
+    (void)context;
+    return *(const int32_t*)component % 2 != 0;
+}
 
-            for (int i = 0; i < init_size; i++)
-                ((char*)v->array)[i] = 0;
+test test_batch_edits(vec_void* v) {
 
-            data_size = sizeof(char);
+    (void)v;
 
-            return v;
+    size_t n = (size_t)init_size + 20;
+    int32_t* src = malloc(n * sizeof(int32_t));
+    vec_int_32* vi = init_vec_int_32(0);
+    vec_int_32* ref = init_vec_int_32(0);
+    bool ok = src != NULL && vi != NULL && ref != NULL;
 
-        case INT32:;
+    for (size_t i = 0; ok && i < n; i++) src[i] = (int32_t)i;
 
-            int32_t* arr32 = (int32_t*)malloc(sizeof(int32_t) * init_size);
-            if (arr32 == NULL) {
+    // One batch against n single appends
+    ok = ok && append_n(vi, src, n) && append_n(vi, NULL, 0) && !append_n(vi, NULL, 1);
+    for (size_t i = 0; ok && i < n; i++) ok = append(ref, src[i]);
+    ok = ok && vi->size == n && memcmp(vi->array, ref->array, n * sizeof(int32_t)) == 0;
 
-                free(v);
-                return NULL;
-            }
+    // [0, 1, 2] goes in at 3: 0 1 2 0 1 2 3 ...
+    ok = ok && insert_range(vi, 3, src, 3) && vi->size == n + 3 && !insert_range(vi, n + 4, src, 1);
+    for (size_t i = 0; ok && i < vi->size; i++) ok = get(vi, i) == (int32_t)(i < 3 ? i : i - 3);
 
-            v->array = arr32;
+    // And comes back out
+    ok = ok && erase_range(vi, 3, 3) && vi->size == n && memcmp(vi->array, src, n * sizeof(int32_t)) == 0;
+    ok = ok && !erase_range(vi, n - 1, 2) && erase_range(vi, n, 0) && erase_range(vi, 0, 0);
 
-            for (int i = 0; i < init_size; i++)
-                ((int32_t*)v->array)[i] = 0;
+    // Compaction keeps the order of the even ones
+    ok = ok && erase_if(vi, is_odd, NULL) == n / 2 && vi->size == n - n / 2;
+    for (size_t i = 0; ok && i < vi->size; i++) ok = get(vi, i) == (int32_t)(2 * i);
+    ok = ok && erase_if(vi, is_odd, NULL) == 0 && erase_if_vec(NULL, is_odd, NULL, sizeof(int32_t)) == 0;
 
-            data_size = sizeof(int32_t);
+    // The index follows every batch edit
+    ok = ok && build_index(vi) && append_n(vi, src, n) && contains(vi, 1);
+    ok = ok && erase_if(vi, is_odd, NULL) == n / 2 && !contains(vi, 1) && contains(vi, 0);
+    ok = ok && erase_range(vi, 0, vi->size) && vi->size == 0 && !contains(vi, 0);
+    ok = ok && insert_range(vi, 0, src + 5, 1) && contains(vi, 5) && vi->size == 1;
 
-            return v;
+    // Fixed-length vectors refuse to grow and stay as they were
+    vec_int_32* fixed = init_vec(2, sizeof(int32_t), true);
+    ok = ok && fixed != NULL && !append_n(fixed, src, 1) && fixed->size == 2 && erase_range(fixed, 0, 1);
+    ok = ok && append_n(fixed, src + 7, 1) && get(fixed, 1) == 7;
 
-        case INT64:;
+    free_vec(fixed);
+    free(src);
+    free_vec(vi);
+    free_vec(ref);
+    return ok ? PASSED : FAILED;
+}
 
-            int64_t* arr64 = (int64_t*)malloc(sizeof(int64_t) * init_size);
-            if (arr64 == NULL) {
+test test_growth_policy(vec_void* v) {
 
-                free(v);
-                return NULL;
-            }
+    (void)v;
 
-            v->array = arr64;
+    size_t n = (size_t)init_size + 20;
+    vec_int_32* vi = init_vec_int_32(0);
+    bool ok = vi != NULL;
 
-            for (int i = 0; i < init_size; i++)
-                ((int64_t*)v->array)[i] = 0;
+    // Defaults: geometric growth, erasing never shrinks, one count per resize
+    ok = ok && vi->policy.growth_percent == VEC_GROWTH_FACTOR * 100 && vi->policy.shrink_divisor == 0;
+    ok = ok && vi->stats.grows == 0 && vi->stats.shrinks == 0;
+    size_t resizes = 0;
+    for (size_t i = 0; ok && i < n; i++) {
 
-            data_size = sizeof(int64_t);
+        size_t capacity = vi->capacity;
+        ok = append(vi, (int32_t)i);
+        resizes += vi->capacity != capacity;
+    }
+    ok = ok && vi->stats.grows == resizes && erase_range(vi, 1, n - 1) && vi->stats.shrinks == 0;
+
+    // Policies that could not grow, or would shrink right back, are refused
+    ok = ok && !set_growth_policy(vi, ((growth_policy){ 100, 0, 0 }));
+    ok = ok && !set_growth_policy(vi, ((growth_policy){ 200, 2, 8 }));
+    ok = ok && !set_growth_policy_vec(NULL, VEC_DEFAULT_POLICY);
+    ok = ok && vi->policy.shrink_divisor == 0;
+
+    // Quarter-full shrinks back to half, one resize however much went
+    ok = ok && set_growth_policy(vi, ((growth_policy){ 200, 4, VEC_MIN_CAPACITY })) && shrink_to_fit(vi);
+    for (size_t i = 1; ok && i < 64 * n; i++) ok = append(vi, (int32_t)i);
+
+    size_t shrinks = vi->stats.shrinks;
+    ok = ok && erase_range(vi, 3, vi->size - 3) && vi->stats.shrinks == shrinks + 1;
+    ok = ok && vi->capacity >= VEC_MIN_CAPACITY && (vi->size > vi->capacity / 4 || vi->capacity == VEC_MIN_CAPACITY);
+    for (size_t i = 0; ok && i < vi->size; i++) ok = get(vi, i) == (int32_t)i;
+
+    // Adding and removing around a boundary stops reallocating
+    while (ok && vi->size < vi->capacity) ok = append(vi, 1);
+    ok = ok && append(vi, 1) && erase_range(vi, vi->size - 1, 1);
+    resize_stats before = vi->stats;
+    for (size_t i = 0; ok && i < 1000; i++) {
+
+        ok = append(vi, 2) && erase_range(vi, vi->size - 1, 1);
+        ok = ok && erase_range(vi, vi->size - 1, 1) && append(vi, 2);
+    }
+    ok = ok && vi->stats.grows == before.grows && vi->stats.shrinks == before.shrinks;
 
-            return v;
+    // erase_if shrinks the same way, fixed-length vectors never do
+    size_t capacity = vi->capacity;
+    ok = ok && erase_if(vi, is_odd, NULL) != 0 && erase_if(vi, is_odd, NULL) == 0;
+    ok = ok && (vi->capacity < capacity || vi->size > vi->capacity / 4);
 
-        case FLOAT32:;
+    vec_int_32* fixed = init_vec(n, sizeof(int32_t), true);
+    ok = ok && fixed != NULL && set_growth_policy(fixed, ((growth_policy){ 200, 4, 1 }));
+    ok = ok && erase_range(fixed, 0, n) && fixed->capacity == n && fixed->stats.shrinks == 0;
 
-            float* arrf = (float*)malloc(sizeof(float) * init_size);
-            if (arrf == NULL) {
+    free_vec(fixed);
+    free_vec(vi);
+    return ok ? PASSED : FAILED;
+}
 
-                free(v);
-                return NULL;
-            }
+test test_free_vec(vec_void* v) {
 
-            v->array = arrf;
+    (void)v;
 
-            for (int i = 0; i < init_size; i++)
-                ((float*)v->array)[i] = 0.0f;
+    // Both must be no-ops without crashing
+    free_vec(NULL);
+    free_vec(init_vec(0, sizeof(char), false));
 
-            data_size = sizeof(float);
+    return PASSED;
+}
 
-            return v;
+// TEST CASE II: VECTOR_MATH_H
+test test_math_float(vec_void* v) {
 
-        case DOUBLE:;
+    (void)v;
 
-            double* arrd = (double*)malloc(sizeof(double) * init_size);
-            if (arrd == NULL) {
+    // Odd length so every kernel runs its unrolled, vector and scalar tails
+    size_t n = (size_t)init_size * 3 + 37;
+    vec_float* x = init_vec(n, sizeof(float), false);
+    vec_float* y = init_vec(n, sizeof(float), false);
+    vec_float* out = init_vec(0, sizeof(float), false);
+    if (x == NULL || y == NULL || out == NULL) goto FAILED_TEST_MATH_FLOAT;
 
-                free(v);
-                return NULL;
-            }
+    for (size_t i = 0; i < n; i++) {
+        x->array[i] = (float)(rand() % 200 - 100) / 16.0f;
+        y->array[i] = (float)(rand() % 200 - 100) / 16.0f;
+    }
 
-            v->array = arrd;
+    // Double-precision references
+    double dot = 0, n1 = 0, n2 = 0, ni = 0;
+    for (size_t i = 0; i < n; i++) {
+        dot += (double)x->array[i] * (double)y->array[i];
+        n1 += fabs((double)x->array[i]);
+        n2 += (double)x->array[i] * (double)x->array[i];
+        if (fabs((double)x->array[i]) > ni) ni = fabs((double)x->array[i]);
+    }
 
-            for (int i = 0; i < init_size; i++)
-                ((double*)v->array)[i] = 0.0f;
+    simd_level max = max_simd_level();
+    for (int level = SIMD_SCALAR; level <= (int)max; level++) {
 
-            data_size = sizeof(double);
+        if (set_simd_level((simd_level)level) != (simd_level)level) goto FAILED_TEST_MATH_FLOAT;
 
-            return v;
+        if (!close_enough(dot_vec_float(x, y), dot, 1e-4)) goto FAILED_TEST_MATH_FLOAT;
+        if (!close_enough(norm1_vec_float(x), n1, 1e-4)) goto FAILED_TEST_MATH_FLOAT;
+        if (!close_enough(norm2_vec_float(x), sqrt(n2), 1e-4)) goto FAILED_TEST_MATH_FLOAT;
+        if (normi_vec_float(x) != (float)ni) goto FAILED_TEST_MATH_FLOAT;
 
-        default:
+        // Inputs are multiples of 1/16, so these are exact
+        if (!add_vec_float(out, x, y) || out->size != n) goto FAILED_TEST_MATH_FLOAT;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != x->array[i] + y->array[i]) goto FAILED_TEST_MATH_FLOAT;
+        if (!sub_vec_float(out, x, y)) goto FAILED_TEST_MATH_FLOAT;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != x->array[i] - y->array[i]) goto FAILED_TEST_MATH_FLOAT;
+        if (!mul_vec_float(out, x, y)) goto FAILED_TEST_MATH_FLOAT;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != x->array[i] * y->array[i]) goto FAILED_TEST_MATH_FLOAT;
 
-            free(v);
-            return NULL;
+        // out = 2 * (y + 0.5 * x)
+        memcpy(out->array, y->array, n * sizeof(float));
+        if (!axpy_vec_float(out, 0.5f, x) || !scale_vec_float(out, 2.0f)) goto FAILED_TEST_MATH_FLOAT;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != 2.0f * y->array[i] + x->array[i]) goto FAILED_TEST_MATH_FLOAT;
     }
+
+    set_simd_level(max);
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    return PASSED;
+
+FAILED_TEST_MATH_FLOAT:
+    printf("FAILED AT SIMD LEVEL %d\n", get_simd_level());
+    set_simd_level(max_simd_level());
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    return FAILED;
 }
 
-void run_test_case(test(*test_case[])(vec*), int size) {
+test test_math_double(vec_void* v) {
 
-    if (test_case == NULL) {
-        printf("NO TEST CASE GIVEN, EXITING!\n");
-        return;
+    (void)v;
+
+    size_t n = (size_t)init_size * 3 + 37;
+    vec_double* x = init_vec(n, sizeof(double), false);
+    vec_double* y = init_vec(n, sizeof(double), false);
+    vec_double* out = init_vec(0, sizeof(double), false);
+    if (x == NULL || y == NULL || out == NULL) goto FAILED_TEST_MATH_DOUBLE;
+
+    for (size_t i = 0; i < n; i++) {
+        x->array[i] = (double)(rand() % 200 - 100) / 16.0;
+        y->array[i] = (double)(rand() % 200 - 100) / 16.0;
     }
 
-    vec* main_v = NULL;
+    // Small multiples of 1/16 sum exactly in double
+    double dot = 0, n1 = 0, n2 = 0, ni = 0;
+    for (size_t i = 0; i < n; i++) {
+        dot += x->array[i] * y->array[i];
+        n1 += fabs(x->array[i]);
+        n2 += x->array[i] * x->array[i];
+        if (fabs(x->array[i]) > ni) ni = fabs(x->array[i]);
+    }
 
-    int i = 0;
-    for (i = 0; i < size; i++) {
+    simd_level max = max_simd_level();
+    for (int level = SIMD_SCALAR; level <= (int)max; level++) {
 
-        // PREFIXTURE
-        vec* main_v = prefixtures(data_type, init_size, false);
+        if (set_simd_level((simd_level)level) != (simd_level)level) goto FAILED_TEST_MATH_DOUBLE;
 
-        if ((*test_case[i])(main_v) == FAILED) goto FAIL;
+        if (dot_vec_double(x, y) != dot) goto FAILED_TEST_MATH_DOUBLE;
+        if (norm1_vec_double(x) != n1) goto FAILED_TEST_MATH_DOUBLE;
+        if (!close_enough(norm2_vec_double(x), sqrt(n2), 1e-12)) goto FAILED_TEST_MATH_DOUBLE;
+        if (normi_vec_double(x) != ni) goto FAILED_TEST_MATH_DOUBLE;
 
-        // TEARDOWN
-        teardown(main_v);
+        if (!add_vec_double(out, x, y) || out->size != n) goto FAILED_TEST_MATH_DOUBLE;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != x->array[i] + y->array[i]) goto FAILED_TEST_MATH_DOUBLE;
+        if (!sub_vec_double(out, x, y)) goto FAILED_TEST_MATH_DOUBLE;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != x->array[i] - y->array[i]) goto FAILED_TEST_MATH_DOUBLE;
+        if (!mul_vec_double(out, x, y)) goto FAILED_TEST_MATH_DOUBLE;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != x->array[i] * y->array[i]) goto FAILED_TEST_MATH_DOUBLE;
+
+        memcpy(out->array, y->array, n * sizeof(double));
+        if (!axpy_vec_double(out, 0.5, x) || !scale_vec_double(out, 2.0)) goto FAILED_TEST_MATH_DOUBLE;
+        for (size_t i = 0; i < n; i++) if (out->array[i] != 2.0 * y->array[i] + x->array[i]) goto FAILED_TEST_MATH_DOUBLE;
     }
 
-    return;
+    set_simd_level(max);
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    return PASSED;
 
-    // FAILED TEST
-FAIL:
-    teardown(main_v);
-    printf("\nTEST %d FAILED, EXIT -1!\n", i);
-    exit(-1);
+FAILED_TEST_MATH_DOUBLE:
+    printf("FAILED AT SIMD LEVEL %d\n", get_simd_level());
+    set_simd_level(max_simd_level());
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    return FAILED;
 }
 
-// TEAR DOWN
-void teardown(vec* v) {
+test test_math_errors(vec_void* v) {
 
-    if (v == NULL) return;
-    else if (v->array == NULL) {
+    (void)v;
 
-        free(v);
-        return;
-    }
+    vec_double* x = init_vec(4, sizeof(double), false);
+    vec_double* y = init_vec(5, sizeof(double), false);
+    vec_double* out = init_vec(1, sizeof(double), true);
+    test result = FAILED;
 
-    // Free the void pointer array
-    free(v->array);
+    if (x == NULL || y == NULL || out == NULL) goto DONE;
 
-    // Finally, free the v pointer
-    free(v);
+    // Size mismatches and NULLs are rejected
+    if (!isnan(dot_vec_double(x, y)) || !isnan(norm2_vec_double(NULL))) goto DONE;
+    if (axpy_vec_double(y, 1.0, x) || add_vec_double(y, x, y)) goto DONE;
+
+    // A fixed_length output that is too small cannot be resized
+    if (add_vec_double(out, x, x)) goto DONE;
+
+    result = PASSED;
+
+DONE:
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    return result;
 }
 
-// HELPER FUNCTIONS
-bool comp_data(const void* arg1, const void* arg2, type data_type) {
-    return (strncmp((char*)arg1, (char*)arg2, data_size) == 0);
+// TEST CASE III: MATRIX_H
+test test_init_mat(vec_void* v) {
+
+    (void)v;
+
+    mat_float* m = init_mat(3, 5, sizeof(float));
+    if (m == NULL) return FAILED;
+
+    bool ok = m->rows == 3 && m->cols == 5 && m->ld >= 5;
+    ok = ok && ((uintptr_t)m->array % MAT_ALIGNMENT) == 0 && (m->ld * sizeof(float)) % MAT_ALIGNMENT == 0;
+    for (size_t i = 0; i < m->rows; i++)
+        for (size_t j = 0; j < m->cols; j++)
+            ok = ok && mat_at(m, i, j) == 0.0f;
+
+    free_mat(m);
+    ok = ok && init_mat(0, 5, sizeof(float)) == NULL;
+
+    return ok ? PASSED : FAILED;
+}
+
+// Shapes that are not multiples of any tile or block size, plus one
+// larger than a cache block in every dimension
+#define GEMM_SHAPES { { 1, 1, 1 }, { 7, 13, 5 }, { 37, 53, 29 }, { 130, 70, 300 } }
+
+test test_gemm_float(vec_void* v) {
+
+    (void)v;
+
+    size_t shapes[][3] = GEMM_SHAPES;
+    simd_level max = max_simd_level();
+
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+
+        size_t m = shapes[s][0], n = shapes[s][1], k = shapes[s][2] + (size_t)init_size;
+        mat_float* a = init_mat(m, k, sizeof(float));
+        mat_float* b = init_mat(k, n, sizeof(float));
+        mat_float* c = init_mat(m, n, sizeof(float));
+        mat_float* c0 = init_mat(m, n, sizeof(float));
+        bool ok = a != NULL && b != NULL && c != NULL && c0 != NULL;
+
+        // Small integers keep every product and sum exact
+        for (size_t i = 0; ok && i < m; i++)
+            for (size_t j = 0; j < k; j++) mat_at(a, i, j) = (float)(rand() % 7 - 3);
+        for (size_t i = 0; ok && i < k; i++)
+            for (size_t j = 0; j < n; j++) mat_at(b, i, j) = (float)(rand() % 7 - 3);
+        for (size_t i = 0; ok && i < m; i++)
+            for (size_t j = 0; j < n; j++) mat_at(c0, i, j) = (float)(rand() % 7 - 3);
+
+        for (int level = SIMD_SCALAR; ok && level <= (int)max; level++) {
+
+            set_simd_level((simd_level)level);
+
+            for (size_t i = 0; i < m; i++) memcpy(&mat_at(c, i, 0), &mat_at(c0, i, 0), n * sizeof(float));
+            ok = gemm_mat_float(c, 2.0f, a, b, -1.0f);
+
+            for (size_t i = 0; ok && i < m; i++)
+                for (size_t j = 0; ok && j < n; j++) {
+
+                    float want = -mat_at(c0, i, j);
+                    for (size_t p = 0; p < k; p++) want += 2.0f * mat_at(a, i, p) * mat_at(b, p, j);
+                    ok = mat_at(c, i, j) == want;
+                }
+        }
+
+        set_simd_level(max);
+        free_mat(a);
+        free_mat(b);
+        free_mat(c);
+        free_mat(c0);
+
+        if (!ok) return FAILED;
+    }
+
+    return PASSED;
+}
+
+test test_gemm_double(vec_void* v) {
+
+    (void)v;
+
+    size_t shapes[][3] = GEMM_SHAPES;
+    simd_level max = max_simd_level();
+
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+
+        size_t m = shapes[s][0], n = shapes[s][1], k = shapes[s][2] + (size_t)init_size;
+        mat_double* a = init_mat(m, k, sizeof(double));
+        mat_double* b = init_mat(k, n, sizeof(double));
+        mat_double* c = init_mat(m, n, sizeof(double));
+        bool ok = a != NULL && b != NULL && c != NULL;
+
+        for (size_t i = 0; ok && i < m; i++)
+            for (size_t j = 0; j < k; j++) mat_at(a, i, j) = (double)(rand() % 7 - 3);
+        for (size_t i = 0; ok && i < k; i++)
+            for (size_t j = 0; j < n; j++) mat_at(b, i, j) = (double)(rand() % 7 - 3);
+
+        for (int level = SIMD_SCALAR; ok && level <= (int)max; level++) {
+
+            set_simd_level((simd_level)level);
+
+            // beta == 0 must ignore whatever C held, even NaN
+            for (size_t i = 0; i < m; i++)
+                for (size_t j = 0; j < n; j++) mat_at(c, i, j) = NAN;
+            ok = gemm_mat_double(c, 1.0, a, b, 0.0);
+
+            for (size_t i = 0; ok && i < m; i++)
+                for (size_t j = 0; ok && j < n; j++) {
+
+                    double want = 0.0;
+                    for (size_t p = 0; p < k; p++) want += mat_at(a, i, p) * mat_at(b, p, j);
+                    ok = mat_at(c, i, j) == want;
+                }
+        }
+
+        set_simd_level(max);
+        free_mat(a);
+        free_mat(b);
+        free_mat(c);
+
+        if (!ok) return FAILED;
+    }
+
+    // Shape mismatch and aliasing are rejected
+    mat_double* a = init_mat(2, 3, sizeof(double));
+    mat_double* b = init_mat(3, 4, sizeof(double));
+    mat_double* c = init_mat(2, 4, sizeof(double));
+    mat_double* sq = init_mat(3, 3, sizeof(double));
+    bool ok = a != NULL && b != NULL && c != NULL && sq != NULL;
+
+    ok = ok && gemm_mat_double(c, 1.0, a, b, 0.0);
+    ok = ok && !gemm_mat_double(c, 1.0, b, a, 0.0) && !gemm_mat_double(sq, 1.0, sq, sq, 0.0);
+    ok = ok && !gemm_mat_double(NULL, 1.0, a, b, 0.0);
+
+    free_mat(a);
+    free_mat(b);
+    free_mat(c);
+    free_mat(sq);
+
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE IV: THREAD_POOL_H
+// More threads than this sandbox may have cores, so the stealing paths still run
+#define POOL_TEST_THREADS 4
+
+// Every index gets hit exactly once, by valid workers
+static void mark_indices(void* ctx, size_t begin, size_t end) {
+
+    int* hits = (int*)ctx;
+    bool valid = get_worker_index() < POOL_TEST_THREADS;
+    for (size_t i = begin; i < end; i++) hits[i] += valid ? 1 : 2;
+}
+
+test test_parallel_for(vec_void* v) {
+
+    (void)v;
+
+    size_t n = (size_t)init_size * 97 + 1000;
+    int* hits = calloc(n, sizeof(int));
+    if (hits == NULL || !set_thread_count(POOL_TEST_THREADS)) goto fail;
+    if (get_thread_count() != POOL_TEST_THREADS) goto fail;
+
+    parallel_for(0, n, 7, mark_indices, hits);
+    for (size_t i = 0; i < n; i++)
+        if (hits[i] != 1) goto fail;
+
+    // Empty ranges do nothing
+    parallel_for(5, 5, 1, mark_indices, hits);
+    if (hits[5] != 1) goto fail;
+
+    set_thread_count(0);
+    free(hits);
+    return PASSED;
+
+    fail:
+    set_thread_count(0);
+    free(hits);
+    return FAILED;
+}
+
+test test_parallel_math(vec_void* v) {
+
+    (void)v;
+
+    // Several reduction blocks with a ragged tail
+    size_t n = ((size_t)1 << 16) + 3 * (size_t)init_size + 11;
+    vec_double* x = init_vec(n, sizeof(double), false);
+    vec_double* y = init_vec(n, sizeof(double), false);
+    vec_double* out = init_vec(0, sizeof(double), false);
+    bool ok = x != NULL && y != NULL && out != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) {
+
+        // Small integers keep every sum exact
+        ok = append(x, (double)(rand() % 9 - 4)) && append(y, (double)(rand() % 9 - 4));
+    }
+
+    ok = ok && set_thread_count(1);
+    double dot = dot_vec_double(x, y), sum = sum_vec_double(x);
+    double n1 = norm1_vec_double(x), ni = normi_vec_double(x);
+    ok = ok && add_vec_double(out, x, y);
+    vec_double* serial = ok ? init_vec(n, sizeof(double), false) : NULL;
+    ok = ok && serial != NULL;
+    for (size_t i = 0; ok && i < n; i++) ok = append(serial, out->array[i]);
+
+    ok = ok && set_thread_count(POOL_TEST_THREADS);
+    set_parallel_threshold(1);
+
+    ok = ok && dot_vec_double(x, y) == dot && sum_vec_double(x) == sum;
+    ok = ok && norm1_vec_double(x) == n1 && normi_vec_double(x) == ni;
+    ok = ok && add_vec_double(out, x, y) && memcmp(out->array, serial->array, n * sizeof(double)) == 0;
+
+    // y += 2x, then y -= 2x again, in parallel
+    ok = ok && axpy_vec_double(y, 2.0, x) && axpy_vec_double(y, -2.0, x);
+    ok = ok && dot_vec_double(x, y) == dot;
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    free_vec(serial);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_parallel_gemm(vec_void* v) {
+
+    (void)v;
+
+    // Several row blocks and column tiles, none of them full
+    size_t m = 250, n = 530 + (size_t)init_size, k = 70;
+    mat_float* a = init_mat(m, k, sizeof(float));
+    mat_float* b = init_mat(k, n, sizeof(float));
+    mat_float* c = init_mat(m, n, sizeof(float));
+    mat_float* want = init_mat(m, n, sizeof(float));
+    bool ok = a != NULL && b != NULL && c != NULL && want != NULL;
+
+    for (size_t i = 0; ok && i < m; i++)
+        for (size_t j = 0; j < k; j++) mat_at(a, i, j) = (float)(rand() % 7 - 3);
+    for (size_t i = 0; ok && i < k; i++)
+        for (size_t j = 0; j < n; j++) mat_at(b, i, j) = (float)(rand() % 7 - 3);
+
+    ok = ok && set_thread_count(1) && gemm_mat_float(want, 2.0f, a, b, 0.0f);
+    ok = ok && set_thread_count(POOL_TEST_THREADS);
+    set_parallel_threshold(1);
+
+    ok = ok && gemm_mat_float(c, 2.0f, a, b, 0.0f);
+    for (size_t i = 0; ok && i < m; i++)
+        for (size_t j = 0; ok && j < n; j++) ok = mat_at(c, i, j) == mat_at(want, i, j);
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+    free_mat(a);
+    free_mat(b);
+    free_mat(c);
+    free_mat(want);
+
+    return ok ? PASSED : FAILED;
+}
+
+// Each task runs a level-1 op big enough to go parallel on its own
+typedef struct nested_dots {
+
+    const float* x;
+    size_t n;
+    float* results;
+} nested_dots;
+
+static void nested_dot(void* ctx, size_t begin, size_t end) {
+
+    nested_dots* d = (nested_dots*)ctx;
+    for (size_t i = begin; i < end; i++) d->results[i] = dot_f32(d->x, d->x, d->n) + sum_f32(d->x, d->n);
+}
+
+test test_parallel_nested(vec_void* v) {
+
+    (void)v;
+
+    // Library calls from inside a task run inline instead of waiting on the pool
+    size_t n = (size_t)1 << 20, tasks = 2 * POOL_TEST_THREADS + (size_t)init_size % 3;
+    float* x = malloc(n * sizeof(float));
+    float* results = calloc(tasks, sizeof(float));
+    bool ok = x != NULL && results != NULL && set_thread_count(POOL_TEST_THREADS);
+
+    // Ones keep both sums exact
+    for (size_t i = 0; ok && i < n; i++) x[i] = 1.0f;
+
+    nested_dots d = { x, n, results };
+    set_parallel_threshold(1);
+    if (ok) parallel_for(0, tasks, 1, nested_dot, &d);
+    for (size_t i = 0; ok && i < tasks; i++) ok = results[i] == 2.0f * (float)n;
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+    free(x);
+    free(results);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_parallel_reduce(vec_void* v) {
+
+    (void)v;
+
+    // Inexact sums over several blocks: rounding would differ if the blocks
+    // were combined differently
+    size_t n = ((size_t)1 << 17) + 7 * (size_t)init_size + 13;
+    float* x = malloc(n * sizeof(float));
+    float* y = malloc(n * sizeof(float));
+    double* xd = malloc(n * sizeof(double));
+    bool ok = x != NULL && y != NULL && xd != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) {
+
+        x[i] = (float)rand() / (float)RAND_MAX - 0.3f;
+        y[i] = (float)rand() / (float)RAND_MAX * 0.7f;
+        xd[i] = (double)rand() / (double)RAND_MAX - 0.3;
+    }
+
+    ok = ok && set_thread_count(1);
+    float dot = ok ? dot_f32(x, y, n) : 0, sum = ok ? sum_f32(x, n) : 0, n1 = ok ? norm1_f32(x, n) : 0;
+    double sumd = ok ? sum_f64(xd, n) : 0, dotd = ok ? dot_f64(xd, xd, n) : 0;
+
+    ok = ok && set_thread_count(POOL_TEST_THREADS);
+    set_parallel_threshold(1);
+
+    ok = ok && dot_f32(x, y, n) == dot && sum_f32(x, n) == sum && norm1_f32(x, n) == n1;
+    ok = ok && sum_f64(xd, n) == sumd && dot_f64(xd, xd, n) == dotd;
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+    free(x);
+    free(y);
+    free(xd);
+
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE V: ARENA_H
+#define ALIGNED(ptr) ((uintptr_t)(ptr) % ARENA_ALIGNMENT == 0)
+
+test test_arena_alloc(vec_void* v) {
+
+    (void)v;
+
+    // Tiny blocks so the test spills across several of them
+    arena* a = init_arena(256);
+    if (a == NULL) return FAILED;
+
+    bool ok = arena_alloc(a, 0) == NULL && arena_alloc(NULL, 8) == NULL;
+    size_t n = (size_t)init_size + 1;
+
+    char* first = arena_calloc(a, n, 3);
+    ok = ok && first != NULL && ALIGNED(first);
+    for (size_t i = 0; ok && i < n * 3; i++) ok = first[i] == 0;
+
+    // Growing the last allocation stays in place while the block has room
+    char* grown = ok ? arena_realloc(a, first, n * 3, 64) : NULL;
+    ok = ok && (n * 3 > 64 || grown == first);
+
+    arena_mark mark = arena_get_mark(a);
+    size_t used = arena_used(a);
+
+    // Bigger than a block, gets a block of its own
+    for (int i = 0; ok && i < 10; i++) {
+
+        void* p = arena_alloc(a, (size_t)(rand() % 1000 + 1));
+        ok = p != NULL && ALIGNED(p);
+    }
+
+    // Moving a non-last allocation keeps its bytes
+    if (ok) memset(grown, 0x5a, 64);
+    char* moved = ok ? arena_realloc(a, grown, 64, 512) : NULL;
+    ok = ok && moved != NULL && moved != grown && ALIGNED(moved);
+    for (int i = 0; ok && i < 64; i++) ok = moved[i] == 0x5a;
+
+    arena_rewind(a, mark);
+    ok = ok && arena_used(a) == used;
+
+    arena_reset(a);
+    ok = ok && arena_used(a) == 0;
+    ok = ok && arena_alloc(a, 1) != NULL;
+
+    free_arena(a);
+    return ok ? PASSED : FAILED;
+}
+
+test test_arena_vec(vec_void* v) {
+
+    (void)v;
+
+    arena* a = init_arena(0);
+    if (a == NULL) return FAILED;
+
+    arena_mark mark = arena_get_mark(a);
+    vec_double* x = init_vec_arena(a, (size_t)init_size, sizeof(double), false);
+    bool ok = x != NULL && x->arena == a && x->size == (size_t)init_size;
+    ok = ok && (x->array == NULL || ALIGNED(x->array));
+    for (size_t i = 0; ok && i < x->size; i++) ok = x->array[i] == 0.0;
+
+    // Enough appends to outgrow the first block
+    size_t n = (size_t)init_size + 10000;
+    for (size_t i = x->size; ok && i < n; i++) ok = append(x, (double)i);
+    ok = ok && x->size == n && ALIGNED(x->array);
+    for (size_t i = (size_t)init_size; ok && i < n; i++) ok = x->array[i] == (double)i;
+
+    // A second vector in between forces the next growth to copy
+    vec_int_32* y = init_vec_arena(a, 4, sizeof(int32_t), true);
+    ok = ok && y != NULL && !append(y, 1);
+    ok = ok && reserve(x, n * 2) && x->array[n - 1] == (double)(n - 1);
+    ok = ok && shrink_to_fit(x) && x->capacity == n;
+
+    // Leaves the memory to the arena
+    free_vec(x);
+    free_vec(y);
+
+    ok = ok && init_vec_arena(NULL, 1, sizeof(double), false) == NULL;
+    ok = ok && init_vec_arena(a, 1, 0, false) == NULL;
+
+    arena_rewind(a, mark);
+    ok = ok && arena_used(a) == 0;
+
+    free_arena(a);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE VI: VALUE_TYPES_H
+test test_value_types(vec_void* v) {
+
+    (void)v;
+
+    vec3 a = { 1, 2, 3 }, b = { 4, 5, 6 };
+    vec3 c = cross_vec3(a, b);
+    bool ok = c.x == -3 && c.y == 6 && c.z == -3;
+    ok = ok && dot_vec3(a, b) == 32 && dot_vec3(c, a) == 0;
+    ok = ok && close_enough(length_vec3(normalize_vec3(b)), 1.0, 1e-6);
+    ok = ok && length_vec2(normalize_vec2((vec2){ 0, 0 })) == 0.0f;
+
+    vec4 d = add_vec4((vec4){ 1, 2, 3, 4 }, scale_vec4((vec4){ 1, 1, 1, 1 }, 2));
+    ok = ok && d.x == 3 && d.w == 6 && dot_vec4(d, (vec4){ 0, 0, 0, 1 }) == 6;
+    ok = ok && (uintptr_t)&d % 16 == 0;
+
+    // Scale then translate: (1, 2, 3) -> (2, 4, 6) -> (12, 14, 16)
+    mat4 m = mul_mat4(translate_mat4((vec3){ 10, 10, 10 }), scale_mat4((vec3){ 2, 2, 2 }));
+    vec3 p = transform_point_mat4(m, a);
+    ok = ok && p.x == 12 && p.y == 14 && p.z == 16;
+
+    mat4 id = mul_mat4(m, identity_mat4());
+    mat4 tt = transpose_mat4(transpose_mat4(m));
+    ok = ok && memcmp(&id, &m, sizeof(mat4)) == 0 && memcmp(&tt, &m, sizeof(mat4)) == 0;
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_vec_pool(vec_void* v) {
+
+    (void)v;
+
+    // A freed small vector's struct and array are handed out again
+    vec_float* x = init_vec(3, sizeof(float), false);
+    if (x == NULL) return FAILED;
+
+    void* header = x;
+    void* array = x->array;
+    bool ok = x->pool_class != 0;
+    free_vec(x);
+
+    vec_float* y = init_vec(3, sizeof(float), false);
+    ok = ok && y != NULL && (void*)y == header && (void*)y->array == array;
+    for (size_t i = 0; ok && i < 3; i++) ok = y->array[i] == 0.0f;
+
+    // Growing past VEC_POOL_MAX_BYTES leaves the pool, components intact
+    size_t n = VEC_POOL_MAX_BYTES / sizeof(float) + (size_t)init_size + 1;
+    for (size_t i = 3; ok && i < n; i++) ok = append(y, (float)i);
+    ok = ok && y->pool_class == 0;
+    for (size_t i = 3; ok && i < n; i++) ok = y->array[i] == (float)i;
+
+    // And shrinking brings it back
+    while (ok && y->capacity > VEC_MIN_CAPACITY) ok = downsize(y);
+    ok = ok && y->pool_class != 0 && y->array[4] == 4.0f;
+    ok = ok && shrink_to_fit(y) && y->capacity == y->size;
+
+    free_vec(y);
+    trim_vec_pool();
+
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE VII: HASH_INDEX_H
+test test_hash_index(vec_void* v) {
+
+    (void)v;
+
+    // Few distinct keys so there are plenty of duplicates and removals
+    size_t n = (size_t)init_size * 13 + 500;
+    int range = (int)(n / 3) + 1;
+    hash_index* h = init_hash_index(sizeof(int), 0);
+    size_t* counts = calloc((size_t)range, sizeof(size_t));
+    bool ok = h != NULL && counts != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) {
+
+        int key = rand() % range;
+        ok = hash_index_insert(h, &key);
+        counts[key]++;
+    }
+
+    // Remove about half, including every copy of some keys
+    for (size_t i = 0; ok && i < n / 2; i++) {
+
+        int key = rand() % range;
+        ok = hash_index_remove(h, &key) == (counts[key] > 0);
+        if (counts[key] > 0) counts[key]--;
+    }
+
+    for (int key = 0; ok && key < range; key++) ok = hash_index_count(h, &key) == counts[key];
+
+    int missing = -1;
+    ok = ok && hash_index_count(h, &missing) == 0 && !hash_index_remove(h, &missing);
+    ok = ok && init_hash_index(0, 1) == NULL && hash_index_count(NULL, &missing) == 0;
+
+    clear_hash_index(h);
+    for (int key = 0; ok && key < range; key++) ok = hash_index_count(h, &key) == 0;
+
+    free(counts);
+    free_hash_index(h);
+    return ok ? PASSED : FAILED;
+}
+
+test test_indexed_contains(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    vec_void* test_v = init_vec(0, data_size, false);
+    if (test_v == NULL) return FAILED;
+
+    fill_random(v);
+    bool ok = build_index_vec(test_v, data_size);
+
+    for (size_t i = 0; ok && i < v->size; i++) ok = append_vec(test_v, (char*)v->array + i * data_size, data_size);
+    for (size_t i = 0; ok && i < v->size; i++) ok = contains_vec(test_v, (char*)v->array + i * data_size, data_size, NULL);
+
+    // Overwrite the first component with the last: only the first value can disappear
+    if (ok && test_v->size > 1) {
+
+        char* first = get_deep_vec(test_v, 0, data_size);
+        ok = first != NULL && replace_vec(test_v, 0, (char*)v->array + (v->size - 1) * data_size, data_size);
+
+        bool still_there = false;
+        for (size_t i = 1; ok && i < test_v->size; i++)
+            still_there |= memcmp((char*)test_v->array + i * data_size, first, data_size) == 0;
+
+        ok = ok && contains_vec(test_v, first, data_size, NULL) == still_there;
+        free(first);
+    }
+
+    // Truncating drops the tail from the index too
+    while (ok && test_v->capacity > 1) {
+
+        ok = downsize_vec(test_v, data_size);
+        for (size_t i = 0; ok && i < v->size; i++) {
+
+            const char* value = (char*)v->array + i * data_size;
+            bool linear = false;
+            for (size_t j = 0; j < test_v->size; j++)
+                linear |= memcmp((char*)test_v->array + j * data_size, value, data_size) == 0;
+
+            ok = contains_vec(test_v, value, data_size, NULL) == linear;
+        }
+    }
+
+    drop_index_vec(test_v);
+    ok = ok && test_v->index == NULL;
+
+    free_vec(test_v);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE VIII: VECTOR_SEARCH_H
+/**
+ * Checks find/count/mask for one component type against a plain loop,
+ * starting one component in so the SIMD loads are unaligned. Values come
+ * from a small range so there are plenty of matches.
+ */
+#define CHECK_SEARCH(T, S) \
+static bool check_search_##S(size_t n) { \
+    T* x = malloc((n + 1) * sizeof(T)); \
+    uint64_t* bits = malloc(((n + 63) / 64 + 1) * sizeof(uint64_t)); \
+    bool ok = x != NULL && bits != NULL; \
+    for (size_t i = 0; ok && i <= n; i++) x[i] = (T)(rand() % 6); \
+    for (int value = 0; ok && value < 7; value++) { \
+        size_t first = n, count = 0; \
+        for (size_t i = 0; i < n; i++) \
+            if (x[i + 1] == (T)value) { if (first == n) first = i; count++; } \
+        ok = find_##S(x + 1, n, (T)value) == first && count_##S(x + 1, n, (T)value) == count; \
+        ok = ok && mask_##S(x + 1, n, (T)value, bits) == count; \
+        for (size_t i = 0; ok && i < n; i++) ok = ((bits[i / 64] >> (i % 64)) & 1) == (x[i + 1] == (T)value); \
+        for (size_t i = n; ok && i % 64 != 0; i++) ok = ((bits[i / 64] >> (i % 64)) & 1) == 0; \
+    } \
+    free(x); \
+    free(bits); \
+    return ok; \
+}
+
+CHECK_SEARCH(char, char)
+CHECK_SEARCH(int32_t, i32)
+CHECK_SEARCH(int64_t, i64)
+CHECK_SEARCH(float, f32)
+CHECK_SEARCH(double, f64)
+
+test test_search_kernels(vec_void* v) {
+
+    (void)v;
+
+    size_t n = (size_t)init_size * 3 + 200;
+    bool ok = true;
+
+    simd_level max = max_search_level();
+    for (int level = SIMD_SCALAR; ok && level <= (int)max; level++) {
+
+        ok = set_search_level((simd_level)level) == (simd_level)level;
+
+        // Every tail length below one AVX-512 char register, then the big one
+        for (size_t len = 0; ok && len < 130; len++)
+            ok = check_search_char(len) && check_search_i32(len) && check_search_i64(len)
+              && check_search_f32(len) && check_search_f64(len);
+
+        ok = ok && check_search_char(n) && check_search_i32(n) && check_search_i64(n)
+           && check_search_f32(n) && check_search_f64(n);
+
+        // Floats compare by value, find_bytes by bits
+        double d[70];
+        for (int i = 0; i < 70; i++) d[i] = 1.0;
+        d[50] = -0.0;
+        d[60] = NAN;
+
+        double zero = 0.0, nan = NAN;
+        ok = ok && find_f64(d, 70, 0.0) == 50 && find_f64(d, 70, NAN) == 70;
+        ok = ok && find_bytes(d, 70, &zero, sizeof(double)) == 70 && find_bytes(d, 70, &nan, sizeof(double)) == 60;
+    }
+
+    set_search_level(max);
+    if (!ok) printf("FAILED AT SEARCH LEVEL %d\n", get_search_level());
+
+    // Sizes without a kernel fall back to memcmp
+    char bytes[12 * 40];
+    for (size_t i = 0; i < sizeof(bytes); i++) bytes[i] = (char)(i % 12);
+    bytes[12 * 33 + 5] = 'x';
+    ok = ok && find_bytes(bytes, 40, bytes + 12 * 33, 12) == 33 && find_bytes(bytes, 40, bytes + 12 * 2, 12) == 0;
+    ok = ok && find_bytes(bytes, 160, bytes + 3 * 7, 3) == 3 && find_bytes(bytes, 0, bytes, 3) == 0;
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_scan_contains(vec_void* v) {
+
+    // NO_TYPE passes
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    vec_void* test_v = init_vec(0, data_size, false);
+    if (test_v == NULL) return FAILED;
+
+    fill_random(v);
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < v->size; i++) ok = append_vec(test_v, (char*)v->array + i * data_size, data_size);
+    for (size_t i = 0; ok && i < v->size; i++) ok = contains_vec(test_v, (char*)v->array + i * data_size, data_size, NULL);
+
+    // All ones is only there if a char component wrapped around to it
+    int64_t ones = -1;
+    bool linear = false;
+    for (size_t i = 0; i < v->size; i++) linear |= memcmp((char*)v->array + i * data_size, &ones, data_size) == 0;
+    ok = ok && contains_vec(test_v, &ones, data_size, NULL) == linear;
+
+    // Components with zero bytes in them still compare whole
+    if (ok && data_size > 1) {
+
+        char zeros[8] = { 0 }, low[8] = { 0 };
+        low[data_size - 1] = 1;
+
+        vec_void* z = init_vec(0, data_size, false);
+        ok = z != NULL && append_vec(z, zeros, data_size);
+        ok = ok && contains_vec(z, zeros, data_size, NULL) && !contains_vec(z, low, data_size, NULL);
+        free_vec(z);
+    }
+
+    free_vec(test_v);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE IX: VECTOR_VIEW_H
+test test_view_slices(vec_void* v) {
+
+    (void)v;
+
+    size_t n = (size_t)init_size + 50;
+    vec_int_32* vi = init_vec_int_32(n);
+    if (vi == NULL) return FAILED;
+    for (size_t i = 0; i < n; i++) vi->array[i] = (int32_t)(i % 7);
+
+    // Bounds: the last component of a slice must lie below size
+    bool ok = slice(vi, 0, n, 1).stride == 1 && slice(vi, n, 0, 1).stride == 1;
+    ok = ok && slice(vi, n, 1, 1).stride == 0 && slice(vi, 0, n + 1, 1).stride == 0;
+    ok = ok && slice(vi, 1, (n - 2) / 3 + 1, 3).stride == 3 && slice(vi, 1, (n - 2) / 3 + 2, 3).stride == 0;
+    ok = ok && slice(vi, 0, 2, 0).stride == 0 && slice(vi, 0, 1, SIZE_MAX).stride == SIZE_MAX;
+    ok = ok && view_vec_int_32(NULL).stride == 0 && !contains_view_int_32(slice(vi, n, 1, 1), 0);
+
+    // Every 3rd component from 2: i = 2 + 3k, so i % 7 cycles through all of 0..6
+    view_int_32 w = slice(vi, 2, (n - 3) / 3 + 1, 3);
+    for (size_t k = 0; ok && k < w.size; k++) ok = get_view_int_32(w, k) == (int32_t)((2 + 3 * k) % 7);
+
+    for (int32_t value = 0; ok && value < 8; value++) {
+
+        size_t first = w.size, count = 0, first_all = n;
+        for (size_t k = 0; k < w.size; k++)
+            if (get_view_int_32(w, k) == value) { if (first == w.size) first = k; count++; }
+        for (size_t i = 0; i < n; i++)
+            if (vi->array[i] == value) { first_all = i; break; }
+
+        ok = find_view_int_32(w, value) == first && count_view_int_32(w, value) == count;
+        ok = ok && find_view_int_32(view_of(vi), value) == first_all;
+        ok = ok && contains_view_int_32(w, value) == (count > 0);
+    }
+
+    // A slice of a slice composes offsets and strides
+    view_int_32 ww = slice_view_int_32(w, 1, w.size / 2, 2);
+    for (size_t k = 0; ok && k < ww.size; k++) ok = get_view_int_32(ww, k) == (int32_t)((5 + 6 * k) % 7);
+    ok = ok && slice_view_int_32(w, 0, w.size + 1, 1).stride == 0;
+
+    // Matrix rows are contiguous, columns strided by ld
+    mat_double* m = init_mat(5, 3, sizeof(double));
+    ok = ok && m != NULL;
+    for (size_t i = 0; ok && i < 5; i++)
+        for (size_t j = 0; j < 3; j++) mat_at(m, i, j) = (double)(10 * i + j);
+
+    view_double col = col_view_mat_double(m, 2), row = row_view_mat_double(m, 4);
+    ok = ok && col.size == 5 && col.stride == m->ld && row.size == 3 && row.stride == 1;
+    for (size_t i = 0; ok && i < 5; i++) ok = get_view_double(col, i) == (double)(10 * i + 2);
+    ok = ok && find_view_double(col, 32.0) == 3 && find_view_double(row, 41.0) == 1;
+    ok = ok && col_view_mat_double(m, 3).stride == 0 && row_view_mat_double(m, 5).stride == 0;
+
+    free_mat(m);
+    free_vec(vi);
+    return ok ? PASSED : FAILED;
+}
+
+test test_view_math(vec_void* v) {
+
+    (void)v;
+
+    // Strided views against the same components copied into vectors
+    size_t n = (size_t)init_size * 2 + 33;
+    vec_double* big = init_vec_double(3 * n);
+    vec_double* x = init_vec_double(n);
+    vec_double* y = init_vec_double(n);
+    vec_double* out = init_vec_double(0);
+    vec_double* want = init_vec_double(0);
+    bool ok = big != NULL && x != NULL && y != NULL && out != NULL && want != NULL;
+
+    // Multiples of 1/8 keep the sums exact in any order
+    for (size_t i = 0; ok && i < 3 * n; i++) big->array[i] = (double)(rand() % 64 - 32) / 8.0;
+
+    view_double vx = slice(big, 0, n, 3), vy = slice(big, 1, n, 3);
+    for (size_t i = 0; ok && i < n; i++) {
+
+        x->array[i] = get_view_double(vx, i);
+        y->array[i] = get_view_double(vy, i);
+    }
+
+    ok = ok && dot_view_double(vx, vy) == dot_vec_double(x, y) && sum_view_double(vx) == sum_vec_double(x);
+    ok = ok && norm1_view_double(vx) == norm1_vec_double(x) && norm2_view_double(vx) == norm2_vec_double(x);
+    ok = ok && normi_view_double(vx) == normi_vec_double(x);
+
+    // Contiguous views take the vector kernels
+    ok = ok && dot_view_double(view_of(x), view_of(y)) == dot_vec_double(x, y);
+
+    ok = ok && add_view_double(out, vx, vy) && add_vec_double(want, x, y) && out->size == n;
+    for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == want->array[i];
+    ok = ok && sub_view_double(out, vx, view_of(y)) && sub_vec_double(want, x, y);
+    for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == want->array[i];
+    ok = ok && mul_view_double(out, vx, vy) && mul_vec_double(want, x, y);
+    for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == want->array[i];
+
+    ok = ok && axpy_view_double(out, 0.5, vx) && axpy_vec_double(want, 0.5, x);
+    for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == want->array[i];
+
+    // Mismatched or invalid views fail
+    ok = ok && isnan(dot_view_double(vx, slice(big, 0, n - 1, 1))) && isnan(sum_view_double(slice(big, 0, 1, 0)));
+    ok = ok && !add_view_double(out, vx, slice(big, 0, n + 1, 3)) && !axpy_view_double(NULL, 1.0, vx);
+
+    // Float goes through the same template
+    vec_float* f = init_vec_float(8);
+    ok = ok && f != NULL;
+    for (size_t i = 0; ok && i < 8; i++) f->array[i] = (float)i;
+    ok = ok && sum_view_float(slice(f, 1, 4, 2)) == 16.0f && normi_view_float(slice(f, 0, 3, 3)) == 6.0f;
+
+    free_vec(f);
+    free_vec(big);
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+    free_vec(want);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE X: VECTOR_MMAP_H
+test test_vec_file(vec_void* v) {
+
+    (void)v;
+
+    char path[] = "/tmp/test_vec_file_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return FAILED;
+    close(fd);
+
+    // Written through the vector API, grown past the initial capacity
+    size_t n = (size_t)init_size + 1000;
+    vec_file* f = create_vec_file(path, vec_type_of((vec_double*)NULL), 16);
+    bool ok = f != NULL && f->writable && ((vec_double*)f->vec)->capacity == 16;
+
+    for (size_t i = 0; ok && i < 16; i++) ok = append((vec_double*)f->vec, (double)i);
+    ok = ok && !append((vec_double*)f->vec, 16.0) && ((uintptr_t)((vec_double*)f->vec)->array % ARENA_ALIGNMENT) == 0;
+
+    for (size_t i = 16; ok && i < n; i++) {
+
+        double d = (double)i;
+        ok = append_n_vec_file(f, &d, 1);
+    }
+
+    vec_double* w = ok ? (vec_double*)f->vec : NULL;
+    ok = ok && w->size == n && w->capacity >= n && w->stats.grows < 16;
+    ok = ok && advise_vec_file(f, VEC_ACCESS_SEQUENTIAL, 0, n) && advise_vec_file(f, VEC_ACCESS_WILLNEED, n / 2, 10);
+    ok = ok && !advise_vec_file(f, VEC_ACCESS_RANDOM, w->capacity, 1) && sync_vec_file(f, true);
+
+    // free_vec leaves mapped vectors to their file
+    if (ok) free_vec(w);
+    ok = close_vec_file(f) && ok;
+
+    // Reopened read-only: same components, straight from the mapping
+    f = open_vec_file(path, false);
+    ok = ok && f != NULL && !f->writable && f->type == VEC_DOUBLE && !reserve_vec_file(f, 2 * n);
+
+    vec_double* r = ok ? (vec_double*)f->vec : NULL;
+    ok = ok && r->size == n && advise_vec_file(f, VEC_ACCESS_RANDOM, 0, n);
+    for (size_t i = 0; ok && i < n; i++) ok = get(r, i) == (double)i;
+    ok = ok && contains(r, (double)(n - 1)) && !contains(r, -1.0) && count_view_double(view_of(r), 3.0) == 1;
+    ok = close_vec_file(f) && ok;
+
+    // Reopened for writing: appends land after what is there
+    f = open_vec_file(path, true);
+    double more[3] = { -1.0, -2.0, -3.0 };
+    ok = ok && f != NULL && append_n_vec_file(f, more, 3) && ((vec_double*)f->vec)->size == n + 3;
+    ok = close_vec_file(f) && ok;
+
+    f = open_vec_file(path, false);
+    ok = ok && f != NULL && ((vec_double*)f->vec)->size == n + 3 && get((vec_double*)f->vec, n + 2) == -3.0;
+    ok = close_vec_file(f) && ok;
+
+    unlink(path);
+    return ok ? PASSED : FAILED;
+}
+
+test test_vec_file_errors(vec_void* v) {
+
+    (void)v;
+
+    char path[] = "/tmp/test_vec_file_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return FAILED;
+
+    // Not a vector file
+    char junk[VEC_FILE_ALIGNMENT] = { 0 };
+    bool ok = write(fd, junk, sizeof(junk)) == (ssize_t)sizeof(junk);
+    close(fd);
+    ok = ok && open_vec_file(path, false) == NULL && open_vec_file("/nonexistent/vec", false) == NULL;
+    ok = ok && create_vec_file(NULL, VEC_INT_32, 1) == NULL && create_vec_file(path, (vec_type)42, 1) == NULL;
+
+    // Truncated below what the header promises
+    vec_file* f = create_vec_file(path, VEC_INT_32, 100);
+    ok = ok && f != NULL && f->type == VEC_INT_32;
+    ok = close_vec_file(f) && ok;
+    ok = ok && truncate(path, VEC_FILE_ALIGNMENT + 50 * sizeof(int32_t)) == 0 && open_vec_file(path, false) == NULL;
+
+    // Empty files still open, and NULL is a no-op everywhere
+    f = create_vec_file(path, VEC_CHAR, 0);
+    ok = ok && f != NULL && ((vec_char*)f->vec)->capacity == 0 && !append((vec_char*)f->vec, 'a');
+    ok = ok && append_n_vec_file(f, "abc", 3) && get((vec_char*)f->vec, 2) == 'c';
+    ok = close_vec_file(f) && ok;
+    ok = ok && close_vec_file(NULL) && !sync_vec_file(NULL, false) && !reserve_vec_file(NULL, 1);
+    ok = ok && !append_n_vec_file(NULL, "a", 1) && !advise_vec_file(NULL, VEC_ACCESS_NORMAL, 0, 1);
+
+    unlink(path);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XI: VECTOR_IO_H
+test test_stream_roundtrip(vec_void* v) {
+
+    if (data_type == NO_TYPE) return PASSED;
+    if (v == NULL) return FAILED;
+
+    char path[] = "/tmp/test_stream_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return FAILED;
+    close(fd);
+
+    // Known answer, then chaining gives the same CRC as one pass
+    bool ok = crc32c(0, "123456789", 9) == 0xE3069283u && crc32c(0, "", 0) == 0;
+    ok = ok && crc32c(crc32c(0, "1234", 4), "56789", 5) == 0xE3069283u;
+
+    // Big enough for several chunks, plus the fixture's components
+    fill_random(v);
+    size_t n = 3 * VEC_IO_CHUNK_BYTES / data_size + 17;
+    vec_void* big = init_vec(n, data_size, false);
+    ok = ok && big != NULL;
+    for (size_t i = 0; ok && i < n * data_size; i++) ((unsigned char*)big->array)[i] = (unsigned char)(i * 31 + 7);
+
+    ok = ok && save_vec(big, path, false, data_size) && save_vec(v, path, true, data_size);
+
+    vec_void* back = ok ? load_vec(path, data_size) : NULL;
+    ok = ok && back != NULL && back->size == n + v->size;
+    ok = ok && memcmp(back->array, big->array, n * data_size) == 0;
+    ok = ok && (v->size == 0 || memcmp((char*)back->array + n * data_size, v->array, v->size * data_size) == 0);
+
+    // Incrementally: never more than a chunk in memory, same bytes in order
+    vec_reader* r = ok ? open_vec_reader(path) : NULL;
+    size_t count, seen = 0, chunks = 0;
+    const void* chunk;
+    ok = ok && r != NULL && r->data_size == data_size;
+    while (ok && (chunk = read_vec_stream(r, &count)) != NULL) {
+
+        ok = count <= VEC_IO_CHUNK_BYTES / data_size;
+        ok = ok && memcmp(chunk, (char*)back->array + seen * data_size, count * data_size) == 0;
+        seen += count;
+        chunks++;
+    }
+    ok = ok && !r->error && seen == back->size && r->read == seen && chunks >= 4;
+    close_vec_reader(r);
+
+    // Component size must match, on load and on append
+    ok = ok && load_vec(path, data_size + 1) == NULL && open_vec_writer(path, data_size + 1, true) == NULL;
+
+    // Empty vectors make empty streams, which load as empty vectors
+    vec_void* none = init_vec(0, data_size, false);
+    ok = ok && none != NULL && save_vec(none, path, false, data_size);
+    free_vec(none);
+    none = ok ? load_vec(path, data_size) : NULL;
+    ok = ok && none != NULL && none->size == 0;
+
+    free_vec(none);
+    free_vec(back);
+    free_vec(big);
+    unlink(path);
+    return ok ? PASSED : FAILED;
+}
+
+test test_stream_corruption(vec_void* v) {
+
+    (void)v;
+
+    char path[] = "/tmp/test_stream_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return FAILED;
+    close(fd);
+
+    size_t n = (size_t)init_size + 100;
+    vec_int_32* vi = init_vec_int_32(n);
+    bool ok = vi != NULL;
+    for (size_t i = 0; ok && i < n; i++) vi->array[i] = (int32_t)i;
+    ok = ok && save_vec(vi, path, false, sizeof(int32_t));
+
+    // Rewrite the header as if a machine of the other byte order wrote it
+    unsigned char header[VEC_IO_HEADER];
+    fd = open(path, O_RDWR);
+    ok = ok && fd >= 0 && pread(fd, header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    unsigned char order = header[12];
+    header[12] = order == 'L' ? 'B' : 'L';
+    uint32_t crc = crc32c(0, header, VEC_IO_HEADER - 4);
+    for (int i = 0; i < 4; i++) header[28 + i] = (unsigned char)(crc >> (8 * i));
+    ok = ok && pwrite(fd, header, sizeof(header), 0) == (ssize_t)sizeof(header);
+
+    vec_int_32* swapped = ok ? load_vec(path, sizeof(int32_t)) : NULL;
+    ok = ok && swapped != NULL && swapped->size == n;
+    for (size_t i = 0; ok && i < n; i++) ok = (uint32_t)swapped->array[i] == __builtin_bswap32((uint32_t)i);
+    free_vec(swapped);
+
+    // Appending in the wrong byte order is refused
+    ok = ok && open_vec_writer(path, sizeof(int32_t), true) == NULL;
+
+    // One flipped payload bit fails the chunk, and the reader says so
+    unsigned char byte;
+    off_t at = VEC_IO_HEADER + VEC_IO_CHUNK_HEADER + 5;
+    ok = ok && pread(fd, &byte, 1, at) == 1;
+    byte ^= 0x10;
+    ok = ok && pwrite(fd, &byte, 1, at) == 1 && load_vec(path, sizeof(int32_t)) == NULL;
+
+    vec_reader* r = ok ? open_vec_reader(path) : NULL;
+    size_t count = 1;
+    ok = ok && r != NULL && read_vec_stream(r, &count) == NULL && count == 0 && r->error;
+    close_vec_reader(r);
+
+    // Cut mid-chunk: the chunks before the cut still stream out
+    ok = ok && save_vec(vi, path, false, sizeof(int32_t)) && save_vec(vi, path, true, sizeof(int32_t));
+    ok = ok && truncate(path, (off_t)(VEC_IO_HEADER + 2 * VEC_IO_CHUNK_HEADER + (2 * n - 1) * sizeof(int32_t))) == 0;
+    ok = ok && load_vec(path, sizeof(int32_t)) == NULL;
+
+    r = ok ? open_vec_reader(path) : NULL;
+    ok = ok && r != NULL && read_vec_stream(r, &count) != NULL && count == n && !r->error;
+    ok = ok && read_vec_stream(r, &count) == NULL && r->error;
+    close_vec_reader(r);
+
+    // Not a stream at all
+    ok = ok && truncate(path, 10) == 0 && open_vec_reader(path) == NULL && open_vec_reader(NULL) == NULL;
+    ok = ok && !save_vec(NULL, path, false, 4) && open_vec_writer(path, 0, false) == NULL;
+
+    if (fd >= 0) close(fd);
+    free_vec(vi);
+    unlink(path);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XII: SPARSE_H
+test test_spvec(vec_void* v) {
+
+    (void)v;
+
+    // Every seventh component set, small integers keep the sums exact
+    size_t n = 3 * (size_t)init_size + 20;
+    vec_double* d = init_vec(n, sizeof(double), false);
+    vec_double* y = init_vec(n, sizeof(double), false);
+    if (d == NULL || y == NULL) return FAILED;
+
+    double want = 0;
+    for (size_t i = 0; i < n; i++) {
+
+        d->array[i] = i % 7 == 3 ? (double)(rand() % 9 + 1) : 0.0;
+        y->array[i] = (double)(rand() % 7 - 3);
+        want += d->array[i] * y->array[i];
+    }
+
+    spvec_double* s = dense_to_spvec_double(d);
+    vec_double* back = spvec_to_dense_double(s);
+    bool ok = s != NULL && back != NULL && s->dim == n && s->nnz == (n + 3) / 7;
+    ok = ok && memcmp(back->array, d->array, n * sizeof(double)) == 0;
+    for (size_t i = 0; ok && i < n; i++) ok = get_spvec_double(s, i) == d->array[i];
+    ok = ok && get_spvec_double(s, n) == 0.0;
+
+    ok = ok && dot_spvec_double(s, y) == want;
+
+    // y - 2d, only the stored positions change
+    vec_double* y_old = init_vec(n, sizeof(double), false);
+    ok = ok && y_old != NULL;
+    if (ok) memcpy(y_old->array, y->array, n * sizeof(double));
+    ok = ok && axpy_spvec_double(y, -2.0, s);
+    for (size_t i = 0; ok && i < n; i++) ok = y->array[i] == y_old->array[i] - 2.0 * d->array[i];
+
+    // Building one by hand: positions have to increase
+    spvec_float* f = init_spvec(n, 0, sizeof(float));
+    float one = 1.0f, two = 2.0f;
+    ok = ok && f != NULL && append_spvec(f, 1, &one, sizeof(float)) && append_spvec(f, n - 1, &two, sizeof(float));
+    ok = ok && !append_spvec(f, n - 1, &one, sizeof(float)) && !append_spvec(f, n, &one, sizeof(float));
+    ok = ok && f->nnz == 2 && get_spvec_float(f, 1) == 1.0f && get_spvec_float(f, n - 1) == 2.0f && get_spvec_float(f, 0) == 0.0f;
+
+    vec_float* ones = init_vec(n, sizeof(float), false);
+    vec_float* shorter = init_vec(n - 1, sizeof(float), false);
+    for (size_t i = 0; ok && ones != NULL && i < n; i++) ones->array[i] = 1.0f;
+    ok = ok && ones != NULL && shorter != NULL && dot_spvec_float(f, ones) == 3.0f;
+    ok = ok && !axpy_spvec_float(shorter, 1.0f, f) && isnan(dot_spvec_float(f, shorter));
+
+    free_vec(d);
+    free_vec(y);
+    free_vec(y_old);
+    free_vec(back);
+    free_vec(ones);
+    free_vec(shorter);
+    free_spvec(s);
+    free_spvec(f);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_spmv(vec_void* v) {
+
+    (void)v;
+
+    // Tall enough for several row blocks, with a few dense rows in between
+    size_t rows = 40000 + (size_t)init_size, cols = 300 + (size_t)init_size % 50;
+    size_t n = 5 * rows + 2 * cols;
+    size_t* ri = malloc(n * sizeof(size_t));
+    size_t* ci = malloc(n * sizeof(size_t));
+    float* vi = malloc(n * sizeof(float));
+    vec_float* x = init_vec(cols, sizeof(float), false);
+    vec_float* y0 = init_vec(rows, sizeof(float), false);
+    vec_float* y = init_vec(rows, sizeof(float), false);
+    vec_float* want = init_vec(rows, sizeof(float), false);
+    bool ok = ri != NULL && ci != NULL && vi != NULL && x != NULL && y0 != NULL && y != NULL && want != NULL;
+
+    for (size_t k = 0; ok && k < n; k++) {
+
+        ri[k] = k < 2 * cols ? (k % 2) * (rows / 2) : (size_t)rand() % rows;
+        ci[k] = k < 2 * cols ? k / 2 : (size_t)rand() % cols;
+        vi[k] = (float)(rand() % 7 - 3);
+    }
+    for (size_t j = 0; ok && j < cols; j++) x->array[j] = (float)(rand() % 5 - 2);
+    for (size_t i = 0; ok && i < rows; i++) y0->array[i] = (float)(rand() % 5 - 2);
+
+    // Reference: straight from the triplets, duplicates included
+    for (size_t i = 0; ok && i < rows; i++) want->array[i] = -y0->array[i];
+    for (size_t k = 0; ok && k < n; k++) want->array[ri[k]] += 2.0f * vi[k] * x->array[ci[k]];
+
+    csr_float* a = ok ? triplets_to_csr_float(rows, cols, n, ri, ci, vi) : NULL;
+    ok = ok && a != NULL && a->nnz <= n && a->row_ptr[0] == 0 && a->row_ptr[rows] == a->nnz;
+    for (size_t i = 0; ok && i < rows; i++)
+        for (size_t k = a->row_ptr[i]; ok && k + 1 < a->row_ptr[i + 1]; k++) ok = a->col[k] < a->col[k + 1];
+
+    // Single-threaded, then split across the pool
+    ok = ok && set_thread_count(1);
+    memcpy(y->array, y0->array, rows * sizeof(float));
+    ok = ok && spmv_csr_float(y, 2.0f, a, x, -1.0f);
+    for (size_t i = 0; ok && i < rows; i++) ok = y->array[i] == want->array[i];
+
+    ok = ok && set_thread_count(POOL_TEST_THREADS);
+    set_parallel_threshold(1);
+    memcpy(y->array, y0->array, rows * sizeof(float));
+    ok = ok && spmv_csr_float(y, 2.0f, a, x, -1.0f);
+    for (size_t i = 0; ok && i < rows; i++) ok = y->array[i] == want->array[i];
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    // beta == 0 never reads y
+    for (size_t i = 0; ok && i < rows; i++) y->array[i] = NAN;
+    ok = ok && spmv_csr_float(y, 1.0f, a, x, 0.0f) && !isnan(y->array[rows / 2]);
+    ok = ok && !spmv_csr_float(y, 1.0f, a, y, 0.0f) && !spmv_csr_float(x, 1.0f, a, x, 0.0f);
+
+    // Out of range positions are refused
+    size_t bad_row = rows;
+    ok = ok && triplets_to_csr_float(rows, cols, 1, &bad_row, ci, vi) == NULL;
+
+    // Dense round trip
+    mat_double* m = init_mat(7, 11, sizeof(double));
+    ok = ok && m != NULL;
+    for (size_t i = 0; ok && i < m->rows; i++)
+        for (size_t j = 0; j < m->cols; j++) mat_at(m, i, j) = rand() % 3 == 0 ? (double)(rand() % 9 + 1) : 0.0;
+
+    csr_double* c = ok ? dense_to_csr_double(m) : NULL;
+    mat_double* back = c == NULL ? NULL : csr_to_dense_double(c);
+    ok = ok && back != NULL;
+    for (size_t i = 0; ok && i < m->rows; i++)
+        ok = memcmp(&mat_at(m, i, 0), &mat_at(back, i, 0), m->cols * sizeof(double)) == 0;
+
+    free(ri);
+    free(ci);
+    free(vi);
+    free_vec(x);
+    free_vec(y0);
+    free_vec(y);
+    free_vec(want);
+    free_csr(a);
+    free_csr(c);
+    free_mat(m);
+    free_mat(back);
+
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XIII: SOA_H
+test test_soa_container(vec_void* v) {
+
+    (void)v;
+
+    size_t n = (size_t)init_size + 37;
+    soa_vec* s = init_soa(3, 0);
+    bool ok = s != NULL && s->size == 0 && init_soa(2, 4) == NULL;
+
+    for (size_t i = 0; ok && i < n; i++) ok = append_vec3_soa(s, (vec3){ (float)i, (float)(2 * i), -(float)i });
+    ok = ok && s->size == n && s->capacity % SOA_LANES == 0 && !append_vec4_soa(s, (vec4){ 0, 0, 0, 0 });
+    ok = ok && (uintptr_t)s->x % SOA_ALIGNMENT == 0 && (uintptr_t)s->y % SOA_ALIGNMENT == 0 && (uintptr_t)s->z % SOA_ALIGNMENT == 0;
+
+    for (size_t i = 0; ok && i < n; i++) {
+
+        vec3 a = get_vec3_soa(s, i);
+        ok = a.x == (float)i && a.y == (float)(2 * i) && a.z == -(float)i;
+    }
+
+    vec3 none = get_vec3_soa(s, n);
+    ok = ok && none.x == 0.0f && none.y == 0.0f && none.z == 0.0f;
+
+    // Position attribute of a 32-byte vertex (pos, normal, uv) at offset 12,
+    // written from the middle of the container and read back
+    typedef struct vertex { float tag; float pos[3]; float normal[3]; float uv; } vertex;
+    size_t first = n / 3, count = n - first;
+    vertex* vb = malloc(count * sizeof(vertex));
+    ok = ok && vb != NULL;
+    for (size_t i = 0; ok && i < count; i++) vb[i].tag = vb[i].uv = 7.0f;
+
+    ok = ok && export_interleaved_soa(s, (char*)vb + offsetof(vertex, pos), sizeof(vertex), first, count);
+    for (size_t i = 0; ok && i < count; i++) {
+
+        vec3 a = get_vec3_soa(s, first + i);
+        ok = vb[i].pos[0] == a.x && vb[i].pos[1] == a.y && vb[i].pos[2] == a.z && vb[i].tag == 7.0f && vb[i].uv == 7.0f;
+    }
+
+    ok = ok && !export_interleaved_soa(s, vb, 8, 0, 1) && !export_interleaved_soa(s, vb, sizeof(vertex), first, count + 1);
+
+    soa_vec* back = init_soa(3, 1);
+    ok = ok && back != NULL && import_interleaved_soa(back, (char*)vb + offsetof(vertex, pos), sizeof(vertex), count);
+    ok = ok && back->size == count && back->stats.grows > 0;
+    for (size_t i = 0; ok && i < count; i++) {
+
+        vec3 a = get_vec3_soa(back, i), b = get_vec3_soa(s, first + i);
+        ok = a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    // vec4: tightly packed round trip
+    soa_vec* s4 = init_soa(4, n);
+    vec4* packed = malloc(n * sizeof(vec4));
+    ok = ok && s4 != NULL && packed != NULL && s4->w != NULL && (uintptr_t)s4->w % SOA_ALIGNMENT == 0;
+    for (size_t i = 0; ok && i < n; i++) ok = append_vec4_soa(s4, (vec4){ (float)i, 1.0f, 2.0f, (float)(n - i) });
+    ok = ok && s4->stats.grows == 0 && export_interleaved_soa(s4, packed, sizeof(vec4), 0, n);
+    for (size_t i = 0; ok && i < n; i++) ok = packed[i].x == (float)i && packed[i].w == (float)(n - i);
+
+    free(vb);
+    free(packed);
+    free_soa(s);
+    free_soa(back);
+    free_soa(s4);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_soa_kernels(vec_void* v) {
+
+    (void)v;
+
+    // Not a multiple of any register width, and big enough to hit the pool
+    size_t n = 3 * (size_t)init_size + 9000 + 13;
+    soa_vec* p = init_soa(3, n);
+    soa_vec* q = init_soa(3, n);
+    soa_vec* h = init_soa(4, n);
+    soa_vec* work = init_soa(3, 0);
+    soa_vec* work4 = init_soa(4, 0);
+    vec_float* dots = init_vec(0, sizeof(float), false);
+    bool ok = p != NULL && q != NULL && h != NULL && work != NULL && work4 != NULL && dots != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) {
+
+        // Every 10th vector has length 0 and must survive normalize
+        float k = i % 10 == 0 ? 0.0f : 1.0f;
+        ok = append_vec3_soa(p, (vec3){ k * (float)(rand() % 21 - 10), k * (float)(rand() % 21 - 10), k * (float)(rand() % 21 - 10) });
+        ok = ok && append_vec3_soa(q, (vec3){ (float)(rand() % 9 - 4), (float)(rand() % 9 - 4), (float)(rand() % 9 - 4) });
+        ok = ok && append_vec4_soa(h, (vec4){ (float)(rand() % 9 - 4), (float)(rand() % 9 - 4), (float)(rand() % 9 - 4), (float)(rand() % 3) });
+    }
+
+    // A perspective-ish transform so the w divide matters
+    mat4 m = mul_mat4(translate_mat4((vec3){ 1.5f, -2.0f, 0.25f }), scale_mat4((vec3){ 2.0f, 0.5f, 3.0f }));
+    m.m[3][2] = 0.125f;
+
+    simd_level max = max_simd_level();
+    for (int level = SIMD_SCALAR; ok && level <= (int)max; level++) {
+
+        set_simd_level((simd_level)level);
+
+        for (int threads = 0; ok && threads < 2; threads++) {
+
+            ok = set_thread_count(threads == 0 ? 1 : POOL_TEST_THREADS);
+            set_parallel_threshold(threads == 0 ? POOL_DEFAULT_THRESHOLD : 1);
+
+            // Points, directions, then vec4
+            work->size = 0;
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec3_soa(work, get_vec3_soa(p, i));
+            ok = ok && transform_soa(work, m, false);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 got = get_vec3_soa(work, i), want = transform_point_mat4(m, get_vec3_soa(p, i));
+                ok = close_enough(got.x, want.x, 1e-5) && close_enough(got.y, want.y, 1e-5) && close_enough(got.z, want.z, 1e-5);
+            }
+
+            work->size = 0;
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec3_soa(work, get_vec3_soa(p, i));
+            ok = ok && transform_soa(work, m, true);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 a = get_vec3_soa(p, i);
+                vec4 want = mul_mat4_vec4(m, (vec4){ a.x, a.y, a.z, 0.0f });
+                vec3 got = get_vec3_soa(work, i);
+                ok = close_enough(got.x, want.x, 1e-5) && close_enough(got.y, want.y, 1e-5) && close_enough(got.z, want.z, 1e-5);
+            }
+
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec4_soa(work4, get_vec4_soa(h, i));
+            ok = ok && transform_soa(work4, m, false);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec4 got = get_vec4_soa(work4, i), want = mul_mat4_vec4(m, get_vec4_soa(h, i));
+                ok = close_enough(got.x, want.x, 1e-5) && close_enough(got.w, want.w, 1e-5);
+            }
+
+            // Normalize, in place
+            work->size = 0;
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec3_soa(work, get_vec3_soa(p, i));
+            ok = ok && normalize_soa(work) && normalize_soa(work4);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 got = get_vec3_soa(work, i), want = normalize_vec3(get_vec3_soa(p, i));
+                ok = close_enough(got.x, want.x, 1e-6) && close_enough(got.y, want.y, 1e-6) && close_enough(got.z, want.z, 1e-6);
+                ok = ok && (i % 10 != 0 || (got.x == 0.0f && got.y == 0.0f && got.z == 0.0f));
+
+                vec4 got4 = get_vec4_soa(work4, i);
+                float len = length_vec4(got4);
+                ok = ok && (len == 0.0f || close_enough(len, 1.0, 1e-6));
+            }
+
+            // Cross into a third container and in place over an operand,
+            // dot products (small integers keep both exact)
+            ok = ok && cross_soa(work, p, q) && dot_soa(dots, p, q) && dots->size == n;
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 got = get_vec3_soa(work, i), want = cross_vec3(get_vec3_soa(p, i), get_vec3_soa(q, i));
+                ok = got.x == want.x && got.y == want.y && got.z == want.z;
+                ok = ok && dots->array[i] == dot_vec3(get_vec3_soa(p, i), get_vec3_soa(q, i));
+            }
+
+            ok = ok && cross_soa(work, work, q);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 want = cross_vec3(cross_vec3(get_vec3_soa(p, i), get_vec3_soa(q, i)), get_vec3_soa(q, i));
+                vec3 got = get_vec3_soa(work, i);
+                ok = got.x == want.x && got.y == want.y && got.z == want.z;
+            }
+
+            ok = ok && dot_soa(dots, h, h) && !dot_soa(dots, h, p) && !cross_soa(work, h, h);
+            for (size_t i = 0; ok && i < n; i++) ok = dots->array[i] == dot_vec4(get_vec4_soa(h, i), get_vec4_soa(h, i));
+
+            work4->size = 0;
+        }
+    }
+
+    set_simd_level(max);
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    free_soa(p);
+    free_soa(q);
+    free_soa(h);
+    free_soa(work);
+    free_soa(work4);
+    free_vec(dots);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_soa_mat(vec_void* v) {
+
+    (void)v;
+
+    size_t n = (size_t)init_size + 37;
+    soa_mat* m = init_soa_mat(4, 0);
+    soa_mat* m3 = init_soa_mat(3, 1);
+    mat4* src = malloc(n * sizeof(mat4));
+    mat4* dst = malloc(n * sizeof(mat4));
+    bool ok = m != NULL && m3 != NULL && src != NULL && dst != NULL;
+
+    for (size_t i = 0; ok && i < n; i++)
+        for (int e = 0; e < 16; e++) src[i].m[e / 4][e % 4] = (float)(rand() % 100);
+
+    // One by one and in bulk, every stream stays aligned
+    for (size_t i = 0; ok && i < n; i++) ok = append_mat4_soa(m, src[i]);
+    ok = ok && import_mats_soa(m, src, n) && m->size == 2 * n && m->capacity >= m->size;
+    for (size_t c = 0; ok && c < 16; c++) ok = ((uintptr_t)m->m[c] % SOA_ALIGNMENT) == 0;
+
+    ok = ok && export_mats_soa(m, dst, n, n) && memcmp(src, dst, n * sizeof(mat4)) == 0;
+    for (size_t i = 0; ok && i < n; i++) {
+
+        mat4 g = get_mat4_soa(m, i);
+        ok = memcmp(&src[i], &g, sizeof(mat4)) == 0;
+    }
+
+    mat3 a = { { { 1, 2, 3 }, { 4, 5, 6 }, { 7, 8, 9 } } };
+    ok = ok && append_mat3_soa(m3, a) && !append_mat4_soa(m3, identity_mat4()) && !append_mat3_soa(m, a);
+    ok = ok && get_mat3_soa(m3, 0).m[2][1] == 8.0f && get_mat3_soa(m3, 1).m[0][0] == 0.0f;
+
+    // Bad shapes and ranges are rejected
+    ok = ok && init_soa_mat(2, 4) == NULL && !export_mats_soa(m, dst, 2 * n, 1) && !mul_soa_mat(m, m, m3);
+    ok = ok && !inverse_soa_mat(m3, m, NULL) && !import_mats_soa(NULL, src, 1);
+
+    free_soa_mat(m);
+    free_soa_mat(m3);
+    free(src);
+    free(dst);
+    return ok ? PASSED : FAILED;
+}
+
+// Every entry of got within tol of want
+static bool mat4_close(mat4 got, mat4 want, double tol) {
+
+    for (int e = 0; e < 16; e++)
+        if (!close_enough(got.m[e / 4][e % 4], want.m[e / 4][e % 4], tol)) return false;
+
+    return true;
+}
+
+static bool mat3_close(mat3 got, mat3 want, double tol) {
+
+    for (int e = 0; e < 9; e++)
+        if (!close_enough(got.m[e / 3][e % 3], want.m[e / 3][e % 3], tol)) return false;
+
+    return true;
+}
+
+test test_soa_mat_kernels(vec_void* v) {
+
+    (void)v;
+
+    // Not a multiple of any register width, and big enough to hit the pool
+    size_t n = (size_t)init_size + 9000 + 13;
+    soa_mat* a = init_soa_mat(4, n);
+    soa_mat* b = init_soa_mat(4, n);
+    soa_mat* c = init_soa_mat(4, 0);
+    soa_mat* a3 = init_soa_mat(3, n);
+    soa_mat* c3 = init_soa_mat(3, 0);
+    soa_vec* p = init_soa(3, n);
+    soa_vec* h = init_soa(4, n);
+    soa_vec* work = init_soa(3, n);
+    soa_vec* work4 = init_soa(4, n);
+    vec_float* dets = init_vec(0, sizeof(float), false);
+    bool ok = a != NULL && b != NULL && c != NULL && a3 != NULL && c3 != NULL;
+    ok = ok && p != NULL && h != NULL && work != NULL && work4 != NULL && dets != NULL;
+
+    // Diagonally dominant, so every inverse is well conditioned, plus one
+    // singular matrix of each size
+    for (size_t i = 0; ok && i < n; i++) {
+
+        mat4 x, y;
+        mat3 z;
+        for (int e = 0; e < 16; e++) {
+            x.m[e / 4][e % 4] = (float)(rand() % 9 - 4) / 4.0f + (e % 5 == 0 ? 8.0f : 0.0f);
+            y.m[e / 4][e % 4] = (float)(rand() % 9 - 4) / 4.0f;
+        }
+        for (int e = 0; e < 9; e++) z.m[e / 3][e % 3] = (float)(rand() % 9 - 4) / 4.0f + (e % 4 == 0 ? 6.0f : 0.0f);
+        if (i == 3) x = (mat4){ { { 1, 2, 3, 4 }, { 2, 4, 6, 8 }, { 0, 1, 0, 1 }, { 1, 0, 1, 0 } } };
+        if (i == 5) z = (mat3){ { { 1, 2, 3 }, { 4, 5, 6 }, { 7, 8, 9 } } };
+
+        ok = append_mat4_soa(a, x) && append_mat4_soa(b, y) && append_mat3_soa(a3, z);
+        ok = ok && append_vec3_soa(p, (vec3){ (float)(rand() % 9 - 4), (float)(rand() % 9 - 4), (float)(rand() % 9 - 4) });
+        ok = ok && append_vec4_soa(h, (vec4){ (float)(rand() % 9 - 4), (float)(rand() % 9 - 4), (float)(rand() % 9 - 4), 1.0f });
+    }
+
+    simd_level max = max_simd_level();
+    for (int level = SIMD_SCALAR; ok && level <= (int)max; level++) {
+
+        set_simd_level((simd_level)level);
+
+        for (int threads = 0; ok && threads < 2; threads++) {
+
+            ok = set_thread_count(threads == 0 ? 1 : POOL_TEST_THREADS);
+            set_parallel_threshold(threads == 0 ? POOL_DEFAULT_THRESHOLD : 1);
+
+            ok = ok && mul_soa_mat(c, a, b) && c->size == n;
+            for (size_t i = 0; ok && i < n; i++) ok = mat4_close(get_mat4_soa(c, i), mul_mat4(get_mat4_soa(a, i), get_mat4_soa(b, i)), 1e-6);
+
+            // A * A^-1 == I, singular matrices give zeros and determinant 0
+            ok = ok && inverse_soa_mat(c, a, dets) && dets->size == n && dets->array[3] == 0.0f;
+            for (size_t i = 0; ok && i < n; i++) {
+
+                mat4 want = i == 3 ? (mat4){ { { 0 } } } : identity_mat4();
+                ok = mat4_close(i == 3 ? get_mat4_soa(c, i) : mul_mat4(get_mat4_soa(a, i), get_mat4_soa(c, i)), want, 1e-5);
+            }
+
+            ok = ok && inverse_soa_mat(c3, a3, NULL) && mul_soa_mat(c3, a3, c3);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                mat3 want = i == 5 ? (mat3){ { { 0 } } } : identity_mat3();
+                ok = mat3_close(get_mat3_soa(c3, i), want, 1e-5);
+            }
+
+            // Points, directions, vec4 and mat3
+            work->size = work4->size = 0;
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec3_soa(work, get_vec3_soa(p, i));
+            ok = ok && transform_soa_mat(work, a, false);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 got = get_vec3_soa(work, i), want = transform_point_mat4(get_mat4_soa(a, i), get_vec3_soa(p, i));
+                ok = close_enough(got.x, want.x, 1e-5) && close_enough(got.y, want.y, 1e-5) && close_enough(got.z, want.z, 1e-5);
+            }
+
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec4_soa(work4, get_vec4_soa(h, i));
+            ok = ok && transform_soa_mat(work4, a, false);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec4 got = get_vec4_soa(work4, i), want = mul_mat4_vec4(get_mat4_soa(a, i), get_vec4_soa(h, i));
+                ok = close_enough(got.x, want.x, 1e-6) && close_enough(got.y, want.y, 1e-6)
+                  && close_enough(got.z, want.z, 1e-6) && close_enough(got.w, want.w, 1e-6);
+            }
+
+            work->size = 0;
+            for (size_t i = 0; ok && i < n; i++) ok = append_vec3_soa(work, get_vec3_soa(p, i));
+            ok = ok && transform_soa_mat(work, a3, false) && !transform_soa_mat(work4, a3, false);
+            for (size_t i = 0; ok && i < n; i++) {
+
+                vec3 got = get_vec3_soa(work, i), want = mul_mat3_vec3(get_mat3_soa(a3, i), get_vec3_soa(p, i));
+                ok = close_enough(got.x, want.x, 1e-6) && close_enough(got.y, want.y, 1e-6) && close_enough(got.z, want.z, 1e-6);
+            }
+        }
+    }
+
+    if (!ok) printf("FAILED AT SIMD LEVEL %d\n", get_simd_level());
+
+    set_simd_level(max);
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    free_soa_mat(a);
+    free_soa_mat(b);
+    free_soa_mat(c);
+    free_soa_mat(a3);
+    free_soa_mat(c3);
+    free_soa(p);
+    free_soa(h);
+    free_soa(work);
+    free_soa(work4);
+    free_vec(dets);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XIV: VECTOR_EXPR_H
+test test_expr_fused(vec_void* v) {
+
+    (void)v;
+
+    // Several blocks plus a partial one
+    size_t n = 5 * EXPR_BLOCK + (size_t)init_size + 3;
+    vec_double* x = init_vec(n, sizeof(double), false);
+    vec_double* y = init_vec(n, sizeof(double), false);
+    vec_double* z = init_vec(n, sizeof(double), false);
+    vec_double* out = init_vec(0, sizeof(double), false);
+    vec_float* xf = init_vec(n, sizeof(float), false);
+    vec_float* outf = init_vec(1, sizeof(float), false);
+    bool ok = x != NULL && y != NULL && z != NULL && out != NULL && xf != NULL && outf != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) {
+
+        x->array[i] = (double)(rand() % 100) / 8.0;
+        y->array[i] = (double)(rand() % 100 - 50) / 4.0;
+        z->array[i] = (double)(rand() % 9 + 1);
+        xf->array[i] = (float)x->array[i];
+    }
+
+    double a = 1.5, b = -0.25;
+
+    // Single-threaded, then across the pool with every block its own task
+    for (int threads = 0; ok && threads < 2; threads++) {
+
+        ok = set_thread_count(threads == 0 ? 1 : POOL_TEST_THREADS);
+        set_parallel_threshold(threads == 0 ? POOL_DEFAULT_THRESHOLD : 1);
+
+        // The same IEEE operations in the same order: bit-identical
+        ok = ok && eval_expr(out, EXPR_SUB(EXPR_ADD(EXPR_SCALE(a, EXPR_VEC(x)), EXPR_SCALE(b, EXPR_VEC(y))), EXPR_VEC(z)));
+        ok = ok && out->size == n;
+        for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == a * x->array[i] + b * y->array[i] - z->array[i];
+
+        // Right-leaning, with division, negation and constants folded first
+        ok = ok && eval_expr(out, EXPR_DIV(EXPR_NEG(EXPR_VEC(x)), EXPR_ADD(EXPR_VEC(z), EXPR_MUL(EXPR_CONST(2), EXPR_CONST(0.5)))));
+        for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == -x->array[i] / (z->array[i] + 1.0);
+
+        ok = ok && eval_expr(out, EXPR_SUB(EXPR_CONST(1), EXPR_DIV(EXPR_VEC(y), EXPR_VEC(z))));
+        for (size_t i = 0; ok && i < n; i++) ok = out->array[i] == 1.0 - y->array[i] / z->array[i];
+
+        // A lone leaf is a copy, floats go through the float kernels
+        ok = ok && eval_expr(out, EXPR_VEC(y)) && memcmp(out->array, y->array, n * sizeof(double)) == 0;
+        ok = ok && eval_expr(outf, EXPR_MUL(EXPR_VEC(xf), EXPR_ADD(EXPR_VEC(xf), EXPR_CONST(0.5f))));
+        for (size_t i = 0; ok && i < n; i++) ok = outf->array[i] == xf->array[i] * (xf->array[i] + 0.5f);
+    }
+
+    // The result may be one of the operands: z = z * z - 2 * z
+    vec_double* z0 = init_vec(n, sizeof(double), false);
+    ok = ok && z0 != NULL;
+    if (ok) memcpy(z0->array, z->array, n * sizeof(double));
+    ok = ok && eval_expr(z, EXPR_SUB(EXPR_MUL(EXPR_VEC(z), EXPR_VEC(z)), EXPR_SCALE(2, EXPR_VEC(z))));
+    for (size_t i = 0; ok && i < n; i++) ok = z->array[i] == z0->array[i] * z0->array[i] - 2.0 * z0->array[i];
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    free_vec(x);
+    free_vec(y);
+    free_vec(z);
+    free_vec(z0);
+    free_vec(out);
+    free_vec(xf);
+    free_vec(outf);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_expr_errors(vec_void* v) {
+
+    (void)v;
+
+    vec_double* x = init_vec(4, sizeof(double), false);
+    vec_double* y = init_vec(5, sizeof(double), false);
+    vec_double* out = init_vec(3, sizeof(double), false);
+    bool ok = x != NULL && y != NULL && out != NULL;
+
+    // Sizes must match, there must be a vector, and out is untouched on failure
+    ok = ok && !eval_expr(out, EXPR_ADD(EXPR_VEC(x), EXPR_VEC(y))) && out->size == 3;
+    ok = ok && !eval_expr(out, EXPR_CONST(1)) && !eval_expr(out, NULL) && !eval_expr_double(NULL, EXPR_VEC(x));
+    ok = ok && !eval_expr(out, EXPR_ADD(EXPR_VEC(x), NULL)) && !eval_expr(out, EXPR_VEC(NULL));
+
+    // A right-leaning chain keeps every operand pending: too deep past
+    // EXPR_MAX_DEPTH. The leaf is built once, a literal in the loop body
+    // would end with each iteration
+    const vec_expr* leaf = EXPR_VEC(x);
+    const vec_expr* chain[EXPR_MAX_DEPTH + 1];
+    vec_expr nodes[EXPR_MAX_DEPTH + 1];
+    for (int i = 0; i <= EXPR_MAX_DEPTH; i++) {
+
+        nodes[i] = (vec_expr){ .op = EXPR_OP_ADD, .left = leaf, .right = i == 0 ? leaf : chain[i - 1] };
+        chain[i] = &nodes[i];
+    }
+
+    ok = ok && eval_expr(out, chain[EXPR_MAX_DEPTH - 2]) && out->size == 4;
+    ok = ok && !eval_expr(out, chain[EXPR_MAX_DEPTH]);
+
+    free_vec(x);
+    free_vec(y);
+    free_vec(out);
+
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XV: VECTOR_MATH_H STATISTICS
+test test_stats_reproducible(vec_void* v) {
+
+    (void)v;
+
+    // Several blocks plus a ragged one, so the pool really splits the work
+    size_t n = ((size_t)1 << 14) * 5 + 1234;
+    vec_float* x = init_vec(n, sizeof(float), false);
+    vec_double* xd = init_vec(n, sizeof(double), false);
+    bool ok = x != NULL && xd != NULL;
+
+    // A large mean and a small spread: a naive float sum loses several
+    // digits here and a one-pass variance loses all of them
+    for (size_t i = 0; ok && i < n; i++) {
+        x->array[i] = 1000.0f + (float)(rand() % 1000) / 1024.0f;
+        xd->array[i] = x->array[i];
+    }
+
+    // Ties across blocks, the first one wins
+    if (ok) {
+        x->array[100] = x->array[3 * ((size_t)1 << 14) + 5] = 500.0f;
+        x->array[20000] = x->array[70000] = 2000.0f;
+        xd->array[100] = xd->array[3 * ((size_t)1 << 14) + 5] = 500.0;
+        xd->array[20000] = xd->array[70000] = 2000.0;
+    }
+
+    long double sum = 0, dev2 = 0;
+    for (size_t i = 0; ok && i < n; i++) sum += x->array[i];
+    long double mean = sum / (long double)n;
+    for (size_t i = 0; ok && i < n; i++) dev2 += (x->array[i] - mean) * (x->array[i] - mean);
+    double var = (double)(dev2 / (long double)(n - 1));
+
+    simd_level max = max_simd_level();
+    for (int level = SIMD_SCALAR; ok && level <= (int)max; level++) {
+
+        set_simd_level((simd_level)level);
+
+        float f[2][5];
+        double d[2][5];
+        for (int threads = 0; ok && threads < 2; threads++) {
+
+            ok = set_thread_count(threads == 0 ? 1 : POOL_TEST_THREADS);
+            set_parallel_threshold(threads == 0 ? POOL_DEFAULT_THRESHOLD : 1);
+
+            f[threads][0] = stable_sum_vec_float(x);
+            f[threads][1] = mean_vec_float(x);
+            f[threads][2] = variance_vec_float(x, true);
+            f[threads][3] = min_vec_float(x);
+            f[threads][4] = max_vec_float(x);
+            d[threads][0] = stable_sum_vec_double(xd);
+            d[threads][1] = mean_vec_double(xd);
+            d[threads][2] = variance_vec_double(xd, true);
+            d[threads][3] = min_vec_double(xd);
+            d[threads][4] = max_vec_double(xd);
+
+            ok = ok && argmin_vec_float(x) == 100 && argmax_vec_float(x) == 20000;
+            ok = ok && argmin_vec_double(xd) == 100 && argmax_vec_double(xd) == 20000;
+        }
+
+        // Bit-identical whatever the thread count
+        ok = ok && memcmp(f[0], f[1], sizeof(f[0])) == 0 && memcmp(d[0], d[1], sizeof(d[0])) == 0;
+
+        ok = ok && close_enough(f[0][0], (double)sum, 1e-6) && close_enough(f[0][1], (double)mean, 1e-6);
+        ok = ok && close_enough(f[0][2], var, 1e-5) && f[0][3] == 500.0f && f[0][4] == 2000.0f;
+        ok = ok && close_enough(d[0][0], (double)sum, 1e-14) && close_enough(d[0][1], (double)mean, 1e-14);
+        ok = ok && close_enough(d[0][2], var, 1e-12) && d[0][3] == 500.0 && d[0][4] == 2000.0;
+    }
+
+    if (!ok) printf("FAILED AT SIMD LEVEL %d\n", get_simd_level());
+
+    set_simd_level(max);
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    free_vec(x);
+    free_vec(xd);
+    return ok ? PASSED : FAILED;
+}
+
+test test_stats_edges(vec_void* v) {
+
+    (void)v;
+
+    vec_float* x = init_vec(37, sizeof(float), false);
+    vec_float* empty = init_vec(0, sizeof(float), false);
+    bool ok = x != NULL && empty != NULL;
+
+    // NaNs are skipped by min/max, -0 and +0 tie
+    for (size_t i = 0; ok && i < x->size; i++) x->array[i] = NAN;
+    if (ok) {
+        x->array[5] = 0.0f;
+        x->array[9] = -0.0f;
+        x->array[30] = 3.0f;
+    }
+
+    ok = ok && min_vec_float(x) == 0.0f && argmin_vec_float(x) == 5;
+    ok = ok && max_vec_float(x) == 3.0f && argmax_vec_float(x) == 30;
+    ok = ok && isnan(stable_sum_vec_float(x));
+
+    // All NaN, empty and NULL have no extremum
+    if (ok) x->array[5] = x->array[9] = x->array[30] = NAN;
+    ok = ok && isnan(min_vec_float(x)) && isnan(max_vec_float(x)) && argmin_vec_float(x) == SIZE_MAX;
+    ok = ok && isnan(min_vec_float(empty)) && argmax_vec_float(empty) == SIZE_MAX && argmin_vec_double(NULL) == SIZE_MAX;
+
+    // Infinite components are real extrema
+    if (ok) x->array[12] = INFINITY;
+    ok = ok && min_vec_float(x) == INFINITY && argmin_vec_float(x) == 12;
+
+    ok = ok && stable_sum_vec_float(empty) == 0.0f && isnan(mean_vec_float(empty)) && isnan(stable_sum_vec_double(NULL));
+
+    // One component: population variance 0, sample variance undefined
+    if (ok) x->size = 1, x->array[0] = 4.0f;
+    ok = ok && variance_vec_float(x, false) == 0.0f && isnan(variance_vec_float(x, true));
+
+    free_vec(x);
+    free_vec(empty);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XVI: LINALG_H
+// Several panels and a ragged last one
+#define LINALG_TEST_N (3 * LINALG_BLOCK + 23)
+#define LINALG_TEST_NRHS 3
+
+test test_lu_solve(vec_void* v) {
+
+    (void)v;
+
+    size_t n = LINALG_TEST_N + (size_t)init_size % 7, nrhs = LINALG_TEST_NRHS;
+    mat_double* a0 = init_mat(n, n, sizeof(double));
+    mat_double* a = init_mat(n, n, sizeof(double));
+    mat_double* x = init_mat(n, nrhs, sizeof(double));
+    mat_double* b = init_mat(n, nrhs, sizeof(double));
+    size_t* piv = malloc(n * sizeof(size_t));
+    bool ok = a0 != NULL && a != NULL && x != NULL && b != NULL && piv != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) {
+        for (size_t j = 0; j < n; j++) mat_at(a0, i, j) = (double)(rand() % 2001 - 1000) / 1000.0;
+        for (size_t j = 0; j < nrhs; j++) mat_at(x, i, j) = (double)(rand() % 201 - 100) / 10.0;
+    }
+
+    for (int threads = 0; ok && threads < 2; threads++) {
+
+        ok = set_thread_count(threads == 0 ? 1 : POOL_TEST_THREADS);
+        set_parallel_threshold(threads == 0 ? POOL_DEFAULT_THRESHOLD : 1);
+
+        for (size_t i = 0; i < n; i++) memcpy(&mat_at(a, i, 0), &mat_at(a0, i, 0), n * sizeof(double));
+        ok = ok && gemm_mat_double(b, 1.0, a0, x, 0.0);
+        ok = ok && lu_mat_double(a, piv) && lu_solve_mat_double(a, piv, b);
+
+        for (size_t i = 0; ok && i < n; i++)
+            for (size_t j = 0; ok && j < nrhs; j++) ok = close_enough(mat_at(b, i, j), mat_at(x, i, j), 1e-9);
+
+        // U^T y = x, checked by multiplying back
+        for (size_t i = 0; ok && i < n; i++) memcpy(&mat_at(b, i, 0), &mat_at(x, i, 0), nrhs * sizeof(double));
+        ok = ok && trsm_mat_double(TRI_UPPER, true, false, a, b);
+        for (size_t i = 0; ok && i < n; i++)
+            for (size_t j = 0; ok && j < nrhs; j++) {
+
+                double got = 0;
+                for (size_t p = 0; p <= i; p++) got += mat_at(a, p, i) * mat_at(b, p, j);
+                ok = close_enough(got, mat_at(x, i, j), 1e-9);
+            }
+    }
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    // A zero column stays exactly zero through every update: singular.
+    // Shapes must match
+    for (size_t i = 0; ok && i < n; i++) {
+        memcpy(&mat_at(a, i, 0), &mat_at(a0, i, 0), n * sizeof(double));
+        mat_at(a, i, n - 2) = 0.0;
+    }
+    ok = ok && !lu_mat_double(a, piv) && !lu_mat_double(x, piv) && !lu_solve_mat_double(x, piv, b) && !lu_mat_double(NULL, piv);
+
+    free_mat(a0);
+    free_mat(a);
+    free_mat(x);
+    free_mat(b);
+    free(piv);
+    return ok ? PASSED : FAILED;
+}
+
+test test_cholesky_solve(vec_void* v) {
+
+    (void)v;
+
+    size_t n = LINALG_TEST_N + (size_t)init_size % 7, nrhs = LINALG_TEST_NRHS;
+    mat_double* m = init_mat(n, n, sizeof(double));
+    mat_double* a0 = init_mat(n, n, sizeof(double));
+    mat_double* a = init_mat(n, n, sizeof(double));
+    mat_double* x = init_mat(n, nrhs, sizeof(double));
+    mat_double* b = init_mat(n, nrhs, sizeof(double));
+    bool ok = m != NULL && a0 != NULL && a != NULL && x != NULL && b != NULL;
+
+    // A = M M^T + n I is symmetric positive definite
+    for (size_t i = 0; ok && i < n; i++) {
+        for (size_t j = 0; j < n; j++) mat_at(m, i, j) = (double)(rand() % 2001 - 1000) / 1000.0;
+        for (size_t j = 0; j < nrhs; j++) mat_at(x, i, j) = (double)(rand() % 201 - 100) / 10.0;
+    }
+    for (size_t i = 0; ok && i < n; i++)
+        for (size_t j = 0; j < n; j++) {
+
+            double s = i == j ? (double)n : 0.0;
+            for (size_t p = 0; p < n; p++) s += mat_at(m, i, p) * mat_at(m, j, p);
+            mat_at(a0, i, j) = s;
+        }
+
+    for (int threads = 0; ok && threads < 2; threads++) {
+
+        ok = set_thread_count(threads == 0 ? 1 : POOL_TEST_THREADS);
+        set_parallel_threshold(threads == 0 ? POOL_DEFAULT_THRESHOLD : 1);
+
+        for (size_t i = 0; i < n; i++) memcpy(&mat_at(a, i, 0), &mat_at(a0, i, 0), n * sizeof(double));
+        ok = ok && gemm_mat_double(b, 1.0, a0, x, 0.0);
+        ok = ok && cholesky_mat_double(a) && cholesky_solve_mat_double(a, b);
+
+        for (size_t i = 0; ok && i < n; i++)
+            for (size_t j = 0; ok && j < nrhs; j++) ok = close_enough(mat_at(b, i, j), mat_at(x, i, j), 1e-9);
+
+        // L L^T == A on the lower triangle, the strict upper one is untouched
+        for (size_t i = 0; ok && i < n; i++)
+            for (size_t j = 0; ok && j < n; j++) {
+
+                if (j > i) {
+                    ok = mat_at(a, i, j) == mat_at(a0, i, j);
+                    continue;
+                }
+
+                double got = 0;
+                for (size_t p = 0; p <= j; p++) got += mat_at(a, i, p) * mat_at(a, j, p);
+                ok = close_enough(got, mat_at(a0, i, j), 1e-12);
+            }
+    }
+
+    set_parallel_threshold(POOL_DEFAULT_THRESHOLD);
+    set_thread_count(0);
+
+    // Not positive definite
+    for (size_t i = 0; ok && i < n; i++) memcpy(&mat_at(a, i, 0), &mat_at(a0, i, 0), n * sizeof(double));
+    if (ok) mat_at(a, n / 2, n / 2) = -1.0;
+    ok = ok && !cholesky_mat_double(a) && !cholesky_mat_double(x) && !cholesky_solve_mat_double(NULL, b);
+
+    free_mat(m);
+    free_mat(a0);
+    free_mat(a);
+    free_mat(x);
+    free_mat(b);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XVII: VECTOR_SHARED_H
+test test_vec_shared(vec_void* v) {
+
+    (void)v;
+
+    // Crosses several segment boundaries one append at a time, then in bulk
+    size_t n = (size_t)init_size + 5000;
+    size_t bulk = 3 * VEC_SHARED_FIRST + 5;
+    vec_shared* s = init_vec_shared(sizeof(int64_t), 0);
+    int64_t* batch = malloc(bulk * sizeof(int64_t));
+    vec_int_64* out = init_vec(0, sizeof(int64_t), false);
+    bool ok = s != NULL && batch != NULL && out != NULL && published_vec_shared(s) == 0 && at_vec_shared(s, 0) == NULL;
+
+    for (size_t i = 0; ok && i < n; i++) ok = append_vec_shared(s, &(int64_t){ (int64_t)i });
+    int64_t* first = ok ? at_vec_shared(s, 0) : NULL;
+
+    for (size_t i = 0; ok && i < bulk; i++) batch[i] = (int64_t)(n + i);
+    ok = ok && append_n_vec_shared(s, batch, bulk) && published_vec_shared(s) == n + bulk;
+    // Growing never moves what is already there
+    ok = ok && at_vec_shared(s, 0) == first;
+    for (size_t i = 0; ok && i < n + bulk; i++) ok = *(int64_t*)at_vec_shared(s, i) == (int64_t)i;
+    ok = ok && at_vec_shared(s, n + bulk) == NULL;
+
+    // Spans end at segment boundaries and at end
+    size_t seen = 0, runs = 0;
+    for (size_t i = 0, len; ok && i < n + bulk - 1; i += len, runs++) {
+
+        const int64_t* run;
+        len = span_vec_shared(s, i, n + bulk - 1, (const void**)&run);
+        for (size_t j = 0; ok && j < len; j++) ok = run[j] == (int64_t)(i + j);
+        seen += len;
+        ok = ok && len > 0;
+    }
+    ok = ok && seen == n + bulk - 1 && runs > 1 && span_vec_shared(s, n + bulk, n + bulk + 9, (const void**)&first) == 0;
+
+    ok = ok && snapshot_vec_shared(s, out) && out->size == n + bulk;
+    for (size_t i = 0; ok && i < out->size; i++) ok = out->array[i] == (int64_t)i;
+
+    ok = ok && init_vec_shared(0, 1) == NULL && !append_vec_shared(s, NULL) && !append_vec_shared(NULL, batch);
+    ok = ok && !reserve_vec_shared(s, SIZE_MAX) && reserve_vec_shared(s, 100 * VEC_SHARED_FIRST) && !snapshot_vec_shared(s, NULL);
+
+    free_vec_shared(s);
+    free(batch);
+    free_vec(out);
+    return ok ? PASSED : FAILED;
+}
+
+typedef struct shared_producer {
+
+    vec_shared* s;
+    int64_t id;
+    size_t count;
+    atomic_size_t* done;
+} shared_producer;
+
+// Appends (id, seq) pairs, alternating single appends and small batches
+static void* shared_produce(void* arg) {
+
+    shared_producer* p = (shared_producer*)arg;
+    int64_t batch[7];
+    void* result = p;
+
+    for (size_t seq = 0; result != NULL && seq < p->count; ) {
+
+        size_t len = seq % 3 == 0 ? 1 : 7;
+        if (len > p->count - seq) len = p->count - seq;
+
+        for (size_t j = 0; j < len; j++) batch[j] = p->id << 32 | (int64_t)(seq + j);
+        if (!append_n_vec_shared(p->s, batch, len)) result = NULL;
+        seq += len;
+    }
+
+    atomic_fetch_add(p->done, 1);
+    return result;
+}
+
+test test_vec_shared_threads(vec_void* v) {
+
+    (void)v;
+
+    size_t per = (size_t)init_size + 20000;
+    size_t total = POOL_TEST_THREADS * per;
+    vec_shared* s = init_vec_shared(sizeof(int64_t), 0);
+    shared_producer prod[POOL_TEST_THREADS];
+    pthread_t threads[POOL_TEST_THREADS];
+    size_t next[POOL_TEST_THREADS] = { 0 };
+    size_t started = 0;
+    atomic_size_t done = 0;
+    bool ok = s != NULL;
+
+    for (; ok && started < POOL_TEST_THREADS; started++) {
+
+        prod[started] = (shared_producer){ s, (int64_t)started, per, &done };
+        ok = pthread_create(&threads[started], NULL, shared_produce, &prod[started]) == 0;
+        if (!ok) break;
+    }
+
+    // Read the prefix while it grows: it may only ever hold finished
+    // components, each producer's in the order it appended them
+    size_t checked = 0;
+    while (ok && checked < total) {
+
+        // Loaded first: once every producer is done the prefix is final
+        bool finished = atomic_load(&done) == started;
+        size_t n = published_vec_shared(s);
+        for (; ok && checked < n; checked++) {
+
+            int64_t x = *(int64_t*)at_vec_shared(s, checked);
+            size_t id = (size_t)(x >> 32);
+            ok = id < POOL_TEST_THREADS && (size_t)(x & 0xFFFFFFFF) == next[id]++;
+        }
+
+        if (finished) break;
+    }
+
+    for (size_t t = 0; t < started; t++) {
+
+        void* r;
+        pthread_join(threads[t], &r);
+        ok = ok && r != NULL;
+    }
+
+    ok = ok && published_vec_shared(s) == total && checked == total;
+    for (size_t t = 0; ok && t < POOL_TEST_THREADS; t++) ok = next[t] == per;
+
+    free_vec_shared(s);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XVIII: VECTOR_RING_H
+test test_vec_ring(vec_void* v) {
+
+    (void)v;
+
+    // 100 rounds up to 128 slots
+    vec_ring* r = init_vec_ring(sizeof(int64_t), 100);
+    vec_int_64* out = init_vec(0, sizeof(int64_t), false);
+    int64_t in[200], got[200];
+    bool ok = r != NULL && out != NULL && r->mask == 127 && size_vec_ring(r) == 0;
+
+    for (int i = 0; i < 200; i++) in[i] = i;
+
+    int64_t x = -1;
+    ok = ok && !pop_vec_ring(r, &x) && x == -1 && pop_n_vec_ring(r, got, 10) == 0;
+
+    // A batch bigger than the free space is cut short, the rest stays put
+    ok = ok && push_n_vec_ring(r, in, 200) == 128 && !push_vec_ring(r, &in[0]) && size_vec_ring(r) == 128;
+    ok = ok && pop_n_vec_ring(r, got, 100) == 100 && memcmp(got, in, 100 * sizeof(int64_t)) == 0;
+
+    // Runs that wrap past the last slot
+    size_t next_in = 128, next_out = 100;
+    for (int round = 0; ok && round < init_size + 50; round++) {
+
+        size_t want = (size_t)(round % 37) + 1;
+        int64_t batch[40];
+        for (size_t j = 0; j < want; j++) batch[j] = (int64_t)(next_in + j);
+
+        size_t pushed = push_n_vec_ring(r, batch, want);
+        next_in += pushed;
+
+        size_t popped = pop_n_vec_ring(r, got, (size_t)(round % 23) + 1);
+        for (size_t j = 0; ok && j < popped; j++) ok = got[j] == (int64_t)(next_out + j);
+        next_out += popped;
+        ok = ok && size_vec_ring(r) == next_in - next_out;
+    }
+
+    // Draining appends after what the vector already holds
+    ok = ok && append(out, -7) && drain_vec_ring(r, out, SIZE_MAX) == next_in - next_out && size_vec_ring(r) == 0;
+    ok = ok && out->array[0] == -7 && out->size == next_in - next_out + 1;
+    for (size_t j = 1; ok && j < out->size; j++) ok = out->array[j] == (int64_t)(next_out + j - 1);
+    ok = ok && drain_vec_ring(r, out, 5) == 0;
+
+    ok = ok && push_vec_ring(r, &in[3]) && pop_vec_ring(r, &x) && x == 3;
+    ok = ok && init_vec_ring(0, 4) == NULL && init_vec_ring(8, 0) == NULL && init_vec_ring(8, SIZE_MAX) == NULL;
+    ok = ok && !push_vec_ring(NULL, &x) && !pop_vec_ring(r, NULL) && drain_vec_ring(r, NULL, 1) == 0;
+
+    free_vec_ring(r);
+    free_vec(out);
+    return ok ? PASSED : FAILED;
+}
+
+typedef struct ring_producer {
+
+    vec_ring* r;
+    size_t count;
+} ring_producer;
+
+// Pushes 0, 1, 2, ... in batches of changing size, yielding while full
+static void* ring_produce(void* arg) {
+
+    ring_producer* p = (ring_producer*)arg;
+    int64_t batch[13];
+
+    for (size_t next = 0; next < p->count; ) {
+
+        size_t want = next % 13 + 1;
+        if (want > p->count - next) want = p->count - next;
+        for (size_t j = 0; j < want; j++) batch[j] = (int64_t)(next + j);
+
+        size_t pushed = want == 1 ? (size_t)push_vec_ring(p->r, batch) : push_n_vec_ring(p->r, batch, want);
+        if (pushed == 0) sched_yield();
+        next += pushed;
+    }
+
+    return p;
+}
+
+test test_vec_ring_threads(vec_void* v) {
+
+    (void)v;
+
+    // A small ring, so both sides keep running into full and empty
+    size_t total = (size_t)init_size * 10 + 200000;
+    vec_ring* r = init_vec_ring(sizeof(int64_t), 64);
+    ring_producer prod = { r, total };
+    pthread_t thread;
+    bool ok = r != NULL && pthread_create(&thread, NULL, ring_produce, &prod) == 0;
+    bool started = ok;
+
+    int64_t got[29];
+    size_t seen = 0;
+    while (ok && seen < total) {
+
+        size_t popped = seen % 2 ? pop_n_vec_ring(r, got, seen % 29 + 1) : (size_t)pop_vec_ring(r, got);
+        if (popped == 0) sched_yield();
+
+        for (size_t j = 0; ok && j < popped; j++) ok = got[j] == (int64_t)(seen + j);
+        seen += popped;
+    }
+
+    if (started) pthread_join(thread, NULL);
+    ok = ok && seen == total && size_vec_ring(r) == 0;
+
+    free_vec_ring(r);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XIX: TELEMETRY_H
+// Ten appends from a thread of its own, counted once it has exited
+static void* telemetry_worker(void* arg) {
+
+    vec_int_32* w = init_vec(0, sizeof(int32_t), false);
+    for (int i = 0; w != NULL && i < 10; i++) append(w, i);
+
+    free_vec(w);
+    trim_vec_pool();
+    return arg;
+}
+
+test test_telemetry(vec_void* v) {
+
+    (void)v;
+
+    size_t n = (size_t)init_size + 100;
+    telemetry_stats before, mine, all;
+    telemetry_reset();
+    telemetry_snapshot_all(&before);
+
+    vec_int_32* w = init_vec(0, sizeof(int32_t), false);
+    bool ok = w != NULL;
+
+    for (size_t i = 0; ok && i < n; i++) ok = append(w, (int32_t)i);
+
+    int32_t* deep = ok ? get_deep(w, 0) : NULL;
+    ok = ok && deep != NULL && erase_range(w, 0, 1) && contains(w, (int32_t)5);
+    free(deep);
+
+    pthread_t thread;
+    ok = ok && pthread_create(&thread, NULL, telemetry_worker, NULL) == 0 && pthread_join(thread, NULL) == 0;
+
+    telemetry_snapshot(&mine);
+    telemetry_snapshot_all(&all);
+
+    FILE* out = tmpfile();
+    ok = ok && out != NULL && telemetry_dump(out, &all) && ftell(out) > 0 && !telemetry_dump(NULL, &all);
+    if (out != NULL) fclose(out);
+    ok = ok && strcmp(telemetry_op_name(TELEMETRY_ARL_APPEND), "arl_append") == 0;
+    ok = ok && strcmp(telemetry_op_name(TELEMETRY_OP_COUNT), "unknown") == 0;
+
+    if (!telemetry_enabled()) {
+
+        // Compiled out: nothing is ever counted
+        telemetry_stats zero;
+        memset(&zero, 0, sizeof(zero));
+        ok = ok && memcmp(&mine, &zero, sizeof(zero)) == 0 && memcmp(&all, &zero, sizeof(zero)) == 0;
+    }
+
+    else {
+
+        // Every append is counted whether it took the inline fast path or
+        // grew the vector
+        ok = ok && mine.calls[TELEMETRY_VEC_APPEND] == n && mine.calls[TELEMETRY_VEC_INIT] == 1;
+        ok = ok && mine.grows == w->stats.grows && mine.calls[TELEMETRY_VEC_RESIZE] == w->stats.grows;
+        ok = ok && mine.allocations >= 1 && mine.bytes_copied >= n * sizeof(int32_t);
+        ok = ok && mine.calls[TELEMETRY_VEC_GET_DEEP] == 1 && mine.calls[TELEMETRY_VEC_ERASE] == 1;
+        ok = ok && mine.calls[TELEMETRY_VEC_CONTAINS] == 1 && mine.cycles[TELEMETRY_VEC_APPEND] > 0;
+        ok = ok && all.calls[TELEMETRY_VEC_APPEND] >= before.calls[TELEMETRY_VEC_APPEND] + n + 10;
+
+        telemetry_reset();
+        telemetry_snapshot(&mine);
+        ok = ok && mine.calls[TELEMETRY_VEC_APPEND] == 0 && mine.allocations == 0;
+    }
+
+    free_vec(w);
+    return ok ? PASSED : FAILED;
+}
+
+// TEST CASE XX: ARRAY_LIST_H
+// Lists are boxed, packed or packed inside an arena
+#define ARL_MODES 3
+
+// Element i: its index in the leading bytes, so every element up to 255 is distinct
+static void arl_elem(size_t i, unsigned char* out) {
+
+    for (size_t b = 0; b < data_size; b++) out[b] = b < sizeof(size_t) ? (unsigned char)(i >> (8 * b)) : 0;
+}
+
+// Buffer of count elements, first, first + 1, ...
+static unsigned char* arl_elems(size_t first, size_t count) {
+
+    unsigned char* buf = malloc(count * data_size + 1);
+    for (size_t i = 0; buf != NULL && i < count; i++) arl_elem(first + i, buf + i * data_size);
+    return buf;
+}
+
+static arl* arl_of_mode(int mode, arena* a, int capacity) {
+
+    if (mode == 0) return init_arl(capacity, data_size);
+    if (mode == 1) return init_arl_packed(capacity, data_size);
+    return init_arl_arena(a, capacity, data_size);
+}
+
+// Same elements as model, in the same order
+static bool arl_matches(arl* ar, const unsigned char* model, int count) {
+
+    if (ar == NULL || ar->size != count) return false;
+
+    for (int i = 0; i < count; i++)
+        if (memcmp(get_shallow_arl(i, ar), model + (size_t)i * data_size, data_size) != 0) return false;
+
+    return true;
+}
+
+static char arl_memcmp(const void* arg1, const void* arg2) {
+    return memcmp(arg1, arg2, data_size) == 0 ? 0 : 1;
+}
+
+// Drops elements whose index is a multiple of 3
+static char arl_every_third(const void* data, void* context) {
+
+    (void)context;
+    return *(const unsigned char*)data % 3 == 0;
+}
+
+test test_arl_modes(vec_void* v) {
+
+    (void)v;
+
+    // NO_TYPE has no element size, no list takes it
+    arena* a = init_arena(512);
+    if (a == NULL) return FAILED;
+    if (data_type == NO_TYPE) {
+
+        bool refused = init_arl(4, 0) == NULL && init_arl_packed(4, 0) == NULL && init_arl_arena(a, 4, 0) == NULL;
+        free_arena(a);
+        return refused ? PASSED : FAILED;
+    }
+
+    int n = 100 + init_size % 100;
+    unsigned char* model = arl_elems(0, (size_t)n + 1);
+    unsigned char x[sizeof(int64_t)], y[sizeof(int64_t)];
+    arl_elem(200, x);
+    arl_elem(201, y);
+    bool ok = model != NULL;
+
+    for (int mode = 0; ok && mode < ARL_MODES; mode++) {
+
+        arl* ar = arl_of_mode(mode, a, 2);
+        ok = ar != NULL && ar->packed == (mode != 0) && (ar->arena == a) == (mode == 2);
+        for (int i = 0; ok && i < n; i++) ok = append_arl(model + (size_t)i * data_size, ar)->size == i + 1;
+        ok = ok && arl_matches(ar, model, n) && ar->capacity >= n;
+
+        // Deep copies are separate, shallow ones are the element itself
+        unsigned char* deep = ok ? get_deep_arl(n - 1, ar) : NULL;
+        ok = ok && deep != NULL && deep != get_shallow_arl(n - 1, ar);
+        ok = ok && memcmp(deep, model + (size_t)(n - 1) * data_size, data_size) == 0;
+        free(deep);
+
+        // Nothing outside 0..size-1 is readable
+        ok = ok && get_shallow_arl(n, ar) == NULL && get_shallow_arl(-1, ar) == NULL;
+        ok = ok && get_deep_arl(n, ar) == NULL && get_deep_arl(-1, ar) == NULL;
+        ok = ok && get_shallow_arl(0, NULL) == NULL && get_deep_arl(0, NULL) == NULL;
+
+        // Replace in range, reject past the end, append at size
+        ok = ok && replace_arl(x, n - 1, ar)->size == n && memcmp(get_shallow_arl(n - 1, ar), x, data_size) == 0;
+        ok = ok && replace_arl(y, n + 1, ar)->size == n && replace_arl(y, -1, ar)->size == n;
+        ok = ok && memcmp(get_shallow_arl(0, ar), model, data_size) == 0;
+        ok = ok && replace_arl(y, n, ar)->size == n + 1 && memcmp(get_shallow_arl(n, ar), y, data_size) == 0;
+
+        // Delete in range shifts the rest down, anything else is ignored
+        ok = ok && delete_arl(n + 1, ar)->size == n + 1 && delete_arl(-1, ar)->size == n + 1;
+        ok = ok && delete_arl(ar->capacity, ar)->size == n + 1;
+        ok = ok && delete_arl(0, ar)->size == n && memcmp(get_shallow_arl(0, ar), model + data_size, data_size) == 0;
+
+        // Capacity changes in place, downsize drops what no longer fits
+        int capacity = ar->capacity;
+        ok = ok && upsize_arl(ar)->capacity == 2 * capacity && ar->size == n && memcmp(get_shallow_arl(n - 2, ar), x, data_size) == 0;
+        while (ok && ar->capacity > n / 2) ok = downsize_arl(ar)->capacity < capacity * 2;
+        ok = ok && ar->size == ar->capacity && arl_matches(ar, model + data_size, ar->size);
+
+        free_arl(ar);
+
+        // A full list: replacing at size must append, not write past the buffer
+        ar = arl_of_mode(mode, a, 2);
+        ok = ok && ar != NULL && append_arl(x, append_arl(x, ar))->size == 2 && ar->capacity == 2;
+        ok = ok && replace_arl(y, 2, ar)->size == 3 && memcmp(get_shallow_arl(2, ar), y, data_size) == 0;
+        ok = ok && replace_arl(y, 4, ar)->size == 3;
+        free_arl(ar);
+    }
+
+    // Arena lists went back with the arena, so nothing is left to free
+    free(model);
+    free_arena(a);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_arl_batch(vec_void* v) {
+
+    (void)v;
+    if (data_type == NO_TYPE) return PASSED;
+
+    int n = 60 + init_size % 100;
+    unsigned char* src = arl_elems(0, (size_t)n);
+    unsigned char* extra = arl_elems(200, 3);
+    unsigned char* model = malloc((size_t)(n + 9) * data_size);
+    bool ok = src != NULL && extra != NULL && model != NULL;
+
+    for (int packed = 0; ok && packed < 2; packed++) {
+
+        arl* ar = packed ? init_arl_packed(1, data_size) : init_arl(1, data_size);
+        ok = ar != NULL && append_n_arl(src, n, ar)->size == n && ar->stats.grows == 1;
+        memcpy(model, src, (size_t)n * data_size);
+        int count = n;
+
+        // Front, middle and back; past the end and empty batches change nothing
+        int at[] = { 0, count / 2, count + 3 };
+        for (int k = 0; ok && k < 3; k++) {
+
+            memmove(model + (size_t)(at[k] + 3) * data_size, model + (size_t)at[k] * data_size, (size_t)(count - at[k]) * data_size);
+            memcpy(model + (size_t)at[k] * data_size, extra, 3 * data_size);
+            count += 3;
+            ok = arl_matches(insert_range_arl(extra, 3, at[k], ar), model, count);
+        }
+
+        ok = ok && insert_range_arl(extra, 3, count + 1, ar)->size == count && insert_range_arl(extra, 3, -1, ar)->size == count;
+        ok = ok && insert_range_arl(extra, 0, 0, ar)->size == count && append_n_arl(NULL, 3, ar)->size == count;
+
+        // Erase a run from the middle, then one that would run off the end
+        memmove(model + data_size, model + 6 * data_size, (size_t)(count - 6) * data_size);
+        count -= 5;
+        ok = ok && arl_matches(erase_range_arl(1, 5, ar), model, count);
+        ok = ok && erase_range_arl(count - 2, 3, ar)->size == count && erase_range_arl(-1, 1, ar)->size == count;
+
+        // Keep the order of whatever the predicate spares
+        int kept = 0;
+        for (int i = 0; i < count; i++)
+            if (!arl_every_third(model + (size_t)i * data_size, NULL))
+                memmove(model + (size_t)kept++ * data_size, model + (size_t)i * data_size, data_size);
+        ok = ok && arl_matches(erase_if_arl(arl_every_third, NULL, ar), model, kept);
+
+        // Everything at once
+        ok = ok && erase_range_arl(0, kept, ar)->size == 0;
+        free_arl(ar);
+    }
+
+    free(src);
+    free(extra);
+    free(model);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_arl_policy(vec_void* v) {
+
+    (void)v;
+    if (data_type == NO_TYPE) return PASSED;
+
+    unsigned char* src = arl_elems(0, 40);
+    arl* ar = init_arl_packed(1, data_size);
+    bool ok = src != NULL && ar != NULL;
+
+    // Growth of at most 100% or a shrink inside the growth factor thrash
+    ok = ok && !set_policy_arl((growth_policy){ 100, 0, 4 }, ar) && !set_policy_arl((growth_policy){ 300, 2, 4 }, ar);
+    ok = ok && !set_policy_arl((growth_policy){ 200, 4, 0 }, ar) && !set_policy_arl(ARL_DEFAULT_POLICY, NULL);
+
+    // Tripling without ever shrinking
+    ok = ok && set_policy_arl((growth_policy){ 300, 0, 4 }, ar);
+    for (int i = 0; ok && i < 40; i++) ok = append_arl(src + (size_t)i * data_size, ar)->size == i + 1;
+    ok = ok && ar->capacity == 108 && ar->stats.grows == 4;
+    ok = ok && erase_range_arl(0, 39, ar)->size == 1 && ar->capacity == 108 && ar->stats.shrinks == 0;
+
+    // The default one gives the room back on the next delete
+    ok = ok && set_policy_arl(ARL_DEFAULT_POLICY, ar) && delete_arl(0, ar)->size == 0;
+    ok = ok && ar->capacity == ARL_MIN_CAPACITY && ar->stats.shrinks == 1 && ar->stats.grows == 4;
+
+    free_arl(ar);
+    free(src);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_arl_index(vec_void* v) {
+
+    (void)v;
+    if (data_type == NO_TYPE) return PASSED;
+
+    int n = 50 + init_size % 100;
+    unsigned char* src = arl_elems(0, (size_t)n);
+    unsigned char x[sizeof(int64_t)], y[sizeof(int64_t)];
+    arl_elem(250, x);
+    arl_elem(251, y);
+    bool ok = src != NULL;
+
+    for (int packed = 0; ok && packed < 2; packed++) {
+
+        arl* ar = packed ? init_arl_packed(4, data_size) : init_arl(4, data_size);
+        ok = ar != NULL && append_n_arl(src, n, ar)->size == n;
+
+        // Scans, with and without a comparator
+        ok = ok && contains_arl(src + (size_t)(n - 1) * data_size, ar, NULL) && !contains_arl(x, ar, NULL);
+        ok = ok && contains_arl(src, ar, arl_memcmp) && !contains_arl(x, ar, arl_memcmp);
+
+        // The index follows every change
+        ok = ok && index_arl(ar) && ar->index != NULL;
+        ok = ok && contains_arl(src + (size_t)(n / 2) * data_size, ar, NULL) && !contains_arl(x, ar, NULL);
+        ok = ok && !contains_arl(x, replace_arl(x, ar->size + 1, ar), NULL) && !contains_arl(x, replace_arl(x, -1, ar), NULL);
+        ok = ok && contains_arl(y, replace_arl(y, ar->size, ar), NULL) && ar->size == n + 1;
+        ok = ok && !contains_arl(y, delete_arl(n, ar), NULL) && ar->size == n;
+        ok = ok && contains_arl(x, replace_arl(x, 0, ar), NULL) && !contains_arl(src, ar, NULL);
+        ok = ok && !contains_arl(x, delete_arl(0, ar), NULL);
+        ok = ok && contains_arl(y, append_n_arl(y, 1, ar), NULL) && !contains_arl(y, erase_range_arl(ar->size - 1, 1, ar), NULL);
+        ok = ok && !contains_arl(src + 3 * data_size, erase_if_arl(arl_every_third, NULL, ar), NULL);
+        ok = ok && contains_arl(src + data_size, ar, NULL);
+
+        drop_index_arl(ar);
+        ok = ok && ar->index == NULL && contains_arl(src + data_size, ar, NULL) && !contains_arl(x, ar, NULL);
+        free_arl(ar);
+    }
+
+    free(src);
+
+    return ok ? PASSED : FAILED;
+}
+
+test test_arl_io(vec_void* v) {
+
+    (void)v;
+    if (data_type == NO_TYPE) return PASSED;
+
+    char path[] = "/tmp/test_arl_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return FAILED;
+    close(fd);
+
+    int n = 200 + init_size;
+    unsigned char* src = arl_elems(0, 2 * (size_t)n);
+    bool ok = src != NULL;
+
+    // Written from either mode, read back into the other one
+    for (int packed = 0; ok && packed < 2; packed++) {
+
+        arl* ar = packed ? init_arl_packed(1, data_size) : init_arl(1, data_size);
+        ok = ar != NULL && append_n_arl(src, n, ar)->size == n && save_arl(path, 0, ar);
+        free_arl(ar);
+
+        ar = ok ? load_arl(path, data_size, !packed) : NULL;
+        ok = ok && ar != NULL && ar->packed == !packed && arl_matches(ar, src, n);
+
+        // Appending continues the stream
+        arl* tail = ok ? init_arl_packed(1, data_size) : NULL;
+        ok = ok && tail != NULL && append_n_arl(src + (size_t)n * data_size, n, tail)->size == n && save_arl(path, 1, tail);
+        free_arl(tail);
+        free_arl(ar);
+
+        ar = ok ? load_arl(path, data_size, packed) : NULL;
+        ok = ok && arl_matches(ar, src, 2 * n);
+        free_arl(ar);
+    }
+
+    // Element size must match
+    ok = ok && load_arl(path, data_size + 1, 1) == NULL && !save_arl(path, 0, NULL);
+
+    free(src);
+    unlink(path);
+
+    return ok ? PASSED : FAILED;
+}
+
+// PREFIXTURES
+vec_void* prefixtures(type data_type, int init_size, bool fixed_length) {
+
+    // Manually create a vector
+    if (data_type == NO_TYPE) return NULL;
+
+    // Init vec struct
+    vec_void* v = (vec_void*)malloc(sizeof(vec_void));
+    if (v == NULL) return NULL;
+
+    // Init the size, capacity, and fixed_length metadata
+    v->size = init_size;
+    v->capacity = init_size;
+    v->fixed_length = fixed_length;
+    v->pool_class = 0;
+    v->arena = NULL;
+    v->index = NULL;
+    v->policy = VEC_DEFAULT_POLICY;
+    v->stats = (resize_stats){ 0, 0 };
+    v->array = NULL;
+
+    if (init_size == 0) return v;
+
+    // Zeroed components, like init_vec
+    v->array = calloc(init_size, get_data_size(data_type));
+    if (v->array == NULL) {
+
+        free(v);
+        return NULL;
+    }
+
+    return v;
+}
+
+void run_test_case(test(*test_case[])(vec_void*), int size) {
+
+    if (test_case == NULL) {
+        printf("NO TEST CASE GIVEN, EXITING!\n");
+        return;
+    }
+
+    vec_void* main_v = NULL;
+
+    int i = 0;
+    for (i = 0; i < size; i++) {
+
+        // PREFIXTURE
+        main_v = prefixtures(data_type, init_size, false);
+
+        if ((*test_case[i])(main_v) == FAILED) goto FAIL;
+
+        // TEARDOWN
+        teardown(main_v);
+    }
+
+    return;
+
+    // FAILED TEST
+FAIL:
+    teardown(main_v);
+    printf("\nTEST %d FAILED, EXIT -1!\n", i);
+    exit(-1);
+}
+
+// TEAR DOWN
+void teardown(vec_void* v) {
+
+    if (v == NULL) return;
+
+    // Free the component array
+    free(v->array);
+
+    // Finally, free the v pointer
+    free(v);
+}
+
+// HELPER FUNCTIONS
+bool comp_data(const void* arg1, const void* arg2, type data_type) {
+    (void)data_type;
+    return memcmp(arg1, arg2, data_size) == 0;
+}
+
+size_t get_data_size(type data_type) {
+
+    switch (data_type) {
+
+        case CHAR:
+            return sizeof(char);
+
+        case INT32:
+            return sizeof(int32_t);
+
+        case INT64:
+            return sizeof(int64_t);
+
+        case FLOAT32:
+            return sizeof(float);
+
+        case DOUBLE:
+            return sizeof(double);
+
+        default:
+            return 0x00;
+    }
+}
+
+void fill_random(vec_void* v) {
+
+    // Fill v with random values
+    for (size_t i = 0; i < v->size; i++) {
+
+        int64_t val64 = (int64_t)(rand() % (init_size + 1));
+        memcpy((char*)v->array + i * data_size, &val64, data_size);
+    }
+}
+
+bool close_enough(double got, double want, double tol) {
+    return fabs(got - want) <= tol * (fabs(want) + 1.0);
 }
 
 bool parse_args(int argc, char* argv[]) {
@@ -0,0 +1,408 @@
+/**
+ * Persistent worker pool with Chase-Lev work-stealing deques.
+ * Every worker owns a deque it pushes/pops at the bottom; idle workers
+ * steal from the top of somebody else's. A job starts as one task on the
+ * submitting thread's deque and is split in halves as it is taken, so the
+ * work spreads out in O(log N) steals.
+ * @author Alejandro Ciuba
+ */
+
+#include "thread_pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Must be a power of 2; splitting only ever needs about log2(N) slots
+#define DEQUE_CAPACITY 256
+// Failed search rounds before a worker goes to sleep
+#define SPIN_LIMIT 64
+
+// ===================== STRUCTS =====================
+
+typedef struct job {
+
+    task_fn fn;
+    void* ctx;
+    size_t grain;
+    // Indices not processed yet, the job is done at 0
+    atomic_size_t remaining;
+} job;
+
+typedef struct task {
+
+    job* owner;
+    size_t begin;
+    size_t end;
+} task;
+
+// top and bottom sit on separate cache lines, thieves only touch top
+typedef struct deque {
+
+    _Alignas(64) atomic_long top;
+    _Alignas(64) atomic_long bottom;
+    task tasks[DEQUE_CAPACITY];
+} deque;
+
+typedef struct pool {
+
+    pthread_t* threads;
+    // workers + 1 deques, the last one belongs to the submitting thread
+    deque* deques;
+    size_t workers;
+    bool started;
+
+    // Sleeping workers wait for epoch to change
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    unsigned long epoch;
+    atomic_size_t sleeping;
+    bool stop;
+
+    // Only one job runs at a time
+    pthread_mutex_t submit;
+} pool;
+
+static pool the_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .submit = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static atomic_size_t parallel_threshold = POOL_DEFAULT_THRESHOLD;
+
+// workers + 1 once the pool has started, 0 before. Read without taking
+// submit, which the thread running a job holds until it is done
+static atomic_size_t thread_count = 0;
+
+// Deque index of this thread while it takes part in a job, -1 otherwise
+static _Thread_local long worker_index = -1;
+
+// ===================== DEQUE =====================
+
+// Owner only
+static bool deque_push(deque* d, task t) {
+
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - top >= DEQUE_CAPACITY) return false;
+
+    // Release publishes the slot to thieves that acquire bottom
+    d->tasks[b & (DEQUE_CAPACITY - 1)] = t;
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+
+    return true;
+}
+
+// Owner only
+static bool deque_take(deque* d, task* t) {
+
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (top > b) {
+
+        // Empty
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *t = d->tasks[b & (DEQUE_CAPACITY - 1)];
+    if (top < b) return true;
+
+    // Last task, race the thieves for it
+    bool won = atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                       memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+
+    return won;
+}
+
+// Any thread
+static bool deque_steal(deque* d, task* t) {
+
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (top >= b) return false;
+
+    *t = d->tasks[top & (DEQUE_CAPACITY - 1)];
+    return atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                                                   memory_order_seq_cst, memory_order_relaxed);
+}
+
+// ===================== WORKERS =====================
+
+// Own deque first, then every other deque starting from a rotating victim
+static bool find_work(size_t self, task* t, unsigned* seed) {
+
+    if (deque_take(&the_pool.deques[self], t)) return true;
+
+    size_t count = the_pool.workers + 1;
+    size_t start = (size_t)rand_r(seed) % count;
+
+    for (size_t i = 0; i < count; i++) {
+
+        size_t victim = (start + i) % count;
+        if (victim != self && deque_steal(&the_pool.deques[victim], t)) return true;
+    }
+
+    return false;
+}
+
+// Wakes sleeping workers because there is something to steal
+static void notify_workers(void) {
+
+    if (atomic_load_explicit(&the_pool.sleeping, memory_order_relaxed) == 0) return;
+
+    pthread_mutex_lock(&the_pool.lock);
+    the_pool.epoch++;
+    pthread_cond_broadcast(&the_pool.wake);
+    pthread_mutex_unlock(&the_pool.lock);
+}
+
+// Keeps halving t, leaving the upper halves for thieves, then runs what is left
+static void run_task(size_t self, task t) {
+
+    job* j = t.owner;
+
+    while (t.end - t.begin > j->grain) {
+
+        size_t mid = t.begin + (t.end - t.begin) / 2;
+        task upper = { j, mid, t.end };
+        if (!deque_push(&the_pool.deques[self], upper)) break;
+
+        t.end = mid;
+        notify_workers();
+    }
+
+    j->fn(j->ctx, t.begin, t.end);
+    atomic_fetch_sub_explicit(&j->remaining, t.end - t.begin, memory_order_release);
+}
+
+static void* worker_main(void* arg) {
+
+    size_t self = (size_t)arg;
+    unsigned seed = (unsigned)self * 2654435761u + 1;
+    unsigned long seen = 0;
+    int idle = 0;
+
+    worker_index = (long)self;
+
+    for (;;) {
+
+        task t;
+        if (find_work(self, &t, &seed)) {
+
+            run_task(self, t);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < SPIN_LIMIT) {
+
+            sched_yield();
+            continue;
+        }
+
+        // Nothing to do, sleep until the next job (or split) is announced
+        pthread_mutex_lock(&the_pool.lock);
+        atomic_fetch_add(&the_pool.sleeping, 1);
+        while (!the_pool.stop && the_pool.epoch == seen)
+            pthread_cond_wait(&the_pool.wake, &the_pool.lock);
+        atomic_fetch_sub(&the_pool.sleeping, 1);
+        seen = the_pool.epoch;
+        bool stop = the_pool.stop;
+        pthread_mutex_unlock(&the_pool.lock);
+
+        if (stop) return NULL;
+        idle = 0;
+    }
+}
+
+// ===================== POOL =====================
+
+// Caller holds the_pool.submit
+static void stop_pool(void) {
+
+    if (!the_pool.started) return;
+
+    atomic_store(&thread_count, 0);
+    pthread_mutex_lock(&the_pool.lock);
+    the_pool.stop = true;
+    pthread_cond_broadcast(&the_pool.wake);
+    pthread_mutex_unlock(&the_pool.lock);
+
+    for (size_t i = 0; i < the_pool.workers; i++)
+        pthread_join(the_pool.threads[i], NULL);
+
+    free(the_pool.threads);
+    free(the_pool.deques);
+    the_pool.threads = NULL;
+    the_pool.deques = NULL;
+    the_pool.workers = 0;
+    the_pool.stop = false;
+    the_pool.started = false;
+}
+
+// Joins the workers before the process tears itself down
+static void stop_pool_at_exit(void) {
+    free_thread_pool();
+}
+
+// Caller holds the_pool.submit
+static bool start_pool(size_t threads) {
+
+    static bool registered = false;
+    if (!registered) registered = atexit(stop_pool_at_exit) == 0;
+
+    if (threads == 0) {
+
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    size_t workers = threads - 1;
+    the_pool.started = true;
+    the_pool.workers = 0;
+    atomic_store(&thread_count, 1);
+    if (workers == 0) return true;
+
+    the_pool.deques = aligned_alloc(_Alignof(deque), sizeof(deque) * (workers + 1));
+    the_pool.threads = malloc(sizeof(pthread_t) * workers);
+    if (the_pool.deques == NULL || the_pool.threads == NULL) {
+
+        free(the_pool.deques);
+        free(the_pool.threads);
+        the_pool.deques = NULL;
+        the_pool.threads = NULL;
+        return false;
+    }
+
+    for (size_t i = 0; i <= workers; i++) {
+
+        atomic_init(&the_pool.deques[i].top, 0);
+        atomic_init(&the_pool.deques[i].bottom, 0);
+    }
+
+    // Workers read the_pool.workers as soon as they start
+    the_pool.workers = workers;
+
+    for (size_t i = 0; i < workers; i++) {
+
+        if (pthread_create(&the_pool.threads[i], NULL, worker_main, (void*)i) != 0) {
+
+            // Keep the workers that did start, the deques are already sized
+            the_pool.workers = i;
+            stop_pool();
+            the_pool.started = true;
+            atomic_store(&thread_count, 1);
+            return false;
+        }
+    }
+
+    atomic_store(&thread_count, workers + 1);
+    return true;
+}
+
+// ===================== FUNCTIONS =====================
+
+bool set_thread_count(size_t threads) {
+
+    pthread_mutex_lock(&the_pool.submit);
+    stop_pool();
+    bool ok = start_pool(threads);
+    pthread_mutex_unlock(&the_pool.submit);
+
+    return ok;
+}
+
+size_t get_thread_count(void) {
+
+    // Running pool: never touch submit, tasks call this from inside a job
+    size_t threads = atomic_load(&thread_count);
+    if (threads != 0) return threads;
+
+    pthread_mutex_lock(&the_pool.submit);
+    if (!the_pool.started) start_pool(0);
+    threads = the_pool.workers + 1;
+    pthread_mutex_unlock(&the_pool.submit);
+
+    return threads;
+}
+
+void set_parallel_threshold(size_t threshold) {
+    atomic_store(&parallel_threshold, threshold);
+}
+
+size_t get_parallel_threshold(void) {
+    return atomic_load(&parallel_threshold);
+}
+
+size_t get_worker_index(void) {
+    return worker_index < 0 ? 0 : (size_t)worker_index;
+}
+
+void parallel_for(size_t begin, size_t end, size_t grain, task_fn fn, void* ctx) {
+
+    if (fn == NULL || end <= begin) return;
+    if (grain == 0) grain = 1;
+
+    // Nested or tiny: just run it here
+    if (worker_index >= 0 || end - begin <= grain) {
+
+        fn(ctx, begin, end);
+        return;
+    }
+
+    // Somebody else owns the pool, don't wait on them
+    if (pthread_mutex_trylock(&the_pool.submit) != 0) {
+
+        fn(ctx, begin, end);
+        return;
+    }
+
+    if (!the_pool.started) start_pool(0);
+    if (the_pool.workers == 0) {
+
+        pthread_mutex_unlock(&the_pool.submit);
+        fn(ctx, begin, end);
+        return;
+    }
+
+    size_t self = the_pool.workers;
+    unsigned seed = 0x9e3779b9u;
+    job j = { .fn = fn, .ctx = ctx, .grain = grain };
+    atomic_init(&j.remaining, end - begin);
+
+    worker_index = (long)self;
+    deque_push(&the_pool.deques[self], (task){ &j, begin, end });
+
+    // Announce the job to everybody
+    pthread_mutex_lock(&the_pool.lock);
+    the_pool.epoch++;
+    pthread_cond_broadcast(&the_pool.wake);
+    pthread_mutex_unlock(&the_pool.lock);
+
+    // Help out until every index is accounted for
+    while (atomic_load_explicit(&j.remaining, memory_order_acquire) != 0) {
+
+        task t;
+        if (find_work(self, &t, &seed)) run_task(self, t);
+        else sched_yield();
+    }
+
+    worker_index = -1;
+    pthread_mutex_unlock(&the_pool.submit);
+}
+
+void free_thread_pool(void) {
+
+    pthread_mutex_lock(&the_pool.submit);
+    stop_pool();
+    pthread_mutex_unlock(&the_pool.submit);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file thread_pool.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Persistent pthread worker pool with work-stealing deques, used to
+ * split large vector and matrix operations across cores. There is one pool
+ * per process; it starts on first use and lives until free_thread_pool().
+ * @version 0.1
+ * @date 2022-07-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Default work size (vector components, or multiply-adds for GEMM)
+// below which operations stay on the calling thread
+#define POOL_DEFAULT_THRESHOLD ((size_t)1 << 18)
+
+/**
+ * @brief Body of a parallel loop: processes indices [begin, end).
+ *
+ * @param ctx User context handed to parallel_for.
+ */
+typedef void (*task_fn)(void* ctx, size_t begin, size_t end);
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Sets how many threads (including the caller) parallel work uses,
+ * restarting the pool. 0 picks the number of online CPUs, 1 keeps
+ * everything on the calling thread. Waits for any running job to finish.
+ *
+ * @param threads Total thread count.
+ * @return false if the workers could not be started (the pool is then
+ * left single-threaded).
+ */
+bool set_thread_count(size_t threads);
+
+/**
+ * @brief Total threads parallel work is split across, starting the pool
+ * with one thread per online CPU if it is not running yet. Never waits on
+ * a running job, so tasks may call it (and anything built on it).
+ *
+ * @return size_t
+ */
+size_t get_thread_count(void);
+
+/**
+ * @brief Sets the work size below which operations stay single-threaded.
+ *
+ * @param threshold Vector components (level-1) or multiply-adds (GEMM).
+ */
+void set_parallel_threshold(size_t threshold);
+
+/**
+ * @brief Current single-threaded cutoff, POOL_DEFAULT_THRESHOLD by default.
+ *
+ * @return size_t
+ */
+size_t get_parallel_threshold(void);
+
+/**
+ * @brief Index of the calling thread inside the running job, in
+ * [0, get_thread_count()). Lets tasks pick per-thread scratch buffers.
+ * Threads outside the pool get 0.
+ *
+ * @return size_t
+ */
+size_t get_worker_index(void);
+
+/**
+ * @brief Runs fn over [begin, end) split into chunks of at least grain
+ * indices, on the pool and the calling thread, and returns when every
+ * chunk is done. Idle workers steal half of a busy worker's remaining
+ * range, so uneven chunks balance themselves.
+ *
+ * Nested calls (from inside a task) and calls made while another thread
+ * owns the pool run fn(ctx, begin, end) inline instead.
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param grain Smallest chunk worth handing to another thread (>= 1).
+ * @param fn Loop body.
+ * @param ctx Passed to fn untouched.
+ */
+void parallel_for(size_t begin, size_t end, size_t grain, task_fn fn, void* ctx);
+
+/**
+ * @brief Stops and joins every worker. The pool restarts on next use.
+ */
+void free_thread_pool(void);
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * @file value_types.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Fixed-size vec2, vec3, vec4, mat3 and mat4 value types for graphics
+ * code. They are plain structs passed and returned by value, so they live
+ * on the stack (or inline in other structs and arrays) and never touch the
+ * heap. Every operation is static inline and header-only.
+ *
+ * mat3 and mat4 are row-major like mat_float: m[row][col], and transform
+ * column vectors (v' = M * v). Upload it to OpenGL with transpose = GL_TRUE.
+ * @version 0.1
+ * @date 2022-07-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VALUE_TYPES_H
+#define VALUE_TYPES_H
+
+#include <math.h>
+
+/**
+ * @brief The value types. vec4 and mat4 are 16-byte aligned so they map
+ * onto SSE registers and GPU uniform layouts.
+ */
+typedef struct vec2 { float x, y; } vec2;
+typedef struct vec3 { float x, y, z; } vec3;
+typedef struct vec4 { _Alignas(16) float x; float y, z, w; } vec4;
+typedef struct mat3 { float m[3][3]; } mat3;
+typedef struct mat4 { _Alignas(16) float m[4][4]; } mat4;
+
+// ===================== VEC2 =====================
+
+static inline vec2 add_vec2(vec2 a, vec2 b) { return (vec2){ a.x + b.x, a.y + b.y }; }
+static inline vec2 sub_vec2(vec2 a, vec2 b) { return (vec2){ a.x - b.x, a.y - b.y }; }
+static inline vec2 mul_vec2(vec2 a, vec2 b) { return (vec2){ a.x * b.x, a.y * b.y }; }
+static inline vec2 scale_vec2(vec2 a, float s) { return (vec2){ a.x * s, a.y * s }; }
+static inline float dot_vec2(vec2 a, vec2 b) { return a.x * b.x + a.y * b.y; }
+static inline float length_vec2(vec2 a) { return sqrtf(dot_vec2(a, a)); }
+
+// Unit vector in the direction of a, a itself if it has length 0
+static inline vec2 normalize_vec2(vec2 a) {
+
+    float len = length_vec2(a);
+    return len > 0.0f ? scale_vec2(a, 1.0f / len) : a;
+}
+
+// ===================== VEC3 =====================
+
+static inline vec3 add_vec3(vec3 a, vec3 b) { return (vec3){ a.x + b.x, a.y + b.y, a.z + b.z }; }
+static inline vec3 sub_vec3(vec3 a, vec3 b) { return (vec3){ a.x - b.x, a.y - b.y, a.z - b.z }; }
+static inline vec3 mul_vec3(vec3 a, vec3 b) { return (vec3){ a.x * b.x, a.y * b.y, a.z * b.z }; }
+static inline vec3 scale_vec3(vec3 a, float s) { return (vec3){ a.x * s, a.y * s, a.z * s }; }
+static inline float dot_vec3(vec3 a, vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static inline float length_vec3(vec3 a) { return sqrtf(dot_vec3(a, a)); }
+
+static inline vec3 cross_vec3(vec3 a, vec3 b) {
+    return (vec3){ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static inline vec3 normalize_vec3(vec3 a) {
+
+    float len = length_vec3(a);
+    return len > 0.0f ? scale_vec3(a, 1.0f / len) : a;
+}
+
+// ===================== VEC4 =====================
+
+static inline vec4 add_vec4(vec4 a, vec4 b) { return (vec4){ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+static inline vec4 sub_vec4(vec4 a, vec4 b) { return (vec4){ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+static inline vec4 mul_vec4(vec4 a, vec4 b) { return (vec4){ a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+static inline vec4 scale_vec4(vec4 a, float s) { return (vec4){ a.x * s, a.y * s, a.z * s, a.w * s }; }
+static inline float dot_vec4(vec4 a, vec4 b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+static inline float length_vec4(vec4 a) { return sqrtf(dot_vec4(a, a)); }
+
+static inline vec4 normalize_vec4(vec4 a) {
+
+    float len = length_vec4(a);
+    return len > 0.0f ? scale_vec4(a, 1.0f / len) : a;
+}
+
+// ===================== MAT3 =====================
+
+static inline mat3 identity_mat3(void) {
+    return (mat3){ { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } } };
+}
+
+// a * b, i.e. apply b first, then a
+static inline mat3 mul_mat3(mat3 a, mat3 b) {
+
+    mat3 c;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            c.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+
+    return c;
+}
+
+static inline vec3 mul_mat3_vec3(mat3 a, vec3 v) {
+
+    float r[3];
+    for (int i = 0; i < 3; i++)
+        r[i] = a.m[i][0] * v.x + a.m[i][1] * v.y + a.m[i][2] * v.z;
+
+    return (vec3){ r[0], r[1], r[2] };
+}
+
+// ===================== MAT4 =====================
+
+static inline mat4 identity_mat4(void) {
+    return (mat4){ { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+}
+
+static inline mat4 transpose_mat4(mat4 a) {
+
+    mat4 t;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) t.m[i][j] = a.m[j][i];
+
+    return t;
+}
+
+// a * b, i.e. apply b first, then a
+static inline mat4 mul_mat4(mat4 a, mat4 b) {
+
+    mat4 c;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            c.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j]
+                      + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+
+    return c;
+}
+
+static inline vec4 mul_mat4_vec4(mat4 a, vec4 v) {
+
+    float r[4];
+    for (int i = 0; i < 4; i++)
+        r[i] = a.m[i][0] * v.x + a.m[i][1] * v.y + a.m[i][2] * v.z + a.m[i][3] * v.w;
+
+    return (vec4){ r[0], r[1], r[2], r[3] };
+}
+
+// Transforms the point p (w = 1), dividing by the resulting w when it is not 1
+static inline vec3 transform_point_mat4(mat4 a, vec3 p) {
+
+    vec4 r = mul_mat4_vec4(a, (vec4){ p.x, p.y, p.z, 1.0f });
+    if (r.w != 1.0f && r.w != 0.0f) return (vec3){ r.x / r.w, r.y / r.w, r.z / r.w };
+
+    return (vec3){ r.x, r.y, r.z };
+}
+
+static inline mat4 translate_mat4(vec3 t) {
+
+    mat4 a = identity_mat4();
+    a.m[0][3] = t.x;
+    a.m[1][3] = t.y;
+    a.m[2][3] = t.z;
+
+    return a;
+}
+
+static inline mat4 scale_mat4(vec3 s) {
+
+    mat4 a = identity_mat4();
+    a.m[0][0] = s.x;
+    a.m[1][1] = s.y;
+    a.m[2][2] = s.z;
+
+    return a;
+}
+
+#endif
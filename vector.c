@@ -0,0 +1,790 @@
+/**
+ * Vector for general purposes
+ * Modified from my arl project.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector.h"
+#include "vector_search.h"
+#include "telemetry.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size classes 1..VEC_POOL_CLASSES hold 16 << (class - 1) bytes
+#define VEC_POOL_CLASSES 5
+// Class 0 holds vector structs, every vec_* struct has vec_void's size
+#define VEC_POOL_STRUCT 0
+
+// ===================== POOL =====================
+
+typedef struct pool_block {
+    struct pool_block* next;
+} pool_block;
+
+typedef struct pool_list {
+
+    pool_block* head;
+    size_t count;
+} pool_list;
+
+static _Thread_local pool_list pool[VEC_POOL_CLASSES + 1];
+static _Thread_local bool pool_registered = false;
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pool_key;
+
+static void pool_thread_exit(void* unused) {
+
+    (void)unused;
+    trim_vec_pool();
+}
+
+static void pool_make_key(void) {
+    pthread_key_create(&pool_key, pool_thread_exit);
+}
+
+static size_t class_bytes(unsigned char cls) {
+    return cls == VEC_POOL_STRUCT ? sizeof(vec_void) : (size_t)16 << (cls - 1);
+}
+
+/**
+ * @brief Smallest size class holding bytes.
+ *
+ * @param bytes Size of the array (> 0).
+ * @return unsigned char | 0 if bytes > VEC_POOL_MAX_BYTES.
+ */
+static unsigned char size_class(size_t bytes) {
+
+    if (bytes > VEC_POOL_MAX_BYTES) return 0;
+
+    unsigned char cls = 1;
+    while (class_bytes(cls) < bytes) cls++;
+
+    return cls;
+}
+
+static void* pool_get(unsigned char cls) {
+
+    pool_list* list = &pool[cls];
+    if (list->head == NULL) {
+
+        void* block = malloc(class_bytes(cls));
+        if (block != NULL) TELEMETRY_ALLOC(class_bytes(cls));
+        return block;
+    }
+
+    pool_block* block = list->head;
+    list->head = block->next;
+    list->count--;
+
+    return block;
+}
+
+static void pool_put(unsigned char cls, void* ptr) {
+
+    pool_list* list = &pool[cls];
+    if (ptr == NULL) return;
+    if (list->count >= VEC_POOL_DEPTH) {
+
+        free(ptr);
+        return;
+    }
+
+    // First block cached by this thread: trim on thread exit
+    if (!pool_registered) {
+
+        pthread_once(&pool_once, pool_make_key);
+        pool_registered = pthread_setspecific(pool_key, pool) == 0;
+    }
+
+    pool_block* block = (pool_block*)ptr;
+    block->next = list->head;
+    list->head = block;
+    list->count++;
+}
+
+// ===================== HELPERS =====================
+
+// Takes components [from, v->size) out of the index before they are dropped
+static void unindex_tail(vec_void* v, size_t from, size_t data_size) {
+
+    if (v->index == NULL) return;
+
+    for (size_t i = from; i < v->size; i++)
+        hash_index_remove(v->index, (const char*)v->array + i * data_size);
+}
+
+// Gives back the component array of a heap vector
+static void release_array(vec_void* v) {
+
+    if (v->arena != NULL || v->pool_class == VEC_POOL_MAPPED) return;
+
+    if (v->pool_class != 0) pool_put(v->pool_class, v->array);
+    else free(v->array);
+}
+
+/**
+ * @brief Moves the components of v into a buffer of exactly capacity
+ * components using realloc (or arena_realloc), so the data is only
+ * copied when the allocator cannot grow the block in place.
+ *
+ * @param v Vector to be resized.
+ * @param capacity New number of components.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+static bool resize_vec(vec_void* v, size_t capacity, size_t data_size) {
+
+    if (capacity == v->capacity) return true;
+
+    // Mapped arrays only move through their vec_file
+    if (v->pool_class == VEC_POOL_MAPPED) return false;
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_RESIZE);
+
+    // Nothing left to keep
+    if (capacity == 0) {
+
+        if (v->index != NULL) clear_hash_index(v->index);
+        release_array(v);
+        TELEMETRY_RESIZE(false);
+        v->stats.shrinks++;
+        v->array = NULL;
+        v->size = 0;
+        v->capacity = 0;
+        v->pool_class = 0;
+        return true;
+    }
+
+    // Guard capacity * data_size against overflow
+    if (capacity > SIZE_MAX / data_size) return false;
+
+    // Shrinking below size drops the tail, take it out of the index first
+    if (capacity < v->size) unindex_tail(v, capacity, data_size);
+
+    size_t bytes = capacity * data_size;
+    unsigned char cls = v->arena != NULL ? 0 : size_class(bytes);
+    void* array;
+
+    if (v->arena != NULL) array = arena_realloc(v->arena, v->array, v->capacity * data_size, bytes);
+    else if (cls != 0 && cls == v->pool_class) array = v->array;
+    else if (cls != 0 || v->pool_class != 0) {
+
+        // Into, out of or across pool classes: move by hand
+        array = cls != 0 ? pool_get(cls) : malloc(bytes);
+        if (array != NULL && cls == 0) TELEMETRY_ALLOC(bytes);
+        size_t keep = v->size < capacity ? v->size : capacity;
+
+        if (array != NULL && keep != 0) memcpy(array, v->array, keep * data_size);
+        if (array != NULL) release_array(v);
+    } else {
+
+        array = realloc(v->array, bytes);
+        if (array != NULL) TELEMETRY_ALLOC(bytes);
+    }
+
+    if (array == NULL) {
+
+        // Put the tail back, it is still there
+        for (size_t i = capacity; v->index != NULL && i < v->size; i++)
+            hash_index_insert(v->index, (const char*)v->array + i * data_size);
+        return false;
+    }
+
+    if (array != v->array) TELEMETRY_COPY((v->size < capacity ? v->size : capacity) * data_size);
+    TELEMETRY_RESIZE(capacity > v->capacity);
+
+    if (capacity > v->capacity) v->stats.grows++;
+    else v->stats.shrinks++;
+
+    v->array = array;
+    v->pool_class = cls;
+    v->capacity = capacity;
+    if (v->size > capacity) v->size = capacity;
+
+    return true;
+}
+
+/**
+ * @brief Grows v at most once so extra more components fit, geometrically
+ * unless the batch alone needs more than that.
+ *
+ * @return false if v is fixed_length and too small, or the resize failed.
+ */
+static bool make_room(vec_void* v, size_t extra, size_t data_size) {
+
+    if (extra > SIZE_MAX - v->size) return false;
+
+    size_t need = v->size + extra;
+    if (need <= v->capacity) return true;
+    if (v->fixed_length) return false;
+
+    return resize_vec(v, policy_grow(v->policy, v->capacity, need), data_size);
+}
+
+/**
+ * @brief Shrinks v after an erase if its growth policy says it has too
+ * much room, with a single resize. A failed shrink leaves v as it was.
+ */
+static void shrink_by_policy(vec_void* v, size_t data_size) {
+
+    if (v->fixed_length) return;
+
+    size_t capacity = policy_shrink(v->policy, v->size, v->capacity);
+    if (capacity < v->capacity) resize_vec(v, capacity, data_size);
+}
+
+/**
+ * @brief Adds count components to v's index, if it has one. All or
+ * nothing: the ones already added are taken back out on failure.
+ *
+ * @return bool
+ */
+static bool index_range(vec_void* v, const void* data, size_t count, size_t data_size) {
+
+    if (v->index == NULL) return true;
+
+    for (size_t i = 0; i < count; i++) {
+
+        if (hash_index_insert(v->index, (const char*)data + i * data_size)) continue;
+
+        while (i-- > 0) hash_index_remove(v->index, (const char*)data + i * data_size);
+        return false;
+    }
+
+    return true;
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Initialize a malloc'd instance of a vector. Cast to your
+ * desired vector like regular malloc(). All components start off
+ * as 0 in their respective formats, and capacity == size.
+ *
+ * @param init_size The starting number of components (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @param fixed_length Vector cannot dynamically change size;
+ * any operations that will alter its capacity will instead leave
+ * the vector completely unchanged.
+ * @return vec* | NULL
+ */
+void* init_vec(size_t init_size, size_t data_size, bool fixed_length) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_INIT);
+    if (data_size == 0) return NULL;
+
+    // Init vec struct
+    vec_void* v = (vec_void*)pool_get(VEC_POOL_STRUCT);
+    if (v == NULL) return NULL;
+
+    // Init the size, capacity, and fixed_length metadata
+    v->array = NULL;
+    v->size = init_size;
+    v->capacity = init_size;
+    v->fixed_length = fixed_length;
+    v->pool_class = 0;
+    v->arena = NULL;
+    v->index = NULL;
+    v->policy = VEC_DEFAULT_POLICY;
+    v->stats = (resize_stats){ 0, 0 };
+
+    if (init_size == 0) return v;
+
+    // Small arrays come out of the pool and are zeroed by hand,
+    // calloc zeroes the rest and checks the multiplication for us
+    unsigned char cls = init_size <= VEC_POOL_MAX_BYTES / data_size ? size_class(init_size * data_size) : 0;
+    v->array = cls != 0 ? pool_get(cls) : calloc(init_size, data_size);
+    if (v->array == NULL) {
+
+        pool_put(VEC_POOL_STRUCT, v);
+        return NULL;
+    }
+
+    if (cls == 0) TELEMETRY_ALLOC(init_size * data_size);
+
+    if (cls != 0) memset(v->array, 0, init_size * data_size);
+    v->pool_class = cls;
+
+    return v;
+}
+
+/**
+ * @brief Same as init_vec, but the vector struct and its components are
+ * allocated from a, with the components ARENA_ALIGNMENT-aligned. Growing
+ * it bumps the arena in place when it was the last allocation and copies
+ * otherwise. free_vec is a no-op for it: the memory goes back when a is
+ * rewound, reset or freed, which must not happen while it is in use.
+ *
+ * @param a Arena to allocate from.
+ * @param init_size The starting number of components (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @param fixed_length See init_vec.
+ * @return vec* | NULL
+ */
+void* init_vec_arena(arena* a, size_t init_size, size_t data_size, bool fixed_length) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_INIT);
+    if (a == NULL || data_size == 0) return NULL;
+
+    // Roll back the struct too if the components do not fit
+    arena_mark mark = arena_get_mark(a);
+
+    vec_void* v = (vec_void*)arena_alloc(a, sizeof(vec_void));
+    if (v == NULL) return NULL;
+
+    v->array = NULL;
+    v->size = init_size;
+    v->capacity = init_size;
+    v->fixed_length = fixed_length;
+    v->pool_class = 0;
+    v->arena = a;
+    v->index = NULL;
+    v->policy = VEC_DEFAULT_POLICY;
+    v->stats = (resize_stats){ 0, 0 };
+
+    if (init_size == 0) return v;
+
+    v->array = arena_calloc(a, init_size, data_size);
+    if (v->array == NULL) {
+
+        arena_rewind(a, mark);
+        return NULL;
+    }
+
+    return v;
+}
+
+/**
+ * @brief Appends a new component to the end of the vector, growing
+ * the capacity geometrically with realloc if the vector is full.
+ *
+ * @param v Vector to be appended to.
+ * @param data Data to be appended. DOES NOT CHECK TYPE.
+ * @param data_size Size of one component.
+ * @return true | false if v or data is NULL, or the vector could not grow.
+ */
+bool append_vec(void* v, const void* data, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_APPEND);
+    if (data == NULL || v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (!make_room(vv, 1, data_size)) return false;
+
+    // Index first, so a failed insert leaves both untouched
+    if (vv->index != NULL && !hash_index_insert(vv->index, data)) return false;
+
+    // Insert
+    memcpy((char*)vv->array + vv->size * data_size, data, data_size);
+    TELEMETRY_COPY(data_size);
+    vv->size++;
+
+    return true;
+}
+
+/**
+ * @brief Replace the value at a given vector position.
+ *
+ * @param v Vector to have component replaced.
+ * @param index Index at which to replace, must be < v->size.
+ * @param data Data to replace current data. Is not type-checked.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool replace_vec(void* v, size_t index, const void* data, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_REPLACE);
+    if (data == NULL || v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (index >= vv->size) return false;
+
+    char* slot = (char*)vv->array + index * data_size;
+    if (vv->index != NULL) {
+
+        if (!hash_index_insert(vv->index, data)) return false;
+        hash_index_remove(vv->index, slot);
+    }
+
+    // Insert
+    memcpy(slot, data, data_size);
+    TELEMETRY_COPY(data_size);
+    return true;
+}
+
+/**
+ * @brief Appends count components at once: one capacity check and one
+ * memcpy for the whole batch.
+ *
+ * @param v Vector to be appended to.
+ * @param data count components back to back, not inside v itself.
+ * @param count Number of components (may be 0).
+ * @param data_size Size of one component.
+ * @return false if v is NULL, data is NULL with count > 0, or the vector
+ * could not grow (v is left unchanged).
+ */
+bool append_n_vec(void* v, const void* data, size_t count, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_INSERT);
+    if (v == NULL || (data == NULL && count != 0)) return false;
+    if (count == 0) return true;
+
+    vec_void* vv = (vec_void*)v;
+    if (!make_room(vv, count, data_size)) return false;
+    if (!index_range(vv, data, count, data_size)) return false;
+
+    memcpy((char*)vv->array + vv->size * data_size, data, count * data_size);
+    TELEMETRY_COPY(count * data_size);
+    vv->size += count;
+
+    return true;
+}
+
+/**
+ * @brief Inserts count components before index, shifting the tail up
+ * with a single memmove.
+ *
+ * @param v Vector to insert into.
+ * @param index Position of the first new component, <= v->size.
+ * @param data count components back to back, not inside v itself.
+ * @param count Number of components (may be 0).
+ * @param data_size Size of one component.
+ * @return false if index > v->size or the vector could not grow (v is
+ * left unchanged).
+ */
+bool insert_range_vec(void* v, size_t index, const void* data, size_t count, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_INSERT);
+    if (v == NULL || (data == NULL && count != 0)) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (index > vv->size) return false;
+    if (count == 0) return true;
+
+    if (!make_room(vv, count, data_size)) return false;
+    if (!index_range(vv, data, count, data_size)) return false;
+
+    char* at = (char*)vv->array + index * data_size;
+    memmove(at + count * data_size, at, (vv->size - index) * data_size);
+    memcpy(at, data, count * data_size);
+    TELEMETRY_COPY((vv->size - index + count) * data_size);
+    vv->size += count;
+
+    return true;
+}
+
+/**
+ * @brief Removes components [index, index + count), shifting the tail
+ * down with a single memmove. The capacity is kept unless v's growth
+ * policy says to shrink (see set_growth_policy_vec).
+ *
+ * @param v Vector to erase from.
+ * @param index First component to go.
+ * @param count Number of components, index + count <= v->size.
+ * @param data_size Size of one component.
+ * @return false if v == NULL or the range does not fit.
+ */
+bool erase_range_vec(void* v, size_t index, size_t count, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_ERASE);
+    if (v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (index > vv->size || count > vv->size - index) return false;
+    if (count == 0) return true;
+
+    char* at = (char*)vv->array + index * data_size;
+    for (size_t i = 0; vv->index != NULL && i < count; i++) hash_index_remove(vv->index, at + i * data_size);
+
+    memmove(at, at + count * data_size, (vv->size - index - count) * data_size);
+    TELEMETRY_COPY((vv->size - index - count) * data_size);
+    vv->size -= count;
+    shrink_by_policy(vv, data_size);
+
+    return true;
+}
+
+/**
+ * @brief Removes every component predicate is true for, keeping the order
+ * of the rest. Runs of kept components are moved with one memmove each,
+ * so the whole pass is O(v->size). Shrinks like erase_range_vec.
+ *
+ * @param v Vector to compact.
+ * @param predicate Called once per component, in order.
+ * @param context Handed to predicate untouched.
+ * @param data_size Size of one component.
+ * @return size_t Number of components removed (0 if v or predicate is NULL).
+ */
+size_t erase_if_vec(void* v, bool (*predicate)(const void* component, void* context), void* context,
+                    size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_ERASE_IF);
+    if (v == NULL || predicate == NULL) return 0;
+
+    vec_void* vv = (vec_void*)v;
+    char* array = (char*)vv->array;
+    size_t kept = 0, run = 0;
+
+    for (size_t i = 0; i < vv->size; i++) {
+
+        char* component = array + i * data_size;
+        if (!predicate(component, context)) continue;
+
+        // Close the run of kept components before i
+        if (i > run) memmove(array + kept * data_size, array + run * data_size, (i - run) * data_size);
+        if (i > run) TELEMETRY_COPY((i - run) * data_size);
+        kept += i - run;
+        run = i + 1;
+
+        if (vv->index != NULL) hash_index_remove(vv->index, component);
+    }
+
+    if (vv->size > run) memmove(array + kept * data_size, array + run * data_size, (vv->size - run) * data_size);
+    if (vv->size > run) TELEMETRY_COPY((vv->size - run) * data_size);
+    kept += vv->size - run;
+
+    size_t removed = vv->size - kept;
+    vv->size = kept;
+    if (removed != 0) shrink_by_policy(vv, data_size);
+
+    return removed;
+}
+
+/**
+ * @brief Checks if a vector contains a value. Can take a user supplied
+ * function. If the function is left NULL, compares component bytes.
+ *
+ * @param v Vector to look at. Returns false if v == NULL.
+ * @param data Data to look for. Returns false if data == NULL.
+ * @param data_size Size of one component.
+ * @param comparator Either NULL for default function or custom function
+ * such that: 1 if arg1 > arg2, -1 if arg1 < arg2, and 0 if arg1 == arg2.
+ * @return bool
+ */
+bool contains_vec(const void* v, const void* data, size_t data_size,
+                  char (*comparator)(const void* arg1, const void* arg2)) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_CONTAINS);
+    if (data == NULL || v == NULL) return false;
+
+    const vec_void* vv = (const vec_void*)v;
+    const char* array = (const char*)vv->array;
+
+    // Byte-wise lookups go through the index when there is one
+    if (comparator == NULL && vv->index != NULL && vv->index->key_size == data_size)
+        return hash_index_count(vv->index, data) != 0;
+
+    // Byte-wise scans go through the SIMD search kernels
+    if (comparator == NULL) return find_bytes(array, vv->size, data, data_size) != vv->size;
+
+    for (size_t i = 0; i < vv->size; i++)
+        if (comparator(data, array + i * data_size) == 0) return true;
+
+    return false;
+}
+
+/**
+ * @brief Get the deep-copy of the component at index position.
+ * REMEMBER TO FREE!!! REMEMBER TO CAST WHEN RECEIVING!!!
+ *
+ * @param v Vector. If NULL returns NULL.
+ * @param index Component to be gotten. If index >= v->size, returns NULL.
+ * @param data_size Size of one component.
+ * @return void* (Cast to type) | NULL
+ */
+void* get_deep_vec(const void* v, size_t index, size_t data_size) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_GET_DEEP);
+    if (v == NULL) return NULL;
+
+    const vec_void* vv = (const vec_void*)v;
+    if (index >= vv->size) return NULL;
+
+    void* data_cpy = malloc(data_size);
+    if (data_cpy == NULL) return NULL;
+
+    TELEMETRY_ALLOC(data_size);
+    TELEMETRY_COPY(data_size);
+    return memcpy(data_cpy, (const char*)vv->array + index * data_size, data_size);
+}
+
+/**
+ * @brief Makes sure the vector can hold at least capacity components
+ * without reallocating. Never shrinks. New components are not counted
+ * in v->size until appended.
+ *
+ * @param v Vector to reserve space in.
+ * @param capacity Minimum number of components.
+ * @param data_size Size of one component.
+ * @return true | false if v == NULL, the vector is fixed_length and
+ * capacity > v->capacity, or realloc failed (v is left unchanged).
+ */
+bool reserve_vec(void* v, size_t capacity, size_t data_size) {
+
+    if (v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (capacity <= vv->capacity) return true;
+    if (vv->fixed_length) return false;
+
+    return resize_vec(vv, capacity, data_size);
+}
+
+/**
+ * @brief Releases unused capacity so that v->capacity == v->size.
+ *
+ * @param v Vector to shrink.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool shrink_to_fit_vec(void* v, size_t data_size) {
+
+    if (v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (vv->fixed_length) return vv->size == vv->capacity;
+
+    return resize_vec(vv, vv->size, data_size);
+}
+
+/**
+ * @brief Grows the capacity of the vector by one step of its growth
+ * policy if v->fixed_length == false. Components are kept in place.
+ *
+ * @param v Vector to be upsized.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool upsize_vec(void* v, size_t data_size) {
+
+    if (v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (vv->fixed_length) return false;
+
+    return resize_vec(vv, policy_grow(vv->policy, vv->capacity, 0), data_size);
+}
+
+/**
+ * @brief Halves the capacity of the vector if v->fixed_length == false,
+ * dropping any components that no longer fit.
+ *
+ * @param v Vector to be downsized.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool downsize_vec(void* v, size_t data_size) {
+
+    if (v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    if (vv->fixed_length) return false;
+
+    return resize_vec(vv, vv->capacity / 2, data_size);
+}
+
+/**
+ * @brief Frees the given vector and all its components. Arena-backed
+ * vectors are left to their arena, mapped ones to close_vec_file.
+ *
+ * @param v Vector to be freed
+ */
+void free_vec(void* v) {
+
+    TELEMETRY_SCOPE(TELEMETRY_VEC_FREE);
+    if (v == NULL) return;
+
+    // The index is on the heap even for arena-backed and mapped vectors
+    drop_index_vec(v);
+    if (((vec_void*)v)->arena != NULL || ((vec_void*)v)->pool_class == VEC_POOL_MAPPED) return;
+
+    // Free the component array (free(NULL) is a no-op)
+    release_array((vec_void*)v);
+
+    // Finally, hand the v pointer back to the pool
+    pool_put(VEC_POOL_STRUCT, v);
+}
+
+/**
+ * @brief Replaces the vector's growth policy, VEC_DEFAULT_POLICY to begin
+ * with. The new policy takes effect on the next grow or erase.
+ *
+ * @param v Vector.
+ * @param policy New policy, see growth_policy.h.
+ * @return false if v == NULL or policy is not valid (v is left unchanged).
+ */
+bool set_growth_policy_vec(void* v, growth_policy policy) {
+
+    if (v == NULL || !growth_policy_valid(policy)) return false;
+
+    ((vec_void*)v)->policy = policy;
+    return true;
+}
+
+/**
+ * @brief Attaches a hash index of the components to the vector (or
+ * rebuilds it), so byte-wise contains() is O(1). append, replace and
+ * anything that truncates the vector keep it up to date; writes straight
+ * into v->array do not, rebuild it after those. vector_math outputs drop
+ * their index.
+ *
+ * @param v Vector to index.
+ * @param data_size Size of one component.
+ * @return false if v == NULL or allocation failed (v keeps no index).
+ */
+bool build_index_vec(void* v, size_t data_size) {
+
+    if (v == NULL) return false;
+
+    vec_void* vv = (vec_void*)v;
+    drop_index_vec(vv);
+
+    hash_index* h = init_hash_index(data_size, vv->size);
+    if (h == NULL) return false;
+
+    for (size_t i = 0; i < vv->size; i++) {
+
+        if (!hash_index_insert(h, (const char*)vv->array + i * data_size)) {
+
+            free_hash_index(h);
+            return false;
+        }
+    }
+
+    vv->index = h;
+    return true;
+}
+
+/**
+ * @brief Frees the vector's index, if any.
+ *
+ * @param v Vector.
+ */
+void drop_index_vec(void* v) {
+
+    if (v == NULL) return;
+
+    free_hash_index(((vec_void*)v)->index);
+    ((vec_void*)v)->index = NULL;
+}
+
+/**
+ * @brief Frees every block the calling thread's small-buffer pool is
+ * caching. Threads trim their own pool when they exit.
+ */
+void trim_vec_pool(void) {
+
+    for (unsigned char cls = 0; cls <= VEC_POOL_CLASSES; cls++) {
+
+        while (pool[cls].head != NULL) {
+
+            pool_block* next = pool[cls].head->next;
+            free(pool[cls].head);
+            pool[cls].head = next;
+        }
+
+        pool[cls].count = 0;
+    }
+}
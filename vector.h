@@ -14,30 +14,55 @@
 #define VECTOR_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
-
-#define metadata size_t size; bool fixed_length;
+#include "arena.h"
+#include "hash_index.h"
+#include "growth_policy.h"
+#include "telemetry.h"
 
 /**
- * @brief Appends a new component to the end of the vector.
- * Upsizes by 2N where N = # of components if double_size == true; 
- * sets v NULL if no v. Sets v unchanged if v->fixed_length == true,
- * or type == void.
- *
- * @param vector Vector to be appended to.
- * @param data Data to be appended.
- * @param type Data type (char|int_32_t|int_64_t|float|double|void)
- * @param double_size If true, upsize makes vector twice as big with padded 0s.
+ * @brief Shared bookkeeping for every vector struct:
+ * - size_t size: Number of components in use.
+ * - size_t capacity: Number of components allocated; size <= capacity.
+ * - bool fixed_length: Whether the vector can change in size.
+ * - unsigned char pool_class: Size class of a pooled array (see below),
+ *   VEC_POOL_MAPPED for a file mapping (see vector_mmap.h), 0 otherwise.
+ * - arena* arena: Arena the vector lives in, NULL if it is on the heap.
+ * - hash_index* index: Optional lookup index for contains (see build_index_vec).
+ * - growth_policy policy: When the vector grows and shrinks on its own
+ *   (see set_growth_policy_vec).
+ * - resize_stats stats: How many times its capacity changed so far.
  */
-#define append(vector, type, data, double_size) ({ \
-    if (vector == NULL) \
-    })
+#define metadata size_t size; size_t capacity; bool fixed_length; unsigned char pool_class; arena* arena; \
+    hash_index* index; growth_policy policy; resize_stats stats
+
+// Default growth policy: capacity is multiplied by VEC_GROWTH_FACTOR when
+// full, never dropping below VEC_MIN_CAPACITY components, and vectors only
+// shrink when asked to (shrink_to_fit, downsize).
+#define VEC_GROWTH_FACTOR 2
+#define VEC_MIN_CAPACITY 8
+#define VEC_DEFAULT_POLICY ((growth_policy){ VEC_GROWTH_FACTOR * 100, 0, VEC_MIN_CAPACITY })
+
+// Small-buffer pool: vector structs and component arrays of up to
+// VEC_POOL_MAX_BYTES are recycled through per-thread free lists, one per
+// power-of-2 size class from 16 bytes up, each caching at most
+// VEC_POOL_DEPTH blocks. Pooled blocks are plain malloc blocks, so free()
+// on them is still safe; they just skip the pool.
+#define VEC_POOL_MAX_BYTES 256
+#define VEC_POOL_DEPTH 256
+// pool_class of a vector whose array is owned by a vec_file mapping:
+// free_vec leaves it alone, close_vec_file releases it
+#define VEC_POOL_MAPPED 0xFF
 
 /**
  * @brief The vector structs containing the following:
  * - type* array: components of the vector, access with v->array[index].
- * - size_t size: Size of array in bytes
- * - bool fixed_length: whether the vector can change in size. Default true.
+ * - metadata: size, capacity, fixed_length, pool_class, arena, index, policy
+ *   and stats (see above).
+ *
+ * All vector structs share the same layout, so the *_vec functions below
+ * take any of them as a void* along with the size of one component.
  *
  * types: vec_char, vec_int_32, vec_int_64, vec_float, vec_double, and vec_void
  */
@@ -77,19 +102,383 @@ typedef struct vector_void {
     metadata;
 } vec_void;
 
+// ===================== MACROS =====================
+
+/**
+ * @brief Component types, for code that has to record which vector it was
+ * handed (e.g. on disk). vec_type_of(vector) picks it at compile time.
+ */
+typedef enum { VEC_CHAR, VEC_INT_32, VEC_INT_64, VEC_FLOAT, VEC_DOUBLE } vec_type;
+
+#define vec_type_of(vector) _Generic((vector), \
+    vec_char*: VEC_CHAR, const vec_char*: VEC_CHAR, \
+    vec_int_32*: VEC_INT_32, const vec_int_32*: VEC_INT_32, \
+    vec_int_64*: VEC_INT_64, const vec_int_64*: VEC_INT_64, \
+    vec_float*: VEC_FLOAT, const vec_float*: VEC_FLOAT, \
+    vec_double*: VEC_DOUBLE, const vec_double*: VEC_DOUBLE)
+
+/**
+ * @brief Picks name##_vec_char, name##_vec_int_32, ... for the vector's
+ * type (see TYPED API below). VEC_SELECT_CONST also accepts const vectors.
+ * Anything else, vec_void included, is a compile error.
+ */
+#define VEC_SELECT(vector, name) _Generic((vector), \
+    vec_char*: name##_vec_char, \
+    vec_int_32*: name##_vec_int_32, \
+    vec_int_64*: name##_vec_int_64, \
+    vec_float*: name##_vec_float, \
+    vec_double*: name##_vec_double)
+
+#define VEC_SELECT_CONST(vector, name) _Generic((vector), \
+    vec_char*: name##_vec_char, const vec_char*: name##_vec_char, \
+    vec_int_32*: name##_vec_int_32, const vec_int_32*: name##_vec_int_32, \
+    vec_int_64*: name##_vec_int_64, const vec_int_64*: name##_vec_int_64, \
+    vec_float*: name##_vec_float, const vec_float*: name##_vec_float, \
+    vec_double*: name##_vec_double, const vec_double*: name##_vec_double)
+
+/**
+ * @brief Appends a new component to the end of the vector. When the
+ * vector is full its capacity grows by its growth policy in place, so
+ * N appends cost amortized O(N). Evaluates to false if vector == NULL,
+ * vector->fixed_length == true and it is full, or allocation failed.
+ *
+ * @param vector Vector to be appended to (not vec_void).
+ * @param data Data to be appended, converted to the component type.
+ */
+#define append(vector, data) VEC_SELECT((vector), append)((vector), (data))
+
+/**
+ * @brief Replaces the component at index. Evaluates to false if
+ * index >= vector->size.
+ */
+#define replace(vector, index, data) VEC_SELECT((vector), replace)((vector), (index), (data))
+
+/**
+ * @brief Checks if the vector contains data, comparing component bytes.
+ */
+#define contains(vector, data) VEC_SELECT_CONST((vector), contains)((vector), (data))
+
+/**
+ * @brief The component at index, by value. Not bounds-checked, index
+ * must be < vector->size.
+ */
+#define get(vector, index) VEC_SELECT_CONST((vector), get)((vector), (index))
+
+/**
+ * @brief Deep-copy of the component at index, already cast to the
+ * component pointer type. REMEMBER TO FREE!!!
+ */
+#define get_deep(vector, index) VEC_SELECT_CONST((vector), get_deep)((vector), (index))
+
+/**
+ * @brief Size of the components in use, in bytes.
+ */
+#define byte_size(vector) ((vector)->size * sizeof(*(vector)->array))
+
+/**
+ * @brief Capacity helpers, see reserve_vec, shrink_to_fit_vec, upsize_vec,
+ * downsize_vec and set_growth_policy_vec.
+ */
+#define reserve(vector, capacity) reserve_vec((vector), (capacity), sizeof(*(vector)->array))
+#define shrink_to_fit(vector) shrink_to_fit_vec((vector), sizeof(*(vector)->array))
+#define upsize(vector) upsize_vec((vector), sizeof(*(vector)->array))
+#define downsize(vector) downsize_vec((vector), sizeof(*(vector)->array))
+#define build_index(vector) build_index_vec((vector), sizeof(*(vector)->array))
+#define set_growth_policy(vector, policy) set_growth_policy_vec((vector), (policy))
+
+/**
+ * @brief Batch edits, see append_n_vec, insert_range_vec, erase_range_vec
+ * and erase_if_vec. data points at count components of the vector's type.
+ */
+#define append_n(vector, data, count) append_n_vec((vector), (data), (count), sizeof(*(vector)->array))
+#define insert_range(vector, index, data, count) \
+    insert_range_vec((vector), (index), (data), (count), sizeof(*(vector)->array))
+#define erase_range(vector, index, count) erase_range_vec((vector), (index), (count), sizeof(*(vector)->array))
+#define erase_if(vector, predicate, context) \
+    erase_if_vec((vector), (predicate), (context), sizeof(*(vector)->array))
+
 // ===================== FUNCTIONS =====================
 
 /**
- * @brief Initialize a malloc'd instance of a vector. NO_TYPE
- * gives you a void* array. Cast to your desired vector like
- * regular malloc(). All components start off as 0 in their
- * respective formats.
+ * @brief Initialize a malloc'd instance of a vector. Cast to your
+ * desired vector like regular malloc(). All components start off
+ * as 0 in their respective formats, and capacity == size. Small
+ * vectors come out of the calling thread's pool instead of malloc.
  *
- * @param init_size The starting size (sizeof(type) * size).
+ * @param init_size The starting number of components (may be 0).
+ * @param data_size Size of one component, sizeof(type).
  * @param fixed_length Vector cannot dynamically change size;
- * any operations that will alter its size will instead leave
+ * any operations that will alter its capacity will instead leave
  * the vector completely unchanged.
  * @return vec* | NULL
  */
-void* init_vec(size_t init_size, bool fixed_length);
-#endif
\ No newline at end of file
+void* init_vec(size_t init_size, size_t data_size, bool fixed_length);
+
+/**
+ * @brief Same as init_vec, but the vector struct and its components are
+ * allocated from a, with the components ARENA_ALIGNMENT-aligned. Growing
+ * it bumps the arena in place when it was the last allocation and copies
+ * otherwise. free_vec is a no-op for it: the memory goes back when a is
+ * rewound, reset or freed, which must not happen while it is in use.
+ *
+ * @param a Arena to allocate from.
+ * @param init_size The starting number of components (may be 0).
+ * @param data_size Size of one component, sizeof(type).
+ * @param fixed_length See init_vec.
+ * @return vec* | NULL
+ */
+void* init_vec_arena(arena* a, size_t init_size, size_t data_size, bool fixed_length);
+
+/**
+ * @brief Appends a new component to the end of the vector, growing
+ * the capacity geometrically with realloc if the vector is full.
+ *
+ * @param v Vector to be appended to.
+ * @param data Data to be appended. DOES NOT CHECK TYPE.
+ * @param data_size Size of one component.
+ * @return true | false if v or data is NULL, or the vector could not grow.
+ */
+bool append_vec(void* v, const void* data, size_t data_size);
+
+/**
+ * @brief Replace the value at a given vector position.
+ *
+ * @param v Vector to have component replaced.
+ * @param index Index at which to replace, must be < v->size.
+ * @param data Data to replace current data. Is not type-checked.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool replace_vec(void* v, size_t index, const void* data, size_t data_size);
+
+/**
+ * @brief Appends count components at once: one capacity check and one
+ * memcpy for the whole batch.
+ *
+ * @param v Vector to be appended to.
+ * @param data count components back to back, not inside v itself.
+ * @param count Number of components (may be 0).
+ * @param data_size Size of one component.
+ * @return false if v is NULL, data is NULL with count > 0, or the vector
+ * could not grow (v is left unchanged).
+ */
+bool append_n_vec(void* v, const void* data, size_t count, size_t data_size);
+
+/**
+ * @brief Inserts count components before index, shifting the tail up
+ * with a single memmove.
+ *
+ * @param v Vector to insert into.
+ * @param index Position of the first new component, <= v->size.
+ * @param data count components back to back, not inside v itself.
+ * @param count Number of components (may be 0).
+ * @param data_size Size of one component.
+ * @return false if index > v->size or the vector could not grow (v is
+ * left unchanged).
+ */
+bool insert_range_vec(void* v, size_t index, const void* data, size_t count, size_t data_size);
+
+/**
+ * @brief Removes components [index, index + count), shifting the tail
+ * down with a single memmove. The capacity is kept unless v's growth
+ * policy says to shrink (see set_growth_policy_vec).
+ *
+ * @param v Vector to erase from.
+ * @param index First component to go.
+ * @param count Number of components, index + count <= v->size.
+ * @param data_size Size of one component.
+ * @return false if v == NULL or the range does not fit.
+ */
+bool erase_range_vec(void* v, size_t index, size_t count, size_t data_size);
+
+/**
+ * @brief Removes every component predicate is true for, keeping the order
+ * of the rest, in one O(v->size) pass. Shrinks like erase_range_vec.
+ *
+ * @param v Vector to compact.
+ * @param predicate Called once per component, in order.
+ * @param context Handed to predicate untouched.
+ * @param data_size Size of one component.
+ * @return size_t Number of components removed (0 if v or predicate is NULL).
+ */
+size_t erase_if_vec(void* v, bool (*predicate)(const void* component, void* context), void* context,
+                    size_t data_size);
+
+/**
+ * @brief Checks if a vector contains a value. Can take a user supplied
+ * function. If the function is left NULL, compares component bytes,
+ * through the vector's index when it has one.
+ *
+ * @param v Vector to look at. Returns false if v == NULL.
+ * @param data Data to look for. Returns false if data == NULL.
+ * @param data_size Size of one component.
+ * @param comparator Either NULL for default function or custom function
+ * such that: 1 if arg1 > arg2, -1 if arg1 < arg2, and 0 if arg1 == arg2.
+ * @return bool
+ */
+bool contains_vec(const void* v, const void* data, size_t data_size,
+                  char (*comparator)(const void* arg1, const void* arg2));
+
+/**
+ * @brief Get the deep-copy of the component at index position.
+ * REMEMBER TO FREE!!! REMEMBER TO CAST WHEN RECEIVING!!!
+ *
+ * @param v Vector. If NULL returns NULL.
+ * @param index Component to be gotten. If index >= v->size, returns NULL.
+ * @param data_size Size of one component.
+ * @return void* (Cast to type) | NULL
+ */
+void* get_deep_vec(const void* v, size_t index, size_t data_size);
+
+/**
+ * @brief Makes sure the vector can hold at least capacity components
+ * without reallocating. Never shrinks. New components are not counted
+ * in v->size until appended.
+ *
+ * @param v Vector to reserve space in.
+ * @param capacity Minimum number of components.
+ * @param data_size Size of one component.
+ * @return true | false if v == NULL, the vector is fixed_length and
+ * capacity > v->capacity, or realloc failed (v is left unchanged).
+ */
+bool reserve_vec(void* v, size_t capacity, size_t data_size);
+
+/**
+ * @brief Releases unused capacity so that v->capacity == v->size.
+ *
+ * @param v Vector to shrink.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool shrink_to_fit_vec(void* v, size_t data_size);
+
+/**
+ * @brief Grows the capacity of the vector by one step of its growth
+ * policy if v->fixed_length == false. Components are kept in place.
+ *
+ * @param v Vector to be upsized.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool upsize_vec(void* v, size_t data_size);
+
+/**
+ * @brief Halves the capacity of the vector if v->fixed_length == false,
+ * dropping any components that no longer fit.
+ *
+ * @param v Vector to be downsized.
+ * @param data_size Size of one component.
+ * @return bool
+ */
+bool downsize_vec(void* v, size_t data_size);
+
+/**
+ * @brief Replaces the vector's growth policy, VEC_DEFAULT_POLICY to begin
+ * with. A shrink_divisor of 4 with the default factor shrinks back to half
+ * the capacity once a quarter of it is in use: queue-like workloads that
+ * hover around a size then stop reallocating. The new policy takes effect
+ * on the next grow or erase; v->stats keeps counting.
+ *
+ * @param v Vector.
+ * @param policy New policy, see growth_policy.h.
+ * @return false if v == NULL or policy is not valid (v is left unchanged).
+ */
+bool set_growth_policy_vec(void* v, growth_policy policy);
+
+/**
+ * @brief Attaches a hash index of the components to the vector (or
+ * rebuilds it), so byte-wise contains() is O(1). append, replace and
+ * anything that truncates the vector keep it up to date; writes straight
+ * into v->array do not, rebuild it after those. vector_math outputs drop
+ * their index.
+ *
+ * @param v Vector to index.
+ * @param data_size Size of one component.
+ * @return false if v == NULL or allocation failed (v keeps no index).
+ */
+bool build_index_vec(void* v, size_t data_size);
+
+/**
+ * @brief Frees the vector's index, if any.
+ *
+ * @param v Vector.
+ */
+void drop_index_vec(void* v);
+
+/**
+ * @brief Frees every block the calling thread's small-buffer pool is
+ * caching. Threads trim their own pool when they exit.
+ */
+void trim_vec_pool(void);
+
+/**
+ * @brief Frees the given vector and all its components. Arena-backed
+ * vectors are left to their arena, mapped ones to close_vec_file.
+ *
+ * @param v Vector to be freed
+ */
+void free_vec(void* v);
+
+// ===================== TYPED API =====================
+
+/**
+ * @brief Stamps out the typed front end of one vector struct. The size of
+ * a component is a compile-time constant and the common cases are inline:
+ *
+ * - init_vec_S(init_size): init_vec for this type.
+ * - append_vec_S(v, data): stores straight into v->array while there is
+ *   room, calls append_vec to grow (or to keep v->index current). Both
+ *   paths count as TELEMETRY_VEC_APPEND under CATORCE_TELEMETRY.
+ * - replace_vec_S(v, index, data): a bounds-checked store, or replace_vec
+ *   when v is indexed.
+ * - get_vec_S(v, index): v->array[index], unchecked.
+ * - contains_vec_S(v, data), get_deep_vec_S(v, index): contains_vec and
+ *   get_deep_vec with the component size filled in.
+ *
+ * Loops over these compile down to plain loads and stores.
+ */
+#define DEFINE_VEC_TYPE(T, S) \
+static inline vec_##S* init_vec_##S(size_t init_size) { \
+    return (vec_##S*)init_vec(init_size, sizeof(T), false); \
+} \
+\
+static inline bool append_vec_##S(vec_##S* v, T data) { \
+    if (v != NULL && v->size < v->capacity && v->index == NULL) { \
+        TELEMETRY_SCOPE(TELEMETRY_VEC_APPEND); \
+        TELEMETRY_COPY(sizeof(T)); \
+        v->array[v->size++] = data; \
+        return true; \
+    } \
+    return append_vec(v, &data, sizeof(T)); \
+} \
+\
+static inline bool replace_vec_##S(vec_##S* v, size_t index, T data) { \
+    if (v == NULL || index >= v->size) return false; \
+    if (v->index != NULL) return replace_vec(v, index, &data, sizeof(T)); \
+    TELEMETRY_SCOPE(TELEMETRY_VEC_REPLACE); \
+    TELEMETRY_COPY(sizeof(T)); \
+    v->array[index] = data; \
+    return true; \
+} \
+\
+static inline T get_vec_##S(const vec_##S* v, size_t index) { \
+    return v->array[index]; \
+} \
+\
+static inline bool contains_vec_##S(const vec_##S* v, T data) { \
+    return contains_vec(v, &data, sizeof(T), NULL); \
+} \
+\
+static inline T* get_deep_vec_##S(const vec_##S* v, size_t index) { \
+    return (T*)get_deep_vec(v, index, sizeof(T)); \
+}
+
+DEFINE_VEC_TYPE(char, char)
+DEFINE_VEC_TYPE(int32_t, int_32)
+DEFINE_VEC_TYPE(int64_t, int_64)
+DEFINE_VEC_TYPE(float, float)
+DEFINE_VEC_TYPE(double, double)
+
+#undef DEFINE_VEC_TYPE
+
+#endif
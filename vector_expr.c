@@ -0,0 +1,230 @@
+/**
+ * Fused evaluation of deferred vector expressions.
+ * A tree is flattened into a postfix program once, then the program runs
+ * over every EXPR_BLOCK components with a stack of block-sized buffers.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_expr.h"
+#include "vector_math.h"
+#include "thread_pool.h"
+#include <string.h>
+
+// Blocks handed to a pool thread at a time
+#define EXPR_GRAIN 64
+
+/**
+ * @brief An expression flattened into postfix order containing the following:
+ * - int count: Nodes in node.
+ * - const vec_expr* node[]: The nodes, operands before their operator.
+ * - size_t size: Length of every vector leaf.
+ */
+typedef struct expr_program {
+
+    int count;
+    const vec_expr* node[EXPR_MAX_NODES];
+    size_t size;
+} expr_program;
+
+// ===================== COMPILING =====================
+
+/**
+ * @brief Appends e to prog in postfix order, checking leaf sizes, node
+ * count and operand stack depth along the way.
+ *
+ * @param depth Operands pending before e, updated to after it.
+ * @param leaves Vector leaves seen so far.
+ * @return bool
+ */
+static bool compile(const vec_expr* e, expr_program* prog, int* depth, size_t* leaves) {
+
+    if (e == NULL || prog->count == EXPR_MAX_NODES) return false;
+
+    switch (e->op) {
+
+        case EXPR_OP_VEC: {
+
+            if (e->vec == NULL) return false;
+
+            size_t size = ((const vec_void*)e->vec)->size;
+            if (*leaves > 0 && size != prog->size) return false;
+
+            prog->size = size;
+            (*leaves)++;
+            break;
+        }
+
+        case EXPR_OP_CONST:
+            break;
+
+        case EXPR_OP_NEG:
+            if (!compile(e->left, prog, depth, leaves)) return false;
+            prog->node[prog->count++] = e;
+            return true;
+
+        case EXPR_OP_ADD:
+        case EXPR_OP_SUB:
+        case EXPR_OP_MUL:
+        case EXPR_OP_DIV:
+            if (!compile(e->left, prog, depth, leaves) || !compile(e->right, prog, depth, leaves)) return false;
+            if (prog->count == EXPR_MAX_NODES) return false;
+            prog->node[prog->count++] = e;
+            (*depth)--;
+            return true;
+
+        default:
+            return false;
+    }
+
+    // Leaves push an operand
+    if (*depth == EXPR_MAX_DEPTH) return false;
+    prog->node[prog->count++] = e;
+    (*depth)++;
+
+    return true;
+}
+
+static bool compile_expr(const vec_expr* e, expr_program* prog) {
+
+    int depth = 0;
+    size_t leaves = 0;
+    prog->count = 0;
+    prog->size = 0;
+
+    return compile(e, prog, &depth, &leaves) && leaves > 0;
+}
+
+// ===================== EVALUATION =====================
+
+/**
+ * @brief Stamps out the block evaluator and driver for one component type.
+ * S is the raw kernel suffix (f32, f64).
+ */
+#define DEFINE_EXPR_EVAL(T, S) \
+/* A pending operand: a block of components, or one constant for all of them */ \
+typedef struct operand_##S { const T* p; T c; } operand_##S; \
+\
+static void binary_##S(expr_op op, operand_##S a, operand_##S b, T* dst, size_t len) { \
+    if (a.p != NULL && b.p != NULL) { \
+        switch (op) { \
+            case EXPR_OP_ADD: add_##S(len, a.p, b.p, dst); return; \
+            case EXPR_OP_SUB: sub_##S(len, a.p, b.p, dst); return; \
+            case EXPR_OP_MUL: mul_##S(len, a.p, b.p, dst); return; \
+            default: for (size_t i = 0; i < len; i++) dst[i] = a.p[i] / b.p[i]; return; \
+        } \
+    } \
+    if (a.p == NULL) { \
+        switch (op) { \
+            case EXPR_OP_ADD: for (size_t i = 0; i < len; i++) dst[i] = a.c + b.p[i]; return; \
+            case EXPR_OP_SUB: for (size_t i = 0; i < len; i++) dst[i] = a.c - b.p[i]; return; \
+            case EXPR_OP_MUL: for (size_t i = 0; i < len; i++) dst[i] = a.c * b.p[i]; return; \
+            default: for (size_t i = 0; i < len; i++) dst[i] = a.c / b.p[i]; return; \
+        } \
+    } \
+    switch (op) { \
+        case EXPR_OP_ADD: for (size_t i = 0; i < len; i++) dst[i] = a.p[i] + b.c; return; \
+        case EXPR_OP_SUB: for (size_t i = 0; i < len; i++) dst[i] = a.p[i] - b.c; return; \
+        case EXPR_OP_MUL: for (size_t i = 0; i < len; i++) dst[i] = a.p[i] * b.c; return; \
+        default: for (size_t i = 0; i < len; i++) dst[i] = a.p[i] / b.c; return; \
+    } \
+} \
+\
+static T fold_##S(expr_op op, T a, T b) { \
+    switch (op) { \
+        case EXPR_OP_ADD: return a + b; \
+        case EXPR_OP_SUB: return a - b; \
+        case EXPR_OP_MUL: return a * b; \
+        default: return a / b; \
+    } \
+} \
+\
+/* Components [lo, lo + len) of prog into out. Only the last node writes */ \
+/* out, every other one writes the scratch block of its stack slot */ \
+static void eval_block_##S(const expr_program* prog, size_t lo, size_t len, T* out, T (*scratch)[EXPR_BLOCK]) { \
+    operand_##S st[EXPR_MAX_DEPTH]; \
+    int top = 0; \
+    for (int k = 0; k < prog->count; k++) { \
+        const vec_expr* e = prog->node[k]; \
+        bool root = k == prog->count - 1; \
+        switch (e->op) { \
+            case EXPR_OP_VEC: \
+                st[top++] = (operand_##S){ (const T*)((const vec_void*)e->vec)->array + lo, 0 }; \
+                break; \
+            case EXPR_OP_CONST: \
+                st[top++] = (operand_##S){ NULL, (T)e->scalar }; \
+                break; \
+            case EXPR_OP_NEG: \
+                if (st[top - 1].p == NULL) st[top - 1].c = -st[top - 1].c; \
+                else { \
+                    T* dst = root ? out : scratch[top - 1]; \
+                    for (size_t i = 0; i < len; i++) dst[i] = -st[top - 1].p[i]; \
+                    st[top - 1].p = dst; \
+                } \
+                break; \
+            default: { \
+                operand_##S b = st[--top]; \
+                operand_##S a = st[top - 1]; \
+                T* dst = root ? out : scratch[top - 1]; \
+                if (a.p == NULL && b.p == NULL) st[top - 1].c = fold_##S(e->op, a.c, b.c); \
+                else { \
+                    binary_##S(e->op, a, b, dst, len); \
+                    st[top - 1].p = dst; \
+                } \
+                break; \
+            } \
+        } \
+    } \
+    /* A lone leaf still has to land in out (the result is never a constant, */ \
+    /* every expression has a vector leaf) */ \
+    if (st[0].p != out) memmove(out, st[0].p, len * sizeof(T)); \
+} \
+\
+typedef struct expr_ctx_##S { const expr_program* prog; T* out; } expr_ctx_##S; \
+\
+static void expr_task_##S(void* arg, size_t begin, size_t end) { \
+    const expr_ctx_##S* ctx = (const expr_ctx_##S*)arg; \
+    T scratch[EXPR_MAX_DEPTH][EXPR_BLOCK]; \
+    size_t n = ctx->prog->size; \
+    for (size_t b = begin; b < end; b++) { \
+        size_t lo = b * EXPR_BLOCK; \
+        size_t len = n - lo < EXPR_BLOCK ? n - lo : EXPR_BLOCK; \
+        eval_block_##S(ctx->prog, lo, len, ctx->out + lo, scratch); \
+    } \
+} \
+\
+static bool eval_##S(void* out, const vec_expr* e) { \
+    if (out == NULL) return false; \
+    expr_program prog; \
+    if (!compile_expr(e, &prog)) return false; \
+    vec_void* vout = (vec_void*)out; \
+    if (!reserve_vec(vout, prog.size, sizeof(T))) return false; \
+    vout->size = prog.size; \
+    /* Written in place behind the index's back */ \
+    drop_index_vec(vout); \
+    expr_ctx_##S ctx = { &prog, (T*)vout->array }; \
+    size_t blocks = (prog.size + EXPR_BLOCK - 1) / EXPR_BLOCK; \
+    if (prog.size >= get_parallel_threshold() && blocks > EXPR_GRAIN && get_thread_count() > 1) \
+        parallel_for(0, blocks, EXPR_GRAIN, expr_task_##S, &ctx); \
+    else expr_task_##S(&ctx, 0, blocks); \
+    return true; \
+}
+
+DEFINE_EXPR_EVAL(float, f32)
+DEFINE_EXPR_EVAL(double, f64)
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Evaluates e in one fused pass and stores it in out, which is
+ * resized to the length of the vectors in e. out may also appear in e.
+ * Every leaf must be a vector of the same component type as out.
+ *
+ * @param out Result.
+ * @param e Expression.
+ * @return false if either is NULL, e has no vector leaf, its vectors
+ * differ in size, it has more than EXPR_MAX_NODES nodes or more than
+ * EXPR_MAX_DEPTH pending operands, or out could not be resized
+ * (out is then left unchanged).
+ */
+bool eval_expr_float(vec_float* out, const vec_expr* e) { return eval_f32(out, e); }
+bool eval_expr_double(vec_double* out, const vec_expr* e) { return eval_f64(out, e); }
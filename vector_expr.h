@@ -0,0 +1,114 @@
+/**
+ * @file vector_expr.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Deferred element-wise expressions over vec_float and vec_double.
+ * The EXPR_* macros build an expression tree out of compound literals (no
+ * heap, no computation), and eval_expr evaluates the whole tree at once:
+ * the vectors are walked in cache-sized blocks, every operator runs on
+ * the block while it is still in L1, and only the result is written back.
+ * A chain like a * x + b * y - z costs one pass over x, y, z and out
+ * instead of one full pass (and temporary vector) per operator.
+ *
+ *     eval_expr(out, EXPR_SUB(EXPR_ADD(EXPR_SCALE(a, EXPR_VEC(x)),
+ *                                      EXPR_SCALE(b, EXPR_VEC(y))),
+ *                             EXPR_VEC(z)));
+ *
+ * The tree lives until the end of the enclosing block, so it can also be
+ * built once and evaluated many times. Add/sub/mul go through the
+ * vector_math kernels, and long vectors are split across the thread pool.
+ * @version 0.1
+ * @date 2022-09-10
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_EXPR_H
+#define VECTOR_EXPR_H
+
+#include "vector.h"
+
+// Most nodes an expression may have, and most operands it may have
+// pending at once (a left-leaning chain of any length needs 3)
+#define EXPR_MAX_NODES 64
+#define EXPR_MAX_DEPTH 16
+// Components evaluated per block, small enough for every live block to
+// stay in L1 together
+#define EXPR_BLOCK 256
+
+/**
+ * @brief Expression node kinds.
+ * - EXPR_OP_VEC: A vector leaf.
+ * - EXPR_OP_CONST: A scalar, broadcast to every component.
+ * - EXPR_OP_ADD, EXPR_OP_SUB, EXPR_OP_MUL, EXPR_OP_DIV: Element-wise
+ *   left op right.
+ * - EXPR_OP_NEG: -left.
+ */
+typedef enum {
+
+    EXPR_OP_VEC,
+    EXPR_OP_CONST,
+    EXPR_OP_ADD,
+    EXPR_OP_SUB,
+    EXPR_OP_MUL,
+    EXPR_OP_DIV,
+    EXPR_OP_NEG
+} expr_op;
+
+/**
+ * @brief An expression node containing the following:
+ * - expr_op op: What the node computes.
+ * - const vec_expr* left, right: Operands (right unused by EXPR_OP_NEG).
+ * - const void* vec: The vector of a leaf, a vec_float or vec_double
+ *   matching the eval_expr it ends up in.
+ * - double scalar: The value of a constant.
+ */
+typedef struct vec_expr {
+
+    expr_op op;
+    const struct vec_expr* left;
+    const struct vec_expr* right;
+    const void* vec;
+    double scalar;
+} vec_expr;
+
+// ===================== MACROS =====================
+
+/**
+ * @brief Expression builders. Each yields a const vec_expr* to a compound
+ * literal, valid until the end of the enclosing block.
+ */
+#define EXPR_VEC(v) (&(const vec_expr){ .op = EXPR_OP_VEC, .vec = (v) })
+#define EXPR_CONST(c) (&(const vec_expr){ .op = EXPR_OP_CONST, .scalar = (double)(c) })
+#define EXPR_ADD(a, b) (&(const vec_expr){ .op = EXPR_OP_ADD, .left = (a), .right = (b) })
+#define EXPR_SUB(a, b) (&(const vec_expr){ .op = EXPR_OP_SUB, .left = (a), .right = (b) })
+#define EXPR_MUL(a, b) (&(const vec_expr){ .op = EXPR_OP_MUL, .left = (a), .right = (b) })
+#define EXPR_DIV(a, b) (&(const vec_expr){ .op = EXPR_OP_DIV, .left = (a), .right = (b) })
+#define EXPR_NEG(a) (&(const vec_expr){ .op = EXPR_OP_NEG, .left = (a) })
+#define EXPR_SCALE(c, a) EXPR_MUL(EXPR_CONST(c), (a))
+
+/**
+ * @brief out = e, picking eval_expr_float or eval_expr_double from out.
+ */
+#define eval_expr(out, e) _Generic((out), \
+    vec_float*: eval_expr_float, \
+    vec_double*: eval_expr_double)((out), (e))
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Evaluates e in one fused pass and stores it in out, which is
+ * resized to the length of the vectors in e. out may also appear in e.
+ * Every leaf must be a vector of the same component type as out.
+ *
+ * @param out Result.
+ * @param e Expression.
+ * @return false if either is NULL, e has no vector leaf, its vectors
+ * differ in size, it has more than EXPR_MAX_NODES nodes or more than
+ * EXPR_MAX_DEPTH pending operands, or out could not be resized
+ * (out is then left unchanged).
+ */
+bool eval_expr_float(vec_float* out, const vec_expr* e);
+bool eval_expr_double(vec_double* out, const vec_expr* e);
+
+#endif
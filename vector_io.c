@@ -0,0 +1,574 @@
+/**
+ * Streaming save/load in a checksummed, chunked binary format.
+ * Headers are little-endian whatever the machine, payloads are stored
+ * in the writer's byte order and swapped by readers of the other one.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_io.h"
+#include "vector.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC_X86 1
+#include <immintrin.h>
+#endif
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NATIVE_ORDER 'L'
+#else
+#define NATIVE_ORDER 'B'
+#endif
+
+// ===================== CHECKSUM =====================
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32c_scalar(uint32_t crc, const unsigned char* p, size_t bytes) {
+
+    for (size_t i = 0; i < bytes; i++) crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char* p, size_t bytes) {
+
+    size_t i = 0;
+
+#ifdef __x86_64__
+    uint64_t c = crc;
+    for (; i + 8 <= bytes; i += 8) {
+
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        c = _mm_crc32_u64(c, word);
+    }
+    crc = (uint32_t)c;
+#endif
+
+    for (; i < bytes; i++) crc = _mm_crc32_u8(crc, p[i]);
+    return crc;
+}
+#endif
+
+static uint32_t (*crc_kernel)(uint32_t, const unsigned char*, size_t) = crc32c_scalar;
+
+// Build the table and pick the kernel before main() runs
+__attribute__((constructor))
+static void init_crc32c(void) {
+
+    // Reflected Castagnoli polynomial
+    for (uint32_t i = 0; i < 256; i++) {
+
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+        crc_table[i] = c;
+    }
+
+#ifdef CRC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) crc_kernel = crc32c_sse42;
+#endif
+}
+
+/**
+ * @brief CRC32C (Castagnoli) of bytes at data, continuing from crc (0 to
+ * start). Uses the SSE4.2 crc32 instruction when the CPU has it.
+ *
+ * @return uint32_t
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t bytes) {
+
+    if (data == NULL) return crc;
+    return ~crc_kernel(~crc, (const unsigned char*)data, bytes);
+}
+
+// ===================== HELPERS =====================
+
+static void put_le32(unsigned char* p, uint32_t x) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(x >> (8 * i));
+}
+
+static uint32_t get_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Components per full chunk of data_size-byte components
+static size_t chunk_count_of(size_t data_size) {
+    return data_size >= VEC_IO_CHUNK_BYTES ? 1 : VEC_IO_CHUNK_BYTES / data_size;
+}
+
+/**
+ * @brief Fills in a stream header. The last 4 bytes are the CRC32C of the
+ * rest.
+ */
+static void encode_header(unsigned char* h, size_t data_size, size_t chunk_count) {
+
+    memset(h, 0, VEC_IO_HEADER);
+    memcpy(h, VEC_IO_MAGIC, 8);
+    put_le32(h + 8, VEC_IO_VERSION);
+    h[12] = NATIVE_ORDER;
+    put_le32(h + 16, (uint32_t)data_size);
+    put_le32(h + 20, (uint32_t)(chunk_count * data_size));
+    put_le32(h + 28, crc32c(0, h, VEC_IO_HEADER - 4));
+}
+
+/**
+ * @brief Checks a stream header and reads its component size, chunk size
+ * and byte order out of it.
+ *
+ * @return false if it is not a stream header this build understands.
+ */
+static bool decode_header(const unsigned char* h, size_t* data_size, size_t* chunk_count, char* order) {
+
+    if (memcmp(h, VEC_IO_MAGIC, 8) != 0 || get_le32(h + 8) != VEC_IO_VERSION) return false;
+    if (get_le32(h + 28) != crc32c(0, h, VEC_IO_HEADER - 4)) return false;
+    if (h[12] != 'L' && h[12] != 'B') return false;
+
+    size_t size = get_le32(h + 16), chunk_bytes = get_le32(h + 20);
+    if (size == 0 || chunk_bytes < size || chunk_bytes % size != 0) return false;
+
+    *data_size = size;
+    *chunk_count = chunk_bytes / size;
+    *order = (char)h[12];
+    return true;
+}
+
+/**
+ * @brief writev until every buffer is out, picking up after short writes
+ * and signals. iov is consumed in the process.
+ *
+ * @return false on a write error.
+ */
+static bool writev_all(int fd, struct iovec* iov, int iovs) {
+
+    while (iovs > 0) {
+
+        ssize_t done = writev(fd, iov, iovs);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) return false;
+
+        // Skip what went out, the rest goes in the next call
+        size_t left = (size_t)done;
+        while (iovs > 0 && left >= iov->iov_len) {
+
+            left -= iov->iov_len;
+            iov++;
+            iovs--;
+        }
+
+        if (iovs > 0) {
+
+            iov->iov_base = (char*)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief readv until every buffer is full or the file ends. iov is
+ * consumed in the process.
+ *
+ * @return ssize_t Bytes read, -1 on a read error.
+ */
+static ssize_t readv_all(int fd, struct iovec* iov, int iovs) {
+
+    ssize_t total = 0;
+    while (iovs > 0) {
+
+        ssize_t done = readv(fd, iov, iovs);
+        if (done < 0 && errno == EINTR) continue;
+        if (done < 0) return -1;
+        if (done == 0) break;
+
+        total += done;
+        size_t left = (size_t)done;
+        while (iovs > 0 && left >= iov->iov_len) {
+
+            left -= iov->iov_len;
+            iov++;
+            iovs--;
+        }
+
+        if (iovs > 0) {
+
+            iov->iov_base = (char*)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return total;
+}
+
+// Hands every queued chunk to the kernel
+static bool flush_writer(vec_writer* w) {
+
+    bool ok = writev_all(w->fd, w->iov, w->iovs);
+    w->iovs = 0;
+    return ok;
+}
+
+/**
+ * @brief Queues one chunk of count components at data, flushing first if
+ * the queue is full. data must stay put until the next flush.
+ *
+ * @return false if the flush failed.
+ */
+static bool queue_chunk(vec_writer* w, const void* data, size_t count) {
+
+    if (w->iovs + 2 > VEC_IO_IOVS && !flush_writer(w)) return false;
+
+    size_t bytes = count * w->data_size;
+    unsigned char* h = w->headers[w->iovs];
+    put_le32(h, (uint32_t)count);
+    put_le32(h + 4, crc32c(0, data, bytes));
+    put_le32(h + 8, 0);
+    put_le32(h + 12, crc32c(0, h, VEC_IO_CHUNK_HEADER - 4));
+
+    w->iov[w->iovs++] = (struct iovec){ h, VEC_IO_CHUNK_HEADER };
+    w->iov[w->iovs++] = (struct iovec){ (void*)data, bytes };
+    w->written += count;
+
+    return true;
+}
+
+/**
+ * @brief Validates the chunk header in r->next.
+ *
+ * @return size_t Components in the chunk, 0 at the end of the stream or
+ * if the header is bad (r->error is set then).
+ */
+static size_t next_count(vec_reader* r) {
+
+    if (r->error || r->pending == 0) return 0;
+
+    const unsigned char* h = r->next;
+    size_t count = r->pending == VEC_IO_CHUNK_HEADER ? get_le32(h) : 0;
+
+    if (count == 0 || count > r->chunk_count || get_le32(h + 12) != crc32c(0, h, VEC_IO_CHUNK_HEADER - 4)) {
+
+        r->error = true;
+        return 0;
+    }
+
+    return count;
+}
+
+static void swap_components(void* data, size_t count, size_t data_size) {
+
+    if (data_size == 2) for (uint16_t* p = data; count-- > 0; p++) *p = __builtin_bswap16(*p);
+    if (data_size == 4) for (uint32_t* p = data; count-- > 0; p++) *p = __builtin_bswap32(*p);
+    if (data_size == 8) for (uint64_t* p = data; count-- > 0; p++) *p = __builtin_bswap64(*p);
+}
+
+/**
+ * @brief Reads the payload of the chunk next_count just validated into
+ * dest, along with the header of the chunk after it, in one readv. Then
+ * checks it and puts it in this machine's byte order.
+ *
+ * @return false on a short read or a bad checksum (r->error is set).
+ */
+static bool read_payload(vec_reader* r, void* dest, size_t count) {
+
+    size_t bytes = count * r->data_size;
+    uint32_t crc = get_le32(r->next + 4);
+
+    struct iovec iov[2] = { { dest, bytes }, { r->next, VEC_IO_CHUNK_HEADER } };
+    ssize_t got = readv_all(r->fd, iov, 2);
+
+    if (got < 0 || (size_t)got < bytes || crc32c(0, dest, bytes) != crc) {
+
+        r->error = true;
+        r->pending = 0;
+        return false;
+    }
+
+    r->pending = (size_t)got - bytes;
+    if (r->swap) swap_components(dest, count, r->data_size);
+    r->read += count;
+
+    return true;
+}
+
+// ===================== STREAMS =====================
+
+/**
+ * @brief Opens path for writing data_size-byte components. The file is
+ * created or truncated, unless append is true and it already holds a
+ * stream, which is then continued. A stream cut short mid-chunk (e.g. by
+ * a crash) stays unreadable past the cut even after appending to it.
+ *
+ * @param path File to write.
+ * @param data_size Bytes per component (> 0).
+ * @param append Continue an existing stream instead of truncating it.
+ * @return vec_writer* | NULL if the file could not be opened, or the
+ * stream being appended to is corrupt, has another component size or was
+ * written in the other byte order.
+ */
+vec_writer* open_vec_writer(const char* path, size_t data_size, bool append) {
+
+    if (path == NULL || data_size == 0 || data_size > UINT32_MAX) return NULL;
+
+    vec_writer* w = malloc(sizeof(vec_writer));
+    if (w == NULL) return NULL;
+
+    w->fd = open(path, O_RDWR | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    w->data_size = data_size;
+    w->chunk_count = chunk_count_of(data_size);
+    w->written = 0;
+    w->iovs = 0;
+    w->staging = NULL;
+
+    struct stat st;
+    if (w->fd < 0 || fstat(w->fd, &st) != 0) goto FAILED_OPEN;
+
+    unsigned char h[VEC_IO_HEADER];
+    if (st.st_size == 0) {
+
+        encode_header(h, data_size, w->chunk_count);
+        struct iovec iov = { h, sizeof(h) };
+        if (!writev_all(w->fd, &iov, 1)) goto FAILED_OPEN;
+        return w;
+    }
+
+    // Continuing a stream: same components, same byte order, its chunk size
+    size_t size, chunk_count;
+    char order;
+    if (pread(w->fd, h, sizeof(h), 0) != (ssize_t)sizeof(h)) goto FAILED_OPEN;
+    if (!decode_header(h, &size, &chunk_count, &order) || size != data_size || order != NATIVE_ORDER) goto FAILED_OPEN;
+
+    w->chunk_count = chunk_count;
+    return w;
+
+FAILED_OPEN:
+    if (w->fd >= 0) close(w->fd);
+    free(w);
+    return NULL;
+}
+
+/**
+ * @brief Writes count components stored back to back at data as chunks.
+ * Everything is handed to the kernel before returning, so data can be
+ * reused right away.
+ *
+ * @param w Writer.
+ * @param data count components.
+ * @param count Number of components (may be 0).
+ * @return false if w is NULL, data is NULL with count > 0, or a write
+ * failed (the stream then ends in a partial chunk readers reject).
+ */
+bool write_vec_stream(vec_writer* w, const void* data, size_t count) {
+
+    if (w == NULL || (data == NULL && count != 0)) return false;
+
+    const char* p = (const char*)data;
+    while (count > 0) {
+
+        size_t n = count < w->chunk_count ? count : w->chunk_count;
+        if (!queue_chunk(w, p, n)) return false;
+
+        p += n * w->data_size;
+        count -= n;
+    }
+
+    return flush_writer(w);
+}
+
+/**
+ * @brief Same as write_vec_stream, for count components each in its own
+ * block (e.g. a boxed array list). They are gathered a chunk at a time.
+ *
+ * @param w Writer.
+ * @param components count pointers to data_size bytes each.
+ * @param count Number of components (may be 0).
+ * @return bool See write_vec_stream.
+ */
+bool write_vec_stream_boxed(vec_writer* w, void* const* components, size_t count) {
+
+    if (w == NULL || (components == NULL && count != 0)) return false;
+    if (count == 0) return true;
+
+    if (w->staging == NULL && (w->staging = malloc(w->chunk_count * w->data_size)) == NULL) return false;
+
+    // One staging buffer, so each chunk goes out before the next is gathered
+    while (count > 0) {
+
+        size_t n = count < w->chunk_count ? count : w->chunk_count;
+        for (size_t i = 0; i < n; i++) memcpy((char*)w->staging + i * w->data_size, components[i], w->data_size);
+
+        if (!queue_chunk(w, w->staging, n) || !flush_writer(w)) return false;
+
+        components += n;
+        count -= n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Closes the stream and frees w.
+ *
+ * @param w Writer, may be NULL.
+ * @param durable fsync before closing, so the stream survives a crash.
+ * @return false if the final write, fsync or close failed.
+ */
+bool close_vec_writer(vec_writer* w, bool durable) {
+
+    if (w == NULL) return true;
+
+    bool ok = flush_writer(w);
+    if (durable) ok = fsync(w->fd) == 0 && ok;
+    ok = close(w->fd) == 0 && ok;
+
+    free(w->staging);
+    free(w);
+    return ok;
+}
+
+/**
+ * @brief Opens the stream at path for reading. Only its header is read.
+ *
+ * @param path File to read.
+ * @return vec_reader* | NULL if it cannot be opened or does not start
+ * with a valid stream header.
+ */
+vec_reader* open_vec_reader(const char* path) {
+
+    if (path == NULL) return NULL;
+
+    vec_reader* r = malloc(sizeof(vec_reader));
+    if (r == NULL) return NULL;
+
+    r->fd = open(path, O_RDONLY);
+    r->swap = false;
+    r->error = false;
+    r->read = 0;
+    r->buffer = NULL;
+    if (r->fd < 0) goto FAILED_OPEN;
+
+    // The stream header and the first chunk header in one go
+    unsigned char h[VEC_IO_HEADER];
+    struct iovec iov[2] = { { h, sizeof(h) }, { r->next, VEC_IO_CHUNK_HEADER } };
+    ssize_t got = readv_all(r->fd, iov, 2);
+
+    char order;
+    if (got < (ssize_t)sizeof(h) || !decode_header(h, &r->data_size, &r->chunk_count, &order)) goto FAILED_OPEN;
+
+    // Only plain 1, 2, 4 and 8-byte components can be swapped
+    r->swap = order != NATIVE_ORDER && r->data_size != 1;
+    if (r->swap && r->data_size != 2 && r->data_size != 4 && r->data_size != 8) goto FAILED_OPEN;
+
+    r->pending = (size_t)got - sizeof(h);
+    return r;
+
+FAILED_OPEN:
+    if (r->fd >= 0) close(r->fd);
+    free(r);
+    return NULL;
+}
+
+/**
+ * @brief Next chunk of the stream, checksummed and in this machine's byte
+ * order, without materializing the rest.
+ *
+ * @param r Reader.
+ * @param count Set to the number of components in the chunk (0 at the end).
+ * @return const void* The components, valid until the next call | NULL at
+ * the end of the stream or on error (r->error tells them apart).
+ */
+const void* read_vec_stream(vec_reader* r, size_t* count) {
+
+    if (count != NULL) *count = 0;
+    if (r == NULL || count == NULL) return NULL;
+
+    size_t n = next_count(r);
+    if (n == 0) return NULL;
+
+    if (r->buffer == NULL && (r->buffer = malloc(r->chunk_count * r->data_size)) == NULL) {
+
+        r->error = true;
+        return NULL;
+    }
+
+    if (!read_payload(r, r->buffer, n)) return NULL;
+
+    *count = n;
+    return r->buffer;
+}
+
+/**
+ * @brief Closes the stream and frees r.
+ *
+ * @param r Reader, may be NULL.
+ */
+void close_vec_reader(vec_reader* r) {
+
+    if (r == NULL) return;
+
+    close(r->fd);
+    free(r->buffer);
+    free(r);
+}
+
+// ===================== VECTORS =====================
+
+/**
+ * @brief Writes the components of a vector to path as a stream.
+ *
+ * @param v Vector (any vec_*).
+ * @param path File to write.
+ * @param append Add to the stream already at path instead of replacing it.
+ * @param data_size Size of one component.
+ * @return false if v is NULL or anything failed.
+ */
+bool save_vec(const void* v, const char* path, bool append, size_t data_size) {
+
+    if (v == NULL) return false;
+
+    const vec_void* vv = (const vec_void*)v;
+    vec_writer* w = open_vec_writer(path, data_size, append);
+
+    bool ok = w != NULL && write_vec_stream(w, vv->array, vv->size);
+    return close_vec_writer(w, false) && ok;
+}
+
+/**
+ * @brief Reads the stream at path into a new heap vector. Chunks are read
+ * straight into the vector's array, growing it by its default policy.
+ *
+ * @param path File to read.
+ * @param data_size Size of one component, must match the stream's.
+ * @return vec* | NULL if the stream is missing, corrupt or holds
+ * components of another size.
+ */
+void* load_vec(const char* path, size_t data_size) {
+
+    vec_reader* r = open_vec_reader(path);
+    if (r == NULL) return NULL;
+
+    vec_void* v = r->data_size == data_size ? init_vec(0, data_size, false) : NULL;
+    bool ok = v != NULL;
+
+    for (size_t n; ok && (n = next_count(r)) != 0;) {
+
+        if (n > v->capacity - v->size) ok = reserve_vec(v, policy_grow(v->policy, v->capacity, v->size + n), data_size);
+        ok = ok && read_payload(r, (char*)v->array + v->size * data_size, n);
+        if (ok) v->size += n;
+    }
+
+    ok = ok && !r->error;
+    close_vec_reader(r);
+
+    if (ok) return v;
+
+    free_vec(v);
+    return NULL;
+}
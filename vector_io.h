@@ -0,0 +1,203 @@
+/**
+ * @file vector_io.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Streaming save/load of components in a checksummed, chunked
+ * binary format. A stream is a 32-byte header (magic, version, byte
+ * order, component size, chunk size) followed by chunks of at most
+ * VEC_IO_CHUNK_BYTES, each with a 16-byte header (component count,
+ * CRC32C of the payload, CRC32C of the header itself). Writes queue whole
+ * chunks and hand them to writev together, reads pull a payload and the
+ * next chunk header with one readv, so throughput is bounded by the disk
+ * rather than per-call overhead. There is no trailer: appending to a
+ * stream is just writing more chunks, and readers stop at end of file.
+ *
+ * Vectors go through save_vec/load_vec below, array lists through
+ * save_arl/load_arl in array_list.h.
+ * @version 0.1
+ * @date 2022-09-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_IO_H
+#define VECTOR_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+// First 8 bytes of every stream and the layout version after them
+#define VEC_IO_MAGIC "CATSTRM\0"
+#define VEC_IO_VERSION 1
+// Largest chunk payload a writer produces (one component if that is bigger)
+#define VEC_IO_CHUNK_BYTES ((size_t)1 << 20)
+// Stream and chunk header sizes
+#define VEC_IO_HEADER 32
+#define VEC_IO_CHUNK_HEADER 16
+// Buffers queued per writev, two per chunk
+#define VEC_IO_IOVS 64
+
+/**
+ * @brief An open stream being written containing the following:
+ * - int fd: The file, opened for appending.
+ * - size_t data_size: Bytes per component.
+ * - size_t chunk_count: Components per full chunk.
+ * - size_t written: Components written through this writer so far.
+ * - int iovs, struct iovec iov[], headers[][]: Chunks queued for the next
+ *   writev and their headers.
+ * - void* staging: One chunk of boxed components gathered back to back,
+ *   allocated on first use.
+ */
+typedef struct vec_writer {
+
+    int fd;
+    size_t data_size;
+    size_t chunk_count;
+    size_t written;
+    int iovs;
+    struct iovec iov[VEC_IO_IOVS];
+    unsigned char headers[VEC_IO_IOVS][VEC_IO_CHUNK_HEADER];
+    void* staging;
+} vec_writer;
+
+/**
+ * @brief An open stream being read containing the following:
+ * - int fd: The file.
+ * - size_t data_size: Bytes per component.
+ * - size_t chunk_count: Most components a chunk may hold.
+ * - bool swap: Written in the other byte order, components of 2, 4 or 8
+ *   bytes are swapped as they are read.
+ * - bool error: A checksum did not match or the stream ended mid-chunk.
+ *   Set once, the reader returns nothing after it.
+ * - size_t read: Components handed out so far.
+ * - size_t pending, unsigned char next[]: Bytes of the next chunk header
+ *   already read (VEC_IO_CHUNK_HEADER, or 0 at the end of the stream).
+ * - void* buffer: One chunk, for read_vec_stream, allocated on first use.
+ */
+typedef struct vec_reader {
+
+    int fd;
+    size_t data_size;
+    size_t chunk_count;
+    bool swap;
+    bool error;
+    size_t read;
+    size_t pending;
+    unsigned char next[VEC_IO_CHUNK_HEADER];
+    void* buffer;
+} vec_reader;
+
+// ===================== CHECKSUM =====================
+
+/**
+ * @brief CRC32C (Castagnoli) of bytes at data, continuing from crc (0 to
+ * start). Uses the SSE4.2 crc32 instruction when the CPU has it.
+ *
+ * @return uint32_t
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t bytes);
+
+// ===================== STREAMS =====================
+
+/**
+ * @brief Opens path for writing data_size-byte components. The file is
+ * created or truncated, unless append is true and it already holds a
+ * stream, which is then continued. A stream cut short mid-chunk (e.g. by
+ * a crash) stays unreadable past the cut even after appending to it.
+ *
+ * @param path File to write.
+ * @param data_size Bytes per component (> 0).
+ * @param append Continue an existing stream instead of truncating it.
+ * @return vec_writer* | NULL if the file could not be opened, or the
+ * stream being appended to is corrupt, has another component size or was
+ * written in the other byte order.
+ */
+vec_writer* open_vec_writer(const char* path, size_t data_size, bool append);
+
+/**
+ * @brief Writes count components stored back to back at data as chunks.
+ * Everything is handed to the kernel before returning, so data can be
+ * reused right away.
+ *
+ * @param w Writer.
+ * @param data count components.
+ * @param count Number of components (may be 0).
+ * @return false if w is NULL, data is NULL with count > 0, or a write
+ * failed (the stream then ends in a partial chunk readers reject).
+ */
+bool write_vec_stream(vec_writer* w, const void* data, size_t count);
+
+/**
+ * @brief Same as write_vec_stream, for count components each in its own
+ * block (e.g. a boxed array list). They are gathered a chunk at a time.
+ *
+ * @param w Writer.
+ * @param components count pointers to data_size bytes each.
+ * @param count Number of components (may be 0).
+ * @return bool See write_vec_stream.
+ */
+bool write_vec_stream_boxed(vec_writer* w, void* const* components, size_t count);
+
+/**
+ * @brief Closes the stream and frees w.
+ *
+ * @param w Writer, may be NULL.
+ * @param durable fsync before closing, so the stream survives a crash.
+ * @return false if the final write, fsync or close failed.
+ */
+bool close_vec_writer(vec_writer* w, bool durable);
+
+/**
+ * @brief Opens the stream at path for reading. Only its header is read.
+ *
+ * @param path File to read.
+ * @return vec_reader* | NULL if it cannot be opened or does not start
+ * with a valid stream header.
+ */
+vec_reader* open_vec_reader(const char* path);
+
+/**
+ * @brief Next chunk of the stream, checksummed and in this machine's byte
+ * order, without materializing the rest.
+ *
+ * @param r Reader.
+ * @param count Set to the number of components in the chunk (0 at the end).
+ * @return const void* The components, valid until the next call | NULL at
+ * the end of the stream or on error (r->error tells them apart).
+ */
+const void* read_vec_stream(vec_reader* r, size_t* count);
+
+/**
+ * @brief Closes the stream and frees r.
+ *
+ * @param r Reader, may be NULL.
+ */
+void close_vec_reader(vec_reader* r);
+
+// ===================== VECTORS =====================
+
+/**
+ * @brief Writes the components of a vector to path as a stream.
+ *
+ * @param v Vector (any vec_*).
+ * @param path File to write.
+ * @param append Add to the stream already at path instead of replacing it.
+ * @param data_size Size of one component.
+ * @return false if v is NULL or anything failed.
+ */
+bool save_vec(const void* v, const char* path, bool append, size_t data_size);
+
+/**
+ * @brief Reads the stream at path into a new heap vector. Chunks are read
+ * straight into the vector's array, growing it by its default policy.
+ *
+ * @param path File to read.
+ * @param data_size Size of one component, must match the stream's.
+ * @return vec* | NULL if the stream is missing, corrupt or holds
+ * components of another size.
+ */
+void* load_vec(const char* path, size_t data_size);
+
+#endif
@@ -0,0 +1,814 @@
+/**
+ * Level-1 arithmetic for vec_float and vec_double.
+ * The kernels themselves live in vector_math_kernels.h and are
+ * stamped out once per component type and instruction set.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_math.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// ===================== SCALAR KERNELS =====================
+
+#define T float
+#define VT float
+#define W 1
+#define SUFFIX f32_scalar
+#define ATTR
+#define VLOAD(p) (*(p))
+#define VSTORE(p, v) (*(p) = (v))
+#define VSET1(a) (a)
+#define VZERO() 0.0f
+#define VADD(a, b) ((a) + (b))
+#define VSUB(a, b) ((a) - (b))
+#define VMUL(a, b) ((a) * (b))
+#define VMAX(a, b) ((a) > (b) ? (a) : (b))
+#define VMIN(a, b) ((a) < (b) ? (a) : (b))
+#define VABS(a) fabsf(a)
+#define VFMA(a, b, c) ((a) * (b) + (c))
+#define VHSUM(v) (v)
+#define VHMAX(v) (v)
+#define VHMIN(v) (v)
+#define SABS(a) fabsf(a)
+#include "vector_math_kernels.h"
+
+#define T double
+#define VT double
+#define W 1
+#define SUFFIX f64_scalar
+#define ATTR
+#define VLOAD(p) (*(p))
+#define VSTORE(p, v) (*(p) = (v))
+#define VSET1(a) (a)
+#define VZERO() 0.0
+#define VADD(a, b) ((a) + (b))
+#define VSUB(a, b) ((a) - (b))
+#define VMUL(a, b) ((a) * (b))
+#define VMAX(a, b) ((a) > (b) ? (a) : (b))
+#define VMIN(a, b) ((a) < (b) ? (a) : (b))
+#define VABS(a) fabs(a)
+#define VFMA(a, b, c) ((a) * (b) + (c))
+#define VHSUM(v) (v)
+#define VHMAX(v) (v)
+#define VHMIN(v) (v)
+#define SABS(a) fabs(a)
+#include "vector_math_kernels.h"
+
+#ifdef SIMD_X86
+
+// ===================== SSE2 KERNELS =====================
+
+static inline float hsum_ps_sse2(__m128 v) {
+
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+static inline float hmax_ps_sse2(__m128 v) {
+
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 maxs = _mm_max_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, maxs);
+    return _mm_cvtss_f32(_mm_max_ss(maxs, shuf));
+}
+
+static inline float hmin_ps_sse2(__m128 v) {
+
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 mins = _mm_min_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, mins);
+    return _mm_cvtss_f32(_mm_min_ss(mins, shuf));
+}
+
+static inline double hsum_pd_sse2(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static inline double hmax_pd_sse2(__m128d v) {
+    return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+static inline double hmin_pd_sse2(__m128d v) {
+    return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#define T float
+#define VT __m128
+#define W 4
+#define SUFFIX f32_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSTORE(p, v) _mm_storeu_ps((p), (v))
+#define VSET1(a) _mm_set1_ps(a)
+#define VZERO() _mm_setzero_ps()
+#define VADD(a, b) _mm_add_ps((a), (b))
+#define VSUB(a, b) _mm_sub_ps((a), (b))
+#define VMUL(a, b) _mm_mul_ps((a), (b))
+#define VMAX(a, b) _mm_max_ps((a), (b))
+#define VMIN(a, b) _mm_min_ps((a), (b))
+#define VABS(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), (a))
+#define VFMA(a, b, c) _mm_add_ps(_mm_mul_ps((a), (b)), (c))
+#define VHSUM(v) hsum_ps_sse2(v)
+#define VHMAX(v) hmax_ps_sse2(v)
+#define VHMIN(v) hmin_ps_sse2(v)
+#define SABS(a) fabsf(a)
+#include "vector_math_kernels.h"
+
+#define T double
+#define VT __m128d
+#define W 2
+#define SUFFIX f64_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_pd(p)
+#define VSTORE(p, v) _mm_storeu_pd((p), (v))
+#define VSET1(a) _mm_set1_pd(a)
+#define VZERO() _mm_setzero_pd()
+#define VADD(a, b) _mm_add_pd((a), (b))
+#define VSUB(a, b) _mm_sub_pd((a), (b))
+#define VMUL(a, b) _mm_mul_pd((a), (b))
+#define VMAX(a, b) _mm_max_pd((a), (b))
+#define VMIN(a, b) _mm_min_pd((a), (b))
+#define VABS(a) _mm_andnot_pd(_mm_set1_pd(-0.0), (a))
+#define VFMA(a, b, c) _mm_add_pd(_mm_mul_pd((a), (b)), (c))
+#define VHSUM(v) hsum_pd_sse2(v)
+#define VHMAX(v) hmax_pd_sse2(v)
+#define VHMIN(v) hmin_pd_sse2(v)
+#define SABS(a) fabs(a)
+#include "vector_math_kernels.h"
+
+// ===================== AVX2 KERNELS =====================
+
+__attribute__((target("avx2,fma")))
+static inline float hsum_ps_avx2(__m256 v) {
+    return hsum_ps_sse2(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static inline float hmax_ps_avx2(__m256 v) {
+    return hmax_ps_sse2(_mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static inline float hmin_ps_avx2(__m256 v) {
+    return hmin_ps_sse2(_mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static inline double hsum_pd_avx2(__m256d v) {
+    return hsum_pd_sse2(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static inline double hmax_pd_avx2(__m256d v) {
+    return hmax_pd_sse2(_mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+static inline double hmin_pd_avx2(__m256d v) {
+    return hmin_pd_sse2(_mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+#define T float
+#define VT __m256
+#define W 8
+#define SUFFIX f32_avx2
+#define ATTR __attribute__((target("avx2,fma")))
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSTORE(p, v) _mm256_storeu_ps((p), (v))
+#define VSET1(a) _mm256_set1_ps(a)
+#define VZERO() _mm256_setzero_ps()
+#define VADD(a, b) _mm256_add_ps((a), (b))
+#define VSUB(a, b) _mm256_sub_ps((a), (b))
+#define VMUL(a, b) _mm256_mul_ps((a), (b))
+#define VMAX(a, b) _mm256_max_ps((a), (b))
+#define VMIN(a, b) _mm256_min_ps((a), (b))
+#define VABS(a) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), (a))
+#define VFMA(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#define VHSUM(v) hsum_ps_avx2(v)
+#define VHMAX(v) hmax_ps_avx2(v)
+#define VHMIN(v) hmin_ps_avx2(v)
+#define SABS(a) fabsf(a)
+#include "vector_math_kernels.h"
+
+#define T double
+#define VT __m256d
+#define W 4
+#define SUFFIX f64_avx2
+#define ATTR __attribute__((target("avx2,fma")))
+#define VLOAD(p) _mm256_loadu_pd(p)
+#define VSTORE(p, v) _mm256_storeu_pd((p), (v))
+#define VSET1(a) _mm256_set1_pd(a)
+#define VZERO() _mm256_setzero_pd()
+#define VADD(a, b) _mm256_add_pd((a), (b))
+#define VSUB(a, b) _mm256_sub_pd((a), (b))
+#define VMUL(a, b) _mm256_mul_pd((a), (b))
+#define VMAX(a, b) _mm256_max_pd((a), (b))
+#define VMIN(a, b) _mm256_min_pd((a), (b))
+#define VABS(a) _mm256_andnot_pd(_mm256_set1_pd(-0.0), (a))
+#define VFMA(a, b, c) _mm256_fmadd_pd((a), (b), (c))
+#define VHSUM(v) hsum_pd_avx2(v)
+#define VHMAX(v) hmax_pd_avx2(v)
+#define VHMIN(v) hmin_pd_avx2(v)
+#define SABS(a) fabs(a)
+#include "vector_math_kernels.h"
+
+// ===================== AVX-512 KERNELS =====================
+
+#define T float
+#define VT __m512
+#define W 16
+#define SUFFIX f32_avx512
+#define ATTR __attribute__((target("avx512f")))
+#define VLOAD(p) _mm512_loadu_ps(p)
+#define VSTORE(p, v) _mm512_storeu_ps((p), (v))
+#define VSET1(a) _mm512_set1_ps(a)
+#define VZERO() _mm512_setzero_ps()
+#define VADD(a, b) _mm512_add_ps((a), (b))
+#define VSUB(a, b) _mm512_sub_ps((a), (b))
+#define VMUL(a, b) _mm512_mul_ps((a), (b))
+#define VMAX(a, b) _mm512_max_ps((a), (b))
+#define VMIN(a, b) _mm512_min_ps((a), (b))
+#define VABS(a) _mm512_abs_ps(a)
+#define VFMA(a, b, c) _mm512_fmadd_ps((a), (b), (c))
+#define VHSUM(v) _mm512_reduce_add_ps(v)
+#define VHMAX(v) _mm512_reduce_max_ps(v)
+#define VHMIN(v) _mm512_reduce_min_ps(v)
+#define SABS(a) fabsf(a)
+#include "vector_math_kernels.h"
+
+#define T double
+#define VT __m512d
+#define W 8
+#define SUFFIX f64_avx512
+#define ATTR __attribute__((target("avx512f")))
+#define VLOAD(p) _mm512_loadu_pd(p)
+#define VSTORE(p, v) _mm512_storeu_pd((p), (v))
+#define VSET1(a) _mm512_set1_pd(a)
+#define VZERO() _mm512_setzero_pd()
+#define VADD(a, b) _mm512_add_pd((a), (b))
+#define VSUB(a, b) _mm512_sub_pd((a), (b))
+#define VMUL(a, b) _mm512_mul_pd((a), (b))
+#define VMAX(a, b) _mm512_max_pd((a), (b))
+#define VMIN(a, b) _mm512_min_pd((a), (b))
+#define VABS(a) _mm512_abs_pd(a)
+#define VFMA(a, b, c) _mm512_fmadd_pd((a), (b), (c))
+#define VHSUM(v) _mm512_reduce_add_pd(v)
+#define VHMAX(v) _mm512_reduce_max_pd(v)
+#define VHMIN(v) _mm512_reduce_min_pd(v)
+#define SABS(a) fabs(a)
+#include "vector_math_kernels.h"
+
+#endif
+
+// ===================== DISPATCH =====================
+
+typedef struct kernels_f32 {
+
+    float (*dot)(const float*, const float*, size_t);
+    float (*sum)(const float*, size_t);
+    float (*norm1)(const float*, size_t);
+    float (*normi)(const float*, size_t);
+    void (*axpy)(size_t, float, const float*, float*);
+    void (*scale)(size_t, float, float*);
+    void (*add)(size_t, const float*, const float*, float*);
+    void (*sub)(size_t, const float*, const float*, float*);
+    void (*mul)(size_t, const float*, const float*, float*);
+    float (*ksum)(const float*, size_t);
+    float (*kdev2)(const float*, size_t, float);
+    float (*min)(const float*, size_t);
+    float (*max)(const float*, size_t);
+} kernels_f32;
+
+typedef struct kernels_f64 {
+
+    double (*dot)(const double*, const double*, size_t);
+    double (*sum)(const double*, size_t);
+    double (*norm1)(const double*, size_t);
+    double (*normi)(const double*, size_t);
+    void (*axpy)(size_t, double, const double*, double*);
+    void (*scale)(size_t, double, double*);
+    void (*add)(size_t, const double*, const double*, double*);
+    void (*sub)(size_t, const double*, const double*, double*);
+    void (*mul)(size_t, const double*, const double*, double*);
+    double (*ksum)(const double*, size_t);
+    double (*kdev2)(const double*, size_t, double);
+    double (*min)(const double*, size_t);
+    double (*max)(const double*, size_t);
+} kernels_f64;
+
+#define KERNEL_TABLE(suffix) { dot_##suffix, sum_##suffix, norm1_##suffix, normi_##suffix, axpy_##suffix, \
+                               scale_##suffix, add_##suffix, sub_##suffix, mul_##suffix, ksum_##suffix, \
+                               kdev2_##suffix, min_##suffix, max_##suffix }
+
+static const kernels_f32 f32_table[] = {
+    [SIMD_SCALAR] = KERNEL_TABLE(f32_scalar),
+#ifdef SIMD_X86
+    [SIMD_SSE2] = KERNEL_TABLE(f32_sse2),
+    [SIMD_AVX2] = KERNEL_TABLE(f32_avx2),
+    [SIMD_AVX512] = KERNEL_TABLE(f32_avx512),
+#endif
+};
+
+static const kernels_f64 f64_table[] = {
+    [SIMD_SCALAR] = KERNEL_TABLE(f64_scalar),
+#ifdef SIMD_X86
+    [SIMD_SSE2] = KERNEL_TABLE(f64_sse2),
+    [SIMD_AVX2] = KERNEL_TABLE(f64_avx2),
+    [SIMD_AVX512] = KERNEL_TABLE(f64_avx512),
+#endif
+};
+
+static simd_level active_level = SIMD_SCALAR;
+static const kernels_f32* f32 = &f32_table[SIMD_SCALAR];
+static const kernels_f64* f64 = &f64_table[SIMD_SCALAR];
+
+/**
+ * @brief Highest instruction set this CPU supports. __builtin_cpu_supports
+ * also checks that the OS saves the wider registers (XGETBV).
+ *
+ * @return simd_level
+ */
+simd_level max_simd_level(void) {
+
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+/**
+ * @brief Forces the kernels down to level (for testing and benchmarking).
+ * Levels above max_simd_level() are clamped. Not thread-safe, call it
+ * while no other thread is running vector math.
+ *
+ * @param level Requested instruction set.
+ * @return simd_level The level actually in use.
+ */
+simd_level set_simd_level(simd_level level) {
+
+    simd_level max = max_simd_level();
+    if (level > max || level < SIMD_SCALAR) level = max;
+
+    active_level = level;
+    f32 = &f32_table[level];
+    f64 = &f64_table[level];
+
+    return level;
+}
+
+/**
+ * @brief The instruction set the kernels currently use.
+ *
+ * @return simd_level
+ */
+simd_level get_simd_level(void) {
+    return active_level;
+}
+
+// Pick the best kernels before main() runs so the hot paths never branch on it
+__attribute__((constructor))
+static void init_simd_level(void) {
+    set_simd_level(max_simd_level());
+}
+
+// ===================== PARALLEL =====================
+
+// Reductions are cut into fixed REDUCE_BLOCK blocks whose partial results
+// are combined in block order, so the answer does not depend on how many
+// threads took part. Element-wise ops are split in ELEMENTWISE_GRAIN chunks.
+#define REDUCE_BLOCK ((size_t)1 << 14)
+#define ELEMENTWISE_GRAIN ((size_t)1 << 14)
+
+typedef enum { REDUCE_DOT, REDUCE_SUM, REDUCE_NORM1, REDUCE_NORMI } reduce_op;
+typedef enum { MAP_AXPY, MAP_SCALE, MAP_ADD, MAP_SUB, MAP_MUL } map_op;
+
+// Worth waking the pool for n components
+static bool go_parallel(size_t n) {
+    return n >= get_parallel_threshold() && n > REDUCE_BLOCK && get_thread_count() > 1;
+}
+
+/**
+ * @brief Stamps out the pool-aware reduction and element-wise drivers for
+ * one component type. S is both the suffix and the active kernel table.
+ */
+#define DEFINE_PARALLEL_OPS(T, S) \
+typedef struct reduce_ctx_##S { reduce_op op; const T* x; const T* y; size_t n; T* partials; } reduce_ctx_##S; \
+\
+static T reduce_block_##S(reduce_op op, const T* x, const T* y, size_t n) { \
+    switch (op) { \
+        case REDUCE_DOT: return S->dot(x, y, n); \
+        case REDUCE_SUM: return S->sum(x, n); \
+        case REDUCE_NORM1: return S->norm1(x, n); \
+        default: return S->normi(x, n); \
+    } \
+} \
+\
+static T reduce_at_##S(const reduce_ctx_##S* ctx, size_t b) { \
+    size_t lo = b * REDUCE_BLOCK; \
+    size_t len = ctx->n - lo < REDUCE_BLOCK ? ctx->n - lo : REDUCE_BLOCK; \
+    return reduce_block_##S(ctx->op, ctx->x + lo, ctx->y == NULL ? NULL : ctx->y + lo, len); \
+} \
+\
+static void reduce_task_##S(void* arg, size_t begin, size_t end) { \
+    reduce_ctx_##S* ctx = (reduce_ctx_##S*)arg; \
+    for (size_t b = begin; b < end; b++) ctx->partials[b] = reduce_at_##S(ctx, b); \
+} \
+\
+/* Serial or not, every block is reduced on its own and folded in order */ \
+static T reduce_##S(reduce_op op, const T* x, const T* y, size_t n) { \
+    if (n <= REDUCE_BLOCK) return reduce_block_##S(op, x, y, n); \
+    size_t blocks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK; \
+    reduce_ctx_##S ctx = { op, x, y, n, go_parallel(n) ? (T*)malloc(blocks * sizeof(T)) : NULL }; \
+    if (ctx.partials != NULL) parallel_for(0, blocks, 1, reduce_task_##S, &ctx); \
+    T result = ctx.partials != NULL ? ctx.partials[0] : reduce_at_##S(&ctx, 0); \
+    for (size_t b = 1; b < blocks; b++) { \
+        T p = ctx.partials != NULL ? ctx.partials[b] : reduce_at_##S(&ctx, b); \
+        result = op == REDUCE_NORMI ? (p > result ? p : result) : result + p; \
+    } \
+    free(ctx.partials); \
+    return result; \
+} \
+\
+typedef struct map_ctx_##S { map_op op; T a; const T* x; const T* y; T* out; } map_ctx_##S; \
+\
+static void map_task_##S(void* arg, size_t begin, size_t end) { \
+    map_ctx_##S* ctx = (map_ctx_##S*)arg; \
+    size_t len = end - begin; \
+    switch (ctx->op) { \
+        case MAP_AXPY: S->axpy(len, ctx->a, ctx->x + begin, ctx->out + begin); break; \
+        case MAP_SCALE: S->scale(len, ctx->a, ctx->out + begin); break; \
+        case MAP_ADD: S->add(len, ctx->x + begin, ctx->y + begin, ctx->out + begin); break; \
+        case MAP_SUB: S->sub(len, ctx->x + begin, ctx->y + begin, ctx->out + begin); break; \
+        case MAP_MUL: S->mul(len, ctx->x + begin, ctx->y + begin, ctx->out + begin); break; \
+    } \
+} \
+\
+static void map_##S(map_op op, size_t n, T a, const T* x, const T* y, T* out) { \
+    map_ctx_##S ctx = { op, a, x, y, out }; \
+    if (go_parallel(n)) parallel_for(0, n, ELEMENTWISE_GRAIN, map_task_##S, &ctx); \
+    else map_task_##S(&ctx, 0, n); \
+}
+
+DEFINE_PARALLEL_OPS(float, f32)
+DEFINE_PARALLEL_OPS(double, f64)
+
+// ===================== STATISTICS =====================
+
+// Statistics are always computed over the same REDUCE_BLOCK blocks, each
+// with compensated SIMD kernels, and the block results always meet in the
+// same pairwise tree. Whether one thread or many filled in the blocks, the
+// additions happen in the same order, so the result is bit-identical for
+// any thread count (at a given SIMD level).
+typedef enum { STAT_SUM, STAT_DEV2, STAT_MIN, STAT_MAX } stat_op;
+
+/**
+ * @brief Stamps out the statistics drivers for one component type.
+ * S is both the suffix and the active kernel table.
+ */
+#define DEFINE_STATS_OPS(T, S) \
+typedef struct stats_ctx_##S { stat_op op; const T* x; size_t n; T mean; T* partials; } stats_ctx_##S; \
+\
+static T stat_block_##S(const stats_ctx_##S* ctx, size_t b) { \
+    size_t lo = b * REDUCE_BLOCK; \
+    size_t len = ctx->n - lo < REDUCE_BLOCK ? ctx->n - lo : REDUCE_BLOCK; \
+    switch (ctx->op) { \
+        case STAT_SUM: return S->ksum(ctx->x + lo, len); \
+        case STAT_DEV2: return S->kdev2(ctx->x + lo, len, ctx->mean); \
+        case STAT_MIN: return S->min(ctx->x + lo, len); \
+        default: return S->max(ctx->x + lo, len); \
+    } \
+} \
+\
+static void stats_task_##S(void* arg, size_t begin, size_t end) { \
+    stats_ctx_##S* ctx = (stats_ctx_##S*)arg; \
+    for (size_t b = begin; b < end; b++) ctx->partials[b] = stat_block_##S(ctx, b); \
+} \
+\
+/* Blocks [lo, hi) folded pairwise, leaves taken from partials when they */ \
+/* were filled in and computed on the spot otherwise */ \
+static T stat_tree_##S(const stats_ctx_##S* ctx, size_t lo, size_t hi) { \
+    if (hi - lo == 1) return ctx->partials != NULL ? ctx->partials[lo] : stat_block_##S(ctx, lo); \
+    size_t mid = lo + (hi - lo) / 2; \
+    T l = stat_tree_##S(ctx, lo, mid); \
+    T r = stat_tree_##S(ctx, mid, hi); \
+    switch (ctx->op) { \
+        case STAT_MIN: return r < l ? r : l; \
+        case STAT_MAX: return r > l ? r : l; \
+        default: return l + r; \
+    } \
+} \
+\
+/* partials, if not NULL, has room for every block and is left holding */ \
+/* their results */ \
+static T stat_##S(stat_op op, const T* x, size_t n, T mean, T* partials) { \
+    size_t blocks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK; \
+    if (blocks == 0) return op == STAT_MIN ? (T)INFINITY : op == STAT_MAX ? -(T)INFINITY : 0; \
+    stats_ctx_##S ctx = { op, x, n, mean, partials }; \
+    bool parallel = go_parallel(n); \
+    T* owned = NULL; \
+    if (parallel && partials == NULL) ctx.partials = owned = (T*)malloc(blocks * sizeof(T)); \
+    if (ctx.partials != NULL) { \
+        if (parallel) parallel_for(0, blocks, 1, stats_task_##S, &ctx); \
+        else stats_task_##S(&ctx, 0, blocks); \
+    } \
+    T result = stat_tree_##S(&ctx, 0, blocks); \
+    free(owned); \
+    return result; \
+} \
+\
+/* Index of the first component equal to the minimum (or maximum), only */ \
+/* rescanning the blocks whose result matches it */ \
+static size_t arg_##S(stat_op op, const T* x, size_t n) { \
+    size_t blocks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK; \
+    if (blocks == 0) return SIZE_MAX; \
+    T* partials = (T*)malloc(blocks * sizeof(T)); \
+    T best = stat_##S(op, x, n, 0, partials); \
+    size_t found = SIZE_MAX; \
+    for (size_t b = 0; b < blocks && found == SIZE_MAX; b++) { \
+        if (partials != NULL && partials[b] != best) continue; \
+        size_t end = n - b * REDUCE_BLOCK < REDUCE_BLOCK ? n : (b + 1) * REDUCE_BLOCK; \
+        for (size_t i = b * REDUCE_BLOCK; i < end; i++) \
+            if (x[i] == best) { found = i; break; } \
+    } \
+    free(partials); \
+    return found; \
+}
+
+DEFINE_STATS_OPS(float, f32)
+DEFINE_STATS_OPS(double, f64)
+
+// ===================== RAW KERNELS =====================
+
+float dot_f32(const float* x, const float* y, size_t n) { return reduce_f32(REDUCE_DOT, x, y, n); }
+float sum_f32(const float* x, size_t n) { return reduce_f32(REDUCE_SUM, x, NULL, n); }
+float norm1_f32(const float* x, size_t n) { return reduce_f32(REDUCE_NORM1, x, NULL, n); }
+float norm2_f32(const float* x, size_t n) { return sqrtf(reduce_f32(REDUCE_DOT, x, x, n)); }
+float normi_f32(const float* x, size_t n) { return reduce_f32(REDUCE_NORMI, x, NULL, n); }
+void axpy_f32(size_t n, float a, const float* x, float* y) { map_f32(MAP_AXPY, n, a, x, NULL, y); }
+void scale_f32(size_t n, float a, float* x) { map_f32(MAP_SCALE, n, a, NULL, NULL, x); }
+void add_f32(size_t n, const float* x, const float* y, float* out) { map_f32(MAP_ADD, n, 0.0f, x, y, out); }
+void sub_f32(size_t n, const float* x, const float* y, float* out) { map_f32(MAP_SUB, n, 0.0f, x, y, out); }
+void mul_f32(size_t n, const float* x, const float* y, float* out) { map_f32(MAP_MUL, n, 0.0f, x, y, out); }
+
+double dot_f64(const double* x, const double* y, size_t n) { return reduce_f64(REDUCE_DOT, x, y, n); }
+double sum_f64(const double* x, size_t n) { return reduce_f64(REDUCE_SUM, x, NULL, n); }
+double norm1_f64(const double* x, size_t n) { return reduce_f64(REDUCE_NORM1, x, NULL, n); }
+double norm2_f64(const double* x, size_t n) { return sqrt(reduce_f64(REDUCE_DOT, x, x, n)); }
+double normi_f64(const double* x, size_t n) { return reduce_f64(REDUCE_NORMI, x, NULL, n); }
+void axpy_f64(size_t n, double a, const double* x, double* y) { map_f64(MAP_AXPY, n, a, x, NULL, y); }
+void scale_f64(size_t n, double a, double* x) { map_f64(MAP_SCALE, n, a, NULL, NULL, x); }
+void add_f64(size_t n, const double* x, const double* y, double* out) { map_f64(MAP_ADD, n, 0.0, x, y, out); }
+void sub_f64(size_t n, const double* x, const double* y, double* out) { map_f64(MAP_SUB, n, 0.0, x, y, out); }
+void mul_f64(size_t n, const double* x, const double* y, double* out) { map_f64(MAP_MUL, n, 0.0, x, y, out); }
+
+/**
+ * @brief Stamps out the raw statistics of one component type.
+ */
+#define DEFINE_STATS_RAW(T, S) \
+T stable_sum_##S(const T* x, size_t n) { return stat_##S(STAT_SUM, x, n, 0, NULL); } \
+\
+T mean_##S(const T* x, size_t n) { \
+    return n == 0 ? (T)NAN : stable_sum_##S(x, n) / (T)n; \
+} \
+\
+T variance_##S(const T* x, size_t n, bool sample) { \
+    if (n == 0 || (sample && n == 1)) return (T)NAN; \
+    T mean = mean_##S(x, n); \
+    return stat_##S(STAT_DEV2, x, n, mean, NULL) / (T)(sample ? n - 1 : n); \
+} \
+\
+size_t argmin_##S(const T* x, size_t n) { return arg_##S(STAT_MIN, x, n); } \
+size_t argmax_##S(const T* x, size_t n) { return arg_##S(STAT_MAX, x, n); } \
+\
+/* +/-INFINITY is also what the kernels give when every component is */ \
+/* NaN, only then is the slower argmin/argmax needed to tell them apart */ \
+T min_##S(const T* x, size_t n) { \
+    T min = stat_##S(STAT_MIN, x, n, 0, NULL); \
+    if (min == (T)INFINITY && argmin_##S(x, n) == SIZE_MAX) return (T)NAN; \
+    return min; \
+} \
+\
+T max_##S(const T* x, size_t n) { \
+    T max = stat_##S(STAT_MAX, x, n, 0, NULL); \
+    if (max == -(T)INFINITY && argmax_##S(x, n) == SIZE_MAX) return (T)NAN; \
+    return max; \
+}
+
+DEFINE_STATS_RAW(float, f32)
+DEFINE_STATS_RAW(double, f64)
+
+// ===================== FUNCTIONS =====================
+
+float dot_vec_float(const vec_float* x, const vec_float* y) {
+
+    if (x == NULL || y == NULL || x->size != y->size) return NAN;
+    return dot_f32(x->array, y->array, x->size);
+}
+
+double dot_vec_double(const vec_double* x, const vec_double* y) {
+
+    if (x == NULL || y == NULL || x->size != y->size) return (double)NAN;
+    return dot_f64(x->array, y->array, x->size);
+}
+
+float sum_vec_float(const vec_float* x) { return x == NULL ? NAN : sum_f32(x->array, x->size); }
+double sum_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : sum_f64(x->array, x->size); }
+
+float norm1_vec_float(const vec_float* x) { return x == NULL ? NAN : norm1_f32(x->array, x->size); }
+float norm2_vec_float(const vec_float* x) { return x == NULL ? NAN : norm2_f32(x->array, x->size); }
+float normi_vec_float(const vec_float* x) { return x == NULL ? NAN : normi_f32(x->array, x->size); }
+double norm1_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : norm1_f64(x->array, x->size); }
+double norm2_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : norm2_f64(x->array, x->size); }
+double normi_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : normi_f64(x->array, x->size); }
+
+float stable_sum_vec_float(const vec_float* x) { return x == NULL ? NAN : stable_sum_f32(x->array, x->size); }
+double stable_sum_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : stable_sum_f64(x->array, x->size); }
+
+float mean_vec_float(const vec_float* x) { return x == NULL ? NAN : mean_f32(x->array, x->size); }
+double mean_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : mean_f64(x->array, x->size); }
+
+float variance_vec_float(const vec_float* x, bool sample) { return x == NULL ? NAN : variance_f32(x->array, x->size, sample); }
+double variance_vec_double(const vec_double* x, bool sample) { return x == NULL ? (double)NAN : variance_f64(x->array, x->size, sample); }
+
+float min_vec_float(const vec_float* x) { return x == NULL ? NAN : min_f32(x->array, x->size); }
+float max_vec_float(const vec_float* x) { return x == NULL ? NAN : max_f32(x->array, x->size); }
+double min_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : min_f64(x->array, x->size); }
+double max_vec_double(const vec_double* x) { return x == NULL ? (double)NAN : max_f64(x->array, x->size); }
+
+size_t argmin_vec_float(const vec_float* x) { return x == NULL ? SIZE_MAX : argmin_f32(x->array, x->size); }
+size_t argmax_vec_float(const vec_float* x) { return x == NULL ? SIZE_MAX : argmax_f32(x->array, x->size); }
+size_t argmin_vec_double(const vec_double* x) { return x == NULL ? SIZE_MAX : argmin_f64(x->array, x->size); }
+size_t argmax_vec_double(const vec_double* x) { return x == NULL ? SIZE_MAX : argmax_f64(x->array, x->size); }
+
+bool axpy_vec_float(vec_float* y, float a, const vec_float* x) {
+
+    if (x == NULL || y == NULL || x->size != y->size) return false;
+
+    // Written in place behind the index's back
+    drop_index_vec(y);
+    axpy_f32(x->size, a, x->array, y->array);
+    return true;
+}
+
+bool axpy_vec_double(vec_double* y, double a, const vec_double* x) {
+
+    if (x == NULL || y == NULL || x->size != y->size) return false;
+
+    // Written in place behind the index's back
+    drop_index_vec(y);
+    axpy_f64(x->size, a, x->array, y->array);
+    return true;
+}
+
+bool scale_vec_float(vec_float* x, float a) {
+
+    if (x == NULL) return false;
+
+    // Written in place behind the index's back
+    drop_index_vec(x);
+    scale_f32(x->size, a, x->array);
+    return true;
+}
+
+bool scale_vec_double(vec_double* x, double a) {
+
+    if (x == NULL) return false;
+
+    // Written in place behind the index's back
+    drop_index_vec(x);
+    scale_f64(x->size, a, x->array);
+    return true;
+}
+
+/**
+ * @brief Sizes out to n components for an element-wise op.
+ *
+ * @return bool
+ */
+static bool prepare_out(void* out, size_t n, size_t data_size) {
+
+    vec_void* vout = (vec_void*)out;
+    if (!reserve_vec(vout, n, data_size)) return false;
+    vout->size = n;
+
+    // Written in place behind the index's back
+    drop_index_vec(vout);
+
+    return true;
+}
+
+/**
+ * @brief Checks the operands of an element-wise op and sizes out to match.
+ *
+ * @return bool
+ */
+static bool prepare_elementwise(void* out, const void* x, const void* y, size_t data_size) {
+
+    if (out == NULL || x == NULL || y == NULL) return false;
+
+    const vec_void* vx = (const vec_void*)x;
+    const vec_void* vy = (const vec_void*)y;
+    if (vx->size != vy->size) return false;
+
+    return prepare_out(out, vx->size, data_size);
+}
+
+#define ELEMENTWISE_VEC(name, vec_t, kernel, T) \
+bool name(vec_t* out, const vec_t* x, const vec_t* y) { \
+    if (!prepare_elementwise(out, x, y, sizeof(T))) return false; \
+    kernel(x->size, x->array, y->array, out->array); \
+    return true; \
+}
+
+ELEMENTWISE_VEC(add_vec_float, vec_float, add_f32, float)
+ELEMENTWISE_VEC(sub_vec_float, vec_float, sub_f32, float)
+ELEMENTWISE_VEC(mul_vec_float, vec_float, mul_f32, float)
+ELEMENTWISE_VEC(add_vec_double, vec_double, add_f64, double)
+ELEMENTWISE_VEC(sub_vec_double, vec_double, sub_f64, double)
+ELEMENTWISE_VEC(mul_vec_double, vec_double, mul_f64, double)
+
+// ===================== VIEWS =====================
+
+// Component i of view w
+#define AT(w, i) ((w).data[(i) * (w).stride])
+
+/**
+ * @brief Stamps out the view operations of one component type. Contiguous
+ * views go straight to the raw kernels (and the thread pool); strided
+ * ones fall back to a scalar loop. K is the raw kernel suffix.
+ */
+#define DEFINE_VIEW_OPS(T, S, K, ABS, SQRT) \
+T dot_view_##S(view_##S x, view_##S y) { \
+    if (x.stride == 0 || y.stride == 0 || x.size != y.size) return (T)NAN; \
+    if (x.stride == 1 && y.stride == 1) return dot_##K(x.data, y.data, x.size); \
+    T sum = 0; \
+    for (size_t i = 0; i < x.size; i++) sum += AT(x, i) * AT(y, i); \
+    return sum; \
+} \
+\
+T sum_view_##S(view_##S x) { \
+    if (x.stride == 0) return (T)NAN; \
+    if (x.stride == 1) return sum_##K(x.data, x.size); \
+    T sum = 0; \
+    for (size_t i = 0; i < x.size; i++) sum += AT(x, i); \
+    return sum; \
+} \
+\
+T norm1_view_##S(view_##S x) { \
+    if (x.stride == 0) return (T)NAN; \
+    if (x.stride == 1) return norm1_##K(x.data, x.size); \
+    T sum = 0; \
+    for (size_t i = 0; i < x.size; i++) sum += ABS(AT(x, i)); \
+    return sum; \
+} \
+\
+T norm2_view_##S(view_##S x) { \
+    return SQRT(dot_view_##S(x, x)); \
+} \
+\
+T normi_view_##S(view_##S x) { \
+    if (x.stride == 0) return (T)NAN; \
+    if (x.stride == 1) return normi_##K(x.data, x.size); \
+    T max = 0; \
+    for (size_t i = 0; i < x.size; i++) if (ABS(AT(x, i)) > max) max = ABS(AT(x, i)); \
+    return max; \
+} \
+\
+bool axpy_view_##S(vec_##S* y, T a, view_##S x) { \
+    if (y == NULL || x.stride == 0 || x.size != y->size) return false; \
+    drop_index_vec(y); \
+    if (x.stride == 1) axpy_##K(x.size, a, x.data, y->array); \
+    else for (size_t i = 0; i < x.size; i++) y->array[i] += a * AT(x, i); \
+    return true; \
+}
+
+#define ELEMENTWISE_VIEW(name, S, T, kernel, op) \
+bool name(vec_##S* out, view_##S x, view_##S y) { \
+    if (out == NULL || x.stride == 0 || y.stride == 0 || x.size != y.size) return false; \
+    if (!prepare_out(out, x.size, sizeof(T))) return false; \
+    if (x.stride == 1 && y.stride == 1) kernel(x.size, x.data, y.data, out->array); \
+    else for (size_t i = 0; i < x.size; i++) out->array[i] = AT(x, i) op AT(y, i); \
+    return true; \
+}
+
+DEFINE_VIEW_OPS(float, float, f32, fabsf, sqrtf)
+DEFINE_VIEW_OPS(double, double, f64, fabs, sqrt)
+
+ELEMENTWISE_VIEW(add_view_float, float, float, add_f32, +)
+ELEMENTWISE_VIEW(sub_view_float, float, float, sub_f32, -)
+ELEMENTWISE_VIEW(mul_view_float, float, float, mul_f32, *)
+ELEMENTWISE_VIEW(add_view_double, double, double, add_f64, +)
+ELEMENTWISE_VIEW(sub_view_double, double, double, sub_f64, -)
+ELEMENTWISE_VIEW(mul_view_double, double, double, mul_f64, *)
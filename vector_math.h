@@ -0,0 +1,264 @@
+/**
+ * @file vector_math.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Level-1 arithmetic for vec_float and vec_double: dot product,
+ * norms, AXPY, scaling, element-wise add/sub/mul and reproducible
+ * statistics (compensated sum, mean, variance, min/max, argmin/argmax). Every operation runs
+ * through SSE2/AVX2/AVX-512 kernels picked at load time with CPUID, with
+ * a scalar fallback for everything else. Calls on at least
+ * get_parallel_threshold() components are split across the thread pool;
+ * reductions give the same result whatever the thread count.
+ * @version 0.1
+ * @date 2022-07-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include "vector.h"
+#include "vector_view.h"
+#include "simd.h"
+
+// ===================== DISPATCH =====================
+
+/**
+ * @brief The instruction set the kernels currently use. Defaults to the
+ * best one the CPU (and OS) supports.
+ *
+ * @return simd_level
+ */
+simd_level get_simd_level(void);
+
+/**
+ * @brief Highest instruction set this CPU supports.
+ *
+ * @return simd_level
+ */
+simd_level max_simd_level(void);
+
+/**
+ * @brief Forces the kernels down to level (for testing and benchmarking).
+ * Levels above max_simd_level() are clamped. Not thread-safe, call it
+ * while no other thread is running vector math.
+ *
+ * @param level Requested instruction set.
+ * @return simd_level The level actually in use.
+ */
+simd_level set_simd_level(simd_level level);
+
+// ===================== RAW KERNELS =====================
+
+/**
+ * @brief Kernels over plain arrays of n components, for code that
+ * manages its own storage. Same semantics as the vec_* versions below.
+ */
+float dot_f32(const float* x, const float* y, size_t n);
+float sum_f32(const float* x, size_t n);
+float norm1_f32(const float* x, size_t n);
+float norm2_f32(const float* x, size_t n);
+float normi_f32(const float* x, size_t n);
+void axpy_f32(size_t n, float a, const float* x, float* y);
+void scale_f32(size_t n, float a, float* x);
+void add_f32(size_t n, const float* x, const float* y, float* out);
+void sub_f32(size_t n, const float* x, const float* y, float* out);
+void mul_f32(size_t n, const float* x, const float* y, float* out);
+
+double dot_f64(const double* x, const double* y, size_t n);
+double sum_f64(const double* x, size_t n);
+double norm1_f64(const double* x, size_t n);
+double norm2_f64(const double* x, size_t n);
+double normi_f64(const double* x, size_t n);
+void axpy_f64(size_t n, double a, const double* x, double* y);
+void scale_f64(size_t n, double a, double* x);
+void add_f64(size_t n, const double* x, const double* y, double* out);
+void sub_f64(size_t n, const double* x, const double* y, double* out);
+void mul_f64(size_t n, const double* x, const double* y, double* out);
+
+float stable_sum_f32(const float* x, size_t n);
+float mean_f32(const float* x, size_t n);
+float variance_f32(const float* x, size_t n, bool sample);
+float min_f32(const float* x, size_t n);
+float max_f32(const float* x, size_t n);
+size_t argmin_f32(const float* x, size_t n);
+size_t argmax_f32(const float* x, size_t n);
+
+double stable_sum_f64(const double* x, size_t n);
+double mean_f64(const double* x, size_t n);
+double variance_f64(const double* x, size_t n, bool sample);
+double min_f64(const double* x, size_t n);
+double max_f64(const double* x, size_t n);
+size_t argmin_f64(const double* x, size_t n);
+size_t argmax_f64(const double* x, size_t n);
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Dot product of x and y.
+ *
+ * @param x Vector.
+ * @param y Vector, y->size == x->size.
+ * @return float | NAN if either is NULL or the sizes differ.
+ */
+float dot_vec_float(const vec_float* x, const vec_float* y);
+double dot_vec_double(const vec_double* x, const vec_double* y);
+
+/**
+ * @brief Sum of the components of x.
+ *
+ * @param x Vector.
+ * @return float | NAN if x == NULL.
+ */
+float sum_vec_float(const vec_float* x);
+double sum_vec_double(const vec_double* x);
+
+/**
+ * @brief L1 (sum of |x_i|), L2 (Euclidean) and L-infinity (max |x_i|)
+ * norms of x.
+ *
+ * @param x Vector.
+ * @return float | NAN if x == NULL.
+ */
+float norm1_vec_float(const vec_float* x);
+float norm2_vec_float(const vec_float* x);
+float normi_vec_float(const vec_float* x);
+double norm1_vec_double(const vec_double* x);
+double norm2_vec_double(const vec_double* x);
+double normi_vec_double(const vec_double* x);
+
+/**
+ * @brief y += a * x, in place.
+ *
+ * @param y Vector to be updated.
+ * @param a Scalar.
+ * @param x Vector, x->size == y->size.
+ * @return bool
+ */
+bool axpy_vec_float(vec_float* y, float a, const vec_float* x);
+bool axpy_vec_double(vec_double* y, double a, const vec_double* x);
+
+/**
+ * @brief x *= a, in place.
+ *
+ * @param x Vector to be scaled.
+ * @param a Scalar.
+ * @return bool
+ */
+bool scale_vec_float(vec_float* x, float a);
+bool scale_vec_double(vec_double* x, double a);
+
+/**
+ * @brief Element-wise out = x + y, x - y and x * y. out is resized to
+ * x->size (it may be x or y itself).
+ *
+ * @param out Result vector. Fails if it is fixed_length and too small.
+ * @param x Vector.
+ * @param y Vector, y->size == x->size.
+ * @return bool
+ */
+bool add_vec_float(vec_float* out, const vec_float* x, const vec_float* y);
+bool sub_vec_float(vec_float* out, const vec_float* x, const vec_float* y);
+bool mul_vec_float(vec_float* out, const vec_float* x, const vec_float* y);
+bool add_vec_double(vec_double* out, const vec_double* x, const vec_double* y);
+bool sub_vec_double(vec_double* out, const vec_double* x, const vec_double* y);
+bool mul_vec_double(vec_double* out, const vec_double* x, const vec_double* y);
+
+// ===================== STATISTICS =====================
+
+/**
+ * @brief The statistics below are reproducible: x is always cut into the
+ * same blocks, summed with Kahan compensation on every SIMD lane, and the
+ * block results are combined in the same pairwise tree no matter how many
+ * threads computed them. Results are bit-identical for any thread count
+ * (they may still differ in the last bits between SIMD levels).
+ */
+
+/**
+ * @brief Compensated sum of the components of x. Slower than
+ * sum_vec_float, but its error does not grow with x->size.
+ *
+ * @param x Vector.
+ * @return float | NAN if x == NULL.
+ */
+float stable_sum_vec_float(const vec_float* x);
+double stable_sum_vec_double(const vec_double* x);
+
+/**
+ * @brief Mean of the components of x.
+ *
+ * @param x Vector.
+ * @return float | NAN if x is NULL or empty.
+ */
+float mean_vec_float(const vec_float* x);
+double mean_vec_double(const vec_double* x);
+
+/**
+ * @brief Variance of the components of x, computed in two passes (mean,
+ * then compensated sum of squared deviations) so it does not cancel
+ * catastrophically when the mean is large.
+ *
+ * @param x Vector.
+ * @param sample Divide by size - 1 (sample variance) instead of size.
+ * @return float | NAN if x is NULL, empty, or has one component and
+ * sample is set.
+ */
+float variance_vec_float(const vec_float* x, bool sample);
+double variance_vec_double(const vec_double* x, bool sample);
+
+/**
+ * @brief Smallest and largest component of x. NaN components are skipped.
+ *
+ * @param x Vector.
+ * @return float | NAN if x is NULL, empty or all NaN.
+ */
+float min_vec_float(const vec_float* x);
+float max_vec_float(const vec_float* x);
+double min_vec_double(const vec_double* x);
+double max_vec_double(const vec_double* x);
+
+/**
+ * @brief Index of the smallest and largest component of x, the first one
+ * on ties (-0 and +0 tie). NaN components are skipped.
+ *
+ * @param x Vector.
+ * @return size_t | SIZE_MAX if x is NULL, empty or all NaN.
+ */
+size_t argmin_vec_float(const vec_float* x);
+size_t argmax_vec_float(const vec_float* x);
+size_t argmin_vec_double(const vec_double* x);
+size_t argmax_vec_double(const vec_double* x);
+
+// ===================== VIEWS =====================
+
+/**
+ * @brief The operations above on views (see vector_view.h), so slices,
+ * strided components and matrix rows or columns need no copy. Contiguous
+ * views run the same kernels as vectors; strided ones a scalar loop.
+ * The reductions return NAN and the rest false on an invalid view or a
+ * size mismatch. axpy_view writes y, the element-wise ops size out like
+ * their vector versions; the views read must not overlap what is written
+ * unless they are exactly the same components.
+ */
+float dot_view_float(view_float x, view_float y);
+float sum_view_float(view_float x);
+float norm1_view_float(view_float x);
+float norm2_view_float(view_float x);
+float normi_view_float(view_float x);
+bool axpy_view_float(vec_float* y, float a, view_float x);
+bool add_view_float(vec_float* out, view_float x, view_float y);
+bool sub_view_float(vec_float* out, view_float x, view_float y);
+bool mul_view_float(vec_float* out, view_float x, view_float y);
+
+double dot_view_double(view_double x, view_double y);
+double sum_view_double(view_double x);
+double norm1_view_double(view_double x);
+double norm2_view_double(view_double x);
+double normi_view_double(view_double x);
+bool axpy_view_double(vec_double* y, double a, view_double x);
+bool add_view_double(vec_double* out, view_double x, view_double y);
+bool sub_view_double(vec_double* out, view_double x, view_double y);
+bool mul_view_double(vec_double* out, view_double x, view_double y);
+
+#endif
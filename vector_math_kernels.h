@@ -0,0 +1,308 @@
+/**
+ * @file vector_math_kernels.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Level-1 kernel template, NOT a regular header. vector_math.c
+ * includes it once per (component type, instruction set) pair after
+ * defining the macros below, so every ISA shares the same loop structure:
+ *
+ * - T, VT, W: scalar type, SIMD register type and lanes per register.
+ * - SUFFIX: appended to every generated function name.
+ * - ATTR: function attributes (e.g. the target ISA).
+ * - VLOAD, VSTORE, VSET1, VZERO: unaligned load/store, broadcast, zero.
+ * - VADD, VSUB, VMUL, VMAX, VMIN, VABS, VFMA(a, b, c) = a * b + c.
+ *   VMAX(a, b) and VMIN(a, b) must give b when either is NaN.
+ * - VHSUM, VHMAX, VHMIN: horizontal sum, maximum and minimum back to a T.
+ * - SABS: scalar absolute value for the tails.
+ *
+ * The macros are #undef'd at the end so the next instantiation starts clean.
+ * @version 0.1
+ * @date 2022-07-02
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#define KCAT_(a, b) a##_##b
+#define KCAT(a, b) KCAT_(a, b)
+#define KFN(name) KCAT(name, SUFFIX)
+
+// Four independent accumulators hide the add latency of the reductions
+#define UNROLL (4 * W)
+
+static ATTR T KFN(dot)(const T* x, const T* y, size_t n) {
+
+    VT acc0 = VZERO(), acc1 = VZERO(), acc2 = VZERO(), acc3 = VZERO();
+    size_t i = 0;
+
+    for (; i + UNROLL <= n; i += UNROLL) {
+
+        acc0 = VFMA(VLOAD(x + i), VLOAD(y + i), acc0);
+        acc1 = VFMA(VLOAD(x + i + W), VLOAD(y + i + W), acc1);
+        acc2 = VFMA(VLOAD(x + i + 2 * W), VLOAD(y + i + 2 * W), acc2);
+        acc3 = VFMA(VLOAD(x + i + 3 * W), VLOAD(y + i + 3 * W), acc3);
+    }
+
+    for (; i + W <= n; i += W)
+        acc0 = VFMA(VLOAD(x + i), VLOAD(y + i), acc0);
+
+    T sum = VHSUM(VADD(VADD(acc0, acc1), VADD(acc2, acc3)));
+    for (; i < n; i++) sum += x[i] * y[i];
+
+    return sum;
+}
+
+static ATTR T KFN(sum)(const T* x, size_t n) {
+
+    VT acc0 = VZERO(), acc1 = VZERO(), acc2 = VZERO(), acc3 = VZERO();
+    size_t i = 0;
+
+    for (; i + UNROLL <= n; i += UNROLL) {
+
+        acc0 = VADD(VLOAD(x + i), acc0);
+        acc1 = VADD(VLOAD(x + i + W), acc1);
+        acc2 = VADD(VLOAD(x + i + 2 * W), acc2);
+        acc3 = VADD(VLOAD(x + i + 3 * W), acc3);
+    }
+
+    for (; i + W <= n; i += W)
+        acc0 = VADD(VLOAD(x + i), acc0);
+
+    T sum = VHSUM(VADD(VADD(acc0, acc1), VADD(acc2, acc3)));
+    for (; i < n; i++) sum += x[i];
+
+    return sum;
+}
+
+static ATTR T KFN(norm1)(const T* x, size_t n) {
+
+    VT acc0 = VZERO(), acc1 = VZERO(), acc2 = VZERO(), acc3 = VZERO();
+    size_t i = 0;
+
+    for (; i + UNROLL <= n; i += UNROLL) {
+
+        acc0 = VADD(VABS(VLOAD(x + i)), acc0);
+        acc1 = VADD(VABS(VLOAD(x + i + W)), acc1);
+        acc2 = VADD(VABS(VLOAD(x + i + 2 * W)), acc2);
+        acc3 = VADD(VABS(VLOAD(x + i + 3 * W)), acc3);
+    }
+
+    for (; i + W <= n; i += W)
+        acc0 = VADD(VABS(VLOAD(x + i)), acc0);
+
+    T sum = VHSUM(VADD(VADD(acc0, acc1), VADD(acc2, acc3)));
+    for (; i < n; i++) sum += SABS(x[i]);
+
+    return sum;
+}
+
+static ATTR T KFN(normi)(const T* x, size_t n) {
+
+    VT acc0 = VZERO(), acc1 = VZERO();
+    size_t i = 0;
+
+    for (; i + 2 * W <= n; i += 2 * W) {
+
+        acc0 = VMAX(VABS(VLOAD(x + i)), acc0);
+        acc1 = VMAX(VABS(VLOAD(x + i + W)), acc1);
+    }
+
+    for (; i + W <= n; i += W)
+        acc0 = VMAX(VABS(VLOAD(x + i)), acc0);
+
+    T max = VHMAX(VMAX(acc0, acc1));
+    for (; i < n; i++)
+        if (SABS(x[i]) > max) max = SABS(x[i]);
+
+    return max;
+}
+
+// Kahan step on every lane: s += v, with the rounding error carried in c
+#define KAHAN(s, c, v) do { \
+    VT y_ = VSUB((v), (c)); \
+    VT t_ = VADD((s), y_); \
+    (c) = VSUB(VSUB(t_, (s)), y_); \
+    (s) = t_; \
+} while (0)
+
+static inline T KFN(kahan)(T s, T* c, T v) {
+
+    T y = v - *c;
+    T t = s + y;
+    *c = (t - s) - y;
+    return t;
+}
+
+// Folds two lane-wise Kahan accumulators into one scalar pair, lane by lane
+// in a fixed order, and returns the running sum with its error in err
+static ATTR T KFN(kfold)(VT s0, VT c0, VT s1, VT c1, T* err) {
+
+    T s[2 * W], c[2 * W];
+    VSTORE(s, s0);
+    VSTORE(s + W, s1);
+    VSTORE(c, c0);
+    VSTORE(c + W, c1);
+
+    T sum = 0;
+    *err = 0;
+    for (size_t k = 0; k < 2 * W; k++) {
+
+        sum = KFN(kahan)(sum, err, s[k]);
+        sum = KFN(kahan)(sum, err, -c[k]);
+    }
+
+    return sum;
+}
+
+// Compensated sum of x
+static ATTR T KFN(ksum)(const T* x, size_t n) {
+
+    VT s0 = VZERO(), c0 = VZERO(), s1 = VZERO(), c1 = VZERO();
+    size_t i = 0;
+
+    for (; i + 2 * W <= n; i += 2 * W) {
+
+        KAHAN(s0, c0, VLOAD(x + i));
+        KAHAN(s1, c1, VLOAD(x + i + W));
+    }
+
+    T err;
+    T sum = KFN(kfold)(s0, c0, s1, c1, &err);
+    for (; i < n; i++) sum = KFN(kahan)(sum, &err, x[i]);
+
+    return sum - err;
+}
+
+// Compensated sum of (x_i - mean)^2
+static ATTR T KFN(kdev2)(const T* x, size_t n, T mean) {
+
+    VT vm = VSET1(mean);
+    VT s0 = VZERO(), c0 = VZERO(), s1 = VZERO(), c1 = VZERO();
+    size_t i = 0;
+
+    for (; i + 2 * W <= n; i += 2 * W) {
+
+        VT d0 = VSUB(VLOAD(x + i), vm);
+        VT d1 = VSUB(VLOAD(x + i + W), vm);
+        KAHAN(s0, c0, VMUL(d0, d0));
+        KAHAN(s1, c1, VMUL(d1, d1));
+    }
+
+    T err;
+    T sum = KFN(kfold)(s0, c0, s1, c1, &err);
+    for (; i < n; i++) sum = KFN(kahan)(sum, &err, (x[i] - mean) * (x[i] - mean));
+
+    return sum - err;
+}
+
+// Smallest and largest non-NaN component, +/-INFINITY if there is none.
+// x is always the first operand, so a NaN x leaves the accumulator alone
+static ATTR T KFN(min)(const T* x, size_t n) {
+
+    VT acc0 = VSET1((T)INFINITY), acc1 = acc0;
+    size_t i = 0;
+
+    for (; i + 2 * W <= n; i += 2 * W) {
+
+        acc0 = VMIN(VLOAD(x + i), acc0);
+        acc1 = VMIN(VLOAD(x + i + W), acc1);
+    }
+
+    for (; i + W <= n; i += W)
+        acc0 = VMIN(VLOAD(x + i), acc0);
+
+    T min = VHMIN(VMIN(acc0, acc1));
+    for (; i < n; i++)
+        if (x[i] < min) min = x[i];
+
+    return min;
+}
+
+static ATTR T KFN(max)(const T* x, size_t n) {
+
+    VT acc0 = VSET1(-(T)INFINITY), acc1 = acc0;
+    size_t i = 0;
+
+    for (; i + 2 * W <= n; i += 2 * W) {
+
+        acc0 = VMAX(VLOAD(x + i), acc0);
+        acc1 = VMAX(VLOAD(x + i + W), acc1);
+    }
+
+    for (; i + W <= n; i += W)
+        acc0 = VMAX(VLOAD(x + i), acc0);
+
+    T max = VHMAX(VMAX(acc0, acc1));
+    for (; i < n; i++)
+        if (x[i] > max) max = x[i];
+
+    return max;
+}
+
+static ATTR void KFN(axpy)(size_t n, T a, const T* x, T* y) {
+
+    VT va = VSET1(a);
+    size_t i = 0;
+
+    for (; i + 2 * W <= n; i += 2 * W) {
+
+        VSTORE(y + i, VFMA(va, VLOAD(x + i), VLOAD(y + i)));
+        VSTORE(y + i + W, VFMA(va, VLOAD(x + i + W), VLOAD(y + i + W)));
+    }
+
+    for (; i + W <= n; i += W)
+        VSTORE(y + i, VFMA(va, VLOAD(x + i), VLOAD(y + i)));
+
+    for (; i < n; i++) y[i] += a * x[i];
+}
+
+static ATTR void KFN(scale)(size_t n, T a, T* x) {
+
+    VT va = VSET1(a);
+    size_t i = 0;
+
+    for (; i + W <= n; i += W)
+        VSTORE(x + i, VMUL(va, VLOAD(x + i)));
+
+    for (; i < n; i++) x[i] *= a;
+}
+
+// Element-wise out = x (op) y, out may alias x or y
+#define KERNEL_ELEMENTWISE(name, VOP, op) \
+static ATTR void KFN(name)(size_t n, const T* x, const T* y, T* out) { \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) \
+        VSTORE(out + i, VOP(VLOAD(x + i), VLOAD(y + i))); \
+    for (; i < n; i++) out[i] = x[i] op y[i]; \
+}
+
+KERNEL_ELEMENTWISE(add, VADD, +)
+KERNEL_ELEMENTWISE(sub, VSUB, -)
+KERNEL_ELEMENTWISE(mul, VMUL, *)
+
+#undef KERNEL_ELEMENTWISE
+#undef KAHAN
+#undef UNROLL
+#undef KFN
+#undef KCAT
+#undef KCAT_
+
+#undef T
+#undef VT
+#undef W
+#undef SUFFIX
+#undef ATTR
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VZERO
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VMAX
+#undef VMIN
+#undef VABS
+#undef VFMA
+#undef VHSUM
+#undef VHMAX
+#undef VHMIN
+#undef SABS
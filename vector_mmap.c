@@ -0,0 +1,311 @@
+/**
+ * Vectors stored in files and mapped into memory.
+ * The whole file is one shared mapping: header page, then the components.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_mmap.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define VEC_FILE_BYTE_ORDER 0x01020304u
+
+_Static_assert(sizeof(vec_file_header) <= VEC_FILE_ALIGNMENT, "vector file header must fit in front of the data");
+
+// Bytes per component of every vec_type
+static const size_t type_sizes[] = { sizeof(char), sizeof(int32_t), sizeof(int64_t), sizeof(float), sizeof(double) };
+
+#define VEC_TYPES (sizeof(type_sizes) / sizeof(type_sizes[0]))
+
+// ===================== HELPERS =====================
+
+static vec_file_header* header_of(vec_file* f) {
+    return (vec_file_header*)f->base;
+}
+
+/**
+ * @brief Bytes of a file with capacity components of data_size bytes.
+ *
+ * @return size_t 0 on overflow.
+ */
+static size_t file_length(size_t capacity, size_t data_size) {
+
+    if (capacity > (SIZE_MAX - VEC_FILE_ALIGNMENT) / data_size) return 0;
+    return VEC_FILE_ALIGNMENT + capacity * data_size;
+}
+
+static void* map_file(int fd, size_t length, bool writable) {
+
+    void* base = mmap(NULL, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    return base == MAP_FAILED ? NULL : base;
+}
+
+/**
+ * @brief Wraps an open, mapped file in a vec_file and its vector. Takes
+ * over fd and base either way.
+ *
+ * @return vec_file* | NULL (fd closed and base unmapped).
+ */
+static vec_file* wrap(int fd, void* base, size_t length, bool writable) {
+
+    const vec_file_header* h = (const vec_file_header*)base;
+    vec_file* f = malloc(sizeof(vec_file));
+    vec_void* v = init_vec(0, h->data_size, true);
+
+    if (f == NULL || v == NULL) {
+
+        free(f);
+        free_vec(v);
+        munmap(base, length);
+        close(fd);
+        return NULL;
+    }
+
+    // The array is the mapping: resizing it is up to this file
+    v->array = (char*)base + h->data_offset;
+    v->size = (size_t)h->size;
+    v->capacity = (size_t)h->capacity;
+    v->pool_class = VEC_POOL_MAPPED;
+
+    f->vec = v;
+    f->type = (vec_type)h->type;
+    f->writable = writable;
+    f->fd = fd;
+    f->base = base;
+    f->length = length;
+
+    return f;
+}
+
+/**
+ * @brief Whether h describes a vector file of file_size bytes this build
+ * can map.
+ *
+ * @return bool
+ */
+static bool valid_header(const vec_file_header* h, size_t file_size) {
+
+    if (memcmp(h->magic, VEC_FILE_MAGIC, sizeof(h->magic)) != 0) return false;
+    if (h->version != VEC_FILE_VERSION || h->byte_order != VEC_FILE_BYTE_ORDER) return false;
+    if (h->type >= VEC_TYPES || h->data_size != type_sizes[h->type]) return false;
+    if (h->data_offset != VEC_FILE_ALIGNMENT || h->size > h->capacity) return false;
+
+    size_t length = file_length((size_t)h->capacity, h->data_size);
+    return length != 0 && length <= file_size;
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Creates (or truncates) the file at path as an empty vector of
+ * type with room for capacity components, and opens it for writing.
+ *
+ * @param path File to create.
+ * @param type Component type.
+ * @param capacity Components to make room for (may be 0).
+ * @return vec_file* | NULL if the file could not be created or mapped.
+ */
+vec_file* create_vec_file(const char* path, vec_type type, size_t capacity) {
+
+    if (path == NULL || (size_t)type >= VEC_TYPES) return NULL;
+
+    size_t length = file_length(capacity, type_sizes[type]);
+    if (length == 0 || length > (size_t)INT64_MAX) return NULL;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+
+    // Sparse: the components cost no disk until they are written
+    void* base = ftruncate(fd, (off_t)length) == 0 ? map_file(fd, length, true) : NULL;
+    if (base == NULL) {
+
+        close(fd);
+        return NULL;
+    }
+
+    vec_file_header* h = (vec_file_header*)base;
+    memcpy(h->magic, VEC_FILE_MAGIC, sizeof(h->magic));
+    h->version = VEC_FILE_VERSION;
+    h->byte_order = VEC_FILE_BYTE_ORDER;
+    h->type = (uint32_t)type;
+    h->data_size = (uint32_t)type_sizes[type];
+    h->size = 0;
+    h->capacity = capacity;
+    h->data_offset = VEC_FILE_ALIGNMENT;
+
+    return wrap(fd, base, length, true);
+}
+
+/**
+ * @brief Maps an existing vector file. Nothing but the header is read.
+ *
+ * @param path File to open.
+ * @param writable Map it for writing (and growing) too.
+ * @return vec_file* | NULL if it cannot be opened, is not a vector file,
+ * has another version or byte order, or is shorter than its header says.
+ */
+vec_file* open_vec_file(const char* path, bool writable) {
+
+    if (path == NULL) return NULL;
+
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    vec_file_header h;
+    if (fstat(fd, &st) != 0 || st.st_size < VEC_FILE_ALIGNMENT ||
+        pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || !valid_header(&h, (size_t)st.st_size)) {
+
+        close(fd);
+        return NULL;
+    }
+
+    // Map only what the header covers, anything after it is not ours
+    size_t length = file_length((size_t)h.capacity, h.data_size);
+    void* base = map_file(fd, length, writable);
+    if (base == NULL) {
+
+        close(fd);
+        return NULL;
+    }
+
+    return wrap(fd, base, length, writable);
+}
+
+/**
+ * @brief Makes sure the file has room for at least capacity components,
+ * growing it and remapping. Never shrinks. f->vec->array may move, and
+ * views or pointers into it are invalidated when it does.
+ *
+ * @param f Writable vector file.
+ * @param capacity Minimum number of components.
+ * @return false if f is NULL or read-only, or the file could not grow
+ * (f is left unchanged).
+ */
+bool reserve_vec_file(vec_file* f, size_t capacity) {
+
+    if (f == NULL || !f->writable) return false;
+
+    vec_void* v = (vec_void*)f->vec;
+    if (capacity <= v->capacity) return true;
+
+    size_t length = file_length(capacity, type_sizes[f->type]);
+    if (length == 0 || length > (size_t)INT64_MAX) return false;
+    if (ftruncate(f->fd, (off_t)length) != 0) return false;
+
+    // Map the grown file before letting go of the old mapping
+    void* base = map_file(f->fd, length, true);
+    if (base == NULL) {
+
+        // Best effort: a longer file is harmless, the header says what is ours
+        (void)ftruncate(f->fd, (off_t)f->length);
+        return false;
+    }
+
+    munmap(f->base, f->length);
+    f->base = base;
+    f->length = length;
+
+    header_of(f)->capacity = capacity;
+    v->array = (char*)base + VEC_FILE_ALIGNMENT;
+    v->capacity = capacity;
+    v->stats.grows++;
+
+    return true;
+}
+
+/**
+ * @brief Appends count components, growing the file by f->vec's growth
+ * policy first if they do not fit (see reserve_vec_file).
+ *
+ * @param f Writable vector file.
+ * @param data count components back to back, not inside the file itself.
+ * @param count Number of components (may be 0).
+ * @return false if the file could not grow or the append failed.
+ */
+bool append_n_vec_file(vec_file* f, const void* data, size_t count) {
+
+    if (f == NULL || !f->writable) return false;
+
+    vec_void* v = (vec_void*)f->vec;
+    if (count > SIZE_MAX - v->size) return false;
+
+    size_t need = v->size + count;
+    if (need > v->capacity && !reserve_vec_file(f, policy_grow(v->policy, v->capacity, need))) return false;
+
+    return append_n_vec(v, data, count, type_sizes[f->type]);
+}
+
+/**
+ * @brief Tells the kernel how components [offset, offset + count) are
+ * about to be used. Page boundaries are rounded outwards. Purely a hint,
+ * the data is never changed.
+ *
+ * @param f Vector file.
+ * @param access See vec_access.
+ * @param offset First component.
+ * @param count Number of components, clamped to the capacity.
+ * @return false if f is NULL, the range is empty or madvise failed.
+ */
+bool advise_vec_file(vec_file* f, vec_access access, size_t offset, size_t count) {
+
+    static const int advice[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED };
+    if (f == NULL || (size_t)access >= sizeof(advice) / sizeof(advice[0])) return false;
+
+    size_t capacity = ((vec_void*)f->vec)->capacity;
+    if (offset >= capacity || count == 0) return false;
+    if (count > capacity - offset) count = capacity - offset;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t data_size = type_sizes[f->type];
+    size_t start = (VEC_FILE_ALIGNMENT + offset * data_size) / page * page;
+    size_t end = VEC_FILE_ALIGNMENT + (offset + count) * data_size;
+
+    return madvise((char*)f->base + start, end - start, advice[access]) == 0;
+}
+
+/**
+ * @brief Records f->vec->size in the header and flushes the dirty pages to
+ * disk, waiting for them if wait is true. A no-op for read-only files.
+ *
+ * @param f Vector file.
+ * @param wait msync with MS_SYNC instead of MS_ASYNC.
+ * @return false if f is NULL or msync failed.
+ */
+bool sync_vec_file(vec_file* f, bool wait) {
+
+    if (f == NULL) return false;
+    if (!f->writable) return true;
+
+    header_of(f)->size = ((vec_void*)f->vec)->size;
+    return msync(f->base, f->length, wait ? MS_SYNC : MS_ASYNC) == 0;
+}
+
+/**
+ * @brief Records the size (like sync_vec_file without waiting), unmaps
+ * and closes the file, and frees f and its vector.
+ *
+ * @param f Vector file, may be NULL.
+ * @return false if the size could not be recorded.
+ */
+bool close_vec_file(vec_file* f) {
+
+    if (f == NULL) return true;
+
+    bool ok = sync_vec_file(f, false);
+    munmap(f->base, f->length);
+    close(f->fd);
+
+    // Back to a plain, empty heap vector so free_vec takes it
+    vec_void* v = (vec_void*)f->vec;
+    v->array = NULL;
+    v->pool_class = 0;
+    free_vec(v);
+    free(f);
+
+    return ok;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file vector_mmap.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Vectors stored in files and mapped straight into memory. A vector
+ * file is one VEC_FILE_ALIGNMENT-byte header (component type, size,
+ * capacity, alignment) followed by the raw components. Opening one costs a
+ * single mmap no matter how big it is: pages are read in lazily as they are
+ * touched, written back by the kernel, and shared through the page cache
+ * with every other process mapping the same file.
+ * @version 0.1
+ * @date 2022-08-30
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_MMAP_H
+#define VECTOR_MMAP_H
+
+#include "vector.h"
+#include <stdint.h>
+
+// Header bytes in front of the components, a page so they are page-aligned
+#define VEC_FILE_ALIGNMENT 4096
+// First 8 bytes of every vector file and the layout version after them
+#define VEC_FILE_MAGIC "CATVEC\0\0"
+#define VEC_FILE_VERSION 1
+
+/**
+ * @brief The header at the start of every vector file. Components are
+ * stored in the byte order of the machine that wrote them; byte_order
+ * holds 0x01020304 as written there, so files from the other byte order
+ * are refused rather than misread.
+ */
+typedef struct vec_file_header {
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t type;
+    uint32_t data_size;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t data_offset;
+} vec_file_header;
+
+/**
+ * @brief Access pattern hints for advise_vec_file (madvise underneath).
+ * - VEC_ACCESS_NORMAL: Default readahead.
+ * - VEC_ACCESS_SEQUENTIAL: Aggressive readahead, pages dropped soon after use.
+ * - VEC_ACCESS_RANDOM: No readahead, only the pages touched are read.
+ * - VEC_ACCESS_WILLNEED: Start reading the range in now.
+ * - VEC_ACCESS_DONTNEED: Done with the range for now, its pages can go.
+ */
+typedef enum {
+
+    VEC_ACCESS_NORMAL,
+    VEC_ACCESS_SEQUENTIAL,
+    VEC_ACCESS_RANDOM,
+    VEC_ACCESS_WILLNEED,
+    VEC_ACCESS_DONTNEED
+} vec_access;
+
+/**
+ * @brief An open vector file containing the following:
+ * - void* vec: The vector, cast it to the vec_* of its type. Its array is
+ *   the mapping, so it is fixed_length: grow it with reserve_vec_file or
+ *   append_n_vec_file, never free_vec it (that is a no-op anyway).
+ * - vec_type type: Component type recorded in the file.
+ * - bool writable: Opened for writing; writing through a read-only one
+ *   faults.
+ * - int fd, void* base, size_t length: The file and its mapping.
+ */
+typedef struct vec_file {
+
+    void* vec;
+    vec_type type;
+    bool writable;
+    int fd;
+    void* base;
+    size_t length;
+} vec_file;
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Creates (or truncates) the file at path as an empty vector of
+ * type with room for capacity components, and opens it for writing.
+ *
+ * @param path File to create.
+ * @param type Component type.
+ * @param capacity Components to make room for (may be 0).
+ * @return vec_file* | NULL if the file could not be created or mapped.
+ */
+vec_file* create_vec_file(const char* path, vec_type type, size_t capacity);
+
+/**
+ * @brief Maps an existing vector file. Nothing but the header is read.
+ *
+ * @param path File to open.
+ * @param writable Map it for writing (and growing) too.
+ * @return vec_file* | NULL if it cannot be opened, is not a vector file,
+ * has another version or byte order, or is shorter than its header says.
+ */
+vec_file* open_vec_file(const char* path, bool writable);
+
+/**
+ * @brief Makes sure the file has room for at least capacity components,
+ * growing it and remapping. Never shrinks. f->vec->array may move, and
+ * views or pointers into it are invalidated when it does.
+ *
+ * @param f Writable vector file.
+ * @param capacity Minimum number of components.
+ * @return false if f is NULL or read-only, or the file could not grow
+ * (f is left unchanged).
+ */
+bool reserve_vec_file(vec_file* f, size_t capacity);
+
+/**
+ * @brief Appends count components, growing the file by f->vec's growth
+ * policy first if they do not fit (see reserve_vec_file).
+ *
+ * @param f Writable vector file.
+ * @param data count components back to back, not inside the file itself.
+ * @param count Number of components (may be 0).
+ * @return false if the file could not grow or the append failed.
+ */
+bool append_n_vec_file(vec_file* f, const void* data, size_t count);
+
+/**
+ * @brief Tells the kernel how components [offset, offset + count) are
+ * about to be used. Page boundaries are rounded outwards. Purely a hint,
+ * the data is never changed.
+ *
+ * @param f Vector file.
+ * @param access See vec_access.
+ * @param offset First component.
+ * @param count Number of components, clamped to the capacity.
+ * @return false if f is NULL, the range is empty or madvise failed.
+ */
+bool advise_vec_file(vec_file* f, vec_access access, size_t offset, size_t count);
+
+/**
+ * @brief Records f->vec->size in the header and flushes the dirty pages to
+ * disk, waiting for them if wait is true. A no-op for read-only files.
+ *
+ * @param f Vector file.
+ * @param wait msync with MS_SYNC instead of MS_ASYNC.
+ * @return false if f is NULL or msync failed.
+ */
+bool sync_vec_file(vec_file* f, bool wait);
+
+/**
+ * @brief Records the size (like sync_vec_file without waiting), unmaps
+ * and closes the file, and frees f and its vector.
+ *
+ * @param f Vector file, may be NULL.
+ * @return false if the size could not be recorded.
+ */
+bool close_vec_file(vec_file* f);
+
+#endif
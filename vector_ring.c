@@ -0,0 +1,197 @@
+/**
+ * Single-producer/single-consumer ring over a fixed_length vector.
+ * Only the owner of an index stores to it (release), the other side
+ * loads it (acquire) when its cached copy runs out.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_ring.h"
+#include <stdlib.h>
+#include <string.h>
+
+static size_t min_size(size_t a, size_t b) { return a < b ? a : b; }
+
+/**
+ * @brief Copies n components between the ring, starting at slot index
+ * pos (not yet masked), and a flat buffer. A run that wraps past the end
+ * of the vector takes two memcpy calls.
+ *
+ * @param in Copy buf into the ring, otherwise the ring into buf.
+ */
+static void copy_ring(const vec_ring* r, size_t pos, void* buf, size_t n, bool in) {
+
+    unsigned char* slots = (unsigned char*)r->vec->array;
+    unsigned char* flat = (unsigned char*)buf;
+    size_t at = pos & r->mask;
+    size_t first = min_size(n, r->mask + 1 - at);
+
+    if (in) {
+
+        memcpy(slots + at * r->data_size, flat, first * r->data_size);
+        memcpy(slots, flat + first * r->data_size, (n - first) * r->data_size);
+    }
+
+    else {
+
+        memcpy(flat, slots + at * r->data_size, first * r->data_size);
+        memcpy(flat + first * r->data_size, slots, (n - first) * r->data_size);
+    }
+}
+
+/**
+ * @brief Components the consumer may pop now, up to count. Reloads tail
+ * only if the cached one does not cover count.
+ */
+static size_t readable(vec_ring* r, size_t head, size_t count) {
+
+    if (r->tail_cache - head < count) r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+    return min_size(count, r->tail_cache - head);
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Creates an empty ring.
+ *
+ * @param data_size Size of one component.
+ * @param capacity Components it can hold, rounded up to a power of 2.
+ * @return NULL if either is 0, capacity is too big or allocation failed.
+ */
+vec_ring* init_vec_ring(size_t data_size, size_t capacity) {
+
+    if (data_size == 0 || capacity == 0 || capacity > (SIZE_MAX >> 1) + 1) return NULL;
+
+    size_t slots = 1;
+    while (slots < capacity) slots <<= 1;
+    if (slots > SIZE_MAX / data_size) return NULL;
+
+    vec_ring* r = aligned_alloc(VEC_RING_ALIGNMENT, sizeof(vec_ring));
+    if (r == NULL) return NULL;
+
+    r->vec = init_vec(slots, data_size, true);
+    if (r->vec == NULL) {
+
+        free(r);
+        return NULL;
+    }
+
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->tail_cache = 0;
+    r->head_cache = 0;
+    r->mask = slots - 1;
+    r->data_size = data_size;
+
+    return r;
+}
+
+/**
+ * @brief Producer only. Pushes as many of the count components from data
+ * as there is room for, in order.
+ *
+ * @return Components pushed, 0 if r or data is NULL or the ring is full.
+ */
+size_t push_n_vec_ring(vec_ring* r, const void* data, size_t count) {
+
+    if (r == NULL || data == NULL) return 0;
+
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t capacity = r->mask + 1;
+
+    if (capacity - (tail - r->head_cache) < count) r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+
+    size_t n = min_size(count, capacity - (tail - r->head_cache));
+    if (n == 0) return 0;
+
+    copy_ring(r, tail, (void*)data, n, true);
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    return n;
+}
+
+/**
+ * @brief Producer only. Pushes one component.
+ *
+ * @return false if r or data is NULL or the ring is full.
+ */
+bool push_vec_ring(vec_ring* r, const void* data) { return push_n_vec_ring(r, data, 1) == 1; }
+
+/**
+ * @brief Consumer only. Pops up to count components into out, oldest
+ * first.
+ *
+ * @return Components popped, 0 if r or out is NULL or the ring is empty.
+ */
+size_t pop_n_vec_ring(vec_ring* r, void* out, size_t count) {
+
+    if (r == NULL || out == NULL) return 0;
+
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t n = readable(r, head, count);
+    if (n == 0) return 0;
+
+    copy_ring(r, head, out, n, false);
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+/**
+ * @brief Consumer only. Pops one component.
+ *
+ * @return false if r or out is NULL or the ring is empty.
+ */
+bool pop_vec_ring(vec_ring* r, void* out) { return pop_n_vec_ring(r, out, 1) == 1; }
+
+/**
+ * @brief Consumer only. Pops up to count components onto the end of a
+ * regular vector of the same component size.
+ *
+ * @param out Any vec_* struct.
+ * @return Components moved, 0 if either is NULL, the ring is empty or out
+ * could not grow (the ring is then left unchanged).
+ */
+size_t drain_vec_ring(vec_ring* r, void* out, size_t count) {
+
+    if (r == NULL || out == NULL) return 0;
+
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t n = readable(r, head, count);
+    if (n == 0) return 0;
+
+    vec_void* v = (vec_void*)out;
+    if (n > v->capacity - v->size && !reserve_vec(v, policy_grow(v->policy, v->capacity, v->size + n), r->data_size))
+        return 0;
+
+    copy_ring(r, head, (unsigned char*)v->array + v->size * r->data_size, n, false);
+    v->size += n;
+    // Written in place behind the index's back
+    drop_index_vec(v);
+
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+/**
+ * @brief Components waiting. Exact from either side when the other one
+ * is idle, otherwise a snapshot that may already be stale.
+ *
+ * @return size_t
+ */
+size_t size_vec_ring(const vec_ring* r) {
+
+    if (r == NULL) return 0;
+
+    // head first: it never passes tail, so the difference cannot underflow
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    return atomic_load_explicit(&r->tail, memory_order_acquire) - head;
+}
+
+/**
+ * @brief Frees r and its vector. Neither side may still be using it.
+ */
+void free_vec_ring(vec_ring* r) {
+
+    if (r == NULL) return;
+
+    free_vec(r->vec);
+    free(r);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file vector_ring.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Fixed-capacity FIFO between exactly one producer thread and one
+ * consumer thread, without locks. Components live in a fixed_length
+ * vector whose capacity is a power of 2, so a slot is index & mask and
+ * nothing ever shifts or reallocates. The producer only writes tail and
+ * the consumer only writes head, each on its own cache line next to a
+ * private copy of the other index: a side only reloads the other's index
+ * (and pays for the cache miss) when its copy says the ring looks full or
+ * empty. Batch push/pop move a whole run with at most two memcpy calls.
+ * @version 0.1
+ * @date 2022-09-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_RING_H
+#define VECTOR_RING_H
+
+#include "vector.h"
+#include <stdatomic.h>
+
+// Each index and the other side's cached copy share one line of this size
+#define VEC_RING_ALIGNMENT 64
+
+/**
+ * @brief A ring containing the following:
+ * - atomic_size_t head, size_t tail_cache: Next slot to pop and the last
+ *   tail the consumer saw. Consumer side.
+ * - atomic_size_t tail, size_t head_cache: Next slot to push and the last
+ *   head the producer saw. Producer side.
+ * - vec_void* vec: The slots, a fixed_length vector, cast it to the vec_*
+ *   of its type.
+ * - size_t mask: vec->capacity - 1.
+ * - size_t data_size: Size of one component.
+ *
+ * head and tail count every push and pop ever made, their difference is
+ * the number of components waiting.
+ */
+typedef struct vec_ring {
+
+    _Alignas(VEC_RING_ALIGNMENT) atomic_size_t head;
+    size_t tail_cache;
+    _Alignas(VEC_RING_ALIGNMENT) atomic_size_t tail;
+    size_t head_cache;
+    _Alignas(VEC_RING_ALIGNMENT) vec_void* vec;
+    size_t mask;
+    size_t data_size;
+} vec_ring;
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Creates an empty ring.
+ *
+ * @param data_size Size of one component.
+ * @param capacity Components it can hold, rounded up to a power of 2.
+ * @return NULL if either is 0, capacity is too big or allocation failed.
+ */
+vec_ring* init_vec_ring(size_t data_size, size_t capacity);
+
+/**
+ * @brief Producer only. Pushes as many of the count components from data
+ * as there is room for, in order.
+ *
+ * @return Components pushed, 0 if r or data is NULL or the ring is full.
+ */
+size_t push_n_vec_ring(vec_ring* r, const void* data, size_t count);
+
+/**
+ * @brief Producer only. Pushes one component.
+ *
+ * @return false if r or data is NULL or the ring is full.
+ */
+bool push_vec_ring(vec_ring* r, const void* data);
+
+/**
+ * @brief Consumer only. Pops up to count components into out, oldest
+ * first.
+ *
+ * @return Components popped, 0 if r or out is NULL or the ring is empty.
+ */
+size_t pop_n_vec_ring(vec_ring* r, void* out, size_t count);
+
+/**
+ * @brief Consumer only. Pops one component.
+ *
+ * @return false if r or out is NULL or the ring is empty.
+ */
+bool pop_vec_ring(vec_ring* r, void* out);
+
+/**
+ * @brief Consumer only. Pops up to count components onto the end of a
+ * regular vector of the same component size.
+ *
+ * @param out Any vec_* struct.
+ * @return Components moved, 0 if either is NULL, the ring is empty or out
+ * could not grow (the ring is then left unchanged).
+ */
+size_t drain_vec_ring(vec_ring* r, void* out, size_t count);
+
+/**
+ * @brief Components waiting. Exact from either side when the other one
+ * is idle, otherwise a snapshot that may already be stale.
+ *
+ * @return size_t
+ */
+size_t size_vec_ring(const vec_ring* r);
+
+/**
+ * @brief Frees r and its vector. Neither side may still be using it.
+ */
+void free_vec_ring(vec_ring* r);
+
+#endif
@@ -0,0 +1,393 @@
+/**
+ * Typed search kernels for plain arrays.
+ * The kernels themselves live in vector_search_kernels.h and are
+ * stamped out once per component type and instruction set.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_search.h"
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// ===================== SCALAR KERNELS =====================
+
+#define T char
+#define VT char
+#define W 1
+#define SUFFIX char_scalar
+#define ATTR 
+#define VLOAD(p) (*(p))
+#define VSET1(a) (a)
+#define VEQ(a, b) ((uint64_t)((a) == (b)))
+#include "vector_search_kernels.h"
+
+#define T int32_t
+#define VT int32_t
+#define W 1
+#define SUFFIX i32_scalar
+#define ATTR 
+#define VLOAD(p) (*(p))
+#define VSET1(a) (a)
+#define VEQ(a, b) ((uint64_t)((a) == (b)))
+#include "vector_search_kernels.h"
+
+#define T int64_t
+#define VT int64_t
+#define W 1
+#define SUFFIX i64_scalar
+#define ATTR 
+#define VLOAD(p) (*(p))
+#define VSET1(a) (a)
+#define VEQ(a, b) ((uint64_t)((a) == (b)))
+#include "vector_search_kernels.h"
+
+#define T float
+#define VT float
+#define W 1
+#define SUFFIX f32_scalar
+#define ATTR 
+#define VLOAD(p) (*(p))
+#define VSET1(a) (a)
+#define VEQ(a, b) ((uint64_t)((a) == (b)))
+#include "vector_search_kernels.h"
+
+#define T double
+#define VT double
+#define W 1
+#define SUFFIX f64_scalar
+#define ATTR 
+#define VLOAD(p) (*(p))
+#define VSET1(a) (a)
+#define VEQ(a, b) ((uint64_t)((a) == (b)))
+#include "vector_search_kernels.h"
+
+#ifdef SIMD_X86
+
+// ===================== SSE2 KERNELS =====================
+
+// SSE2 has no 64-bit compare: both 32-bit halves have to match
+__attribute__((target("sse2")))
+static inline int movemask_eq_epi64_sse2(__m128i a, __m128i b) {
+
+    __m128i eq = _mm_cmpeq_epi32(a, b);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_movemask_pd(_mm_castsi128_pd(eq));
+}
+
+#define T char
+#define VT __m128i
+#define W 16
+#define SUFFIX char_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define VSET1(a) _mm_set1_epi8(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8((a), (b))))
+#include "vector_search_kernels.h"
+
+#define T int32_t
+#define VT __m128i
+#define W 4
+#define SUFFIX i32_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define VSET1(a) _mm_set1_epi32(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32((a), (b)))))
+#include "vector_search_kernels.h"
+
+#define T int64_t
+#define VT __m128i
+#define W 2
+#define SUFFIX i64_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define VSET1(a) _mm_set1_epi64x(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)movemask_eq_epi64_sse2((a), (b)))
+#include "vector_search_kernels.h"
+
+#define T float
+#define VT __m128
+#define W 4
+#define SUFFIX f32_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSET1(a) _mm_set1_ps(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm_movemask_ps(_mm_cmpeq_ps((a), (b))))
+#include "vector_search_kernels.h"
+
+#define T double
+#define VT __m128d
+#define W 2
+#define SUFFIX f64_sse2
+#define ATTR __attribute__((target("sse2")))
+#define VLOAD(p) _mm_loadu_pd(p)
+#define VSET1(a) _mm_set1_pd(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm_movemask_pd(_mm_cmpeq_pd((a), (b))))
+#include "vector_search_kernels.h"
+
+// ===================== AVX2 KERNELS =====================
+
+
+#define T char
+#define VT __m256i
+#define W 32
+#define SUFFIX char_avx2
+#define ATTR __attribute__((target("avx2,popcnt")))
+#define VLOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VSET1(a) _mm256_set1_epi8(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8((a), (b))))
+#include "vector_search_kernels.h"
+
+#define T int32_t
+#define VT __m256i
+#define W 8
+#define SUFFIX i32_avx2
+#define ATTR __attribute__((target("avx2,popcnt")))
+#define VLOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VSET1(a) _mm256_set1_epi32(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32((a), (b)))))
+#include "vector_search_kernels.h"
+
+#define T int64_t
+#define VT __m256i
+#define W 4
+#define SUFFIX i64_avx2
+#define ATTR __attribute__((target("avx2,popcnt")))
+#define VLOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VSET1(a) _mm256_set1_epi64x(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64((a), (b)))))
+#include "vector_search_kernels.h"
+
+#define T float
+#define VT __m256
+#define W 8
+#define SUFFIX f32_avx2
+#define ATTR __attribute__((target("avx2,popcnt")))
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSET1(a) _mm256_set1_ps(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm256_movemask_ps(_mm256_cmp_ps((a), (b), _CMP_EQ_OQ)))
+#include "vector_search_kernels.h"
+
+#define T double
+#define VT __m256d
+#define W 4
+#define SUFFIX f64_avx2
+#define ATTR __attribute__((target("avx2,popcnt")))
+#define VLOAD(p) _mm256_loadu_pd(p)
+#define VSET1(a) _mm256_set1_pd(a)
+#define VEQ(a, b) ((uint64_t)(unsigned)_mm256_movemask_pd(_mm256_cmp_pd((a), (b), _CMP_EQ_OQ)))
+#include "vector_search_kernels.h"
+
+// ===================== AVX-512 KERNELS =====================
+
+// Compares land straight in mask registers, no movemask needed
+
+#define T char
+#define VT __m512i
+#define W 64
+#define SUFFIX char_avx512
+#define ATTR __attribute__((target("avx512f,avx512bw,popcnt")))
+#define VLOAD(p) _mm512_loadu_si512((const void*)(p))
+#define VSET1(a) _mm512_set1_epi8(a)
+#define VEQ(a, b) ((uint64_t)_mm512_cmpeq_epi8_mask((a), (b)))
+#include "vector_search_kernels.h"
+
+#define T int32_t
+#define VT __m512i
+#define W 16
+#define SUFFIX i32_avx512
+#define ATTR __attribute__((target("avx512f,avx512bw,popcnt")))
+#define VLOAD(p) _mm512_loadu_si512((const void*)(p))
+#define VSET1(a) _mm512_set1_epi32(a)
+#define VEQ(a, b) ((uint64_t)_mm512_cmpeq_epi32_mask((a), (b)))
+#include "vector_search_kernels.h"
+
+#define T int64_t
+#define VT __m512i
+#define W 8
+#define SUFFIX i64_avx512
+#define ATTR __attribute__((target("avx512f,avx512bw,popcnt")))
+#define VLOAD(p) _mm512_loadu_si512((const void*)(p))
+#define VSET1(a) _mm512_set1_epi64(a)
+#define VEQ(a, b) ((uint64_t)_mm512_cmpeq_epi64_mask((a), (b)))
+#include "vector_search_kernels.h"
+
+#define T float
+#define VT __m512
+#define W 16
+#define SUFFIX f32_avx512
+#define ATTR __attribute__((target("avx512f,avx512bw,popcnt")))
+#define VLOAD(p) _mm512_loadu_ps(p)
+#define VSET1(a) _mm512_set1_ps(a)
+#define VEQ(a, b) ((uint64_t)_mm512_cmp_ps_mask((a), (b), _CMP_EQ_OQ))
+#include "vector_search_kernels.h"
+
+#define T double
+#define VT __m512d
+#define W 8
+#define SUFFIX f64_avx512
+#define ATTR __attribute__((target("avx512f,avx512bw,popcnt")))
+#define VLOAD(p) _mm512_loadu_pd(p)
+#define VSET1(a) _mm512_set1_pd(a)
+#define VEQ(a, b) ((uint64_t)_mm512_cmp_pd_mask((a), (b), _CMP_EQ_OQ))
+#include "vector_search_kernels.h"
+
+#endif
+
+// ===================== DISPATCH =====================
+
+#define SEARCH_KERNELS(T, S) \
+typedef struct kernels_##S { \
+    size_t (*find)(const T*, size_t, T); \
+    size_t (*count)(const T*, size_t, T); \
+    size_t (*mask)(const T*, size_t, T, uint64_t*); \
+} kernels_##S;
+
+SEARCH_KERNELS(char, char)
+SEARCH_KERNELS(int32_t, i32)
+SEARCH_KERNELS(int64_t, i64)
+SEARCH_KERNELS(float, f32)
+SEARCH_KERNELS(double, f64)
+
+#undef SEARCH_KERNELS
+
+#define KERNEL_TABLE(suffix) { find_##suffix, count_##suffix, mask_##suffix }
+
+#ifdef SIMD_X86
+#define SEARCH_TABLE(S) \
+static const kernels_##S S##_table[] = { \
+    [SIMD_SCALAR] = KERNEL_TABLE(S##_scalar), \
+    [SIMD_SSE2] = KERNEL_TABLE(S##_sse2), \
+    [SIMD_AVX2] = KERNEL_TABLE(S##_avx2), \
+    [SIMD_AVX512] = KERNEL_TABLE(S##_avx512), \
+}; \
+static const kernels_##S* S##_kernels = &S##_table[SIMD_SCALAR];
+#else
+#define SEARCH_TABLE(S) \
+static const kernels_##S S##_table[] = { [SIMD_SCALAR] = KERNEL_TABLE(S##_scalar) }; \
+static const kernels_##S* S##_kernels = &S##_table[SIMD_SCALAR];
+#endif
+
+SEARCH_TABLE(char)
+SEARCH_TABLE(i32)
+SEARCH_TABLE(i64)
+SEARCH_TABLE(f32)
+SEARCH_TABLE(f64)
+
+#undef SEARCH_TABLE
+
+static simd_level active_level = SIMD_SCALAR;
+
+/**
+ * @brief Highest instruction set the search kernels can use on this CPU.
+ * SIMD_AVX512 also needs AVX-512BW for the char kernels.
+ *
+ * @return simd_level
+ */
+simd_level max_search_level(void) {
+
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    bool popcnt = __builtin_cpu_supports("popcnt");
+    if (popcnt && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return SIMD_AVX512;
+    if (popcnt && __builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+/**
+ * @brief Forces the search kernels down to level (for testing and
+ * benchmarking). Levels above max_search_level() are clamped. Not
+ * thread-safe, call it while no other thread is searching.
+ *
+ * @param level Requested instruction set.
+ * @return simd_level The level actually in use.
+ */
+simd_level set_search_level(simd_level level) {
+
+    simd_level max = max_search_level();
+    if (level > max || level < SIMD_SCALAR) level = max;
+
+    active_level = level;
+    char_kernels = &char_table[level];
+    i32_kernels = &i32_table[level];
+    i64_kernels = &i64_table[level];
+    f32_kernels = &f32_table[level];
+    f64_kernels = &f64_table[level];
+
+    return level;
+}
+
+/**
+ * @brief The instruction set the search kernels currently use.
+ *
+ * @return simd_level
+ */
+simd_level get_search_level(void) {
+    return active_level;
+}
+
+// Pick the best kernels before main() runs so the hot paths never branch on it
+__attribute__((constructor))
+static void init_search_level(void) {
+    set_search_level(max_search_level());
+}
+
+// ===================== FUNCTIONS =====================
+
+#define DEFINE_SEARCH(T, S) \
+size_t find_##S(const T* x, size_t n, T value) { return S##_kernels->find(x, n, value); } \
+size_t count_##S(const T* x, size_t n, T value) { return S##_kernels->count(x, n, value); } \
+size_t mask_##S(const T* x, size_t n, T value, uint64_t* bits) { return S##_kernels->mask(x, n, value, bits); }
+
+DEFINE_SEARCH(char, char)
+DEFINE_SEARCH(int32_t, i32)
+DEFINE_SEARCH(int64_t, i64)
+DEFINE_SEARCH(float, f32)
+DEFINE_SEARCH(double, f64)
+
+/**
+ * @brief Index of the first of the n data_size-byte components of x whose
+ * bytes equal value's. Components of 1, 4 or 8 bytes go through the
+ * char/int32/int64 kernels, anything else through memcmp.
+ *
+ * @param x Components, data_size bytes apart and aligned for their width.
+ * @param n Number of components.
+ * @param value data_size bytes to look for.
+ * @param data_size Size of one component.
+ * @return size_t n if there is none.
+ */
+size_t find_bytes(const void* x, size_t n, const void* value, size_t data_size) {
+
+    // Integer compares are bit-exact, so they also serve float/double bytes
+    switch (data_size) {
+
+        case 1:
+            return find_char((const char*)x, n, *(const char*)value);
+
+        case 4: {
+
+            int32_t key;
+            memcpy(&key, value, sizeof(key));
+            return find_i32((const int32_t*)x, n, key);
+        }
+
+        case 8: {
+
+            int64_t key;
+            memcpy(&key, value, sizeof(key));
+            return find_i64((const int64_t*)x, n, key);
+        }
+    }
+
+    const char* bytes = (const char*)x;
+    for (size_t i = 0; i < n; i++)
+        if (memcmp(bytes + i * data_size, value, data_size) == 0) return i;
+
+    return n;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file vector_search.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Typed linear search over plain arrays: first match, number of
+ * matches, or a bitmask of them, for char, int32, int64, float and double.
+ * Components are compared 16 to 64 bytes at a time with SSE2/AVX2/AVX-512
+ * compares and movemask, picked at load time with CPUID, so long scans run
+ * at memory bandwidth. find_bytes puts them behind contains_vec and the
+ * packed array list's contains.
+ * @version 0.1
+ * @date 2022-08-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_SEARCH_H
+#define VECTOR_SEARCH_H
+
+#include "simd.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// ===================== DISPATCH =====================
+
+/**
+ * @brief The instruction set the search kernels currently use. Defaults to
+ * the best one the CPU (and OS) supports.
+ *
+ * @return simd_level
+ */
+simd_level get_search_level(void);
+
+/**
+ * @brief Highest instruction set the search kernels can use on this CPU.
+ * SIMD_AVX512 also needs AVX-512BW for the char kernels.
+ *
+ * @return simd_level
+ */
+simd_level max_search_level(void);
+
+/**
+ * @brief Forces the search kernels down to level (for testing and
+ * benchmarking). Levels above max_search_level() are clamped. Not
+ * thread-safe, call it while no other thread is searching.
+ *
+ * @param level Requested instruction set.
+ * @return simd_level The level actually in use.
+ */
+simd_level set_search_level(simd_level level);
+
+// ===================== KERNELS =====================
+
+/**
+ * @brief Index of the first of the n components of x equal to value.
+ * The float and double versions compare with ==, so NaN never matches
+ * and -0.0 matches 0.0.
+ *
+ * @return size_t n if there is none.
+ */
+size_t find_char(const char* x, size_t n, char value);
+size_t find_i32(const int32_t* x, size_t n, int32_t value);
+size_t find_i64(const int64_t* x, size_t n, int64_t value);
+size_t find_f32(const float* x, size_t n, float value);
+size_t find_f64(const double* x, size_t n, double value);
+
+/**
+ * @brief Number of the n components of x equal to value.
+ *
+ * @return size_t
+ */
+size_t count_char(const char* x, size_t n, char value);
+size_t count_i32(const int32_t* x, size_t n, int32_t value);
+size_t count_i64(const int64_t* x, size_t n, int64_t value);
+size_t count_f32(const float* x, size_t n, float value);
+size_t count_f64(const double* x, size_t n, double value);
+
+/**
+ * @brief Sets bit i % 64 of bits[i / 64] for every component i of x equal
+ * to value, and clears the rest.
+ *
+ * @param bits Room for (n + 63) / 64 words, every one of them is written.
+ * @return size_t Number of matches.
+ */
+size_t mask_char(const char* x, size_t n, char value, uint64_t* bits);
+size_t mask_i32(const int32_t* x, size_t n, int32_t value, uint64_t* bits);
+size_t mask_i64(const int64_t* x, size_t n, int64_t value, uint64_t* bits);
+size_t mask_f32(const float* x, size_t n, float value, uint64_t* bits);
+size_t mask_f64(const double* x, size_t n, double value, uint64_t* bits);
+
+/**
+ * @brief Index of the first of the n data_size-byte components of x whose
+ * bytes equal value's. Components of 1, 4 or 8 bytes go through the
+ * char/int32/int64 kernels, anything else through memcmp.
+ *
+ * @return size_t n if there is none.
+ */
+size_t find_bytes(const void* x, size_t n, const void* value, size_t data_size);
+
+#endif
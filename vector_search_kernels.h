@@ -0,0 +1,122 @@
+/**
+ * @file vector_search_kernels.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Search kernel template, NOT a regular header. vector_search.c
+ * includes it once per (component type, instruction set) pair after
+ * defining the macros below:
+ *
+ * - T, VT, W: scalar type, SIMD register type and lanes per register
+ *   (a power of 2, at most 64).
+ * - SUFFIX: appended to every generated function name.
+ * - ATTR: function attributes (e.g. the target ISA).
+ * - VLOAD, VSET1: unaligned load and broadcast.
+ * - VEQ(a, b): uint64_t with bit i set where lane i of a equals lane i of b.
+ *
+ * The macros are #undef'd at the end so the next instantiation starts clean.
+ * @version 0.1
+ * @date 2022-08-20
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#define KCAT_(a, b) a##_##b
+#define KCAT(a, b) KCAT_(a, b)
+#define KFN(name) KCAT(name, SUFFIX)
+
+// Four loads in flight per iteration keep the memory pipeline busy
+#define UNROLL (4 * W)
+
+static ATTR size_t KFN(find)(const T* x, size_t n, T value) {
+
+    VT v = VSET1(value);
+    size_t i = 0;
+
+    for (; i + UNROLL <= n; i += UNROLL) {
+
+        uint64_t m0 = VEQ(VLOAD(x + i), v);
+        uint64_t m1 = VEQ(VLOAD(x + i + W), v);
+        uint64_t m2 = VEQ(VLOAD(x + i + 2 * W), v);
+        uint64_t m3 = VEQ(VLOAD(x + i + 3 * W), v);
+
+        // One branch per UNROLL components until something matches
+        if ((m0 | m1 | m2 | m3) == 0) continue;
+        if (m0 != 0) return i + (size_t)__builtin_ctzll(m0);
+        if (m1 != 0) return i + W + (size_t)__builtin_ctzll(m1);
+        if (m2 != 0) return i + 2 * W + (size_t)__builtin_ctzll(m2);
+        return i + 3 * W + (size_t)__builtin_ctzll(m3);
+    }
+
+    for (; i + W <= n; i += W) {
+
+        uint64_t m = VEQ(VLOAD(x + i), v);
+        if (m != 0) return i + (size_t)__builtin_ctzll(m);
+    }
+
+    for (; i < n; i++)
+        if (x[i] == value) return i;
+
+    return n;
+}
+
+static ATTR size_t KFN(count)(const T* x, size_t n, T value) {
+
+    VT v = VSET1(value);
+    size_t count = 0, i = 0;
+
+    for (; i + UNROLL <= n; i += UNROLL) {
+
+        count += (size_t)__builtin_popcountll(VEQ(VLOAD(x + i), v));
+        count += (size_t)__builtin_popcountll(VEQ(VLOAD(x + i + W), v));
+        count += (size_t)__builtin_popcountll(VEQ(VLOAD(x + i + 2 * W), v));
+        count += (size_t)__builtin_popcountll(VEQ(VLOAD(x + i + 3 * W), v));
+    }
+
+    for (; i + W <= n; i += W)
+        count += (size_t)__builtin_popcountll(VEQ(VLOAD(x + i), v));
+
+    for (; i < n; i++) count += x[i] == value;
+
+    return count;
+}
+
+static ATTR size_t KFN(mask)(const T* x, size_t n, T value, uint64_t* bits) {
+
+    VT v = VSET1(value);
+    size_t count = 0, i = 0;
+
+    // 64 components per word, 64 / W registers per word
+    for (; i + 64 <= n; i += 64) {
+
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += W) word |= VEQ(VLOAD(x + i + j), v) << j;
+
+        bits[i / 64] = word;
+        count += (size_t)__builtin_popcountll(word);
+    }
+
+    if (i < n) {
+
+        uint64_t word = 0;
+        for (size_t j = 0; i + j < n; j++) word |= (uint64_t)(x[i + j] == value) << j;
+
+        bits[i / 64] = word;
+        count += (size_t)__builtin_popcountll(word);
+    }
+
+    return count;
+}
+
+#undef UNROLL
+#undef KFN
+#undef KCAT
+#undef KCAT_
+
+#undef T
+#undef VT
+#undef W
+#undef SUFFIX
+#undef ATTR
+#undef VLOAD
+#undef VSET1
+#undef VEQ
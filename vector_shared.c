@@ -0,0 +1,287 @@
+/**
+ * Lock-free multi-producer append over doubling segments.
+ * Slot i lives in segment k = log2(i / VEC_SHARED_FIRST + 1), so index
+ * math is one count-leading-zeros and segments never move once published.
+ * @author Alejandro Ciuba
+ */
+
+#include "vector_shared.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FIRST_LOG2 (__builtin_ctzll(VEC_SHARED_FIRST))
+
+// Slots the first k segments hold together
+static size_t segment_start(size_t k) { return (VEC_SHARED_FIRST << k) - VEC_SHARED_FIRST; }
+
+static size_t segment_length(size_t k) { return VEC_SHARED_FIRST << k; }
+
+static size_t segment_of(size_t i) {
+
+    return (size_t)(63 - __builtin_clzll((unsigned long long)(i + VEC_SHARED_FIRST))) - FIRST_LOG2;
+}
+
+// Components come first, padded to the alignment, then the ready flags
+static size_t flags_offset(const vec_shared* s, size_t k) {
+
+    size_t bytes = segment_length(k) * s->data_size;
+    return (bytes + VEC_SHARED_ALIGNMENT - 1) / VEC_SHARED_ALIGNMENT * VEC_SHARED_ALIGNMENT;
+}
+
+static atomic_uchar* flags_of(const vec_shared* s, unsigned char* seg, size_t k) {
+
+    return (atomic_uchar*)(seg + flags_offset(s, k));
+}
+
+// ===================== SEGMENTS =====================
+
+/**
+ * @brief Segment k, allocating it if nobody has yet. Racing threads each
+ * allocate one, the first to install it wins and the rest free theirs.
+ *
+ * @return NULL if k is past the last segment or allocation failed.
+ */
+static unsigned char* get_segment(vec_shared* s, size_t k) {
+
+    if (k >= VEC_SHARED_SEGMENTS) return NULL;
+
+    unsigned char* seg = atomic_load_explicit(&s->segment[k], memory_order_acquire);
+    if (seg != NULL) return seg;
+
+    size_t offset = flags_offset(s, k);
+    size_t bytes = offset + segment_length(k);
+    bytes = (bytes + VEC_SHARED_ALIGNMENT - 1) / VEC_SHARED_ALIGNMENT * VEC_SHARED_ALIGNMENT;
+
+    unsigned char* fresh = aligned_alloc(VEC_SHARED_ALIGNMENT, bytes);
+    if (fresh == NULL) return NULL;
+    memset(fresh + offset, 0, segment_length(k));
+
+    if (atomic_compare_exchange_strong_explicit(&s->segment[k], &seg, fresh,
+                                                memory_order_acq_rel, memory_order_acquire))
+        return fresh;
+
+    free(fresh);
+    return seg;
+}
+
+// ===================== PUBLISHING =====================
+
+/**
+ * @brief Moves published over every ready slot after it. Any thread may
+ * do it, so whichever writer fills the gap carries the prefix past the
+ * slots finished before it. Writers set their flags and then fence
+ * before coming here, so of two writers finishing next to each other at
+ * least one sees the other's flag and nobody's slots are left behind.
+ */
+static void advance(vec_shared* s) {
+
+    size_t p = atomic_load_explicit(&s->published, memory_order_acquire);
+
+    while (true) {
+
+        size_t end = atomic_load_explicit(&s->reserved, memory_order_acquire);
+        size_t q = p;
+
+        while (q < end) {
+
+            size_t k = segment_of(q);
+            unsigned char* seg = atomic_load_explicit(&s->segment[k], memory_order_acquire);
+            if (seg == NULL) break;
+
+            atomic_uchar* flags = flags_of(s, seg, k);
+            size_t last = segment_start(k + 1) < end ? segment_start(k + 1) : end;
+            size_t j = q - segment_start(k);
+
+            while (q < last && atomic_load_explicit(&flags[j], memory_order_acquire)) {
+
+                q++;
+                j++;
+            }
+
+            if (q < last) break;
+        }
+
+        // On failure p is reloaded and the scan picks up from there
+        if (q == p || atomic_compare_exchange_weak_explicit(&s->published, &p, q,
+                                                            memory_order_acq_rel, memory_order_acquire))
+            return;
+    }
+}
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Creates an empty shared vector with room for capacity components
+ * allocated up front.
+ *
+ * @param data_size Size of one component.
+ * @param capacity Components to allocate now (0 allocates on first append).
+ * @return NULL if data_size == 0 or allocation failed.
+ */
+vec_shared* init_vec_shared(size_t data_size, size_t capacity) {
+
+    if (data_size == 0) return NULL;
+
+    vec_shared* s = aligned_alloc(VEC_SHARED_ALIGNMENT, sizeof(vec_shared));
+    if (s == NULL) return NULL;
+
+    atomic_init(&s->reserved, 0);
+    atomic_init(&s->published, 0);
+    for (size_t k = 0; k < VEC_SHARED_SEGMENTS; k++) atomic_init(&s->segment[k], NULL);
+    s->data_size = data_size;
+
+    if (!reserve_vec_shared(s, capacity)) {
+
+        free_vec_shared(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+/**
+ * @brief Allocates every segment needed to hold capacity components. Safe
+ * to call while other threads append; appends that stay below a reserved
+ * capacity never allocate.
+ *
+ * @return false if allocation failed or capacity is beyond the last segment.
+ */
+bool reserve_vec_shared(vec_shared* s, size_t capacity) {
+
+    if (s == NULL || capacity > segment_start(VEC_SHARED_SEGMENTS)) return false;
+    if (capacity == 0) return true;
+
+    for (size_t k = 0; k <= segment_of(capacity - 1); k++)
+        if (get_segment(s, k) == NULL) return false;
+
+    return true;
+}
+
+/**
+ * @brief Appends count components from data, thread-safe and lock-free.
+ * The components end up next to each other in the order given, and are
+ * readable once every slot before them has been written as well.
+ *
+ * @param data count components of data_size bytes each.
+ * @return false if s or data is NULL, or a segment could not be allocated.
+ * The slots were already claimed by then, so publishing stops in front of
+ * them for good; reserve_vec_shared up front to rule this out.
+ */
+bool append_n_vec_shared(vec_shared* s, const void* data, size_t count) {
+
+    if (s == NULL || data == NULL) return false;
+    if (count == 0) return true;
+
+    size_t first = atomic_fetch_add_explicit(&s->reserved, count, memory_order_relaxed);
+    const unsigned char* src = (const unsigned char*)data;
+
+    // Copy segment by segment, flagging each slot once its bytes are in
+    for (size_t i = first, end = first + count; i < end; ) {
+
+        size_t k = segment_of(i);
+        unsigned char* seg = get_segment(s, k);
+        if (seg == NULL) return false;
+
+        size_t j = i - segment_start(k);
+        size_t len = segment_length(k) - j < end - i ? segment_length(k) - j : end - i;
+
+        memcpy(seg + j * s->data_size, src, len * s->data_size);
+        atomic_uchar* flags = flags_of(s, seg, k);
+        for (size_t t = 0; t < len; t++) atomic_store_explicit(&flags[j + t], 1, memory_order_release);
+
+        src += len * s->data_size;
+        i += len;
+    }
+
+    atomic_thread_fence(memory_order_seq_cst);
+    advance(s);
+    return true;
+}
+
+bool append_vec_shared(vec_shared* s, const void* data) { return append_n_vec_shared(s, data, 1); }
+
+/**
+ * @brief Length of the published prefix. Every component below it is
+ * fully written and visible to the calling thread.
+ *
+ * @return size_t
+ */
+size_t published_vec_shared(const vec_shared* s) {
+
+    return s == NULL ? 0 : atomic_load_explicit(&s->published, memory_order_acquire);
+}
+
+/**
+ * @brief Pointer to component i, which stays put while appends go on.
+ *
+ * @return NULL if i is not published yet.
+ */
+void* at_vec_shared(const vec_shared* s, size_t i) {
+
+    if (i >= published_vec_shared(s)) return NULL;
+
+    size_t k = segment_of(i);
+    unsigned char* seg = atomic_load_explicit(&s->segment[k], memory_order_acquire);
+    return seg + (i - segment_start(k)) * s->data_size;
+}
+
+/**
+ * @brief Contiguous run of published components starting at first, for
+ * walking the prefix one segment at a time without copying.
+ *
+ * @param end Stop at this index (clamped to the published length).
+ * @param data Set to the first component of the run.
+ * @return Components in the run, 0 if first >= end.
+ */
+size_t span_vec_shared(const vec_shared* s, size_t first, size_t end, const void** data) {
+
+    size_t n = published_vec_shared(s);
+    if (end > n) end = n;
+    if (data == NULL || first >= end) return 0;
+
+    size_t k = segment_of(first);
+    *data = at_vec_shared(s, first);
+
+    return segment_start(k + 1) < end ? segment_start(k + 1) - first : end - first;
+}
+
+/**
+ * @brief Copies the published prefix into a regular vector of the same
+ * component size, replacing its contents.
+ *
+ * @param out Any vec_* struct.
+ * @return false if either is NULL or out could not be resized (out is
+ * then left unchanged).
+ */
+bool snapshot_vec_shared(const vec_shared* s, void* out) {
+
+    if (s == NULL || out == NULL) return false;
+
+    size_t n = published_vec_shared(s);
+    vec_void* v = (vec_void*)out;
+    if (!reserve_vec(v, n, s->data_size)) return false;
+
+    unsigned char* dst = (unsigned char*)v->array;
+    for (size_t i = 0, len; i < n; i += len) {
+
+        const void* run;
+        len = span_vec_shared(s, i, n, &run);
+        memcpy(dst + i * s->data_size, run, len * s->data_size);
+    }
+
+    v->size = n;
+    // Written in place behind the index's back
+    drop_index_vec(v);
+    return true;
+}
+
+/**
+ * @brief Frees s and every segment. No thread may still be using it.
+ */
+void free_vec_shared(vec_shared* s) {
+
+    if (s == NULL) return;
+
+    for (size_t k = 0; k < VEC_SHARED_SEGMENTS; k++) free(atomic_load_explicit(&s->segment[k], memory_order_relaxed));
+    free(s);
+}
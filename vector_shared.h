@@ -0,0 +1,133 @@
+/**
+ * @file vector_shared.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Append-only vector that many threads can append to at once. A
+ * writer claims its slots with one atomic fetch-add on the length and
+ * copies its components in without any lock. Storage is a list of
+ * segments that double in size (VEC_SHARED_FIRST components, then twice
+ * that, ...), so growing never moves a component and a pointer to one
+ * stays valid until free_vec_shared.
+ *
+ * Readers only see the published prefix: the longest run of slots from 0
+ * whose writers have all finished. Whichever writer completes the run
+ * moves it forward, so readers never wait, and a slow writer only holds
+ * back the slots behind its own.
+ * @version 0.1
+ * @date 2022-09-18
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_SHARED_H
+#define VECTOR_SHARED_H
+
+#include "vector.h"
+#include <stdatomic.h>
+
+// Components in segment 0, a power of 2; segment k holds VEC_SHARED_FIRST << k
+#define VEC_SHARED_FIRST ((size_t)1 << 10)
+// Segment slots, enough for VEC_SHARED_FIRST * (2^40 - 1) components
+#define VEC_SHARED_SEGMENTS 40
+// Segments are allocated on this boundary, and the two counters get a
+// cache line each so writers bumping one do not slow readers of the other
+#define VEC_SHARED_ALIGNMENT 64
+
+/**
+ * @brief A shared vector containing the following:
+ * - atomic_size_t reserved: Slots handed out to writers so far.
+ * - atomic_size_t published: Slots readable from 0, published <= reserved.
+ * - unsigned char* segment[]: The segments, NULL until first needed. Each
+ *   holds its components followed by one ready flag per slot.
+ * - size_t data_size: Size of one component.
+ */
+typedef struct vec_shared {
+
+    _Alignas(VEC_SHARED_ALIGNMENT) atomic_size_t reserved;
+    _Alignas(VEC_SHARED_ALIGNMENT) atomic_size_t published;
+    _Alignas(VEC_SHARED_ALIGNMENT) _Atomic(unsigned char*) segment[VEC_SHARED_SEGMENTS];
+    size_t data_size;
+} vec_shared;
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Creates an empty shared vector with room for capacity components
+ * allocated up front.
+ *
+ * @param data_size Size of one component.
+ * @param capacity Components to allocate now (0 allocates on first append).
+ * @return NULL if data_size == 0 or allocation failed.
+ */
+vec_shared* init_vec_shared(size_t data_size, size_t capacity);
+
+/**
+ * @brief Allocates every segment needed to hold capacity components. Safe
+ * to call while other threads append; appends that stay below a reserved
+ * capacity never allocate.
+ *
+ * @return false if allocation failed or capacity is beyond the last segment.
+ */
+bool reserve_vec_shared(vec_shared* s, size_t capacity);
+
+/**
+ * @brief Appends count components from data, thread-safe and lock-free.
+ * The components end up next to each other in the order given, and are
+ * readable once every slot before them has been written as well.
+ *
+ * @param data count components of data_size bytes each.
+ * @return false if s or data is NULL, or a segment could not be allocated.
+ * The slots were already claimed by then, so publishing stops in front of
+ * them for good; reserve_vec_shared up front to rule this out.
+ */
+bool append_n_vec_shared(vec_shared* s, const void* data, size_t count);
+bool append_vec_shared(vec_shared* s, const void* data);
+
+/**
+ * @brief Length of the published prefix. Every component below it is
+ * fully written and visible to the calling thread.
+ *
+ * @return size_t
+ */
+size_t published_vec_shared(const vec_shared* s);
+
+/**
+ * @brief Pointer to component i, which stays put while appends go on.
+ *
+ * @return NULL if i is not published yet.
+ */
+void* at_vec_shared(const vec_shared* s, size_t i);
+
+/**
+ * @brief Contiguous run of published components starting at first, for
+ * walking the prefix one segment at a time without copying:
+ *
+ *     size_t n = published_vec_shared(s);
+ *     for (size_t i = 0, len; i < n; i += len) {
+ *         const float* run;
+ *         len = span_vec_shared(s, i, n, (const void**)&run);
+ *         ...
+ *     }
+ *
+ * @param end Stop at this index (clamped to the published length).
+ * @param data Set to the first component of the run.
+ * @return Components in the run, 0 if first >= end.
+ */
+size_t span_vec_shared(const vec_shared* s, size_t first, size_t end, const void** data);
+
+/**
+ * @brief Copies the published prefix into a regular vector of the same
+ * component size, replacing its contents.
+ *
+ * @param out Any vec_* struct.
+ * @return false if either is NULL or out could not be resized (out is
+ * then left unchanged).
+ */
+bool snapshot_vec_shared(const vec_shared* s, void* out);
+
+/**
+ * @brief Frees s and every segment. No thread may still be using it.
+ */
+void free_vec_shared(vec_shared* s);
+
+#endif
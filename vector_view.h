@@ -0,0 +1,155 @@
+/**
+ * @file vector_view.h
+ * @author Alejandro Ciuba (alejandrociuba@gmail.com)
+ * @brief Non-owning, read-only views over vector, matrix or plain array
+ * storage: a first component, a length and a stride, so windows, every
+ * k-th component or a matrix column can be handed to the search and
+ * vector_math operations without allocating or copying. Views are small
+ * values, pass them around by copy.
+ * @version 0.1
+ * @date 2022-08-27
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#ifndef VECTOR_VIEW_H
+#define VECTOR_VIEW_H
+
+#include "vector.h"
+#include "vector_search.h"
+#include "matrix.h"
+
+/**
+ * @brief The view structs containing the following:
+ * - const type* data: First component of the view.
+ * - size_t size: Number of components in the view.
+ * - size_t stride: Components between two consecutive view components
+ *   (1 is contiguous). 0 marks an invalid view, e.g. a slice that did not
+ *   fit; every operation taking one fails on it.
+ *
+ * A view does not keep its storage alive: anything that reallocates the
+ * vector (append, reserve, upsize, ...) or frees it invalidates its views.
+ *
+ * types: view_char, view_int_32, view_int_64, view_float and view_double
+ */
+#define DEFINE_VIEW_STRUCT(T, S) \
+typedef struct view_##S { \
+    const T* data; \
+    size_t size; \
+    size_t stride; \
+} view_##S;
+
+DEFINE_VIEW_STRUCT(char, char)
+DEFINE_VIEW_STRUCT(int32_t, int_32)
+DEFINE_VIEW_STRUCT(int64_t, int_64)
+DEFINE_VIEW_STRUCT(float, float)
+DEFINE_VIEW_STRUCT(double, double)
+
+#undef DEFINE_VIEW_STRUCT
+
+// ===================== MACROS =====================
+
+/**
+ * @brief Whether the components of offset, offset + stride, ... (length
+ * of them) all lie below size.
+ */
+#define VIEW_FITS(offset, length, stride, size) \
+    ((stride) != 0 && (offset) <= (size) && \
+     ((length) == 0 || ((offset) < (size) && ((length) - 1) <= ((size) - (offset) - 1) / (stride))))
+
+/**
+ * @brief View of the whole vector, or of length components of it starting
+ * at offset and stride apart (see view_vec_S and slice_vec_S below).
+ */
+#define view_of(vector) VEC_SELECT_CONST((vector), view)((vector))
+#define slice(vector, offset, length, stride) \
+    VEC_SELECT_CONST((vector), slice)((vector), (offset), (length), (stride))
+
+// ===================== FUNCTIONS =====================
+
+/**
+ * @brief Stamps out the view functions of one component type. K is the
+ * vector_search suffix of the type:
+ *
+ * - view_vec_S(v): the whole vector, contiguous. Invalid if v == NULL.
+ * - slice_vec_S(v, offset, length, stride): components offset,
+ *   offset + stride, ... of v. Invalid unless they all lie below v->size.
+ * - slice_view_S(w, offset, length, stride): the same, within w.
+ * - view_array_S(data, size, stride): size components of a plain array.
+ * - get_view_S(w, index): component index of w, unchecked.
+ * - find_view_S(w, value), count_view_S(w, value), contains_view_S(w, value):
+ *   the vector_search kernels on w (w.size if not found). Contiguous
+ *   views use the SIMD kernels, strided ones a scalar loop.
+ */
+#define DEFINE_VIEW_TYPE(T, S, K) \
+static inline view_##S view_array_##S(const T* data, size_t size, size_t stride) { \
+    return (view_##S){ data, size, stride }; \
+} \
+\
+static inline view_##S view_vec_##S(const vec_##S* v) { \
+    if (v == NULL) return (view_##S){ NULL, 0, 0 }; \
+    return (view_##S){ v->array, v->size, 1 }; \
+} \
+\
+static inline view_##S slice_vec_##S(const vec_##S* v, size_t offset, size_t length, size_t stride) { \
+    if (v == NULL || !VIEW_FITS(offset, length, stride, v->size)) return (view_##S){ NULL, 0, 0 }; \
+    return (view_##S){ v->array + offset, length, stride }; \
+} \
+\
+static inline view_##S slice_view_##S(view_##S w, size_t offset, size_t length, size_t stride) { \
+    if (w.stride == 0 || !VIEW_FITS(offset, length, stride, w.size)) return (view_##S){ NULL, 0, 0 }; \
+    return (view_##S){ w.data + offset * w.stride, length, stride * w.stride }; \
+} \
+\
+static inline T get_view_##S(view_##S w, size_t index) { \
+    return w.data[index * w.stride]; \
+} \
+\
+static inline size_t find_view_##S(view_##S w, T value) { \
+    if (w.stride == 1) return find_##K(w.data, w.size, value); \
+    for (size_t i = 0; w.stride != 0 && i < w.size; i++) \
+        if (w.data[i * w.stride] == value) return i; \
+    return w.size; \
+} \
+\
+static inline size_t count_view_##S(view_##S w, T value) { \
+    if (w.stride == 1) return count_##K(w.data, w.size, value); \
+    size_t count = 0; \
+    for (size_t i = 0; w.stride != 0 && i < w.size; i++) count += w.data[i * w.stride] == value; \
+    return count; \
+} \
+\
+static inline bool contains_view_##S(view_##S w, T value) { \
+    return w.stride != 0 && find_view_##S(w, value) != w.size; \
+}
+
+DEFINE_VIEW_TYPE(char, char, char)
+DEFINE_VIEW_TYPE(int32_t, int_32, i32)
+DEFINE_VIEW_TYPE(int64_t, int_64, i64)
+DEFINE_VIEW_TYPE(float, float, f32)
+DEFINE_VIEW_TYPE(double, double, f64)
+
+#undef DEFINE_VIEW_TYPE
+
+/**
+ * @brief Row i or column j of a matrix. Columns are strided by m->ld.
+ * Invalid if m == NULL or the index is out of range.
+ */
+#define DEFINE_MAT_VIEWS(T, S) \
+static inline view_##S row_view_mat_##S(const mat_##S* m, size_t i) { \
+    if (m == NULL || i >= m->rows) return (view_##S){ NULL, 0, 0 }; \
+    return (view_##S){ m->array + i * m->ld, m->cols, 1 }; \
+} \
+\
+static inline view_##S col_view_mat_##S(const mat_##S* m, size_t j) { \
+    if (m == NULL || j >= m->cols) return (view_##S){ NULL, 0, 0 }; \
+    return (view_##S){ m->array + j, m->rows, m->ld }; \
+}
+
+DEFINE_MAT_VIEWS(float, float)
+DEFINE_MAT_VIEWS(double, double)
+
+#undef DEFINE_MAT_VIEWS
+
+#endif